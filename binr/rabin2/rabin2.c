@@ -87,6 +87,7 @@ static int rabin_show_help(int v) {
 		" RABIN2_NOPLUGINS: # do not load shared plugins (speedup loading)\n"
 		" RABIN2_DEMANGLE=0:e bin.demangle     # do not demangle symbols\n"
 		" RABIN2_MAXSTRBUF: e bin.maxstrbuf    # specify maximum buffer size\n"
+		" RABIN2_STRJOBS:   e bin.strjobs      # threads extracting strings\n"
 		" RABIN2_STRFILTER: e bin.strfilter    # r2 -qe bin.strfilter=? -c '' --\n"
 		" RABIN2_STRPURGE:  e bin.strpurge     # try to purge false positives\n"
 		" RABIN2_DEBASE64:  e bin.debase64     # Try to debase64 all strings\n"
@@ -591,6 +592,10 @@ int main(int argc, char **argv) {
 		r_config_set (core.config, "bin.maxstrbuf", tmp);
 		free (tmp);
 	}
+	if ((tmp = r_sys_getenv ("RABIN2_STRJOBS"))) {
+		r_config_set (core.config, "bin.strjobs", tmp);
+		free (tmp);
+	}
 	if ((tmp = r_sys_getenv ("RABIN2_STRFILTER"))) {
 		r_config_set (core.config, "bin.strfilter", tmp);
 		free (tmp);
@@ -932,6 +937,7 @@ int main(int argc, char **argv) {
 	}
 	bin->minstrlen = r_config_get_i (core.config, "bin.minstr");
 	bin->maxstrbuf = r_config_get_i (core.config, "bin.maxstrbuf");
+	bin->strjobs = r_config_get_i (core.config, "bin.strjobs");
 
 	r_bin_force_plugin (bin, forcebin);
 	r_bin_load_filter (bin, action);
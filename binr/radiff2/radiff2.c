@@ -250,6 +250,7 @@ static int show_help(int v) {
 			"  -ss        compute text distance (using levenstein algorithm)\n"
 			"  -S [name]  sort code diff (name, namelen, addr, size, type, dist) (only for -C or -g)\n"
 			"  -t [0-100] set threshold for code diff (default is 70%%)\n"
+			"  -T [jobs]  threads comparing the functions for code diff (diff.jobs)\n"
 			"  -x         show two column hexdump diffing\n"
 			"  -u         unified output (---+++)\n"
 			"  -U         unified output using system 'diff'\n"
@@ -495,9 +496,10 @@ int main(int argc, char **argv) {
 	int mode = MODE_DIFF;
 	int diffops = 0;
 	int threshold = -1;
+	int jobs = 0;
 	double sim;
 
-	while ((o = getopt (argc, argv, "Aa:b:CDnpg:OijrhcdsS:uUvVxt:zq")) != -1) {
+	while ((o = getopt (argc, argv, "Aa:b:CDnpg:OijrhcdsS:uUvVxt:T:zq")) != -1) {
 		switch (o) {
 		case 'a':
 			arch = optarg;
@@ -537,6 +539,9 @@ int main(int argc, char **argv) {
 			threshold = atoi (optarg);
 			printf ("%s\n", optarg);
 			break;
+		case 'T':
+			jobs = atoi (optarg);
+			break;
 		case 'd':
 			delta = 1;
 			break;
@@ -626,6 +631,10 @@ int main(int argc, char **argv) {
 		r_config_set_i (c2->config, "diff.bare", showbare);
 		r_anal_diff_setup_i (c->anal, diffops, threshold, threshold);
 		r_anal_diff_setup_i (c2->anal, diffops, threshold, threshold);
+		if (jobs > 0) {
+			r_config_set_i (c->config, "diff.jobs", jobs);
+			r_config_set_i (c2->config, "diff.jobs", jobs);
+		}
 		if (pdc) {
 			if (!addr) {
 				addr = "entry0";
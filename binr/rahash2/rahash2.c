@@ -15,6 +15,8 @@ static ut64 to = 0LL;
 static int incremental = 1;
 static int iterations = 0;
 static int quiet = 0;
+static int threads = 1;
+static int treesize = 0;
 static RHashSeed s = {
 	0
 }, *_s = NULL;
@@ -90,6 +92,11 @@ static void do_hash_print(RHash *ctx, int hash, int dlen, int rad, int ule) {
 	char *o;
 	const ut8 *c = ctx->digest;
 	const char *hname = r_hash_name (hash);
+	char tname[32];
+	if (treesize) {
+		snprintf (tname, sizeof (tname), "%s-tree", hname);
+		hname = tname;
+	}
 	switch (rad) {
 	case 0:
 		if (!quiet) {
@@ -118,7 +125,24 @@ static void do_hash_print(RHash *ctx, int hash, int dlen, int rad, int ule) {
 	}
 }
 
+/* prints the digest in ctx, or e for the entropy */
+static void do_hash_result(RHash *ctx, int hash, int dlen, double e, int rad, int le) {
+	if (hash == R_HASH_ENTROPY) {
+		if (rad) {
+			eprintf ("entropy: %10f\n", e);
+		} else {
+			printf ("0x%08"PFMT64x "-0x%08"PFMT64x " %10f: ",
+				from, to > 0? to - 1: 0, e);
+			r_print_progressbar (NULL, 12.5 * e, 60);
+			printf ("\n");
+		}
+	} else {
+		do_hash_print (ctx, hash, dlen, rad, le);
+	}
+}
+
 static int do_hash_internal(RHash *ctx, int hash, const ut8 *buf, int len, int rad, int print, int le) {
+	double e = 0;
 	int dlen;
 	if (len < 0) {
 		return 0;
@@ -131,30 +155,214 @@ static int do_hash_internal(RHash *ctx, int hash, const ut8 *buf, int len, int r
 		return 1;
 	}
 	if (hash == R_HASH_ENTROPY) {
-		double e = r_hash_entropy (buf, len);
-		if (rad) {
-			eprintf ("entropy: %10f\n", e);
-		} else {
-			printf ("0x%08"PFMT64x "-0x%08"PFMT64x " %10f: ",
-				from, to > 0? to - 1: 0, e);
-			r_print_progressbar (NULL, 12.5 * e, 60);
-			printf ("\n");
+		e = r_hash_entropy (buf, len);
+	} else if (iterations > 0) {
+		r_hash_do_spice (ctx, hash, iterations, _s);
+	}
+	do_hash_result (ctx, hash, dlen, e, rad, le);
+	return 1;
+}
+
+/* -T: the blocks read from the file are hashed by a pool of threads.
+ * The file is still read by the main thread, a window of blocks at a
+ * time, and the results are printed in the same order as before. */
+
+#define HASH_WINDOW (64 * 1024 * 1024)
+
+typedef struct {
+	RHash *ctx;
+	int hash;
+} HashAlgo;
+
+typedef struct hash_jobs_t {
+	RThreadLock *lock;
+	void (*run)(struct hash_jobs_t *hj, int i);
+	int next;
+	int count;
+	const ut8 *buf;
+	int bsize;
+	/* run_algo: the window is len bytes hashed with every algo */
+	HashAlgo *algos;
+	int len;
+	/* run_block: the digest of each block of the window */
+	int hash;
+	int dlen;
+	ut64 at;
+	ut64 end; // blocks are cut here
+	bool leaf;
+	ut8 *digests;
+	double *entropy;
+} HashJobs;
+
+static void run_algo(HashJobs *hj, int i) {
+	HashAlgo *a = &hj->algos[i];
+	int off;
+	for (off = 0; off < hj->len; off += hj->bsize) {
+		int len = R_MIN (hj->bsize, hj->len - off);
+		r_hash_calculate (a->ctx, a->hash, hj->buf + off, len);
+	}
+}
+
+static void run_block(HashJobs *hj, int i) {
+	ut64 at = hj->at + (ut64)i * hj->bsize;
+	int len = R_MIN (hj->bsize, hj->end - at);
+	const ut8 *buf = hj->buf + (size_t)i * hj->bsize;
+	RHash *ctx = r_hash_new (true, hj->hash);
+	if (!ctx) {
+		return;
+	}
+	r_hash_calculate (ctx, hj->hash, buf, len);
+	if (!hj->leaf) {
+		if (hj->hash == R_HASH_ENTROPY) {
+			hj->entropy[i] = r_hash_entropy (buf, len);
+		} else if (iterations > 0) {
+			r_hash_do_spice (ctx, hj->hash, iterations, _s);
 		}
+	}
+	memcpy (hj->digests + (size_t)i * hj->dlen, ctx->digest, hj->dlen);
+	r_hash_free (ctx);
+}
+
+static int hash_worker(RThread *th) {
+	HashJobs *hj = th->user;
+	int i;
+	for (;;) {
+		r_th_lock_enter (hj->lock);
+		i = (hj->next < hj->count)? hj->next++: -1;
+		r_th_lock_leave (hj->lock);
+		if (i < 0) {
+			break;
+		}
+		hj->run (hj, i);
+	}
+	return 0;
+}
+
+/* runs the count jobs of hj and waits for them */
+static void hash_jobs_run(HashJobs *hj, int count) {
+	RThreadPool *pool = NULL;
+	hj->next = 0;
+	hj->count = count;
+	if (threads > 1 && count > 1) {
+		hj->lock = r_th_lock_new ();
+		pool = r_th_pool_new (R_MIN (threads, count), hash_worker, hj);
+	}
+	if (pool) {
+		r_th_pool_free (pool);
 	} else {
-		if (iterations > 0) {
-			r_hash_do_spice (ctx, hash, iterations, _s);
+		for (; hj->next < count; hj->next++) {
+			hj->run (hj, hj->next);
 		}
-		do_hash_print (ctx, hash, dlen, rad, le);
 	}
-	return 1;
+	r_th_lock_free (hj->lock);
+	hj->lock = NULL;
+}
+
+/* blocks of a window, it is always a multiple of the block size */
+static int hash_window_blocks(int bsize) {
+	return R_MAX (1, HASH_WINDOW / bsize);
+}
+
+/* -a with several algorithms, all of them are fed from the same reads */
+static void do_hash_algos(HashAlgo *algos, int nalgos, RIO *io, int bsize) {
+	HashJobs hj = {0};
+	int wsize = bsize * hash_window_blocks (bsize);
+	ut64 j;
+	ut8 *buf = malloc (wsize + 1);
+	if (!buf) {
+		return;
+	}
+	hj.run = run_algo;
+	hj.algos = algos;
+	hj.buf = buf;
+	hj.bsize = bsize;
+	for (j = from; j < to; j += wsize) {
+		hj.len = ((j + wsize) > to)? (to - j): wsize;
+		r_io_pread (io, j, buf, hj.len);
+		hash_jobs_run (&hj, nalgos);
+	}
+	free (buf);
+}
+
+/* -B, the per block digests are computed in parallel */
+static void do_hash_blocks(RHash *ctx, int hash, RIO *io, int bsize, ut64 fsize, int rad, int ule) {
+	int i, nblocks = hash_window_blocks (bsize);
+	ut64 j, ofrom = from, oto = to;
+	HashJobs hj = {0};
+	hj.run = run_block;
+	hj.hash = hash;
+	hj.dlen = r_hash_size (hash);
+	hj.bsize = bsize;
+	hj.end = fsize;
+	hj.buf = malloc ((size_t)nblocks * bsize + 1);
+	hj.digests = calloc (nblocks, hj.dlen);
+	hj.entropy = calloc (nblocks, sizeof (double));
+	if (!hj.buf || !hj.digests || !hj.entropy) {
+		goto beach;
+	}
+	for (j = ofrom; j < oto; j += (ut64)nblocks * bsize) {
+		int count = 0;
+		for (; count < nblocks && j + (ut64)count * bsize < oto; count++) {
+			r_io_pread (io, j + (ut64)count * bsize,
+				(ut8 *)hj.buf + (size_t)count * bsize, bsize);
+		}
+		hj.at = j;
+		hash_jobs_run (&hj, count);
+		for (i = 0; i < count; i++) {
+			from = j + (ut64)i * bsize;
+			to = R_MIN (from + bsize, fsize);
+			memcpy (ctx->digest, hj.digests + (size_t)i * hj.dlen, hj.dlen);
+			do_hash_result (ctx, hash, hj.dlen, hj.entropy[i], rad, ule);
+		}
+	}
+beach:
+	from = ofrom;
+	to = oto;
+	free ((ut8 *)hj.buf);
+	free (hj.digests);
+	free (hj.entropy);
+}
+
+/* -M, hash of the concatenated digests of every treesize bytes leaf */
+static void do_hash_tree(RHash *ctx, int hash, RIO *io) {
+	int nblocks = hash_window_blocks (treesize);
+	ut64 j, nleaves = (to - from + treesize - 1) / treesize;
+	ut8 *digests;
+	HashJobs hj = {0};
+	hj.run = run_block;
+	hj.hash = hash;
+	hj.dlen = r_hash_size (hash);
+	hj.bsize = treesize;
+	hj.end = to;
+	hj.leaf = true;
+	hj.buf = malloc ((size_t)nblocks * treesize + 1);
+	digests = calloc (R_MAX (nleaves, 1), hj.dlen);
+	if (!hj.buf || !digests) {
+		goto beach;
+	}
+	hj.digests = digests;
+	for (j = from; j < to; j += (ut64)nblocks * treesize) {
+		int count = R_MIN (nblocks, (to - j + treesize - 1) / treesize);
+		r_io_pread (io, j, (ut8 *)hj.buf, R_MIN ((ut64)count * treesize, to - j));
+		hj.at = j;
+		hash_jobs_run (&hj, count);
+		hj.digests += (size_t)count * hj.dlen;
+	}
+	r_hash_do_begin (ctx, hash);
+	r_hash_calculate (ctx, hash, digests, nleaves * hj.dlen);
+	r_hash_do_end (ctx, hash);
+beach:
+	free ((ut8 *)hj.buf);
+	free (digests);
 }
 
 static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int rad, int ule, const ut8 *compare) {
 	ut64 j, fsize, algobit = r_hash_name_to_bits (algo);
+	HashAlgo *algos = NULL;
 	RHash *ctx;
 	ut8 *buf;
 	int ret = 0;
-	int i, first = 1;
+	int i, n, nalgos = 0, first = 1;
 	if (algobit == R_HASH_NONE) {
 		eprintf ("rahash2: Invalid hashing algorithm specified\n");
 		return 1;
@@ -191,11 +399,32 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 		printf ("[");
 	}
 	if (incremental) {
-		for (i = 1; i < 0x800000; i <<= 1) {
+		if (treesize && s.buf) {
+			eprintf ("Warning: Seed ignored on tree hashing.\n");
+		}
+		if (threads > 1 && !treesize) {
+			/* every algorithm gets its own context and thread */
+			algos = calloc (R_HASH_NBITS, sizeof (HashAlgo));
+			for (i = 1; algos && i < 0x800000; i <<= 1) {
+				if (algobit & i) {
+					HashAlgo *a = &algos[nalgos++];
+					a->hash = i;
+					a->ctx = r_hash_new (true, i);
+					r_hash_do_begin (a->ctx, i);
+					if (s.buf && s.prefix) {
+						do_hash_internal (a->ctx,
+							i, s.buf, s.len, rad, 0, ule);
+					}
+				}
+			}
+			if (algos) {
+				do_hash_algos (algos, nalgos, io, bsize);
+			}
+		}
+		for (n = 0, i = 1; i < 0x800000; i <<= 1) {
 			if (algobit & i) {
 				int hashbit = i & algobit;
 				int dlen = r_hash_size (hashbit);
-				r_hash_do_begin (ctx, i);
 				if (rad == 'j') {
 					if (first) {
 						first = 0;
@@ -203,21 +432,34 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 						printf (",");
 					}
 				}
-				if (s.buf && s.prefix) {
-					do_hash_internal (ctx,
-						hashbit, s.buf, s.len, rad, 0, ule);
-				}
-				for (j = from; j < to; j += bsize) {
-					int len = ((j + bsize) > to)? (to - j): bsize;
-					r_io_pread (io, j, buf, len);
-					do_hash_internal (ctx, hashbit, buf,
-						len, rad, 0, ule);
-				}
-				if (s.buf && !s.prefix) {
-					do_hash_internal (ctx, hashbit, s.buf,
-						s.len, rad, 0, ule);
+				if (treesize) {
+					do_hash_tree (ctx, hashbit, io);
+				} else if (algos) {
+					RHash *actx = algos[n++].ctx;
+					if (s.buf && !s.prefix) {
+						do_hash_internal (actx, hashbit, s.buf,
+							s.len, rad, 0, ule);
+					}
+					r_hash_do_end (actx, i);
+					memcpy (ctx->digest, actx->digest, sizeof (ctx->digest));
+				} else {
+					r_hash_do_begin (ctx, i);
+					if (s.buf && s.prefix) {
+						do_hash_internal (ctx,
+							hashbit, s.buf, s.len, rad, 0, ule);
+					}
+					for (j = from; j < to; j += bsize) {
+						int len = ((j + bsize) > to)? (to - j): bsize;
+						r_io_pread (io, j, buf, len);
+						do_hash_internal (ctx, hashbit, buf,
+							len, rad, 0, ule);
+					}
+					if (s.buf && !s.prefix) {
+						do_hash_internal (ctx, hashbit, s.buf,
+							s.len, rad, 0, ule);
+					}
+					r_hash_do_end (ctx, i);
 				}
-				r_hash_do_end (ctx, i);
 				if (iterations > 0) {
 					r_hash_do_spice (ctx, i, iterations, _s);
 				}
@@ -237,6 +479,10 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 				}
 			}
 		}
+		for (n = 0; n < nalgos; n++) {
+			r_hash_free (algos[n].ctx);
+		}
+		free (algos);
 		if (_s) {
 			free (_s->buf);
 		}
@@ -249,6 +495,10 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 			ut64 f, t, ofrom, oto;
 			if (algobit & i) {
 				int hashbit = i & algobit;
+				if (threads > 1) {
+					do_hash_blocks (ctx, hashbit, io, bsize, fsize, rad, ule);
+					continue;
+				}
 				ofrom = from;
 				oto = to;
 				f = from;
@@ -279,7 +529,7 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 }
 
 static int do_help(int line) {
-	printf ("Usage: rahash2 [-rBhLkv] [-b S] [-a A] [-c H] [-E A] [-s S] [-f O] [-t O] [file] ...\n");
+	printf ("Usage: rahash2 [-rBhLkv] [-b S] [-a A] [-c H] [-E A] [-s S] [-f O] [-t O] [-T N] [-M S] [file] ...\n");
 	if (line) {
 		return 0;
 	}
@@ -299,9 +549,11 @@ static int do_help(int line) {
 		" -k          show hash using the openssh's randomkey algorithm\n"
 		" -q          run in quiet mode (-qq to show only the hash)\n"
 		" -L          list all available algorithms (see -a)\n"
+		" -M size     tree hash, digest of the digests of each leaf of this size\n"
 		" -r          output radare commands\n"
 		" -s string   hash this string instead of files\n"
 		" -t to       stop hashing at given address\n"
+		" -T threads  hash the algorithms, blocks or leaves in parallel\n"
 		" -x hexstr   hash this hexpair string instead of files\n"
 		" -v          show version information\n");
 	return 0;
@@ -451,7 +703,7 @@ int main(int argc, char **argv) {
 	RHash *ctx;
 	RIO *io;
 
-	while ((c = getopt (argc, argv, "jD:rveE:a:i:I:S:s:x:b:nBhf:t:kLqc:")) != -1) {
+	while ((c = getopt (argc, argv, "jD:rveE:a:i:I:S:s:x:b:nBhf:t:kLqc:T:M:")) != -1) {
 		switch (c) {
 		case 'q': quiet++; break;
 		case 'i':
@@ -481,9 +733,19 @@ int main(int argc, char **argv) {
 		case 's': setHashString (optarg, 0); break;
 		case 'x': setHashString (optarg, 1); break;
 		case 'c': compareStr = optarg; break;
+		case 'T': threads = (int) r_num_math (NULL, optarg); break;
+		case 'M': treesize = (int) r_num_math (NULL, optarg); break;
 		default: return do_help (0);
 		}
 	}
+	if (threads < 1) {
+		eprintf ("rahash2: Invalid number of threads\n");
+		return 1;
+	}
+	if (treesize < 0 || (treesize && !incremental)) {
+		eprintf ("rahash2: Option -M needs a leaf size and is incompatible with -B.\n");
+		return 1;
+	}
 	if (encrypt && decrypt) {
 		eprintf ("rahash2: Option -E and -D are incompatible with each other.\n");
 		return 1;
@@ -627,6 +889,10 @@ int main(int argc, char **argv) {
 				eprintf ("Invalid algorithm. See -E, -D maybe?\n");
 				return 1;
 			}
+			if (treesize) {
+				eprintf ("Warning: Tree hashing ignored on strings.\n");
+				treesize = 0;
+			}
 			for (i = 1; i < 0x800000; i <<= 1) {
 				if (algobit & i) {
 					int hashbit = i & algobit;
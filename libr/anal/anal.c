@@ -85,6 +85,7 @@ R_API RAnal *r_anal_new() {
 	(void)r_anal_xrefs_init (anal);
 	anal->diff_thbb = R_ANAL_THRESHOLDBB;
 	anal->diff_thfcn = R_ANAL_THRESHOLDFCN;
+	anal->diff_jobs = 1;
 	anal->split = true; // used from core
 	anal->syscall = r_syscall_new ();
 	r_io_bind_init (anal->iob);
@@ -95,9 +96,7 @@ R_API RAnal *r_anal_new() {
 	anal->bits_ranges = r_list_newf (free);
 	anal->lineswidth = 0;
 	anal->fcns = r_anal_fcn_list_new ();
-#if USE_NEW_FCN_STORE
-	anal->fcnstore = r_listrange_new ();
-#endif
+	anal->fcnstore = r_anal_fcnstore_new ();
 	anal->refs = r_anal_ref_list_new ();
 	anal->types = r_anal_type_list_new ();
 	r_anal_set_bits (anal, 32);
@@ -126,6 +125,9 @@ R_API RAnal *r_anal_free(RAnal *a) {
 	r_list_free (a->plugins);
 	a->fcns->free = r_anal_fcn_free;
 	r_list_free (a->fcns);
+	r_anal_fcnstore_free (a->fcnstore);
+	r_hashtable64_free (a->dict_refs);
+	r_hashtable64_free (a->dict_xrefs);
 	r_space_free (&a->meta_spaces);
 	r_space_free (&a->zign_spaces);
 	r_anal_pin_fini (a);
@@ -392,15 +394,12 @@ R_API int r_anal_purge (RAnal *anal) {
 	sdb_reset (anal->sdb_fcns);
 	sdb_reset (anal->sdb_meta);
 	sdb_reset (anal->sdb_hints);
-	sdb_reset (anal->sdb_xrefs);
+	r_anal_xrefs_init (anal);
 	sdb_reset (anal->sdb_types);
 	sdb_reset (anal->sdb_zigns);
 	r_list_free (anal->fcns);
 	anal->fcns = r_anal_fcn_list_new ();
-#if USE_NEW_FCN_STORE
-	r_listrange_free (anal->fcnstore);
-	anal->fcnstore = r_listrange_new ();
-#endif
+	r_anal_fcnstore_reindex (anal->fcnstore, anal->fcns);
 	r_list_free (anal->refs);
 	anal->refs = r_anal_ref_list_new ();
 	r_list_free (anal->types);
@@ -3,6 +3,7 @@
 #include <r_anal.h>
 #include <r_util.h>
 #include <r_diff.h>
+#include <r_th.h>
 
 R_API RAnalDiff *r_anal_diff_new() {
 	RAnalDiff *diff = R_NEW0 (RAnalDiff);
@@ -169,118 +170,569 @@ R_API bool r_anal_diff_bb(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2)
 	return true;
 }
 
-R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
-	RAnalFunction *fcn, *fcn2, *mfcn, *mfcn2;
-	RListIter *iter, *iter2;
-	ut64 maxsize, minsize;
-	double t, ot;
+/* function matching. The pairs of functions with the same name are
+ * scored first, then each remaining function of the first list takes
+ * the most similar unmatched one of the second. Only the candidates
+ * found by a locality sensitive index over the fingerprints are scored
+ * when comparing all the pairs would be too slow: minhashes of the
+ * shingles of each fingerprint grouped in bands, the whole fingerprint
+ * and the basic block count with the cyclomatic complexity. A pair
+ * sharing any band is scored. The scores are computed by diff_jobs threads. */
 
-	if (!anal) {
+#define DIFF_SHINGLE 4
+#define DIFF_HASHES 48
+#define DIFF_ROWS 3
+#define DIFF_BANDS (DIFF_HASHES / DIFF_ROWS)
+/* below this many pairs all of them are scored */
+#define DIFF_ALLPAIRS (1 << 16)
+/* bands shared by more functions than this tell nothing */
+#define DIFF_BUCKET_MAX 64
+
+typedef void (*DiffJobFn)(void *user, int i);
+
+typedef struct {
+	DiffJobFn fn;
+	void *user;
+	int count;
+	int next;
+	RThreadLock *lock;
+} DiffJobs;
+
+static int diff_worker(RThread *th) {
+	DiffJobs *dj = th->user;
+	int i;
+	for (;;) {
+		r_th_lock_enter (dj->lock);
+		i = (dj->next < dj->count)? dj->next++: -1;
+		r_th_lock_leave (dj->lock);
+		if (i < 0) {
+			break;
+		}
+		dj->fn (dj->user, i);
+	}
+	return 0;
+}
+
+/* calls fn for every i below count, split between jobs threads */
+static void diff_jobs_run(int jobs, int count, DiffJobFn fn, void *user) {
+	DiffJobs dj = { fn, user, count, 0, NULL };
+	RThreadPool *pool = NULL;
+	int i;
+	if (jobs > 1 && count > 1 && (dj.lock = r_th_lock_new ())) {
+		pool = r_th_pool_new (R_MIN (jobs, count), diff_worker, &dj);
+	}
+	if (pool) {
+		r_th_pool_free (pool);
+	} else {
+		for (i = 0; i < count; i++) {
+			fn (user, i);
+		}
+	}
+	r_th_lock_free (dj.lock);
+}
+
+static double diff_score(RAnalFunction *fcn, RAnalFunction *fcn2) {
+	double t = 0;
+	if (!r_diff_buffers_distance (NULL, fcn->fingerprint, r_anal_fcn_size (fcn),
+			fcn2->fingerprint, r_anal_fcn_size (fcn2), NULL, &t)) {
+		return 0;
+	}
+	return t;
+}
+
+static void diff_set_match(RAnalFunction *fcn, RAnalFunction *fcn2, double t, int type) {
+	fcn->diff->type = fcn2->diff->type = type;
+	fcn->diff->dist = fcn2->diff->dist = t;
+	R_FREE (fcn->fingerprint);
+	R_FREE (fcn2->fingerprint);
+	fcn->diff->addr = fcn2->addr;
+	fcn2->diff->addr = fcn->addr;
+	fcn->diff->size = r_anal_fcn_size (fcn2);
+	fcn2->diff->size = r_anal_fcn_size (fcn);
+	R_FREE (fcn->diff->name);
+	if (fcn2->name) {
+		fcn->diff->name = strdup (fcn2->name);
+	}
+	R_FREE (fcn2->diff->name);
+	if (fcn->name) {
+		fcn2->diff->name = strdup (fcn->name);
+	}
+}
+
+typedef struct {
+	RAnalFunction *fcn;
+	RAnalFunction *fcn2;
+	double t;
+} DiffPair;
+
+static void diff_pair_job(void *user, int i) {
+	DiffPair *p = (DiffPair *)user + i;
+	p->t = diff_score (p->fcn, p->fcn2);
+}
+
+static void kv_name_free(HtKv *kv) {
+	free (kv->key);
+	free (kv);
+}
+
+/* pairs each function with the first one of the same name */
+static void diff_by_name(RAnal *anal, RList *fcns, RList *fcns2) {
+	RAnalFunction *fcn, *fcn2, *any = NULL, **v2;
+	RListIter *iter;
+	DiffPair *pairs;
+	SdbHash *names;
+	int i, n = 0, n2 = 0, anyidx = -1;
+
+	v2 = calloc (R_MAX (r_list_length (fcns2), 1), sizeof (RAnalFunction *));
+	pairs = calloc (R_MAX (r_list_length (fcns), 1), sizeof (DiffPair));
+	names = ht_new (NULL, kv_name_free, NULL);
+	if (!v2 || !pairs || !names) {
+		goto beach;
+	}
+	r_list_foreach (fcns2, iter, fcn2) {
+		if (!fcn2->name) {
+			if (!any) {
+				any = fcn2;
+				anyidx = n2;
+			}
+		} else {
+			// keeps the first one
+			ht_insert (names, fcn2->name, (void *)(size_t)(n2 + 1));
+		}
+		v2[n2++] = fcn2;
+	}
+	if (!n2) {
+		goto beach;
+	}
+	r_list_foreach (fcns, iter, fcn) {
+		fcn2 = NULL;
+		if (!fcn->name) {
+			fcn2 = v2[0];
+		} else {
+			int at = (int)(size_t)ht_find (names, fcn->name, NULL) - 1;
+			if (at >= 0 && (anyidx < 0 || at < anyidx)) {
+				fcn2 = v2[at];
+			} else {
+				fcn2 = any;
+			}
+		}
+		if (fcn2) {
+			pairs[n].fcn = fcn;
+			pairs[n].fcn2 = fcn2;
+			n++;
+		}
+	}
+	diff_jobs_run (anal->diff_jobs, n, diff_pair_job, pairs);
+	for (i = 0; i < n; i++) {
+		/* Set flag in matched functions */
+		diff_set_match (pairs[i].fcn, pairs[i].fcn2, pairs[i].t, (pairs[i].t >= 1)
+			? R_ANAL_DIFF_TYPE_MATCH
+			: R_ANAL_DIFF_TYPE_UNMATCH);
+		r_anal_diff_bb (anal, pairs[i].fcn, pairs[i].fcn2);
+	}
+beach:
+	ht_free (names);
+	free (pairs);
+	free (v2);
+}
+
+typedef struct {
+	RAnal *anal;
+	RAnalFunction **a; // unmatched functions of the first list
+	int na;
+	RAnalFunction **b; // the ones of the second list they can take
+	int nb;
+	int *gid; // group of the functions of b with the same fingerprint
+	int *gfirst; // first function of b in each group
+	int *gnext; // next function of b in the same group
+	int ng;
+	ut32 *sig; // minhashes of a, then of the groups
+	int *cand; // candidate groups of each function of a
+	double *score;
+	int *candoff;
+} DiffIndex;
+
+typedef struct {
+	ut64 key;
+	int id; // < na for a, na + group otherwise
+} DiffBand;
+
+static inline ut64 diff_mix(ut64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static void diff_minhash(RAnalFunction *fcn, ut32 *sig) {
+	const ut8 *fp = fcn->fingerprint;
+	int size = r_anal_fcn_size (fcn);
+	int i, k, last = R_MAX (size - DIFF_SHINGLE, 0);
+	for (k = 0; k < DIFF_HASHES; k++) {
+		sig[k] = UT32_MAX;
+	}
+	if (!fp || size < 1) {
+		return;
+	}
+	for (i = 0; i <= last; i++) {
+		ut64 sh = 0;
+		for (k = 0; k < DIFF_SHINGLE && i + k < size; k++) {
+			sh = (sh << 8) | fp[i + k];
+		}
+		sh = diff_mix (sh);
+		for (k = 0; k < DIFF_HASHES; k++) {
+			ut32 h = (ut32)diff_mix (sh + k);
+			if (h < sig[k]) {
+				sig[k] = h;
+			}
+		}
+	}
+}
+
+static void diff_minhash_job(void *user, int i) {
+	DiffIndex *di = user;
+	RAnalFunction *fcn = (i < di->na)? di->a[i]: di->b[di->gfirst[i - di->na]];
+	diff_minhash (fcn, di->sig + (size_t)i * DIFF_HASHES);
+}
+
+static int band_cmp(const void *a, const void *b) {
+	const DiffBand *x = a, *y = b;
+	if (x->key != y->key) {
+		return (x->key < y->key)? -1: 1;
+	}
+	return x->id - y->id;
+}
+
+static int int_cmp(const void *a, const void *b) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/* same size and bytes */
+static bool diff_same(RAnalFunction *fcn, RAnalFunction *fcn2) {
+	int size = r_anal_fcn_size (fcn);
+	if (size != r_anal_fcn_size (fcn2)) {
 		return false;
 	}
-	if (anal->cur && anal->cur->diff_fcn) {
-		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+	if (!fcn->fingerprint || !fcn2->fingerprint) {
+		return fcn->fingerprint == fcn2->fingerprint;
 	}
-	/* Compare functions with the same name */
-	if (fcns) {
-		r_list_foreach (fcns, iter, fcn) {
-			r_list_foreach (fcns2, iter2, fcn2) {
-				if (fcn->name && fcn2->name && strcmp (fcn->name, fcn2->name)) {
-					continue;
+	return !memcmp (fcn->fingerprint, fcn2->fingerprint, size);
+}
+
+static ut64 diff_fphash(RAnalFunction *fcn) {
+	int size = r_anal_fcn_size (fcn);
+	ut64 h = diff_mix (size);
+	int i;
+	if (fcn->fingerprint) {
+		for (i = 0; i < size; i++) {
+			h = (h ^ fcn->fingerprint[i]) * 0x100000001b3ULL;
+		}
+	}
+	return diff_mix (h);
+}
+
+/* functions of b with the same fingerprint are scored once */
+static bool diff_groups(DiffIndex *di) {
+	DiffBand *keys = calloc (R_MAX (di->nb, 1), sizeof (DiffBand));
+	int *last;
+	int i, j;
+	di->gid = calloc (R_MAX (di->nb, 1), sizeof (int));
+	di->gfirst = calloc (R_MAX (di->nb, 1), sizeof (int));
+	di->gnext = calloc (R_MAX (di->nb, 1), sizeof (int));
+	last = calloc (R_MAX (di->nb, 1), sizeof (int));
+	if (!keys || !di->gid || !di->gfirst || !di->gnext || !last) {
+		free (keys);
+		free (last);
+		return false;
+	}
+	for (i = 0; i < di->nb; i++) {
+		keys[i].key = diff_fphash (di->b[i]);
+		keys[i].id = i;
+		di->gid[i] = -1;
+		di->gnext[i] = -1;
+	}
+	qsort (keys, di->nb, sizeof (DiffBand), band_cmp);
+	for (i = 0; i < di->nb; i = j) {
+		for (j = i + 1; j < di->nb && keys[j].key == keys[i].key; j++) {
+			;
+		}
+		/* the run is sorted by position, its first one starts a group */
+		int k, l;
+		for (k = i; k < j; k++) {
+			int at = keys[k].id;
+			if (di->gid[at] >= 0) {
+				continue;
+			}
+			di->gid[at] = di->ng;
+			di->gfirst[di->ng] = at;
+			last[di->ng] = at;
+			for (l = k + 1; l < j; l++) {
+				int at2 = keys[l].id;
+				if (di->gid[at2] < 0 && diff_same (di->b[at], di->b[at2])) {
+					di->gid[at2] = di->ng;
+					di->gnext[last[di->ng]] = at2;
+					last[di->ng] = at2;
 				}
-				r_diff_buffers_distance (NULL, fcn->fingerprint, r_anal_fcn_size (fcn),
-						fcn2->fingerprint, r_anal_fcn_size (fcn2),
-						NULL, &t);
-				/* Set flag in matched functions */
-				fcn->diff->type = fcn2->diff->type = (t >= 1)
-					? R_ANAL_DIFF_TYPE_MATCH
-					: R_ANAL_DIFF_TYPE_UNMATCH;
-				fcn->diff->dist = fcn2->diff->dist = t;
-				R_FREE (fcn->fingerprint);
-				R_FREE (fcn2->fingerprint);
-				fcn->diff->addr = fcn2->addr;
-				fcn2->diff->addr = fcn->addr;
-				fcn->diff->size = r_anal_fcn_size (fcn2);
-				fcn2->diff->size = r_anal_fcn_size (fcn);
-				R_FREE (fcn->diff->name);
-				if (fcn2->name) {
-					fcn->diff->name = strdup (fcn2->name);
+			}
+			di->ng++;
+		}
+	}
+	free (keys);
+	free (last);
+	return true;
+}
+
+static bool diff_add_cand(int **cand, int *ncand, int *cap, int g) {
+	if (*ncand == *cap) {
+		int size = *cap? *cap * 2: 8;
+		int *c = realloc (*cand, size * sizeof (int));
+		if (!c) {
+			return false;
+		}
+		*cand = c;
+		*cap = size;
+	}
+	(*cand)[(*ncand)++] = g;
+	return true;
+}
+
+/* candidate groups of each function of a, every group when there are
+ * few enough pairs, the ones sharing a band otherwise */
+static bool diff_candidates(DiffIndex *di) {
+	int **cand = calloc (R_MAX (di->na, 1), sizeof (int *));
+	int *ncand = calloc (R_MAX (di->na, 1), sizeof (int));
+	int *cap = calloc (R_MAX (di->na, 1), sizeof (int));
+	DiffBand *bands = NULL;
+	int i, j, k, n = di->na + di->ng, nbands = 0, total = 0;
+	bool ret = false;
+
+	if (!cand || !ncand || !cap) {
+		goto beach;
+	}
+	if ((ut64)di->na * di->ng <= DIFF_ALLPAIRS) {
+		for (i = 0; i < di->na; i++) {
+			for (j = 0; j < di->ng; j++) {
+				if (!diff_add_cand (&cand[i], &ncand[i], &cap[i], j)) {
+					goto beach;
 				}
-				R_FREE (fcn2->diff->name);
-				if (fcn->name) {
-					fcn2->diff->name = strdup (fcn->name);
+			}
+		}
+	} else {
+		di->sig = malloc ((size_t)n * DIFF_HASHES * sizeof (ut32));
+		bands = malloc ((size_t)n * (DIFF_BANDS + 2) * sizeof (DiffBand));
+		if (!di->sig || !bands) {
+			goto beach;
+		}
+		diff_jobs_run (di->anal->diff_jobs, n, diff_minhash_job, di);
+		for (i = 0; i < n; i++) {
+			RAnalFunction *fcn = (i < di->na)? di->a[i]: di->b[di->gfirst[i - di->na]];
+			const ut32 *sig = di->sig + (size_t)i * DIFF_HASHES;
+			for (j = 0; j < DIFF_BANDS; j++) {
+				ut64 key = diff_mix (j);
+				for (k = 0; k < DIFF_ROWS; k++) {
+					key = diff_mix (key ^ sig[j * DIFF_ROWS + k]);
 				}
-				r_anal_diff_bb (anal, fcn, fcn2);
-				break;
+				bands[nbands].key = key;
+				bands[nbands].id = i;
+				nbands++;
+			}
+			/* the same bytes always meet */
+			bands[nbands].key = diff_fphash (fcn);
+			bands[nbands].id = i;
+			nbands++;
+			if (!r_list_empty (fcn->bbs)) {
+				bands[nbands].key = diff_mix (diff_mix (DIFF_BANDS) ^
+					((ut64)r_list_length (fcn->bbs) << 32 | (ut32)r_anal_fcn_cc (fcn)));
+				bands[nbands].id = i;
+				nbands++;
 			}
 		}
+		qsort (bands, nbands, sizeof (DiffBand), band_cmp);
+		for (i = 0; i < nbands; i = j) {
+			int first2;
+			for (j = i; j < nbands && bands[j].key == bands[i].key; j++) {
+				;
+			}
+			/* the ids of a go first */
+			for (first2 = i; first2 < j && bands[first2].id < di->na; first2++) {
+				;
+			}
+			if (first2 == i || first2 == j || j - first2 > DIFF_BUCKET_MAX) {
+				continue;
+			}
+			for (k = i; k < first2; k++) {
+				int l, a = bands[k].id;
+				for (l = first2; l < j; l++) {
+					if (!diff_add_cand (&cand[a], &ncand[a], &cap[a], bands[l].id - di->na)) {
+						goto beach;
+					}
+				}
+			}
+		}
+		for (i = 0; i < di->na; i++) {
+			int u = 0;
+			qsort (cand[i], ncand[i], sizeof (int), int_cmp);
+			for (j = 0; j < ncand[i]; j++) {
+				if (!u || cand[i][u - 1] != cand[i][j]) {
+					cand[i][u++] = cand[i][j];
+				}
+			}
+			ncand[i] = u;
+		}
+	}
+	di->candoff = malloc ((di->na + 1) * sizeof (int));
+	if (!di->candoff) {
+		goto beach;
+	}
+	for (i = 0; i < di->na; i++) {
+		di->candoff[i] = total;
+		total += ncand[i];
+	}
+	di->candoff[di->na] = total;
+	di->cand = malloc (R_MAX (total, 1) * sizeof (int));
+	di->score = malloc (R_MAX (total, 1) * sizeof (double));
+	if (!di->cand || !di->score) {
+		goto beach;
+	}
+	for (i = 0; i < di->na; i++) {
+		if (ncand[i]) {
+			memcpy (di->cand + di->candoff[i], cand[i], ncand[i] * sizeof (int));
+		}
+	}
+	ret = true;
+beach:
+	if (cand) {
+		for (i = 0; i < di->na; i++) {
+			free (cand[i]);
+		}
+	}
+	free (cand);
+	free (ncand);
+	free (cap);
+	free (bands);
+	return ret;
+}
+
+static void diff_score_job(void *user, int i) {
+	DiffIndex *di = user;
+	RAnalFunction *fcn = di->a[i];
+	int j, size = r_anal_fcn_size (fcn);
+	for (j = di->candoff[i]; j < di->candoff[i + 1]; j++) {
+		RAnalFunction *fcn2 = di->b[di->gfirst[di->cand[j]]];
+		int size2 = r_anal_fcn_size (fcn2);
+		ut64 maxsize = R_MAX (size, size2);
+		ut64 minsize = R_MIN (size, size2);
+		di->score[j] = (maxsize * di->anal->diff_thfcn > minsize)
+			? 0: diff_score (fcn, fcn2);
+	}
+}
+
+static void diff_index_fini(DiffIndex *di) {
+	free (di->a);
+	free (di->b);
+	free (di->gid);
+	free (di->gfirst);
+	free (di->gnext);
+	free (di->sig);
+	free (di->cand);
+	free (di->score);
+	free (di->candoff);
+}
+
+/* each function takes the most similar one left, the first one in
+ * the list on ties */
+static bool diff_by_similarity(RAnal *anal, RList *fcns, RList *fcns2) {
+	RAnalFunction *fcn, *fcn2;
+	DiffIndex di = {0};
+	RListIter *iter;
+	bool *taken = NULL;
+	int i, j;
+
+	di.anal = anal;
+	di.a = calloc (R_MAX (r_list_length (fcns), 1), sizeof (RAnalFunction *));
+	di.b = calloc (R_MAX (r_list_length (fcns2), 1), sizeof (RAnalFunction *));
+	if (!di.a || !di.b) {
+		diff_index_fini (&di);
+		return false;
 	}
-	/* Compare remaining functions */
 	r_list_foreach (fcns, iter, fcn) {
-/*
-		if ((fcn->type != R_ANAL_FCN_TYPE_FCN &&
-			fcn->type != R_ANAL_FCN_TYPE_SYM) ||
-			fcn->diff->type != R_ANAL_DIFF_TYPE_NULL) {
-			continue;
+		if (fcn->diff->type == R_ANAL_DIFF_TYPE_NULL) {
+			di.a[di.na++] = fcn;
+		}
+	}
+	r_list_foreach (fcns2, iter, fcn2) {
+		if ((fcn2->type == R_ANAL_FCN_TYPE_FCN || fcn2->type == R_ANAL_FCN_TYPE_SYM) &&
+				fcn2->diff->type == R_ANAL_DIFF_TYPE_NULL) {
+			di.b[di.nb++] = fcn2;
 		}
-*/
+	}
+	if (!di.na || !di.nb) {
+		diff_index_fini (&di);
+		return true;
+	}
+	taken = calloc (di.nb, sizeof (bool));
+	if (!taken || !diff_groups (&di) || !diff_candidates (&di)) {
+		free (taken);
+		diff_index_fini (&di);
+		return false;
+	}
+	diff_jobs_run (anal->diff_jobs, di.na, diff_score_job, &di);
+	for (i = 0; i < di.na; i++) {
+		double ot = 0;
+		int m = -1;
+		fcn = di.a[i];
 		if (fcn->diff->type != R_ANAL_DIFF_TYPE_NULL) {
 			continue;
 		}
-		ot = 0;
-		mfcn = mfcn2 = NULL;
-		r_list_foreach (fcns2, iter2, fcn2) {
-			int fcn_size = r_anal_fcn_size (fcn);
-			int fcn2_size = r_anal_fcn_size (fcn2);
-			if (fcn_size > fcn2_size) {
-				maxsize = fcn_size;
-				minsize = fcn2_size;
-			} else {
-				maxsize = fcn2_size;
-				minsize = fcn_size;
+		for (j = di.candoff[i]; j < di.candoff[i + 1]; j++) {
+			double t = di.score[j];
+			int g = di.cand[j];
+			if (t <= anal->diff_thfcn || t < ot) {
+				continue;
 			}
-			if ((fcn2->type != R_ANAL_FCN_TYPE_FCN
-				&& fcn2->type != R_ANAL_FCN_TYPE_SYM) ||
-				fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL ||
-				(maxsize * anal->diff_thfcn > minsize)) {
+			/* the first one of the group not taken yet */
+			while (di.gfirst[g] >= 0 && taken[di.gfirst[g]]) {
+				di.gfirst[g] = di.gnext[di.gfirst[g]];
+			}
+			if (di.gfirst[g] < 0) {
 				continue;
 			}
-			r_diff_buffers_distance (NULL, fcn->fingerprint, fcn_size, fcn2->fingerprint, fcn2_size, NULL, &t);
-			fcn->diff->dist = fcn2->diff->dist = t;
-			if (t > anal->diff_thfcn && t > ot) {
+			if (t > ot || di.gfirst[g] < m) {
 				ot = t;
-				mfcn = fcn;
-				mfcn2 = fcn2;
-				if (t == 1) {
-					break;
-				}
+				m = di.gfirst[g];
 			}
 		}
-		if (mfcn && mfcn2) {
+		if (m >= 0) {
+			taken[m] = true;
 			/* Set flag in matched functions */
-			mfcn->diff->type = mfcn2->diff->type = (ot == 1)
+			diff_set_match (fcn, di.b[m], ot, (ot == 1)
 				? R_ANAL_DIFF_TYPE_MATCH
-				: R_ANAL_DIFF_TYPE_UNMATCH;
-			R_FREE (mfcn->fingerprint);
-			R_FREE (mfcn2->fingerprint);
-			mfcn->diff->addr = mfcn2->addr;
-			mfcn2->diff->addr = mfcn->addr;
-			mfcn->diff->size = r_anal_fcn_size (mfcn2);
-			mfcn2->diff->size = r_anal_fcn_size (mfcn);
-			R_FREE (mfcn->diff->name);
-			if (mfcn2->name) {
-				mfcn->diff->name = strdup (mfcn2->name);
-			}
-			R_FREE (mfcn2->diff->name);
-			if (mfcn->name) {
-				mfcn2->diff->name = strdup (mfcn->name);
-			}
-			r_anal_diff_bb (anal, mfcn, mfcn2);
+				: R_ANAL_DIFF_TYPE_UNMATCH);
+			r_anal_diff_bb (anal, fcn, di.b[m]);
 		}
 	}
+	free (taken);
+	diff_index_fini (&di);
 	return true;
 }
 
+R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
+	if (!anal) {
+		return false;
+	}
+	if (anal->cur && anal->cur->diff_fcn) {
+		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+	}
+	/* Compare functions with the same name */
+	if (fcns) {
+		diff_by_name (anal, fcns, fcns2);
+	}
+	/* Compare remaining functions */
+	return diff_by_similarity (anal, fcns, fcns2);
+}
+
 R_API int r_anal_diff_eval(RAnal *anal) {
 	if (anal && anal->cur && anal->cur->diff_eval) {
 		return (anal->cur->diff_eval (anal));
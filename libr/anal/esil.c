@@ -68,6 +68,8 @@ static bool popRN(RAnalEsil *esil, ut64 *n) {
 	return false;
 }
 
+static void esil_code_unref(void *data);
+
 /* R_ANAL_ESIL API */
 
 R_API RAnalEsil *r_anal_esil_new(int stacksize, int iotrap) {
@@ -87,6 +89,7 @@ R_API RAnalEsil *r_anal_esil_new(int stacksize, int iotrap) {
 	esil->stacksize = stacksize;
 	esil->parse_goto_count = R_ANAL_ESIL_GOTO_LIMIT;
 	esil->ops = sdb_new0 ();
+	esil->code = r_hashtable64_new (esil_code_unref);
 	esil->iotrap = iotrap;
 	esil->interrupts = sdb_new0 ();
 	return esil;
@@ -100,6 +103,8 @@ R_API int r_anal_esil_set_op(RAnalEsil *esil, const char *op, RAnalEsilOp code)
 	}
 	h = sdb_itoa (sdb_hash (op), t, 16);
 	sdb_num_set (esil->ops, h, (ut64)(size_t)code, 0);
+	// compiled expressions have their ops resolved already
+	r_hashtable64_clear (esil->code);
 	if (!sdb_num_exists (esil->ops, h)) {
 		eprintf ("can't set esil-op %s\n", op);
 		return false;
@@ -193,6 +198,8 @@ R_API void r_anal_esil_free(RAnalEsil *esil) {
 	}
 	sdb_free (esil->ops);
 	esil->ops = NULL;
+	r_hashtable64_free (esil->code);
+	esil->code = NULL;
 	sdb_free (esil->interrupts);
 	esil->interrupts = NULL;
 	sdb_free (esil->stats);
@@ -2399,38 +2406,19 @@ static int iscommand(RAnalEsil *esil, const char *word, RAnalEsilOp *op) {
 	return false;
 }
 
-static int runword(RAnalEsil *esil, const char *word) {
-	RAnalEsilOp op = NULL;
+static bool goto_count_check(RAnalEsil *esil) {
 	esil->parse_goto_count--;
 	if (esil->parse_goto_count < 1) {
 		ERR ("ESIL infinite loop detected\n");
 		esil->trap = 1;       // INTERNAL ERROR
 		esil->parse_stop = 1; // INTERNAL ERROR
-		return 0;
-	}
-
-	// Don't push anything onto stack when processing if statements
-	if (!strcmp (word, "?{") && esil->Reil) {
-		esil->Reil->skip = esil->Reil->skip? 0: 1;
-		if (esil->Reil->skip) {
-			esil->Reil->cmd_count = 0;
-			memset (esil->Reil->if_buf, 0, sizeof (esil->Reil->if_buf));
-		}
-	}
-
-	if (esil->Reil && esil->Reil->skip) {
-		int tmp_len = strlen (esil->Reil->if_buf);
-		strncat (esil->Reil->if_buf, word, sizeof (esil->Reil->if_buf) - tmp_len - 2);
-		strncat (esil->Reil->if_buf, ",", 1);
-		if (!strcmp (word, "}")) {
-			r_anal_esil_pushnum (esil, esil->Reil->addr + esil->Reil->cmd_count + 1);
-			r_anal_esil_parse (esil, esil->Reil->if_buf);
-			return 1;
-		}
-		if (iscommand (esil, word, &op)) esil->Reil->cmd_count++;
-		return 1;
+		return false;
 	}
+	return true;
+}
 
+/* runs a word whose op has been already looked up */
+static int runword_op(RAnalEsil *esil, const char *word, bool isop, RAnalEsilOp op) {
 	//eprintf ("WORD (%d) (%s)\n", esil->skip, word);
 	if (!strcmp (word, "}{")) {
 		esil->skip = esil->skip? 0: 1;
@@ -2443,7 +2431,7 @@ static int runword(RAnalEsil *esil, const char *word) {
 		return 1;
 	}
 
-	if (iscommand (esil, word, &op)) {
+	if (isop) {
 		// run action
 		if (op) {
 			if (esil->cb.hook_command) {
@@ -2468,6 +2456,38 @@ static int runword(RAnalEsil *esil, const char *word) {
 	return 1;
 }
 
+static int runword(RAnalEsil *esil, const char *word) {
+	RAnalEsilOp op = NULL;
+	bool isop;
+	if (!goto_count_check (esil)) {
+		return 0;
+	}
+
+	// Don't push anything onto stack when processing if statements
+	if (!strcmp (word, "?{") && esil->Reil) {
+		esil->Reil->skip = esil->Reil->skip? 0: 1;
+		if (esil->Reil->skip) {
+			esil->Reil->cmd_count = 0;
+			memset (esil->Reil->if_buf, 0, sizeof (esil->Reil->if_buf));
+		}
+	}
+
+	if (esil->Reil && esil->Reil->skip) {
+		int tmp_len = strlen (esil->Reil->if_buf);
+		strncat (esil->Reil->if_buf, word, sizeof (esil->Reil->if_buf) - tmp_len - 2);
+		strncat (esil->Reil->if_buf, ",", 1);
+		if (!strcmp (word, "}")) {
+			r_anal_esil_pushnum (esil, esil->Reil->addr + esil->Reil->cmd_count + 1);
+			r_anal_esil_parse (esil, esil->Reil->if_buf);
+			return 1;
+		}
+		if (iscommand (esil, word, &op)) esil->Reil->cmd_count++;
+		return 1;
+	}
+	isop = iscommand (esil, word, &op);
+	return runword_op (esil, word, isop, op);
+}
+
 static const char *gotoWord(const char *str, int n) {
 	const char *ostr = str;
 	int count = 0;
@@ -2518,7 +2538,187 @@ static int evalWord(RAnalEsil *esil, const char *ostr, const char **str) {
 	return 3;
 }
 
-R_API int r_anal_esil_parse(RAnalEsil *esil, const char *str) {
+/* compiled expressions. Every expression is split once into its words
+ * with the ops already resolved, so running it again only walks them.
+ * The cache is keyed by the expression (same bytes, same expression)
+ * and entries are refcounted because ops may reenter the parser.
+ *
+ * This only skips the tokenizer and the ops lookup, the operands are
+ * not resolved here: the stack holds strings, and the ops pass register
+ * names to hook_reg_read and hook_reg_write, which the debugger and the
+ * emulation hooks rely on. A RRegItem kept here would also dangle after
+ * r_reg_set_profile. Resolving them needs a typed stack first. */
+
+typedef struct {
+	char *word; // NULL if too long to be a valid word
+	RAnalEsilOp op;
+	bool isop;
+	bool term; // followed by ';'
+	int off;
+} EsilWord;
+
+typedef struct {
+	char *str;
+	EsilWord *words;
+	int count;
+	int refs;
+} EsilCode;
+
+static void esil_code_unref(void *data) {
+	EsilCode *c = data;
+	int i;
+	if (!c || --c->refs > 0) {
+		return;
+	}
+	for (i = 0; i < c->count; i++) {
+		free (c->words[i].word);
+	}
+	free (c->words);
+	free (c->str);
+	free (c);
+}
+
+/* empty words are handled by the tokenizer in odd ways, leave them to it */
+static bool esil_compilable(const char *str) {
+	if (*str == ',' || *str == ';') {
+		return false;
+	}
+	for (; *str; str++) {
+		if ((*str == ',' || *str == ';') && (str[1] == ',' || str[1] == ';')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static EsilCode *esil_compile(RAnalEsil *esil, const char *str) {
+	const char *p;
+	EsilCode *c = R_NEW0 (EsilCode);
+	int len, n = 1;
+	if (!c) {
+		return NULL;
+	}
+	for (p = str; *p; p++) {
+		if (*p == ',' || *p == ';') {
+			n++;
+		}
+	}
+	c->str = strdup (str);
+	c->words = calloc (n, sizeof (EsilWord));
+	c->refs = 1;
+	if (!c->str || !c->words) {
+		esil_code_unref (c);
+		return NULL;
+	}
+	for (p = str; *p; p += len + (p[len]? 1: 0)) {
+		EsilWord *w = &c->words[c->count++];
+		len = strcspn (p, ",;");
+		w->off = p - str;
+		w->term = p[len] == ';';
+		// same limit as the 64 byte word buffer of the tokenizer
+		if (len > 63 || (len == 63 && p[len])) {
+			break;
+		}
+		w->word = r_str_ndup (p, len);
+		if (!w->word) {
+			esil_code_unref (c);
+			return NULL;
+		}
+		w->isop = iscommand (esil, w->word, &w->op);
+	}
+	return c;
+}
+
+static EsilCode *esil_code_get(RAnalEsil *esil, const char *str) {
+	ut64 h = r_str_hash64 (str);
+	EsilCode *c = r_hashtable64_lookup (esil->code, h);
+	if (c && !strcmp (c->str, str)) {
+		c->refs++;
+		return c;
+	}
+	if (!esil_compilable (str) || !(c = esil_compile (esil, str))) {
+		return NULL;
+	}
+	if (esil->code->count >= R_ANAL_ESIL_CODE_CACHE) {
+		r_hashtable64_clear (esil->code);
+	}
+	if (r_hashtable64_update (esil->code, h, c)) {
+		c->refs++;
+	}
+	return c;
+}
+
+static int esil_code_word_at(EsilCode *c, int off) {
+	int lo = 0, hi = c->count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (c->words[mid].off < off) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* same control flow as the tokenizer loop and evalWord () below */
+static int esil_code_run(RAnalEsil *esil, EsilCode *c) {
+	const char *s;
+	int i;
+	esil->trap = 0;
+loop:
+	esil->repeat = 0;
+	esil->skip = 0;
+	esil->parse_goto = -1;
+	esil->parse_stop = 0;
+	if (esil->anal) {
+		esil->parse_goto_count = esil->anal->esil_goto_limit;
+	} else {
+		esil->parse_goto_count = R_ANAL_ESIL_GOTO_LIMIT;
+	}
+	for (i = 0; i < c->count;) {
+		EsilWord *w = &c->words[i];
+		if (!w->word) {
+			ERR ("Invalid esil string");
+			return -1;
+		}
+		if (!goto_count_check (esil)) {
+			return 0;
+		}
+		if (!runword_op (esil, w->word, w->isop, w->op)) {
+			return 0;
+		}
+		if (esil->repeat) {
+			goto loop;
+		}
+		if (esil->parse_goto != -1) {
+			s = gotoWord (c->str, esil->parse_goto);
+			if (!s) {
+				if (esil->verbose) {
+					eprintf ("Cannot find word %d\n", esil->parse_goto);
+				}
+				return 0;
+			}
+			esil->parse_goto = -1;
+			i = esil_code_word_at (c, s - c->str);
+			continue;
+		}
+		if (esil->parse_stop) {
+			if (esil->parse_stop == 2) {
+				s = c->str + w->off + strlen (w->word);
+				eprintf ("ESIL TODO: %s\n", *s? s + 1: s);
+			}
+			return 0;
+		}
+		if (w->term) {
+			return 0;
+		}
+		i++;
+	}
+	return 1;
+}
+
+static int esil_parse_words(RAnalEsil *esil, const char *str) {
 	int wordi = 0;
 	int dorunword;
 	char word[64];
@@ -2591,6 +2791,21 @@ repeat:
 	return 1;
 }
 
+R_API int r_anal_esil_parse(RAnalEsil *esil, const char *str) {
+	EsilCode *c;
+	int ret;
+	if (!esil || !str || !*str) {
+		return 0;
+	}
+	// reil translation needs to see every word go through the tokenizer
+	if (esil->Reil || !esil->code || !(c = esil_code_get (esil, str))) {
+		return esil_parse_words (esil, str);
+	}
+	ret = esil_code_run (esil, c);
+	esil_code_unref (c);
+	return ret;
+}
+
 //frees all elements from the stack, not the stack itself
 //rename to stack_empty() ?
 R_API void r_anal_esil_stack_free(RAnalEsil *esil) {
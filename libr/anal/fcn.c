@@ -64,6 +64,7 @@ static void update_tinyrange_bbs(RAnalFunction *fcn) {
 	r_list_foreach (fcn->bbs, iter, bb) {
 		r_tinyrange_add (&fcn->bbr, bb->addr, bb->addr + bb->size);
 	}
+	r_anal_fcnstore_update (fcn);
 }
 
 R_API int r_anal_fcn_resize(RAnalFunction *fcn, int newsize) {
@@ -135,6 +136,7 @@ R_API void r_anal_fcn_free(void *_fcn) {
 	if (!_fcn) {
 		return;
 	}
+	r_anal_fcnstore_del (fcn);
 	fcn->_size = 0;
 	free (fcn->name);
 	free (fcn->attr);
@@ -1258,12 +1260,9 @@ R_API int r_anal_fcn_insert(RAnal *anal, RAnalFunction *fcn) {
 	if (f) {
 		return false;
 	}
-#if USE_NEW_FCN_STORE
-	r_listrange_add (anal->fcnstore, fcn);
-	// HUH? store it here .. for backweird compatibility
-#endif
 	/* TODO: sdbization */
 	r_list_append (anal->fcns, fcn);
+	r_anal_fcnstore_add (anal->fcnstore, fcn);
 	if (anal->cb.on_fcn_new) {
 		anal->cb.on_fcn_new (anal, anal->user, fcn);
 	}
@@ -1315,9 +1314,6 @@ R_API int r_anal_fcn_del_locs(RAnal *anal, ut64 addr) {
 	RListIter *iter, *iter2;
 	RAnalFunction *fcn, *f = r_anal_get_fcn_in (anal, addr,
 		R_ANAL_FCN_TYPE_ROOT);
-#if USE_NEW_FCN_STORE
-#warning TODO: r_anal_fcn_del_locs not implemented for newstore
-#endif
 	if (!f) {
 		return false;
 	}
@@ -1335,23 +1331,12 @@ R_API int r_anal_fcn_del_locs(RAnal *anal, ut64 addr) {
 
 R_API int r_anal_fcn_del(RAnal *a, ut64 addr) {
 	if (addr == UT64_MAX) {
-#if USE_NEW_FCN_STORE
-		r_listrange_free (a->fcnstore);
-		a->fcnstore = r_listrange_new ();
-#else
 		r_list_free (a->fcns);
 		if (!(a->fcns = r_anal_fcn_list_new ())) {
 			return false;
 		}
-#endif
+		r_anal_fcnstore_reindex (a->fcnstore, a->fcns);
 	} else {
-#if USE_NEW_FCN_STORE
-		// XXX: must only get the function if starting at 0?
-		RAnalFunction *f = r_listrange_find_in_range (a->fcnstore, addr);
-		if (f) {
-			r_listrange_del (a->fcnstore, f);
-		}
-#else
 		RAnalFunction *fcni;
 		RListIter *iter, *iter_tmp;
 		r_list_foreach_safe (a->fcns, iter, iter_tmp, fcni) {
@@ -1362,37 +1347,53 @@ R_API int r_anal_fcn_del(RAnal *a, ut64 addr) {
 				r_list_delete (a->fcns, iter);
 			}
 		}
-#endif
 	}
 	return true;
 }
 
+typedef struct {
+	ut64 addr;
+	int type;
+} FcnQuery;
+
+static bool filter_root(RIntervalNode *node, void *user) {
+	FcnQuery *q = user;
+	RAnalFunction *fcn = node->data;
+	return fcn->addr == q->addr && (!q->type || (fcn->type & q->type));
+}
+
+static bool filter_in(RIntervalNode *node, void *user) {
+	FcnQuery *q = user;
+	RAnalFunction *fcn = node->data;
+	if (q->type && !(fcn->type & q->type)) {
+		return false;
+	}
+	return fcn->addr == q->addr || r_anal_fcn_is_in_offset (fcn, q->addr);
+}
+
+static bool filter_in_bounds(RIntervalNode *node, void *user) {
+	FcnQuery *q = user;
+	RAnalFunction *fcn = node->data;
+	return (!q->type || (fcn->type & q->type)) && r_anal_fcn_in (fcn, q->addr);
+}
+
+/* first (or last) function in anal->fcns order passing filter at addr */
+static RAnalFunction *fcn_find(RAnal *anal, ut64 addr, int type, RIntervalIterCb filter, bool last) {
+	RIntervalNode *node;
+	FcnQuery q = { addr, type };
+	if (last) {
+		node = r_interval_tree_last_intersect (&anal->fcnstore->bounds, addr, addr, filter, &q);
+	} else {
+		node = r_interval_tree_first_intersect (&anal->fcnstore->bounds, addr, addr, filter, &q);
+	}
+	return node? node->data: NULL;
+}
+
 R_API RAnalFunction *r_anal_get_fcn_in(RAnal *anal, ut64 addr, int type) {
-#if USE_NEW_FCN_STORE
-	// TODO: type is ignored here? wtf.. we need more work on fcnstore
-	// if (root) return r_listrange_find_root (anal->fcnstore, addr);
-	return r_listrange_find_in_range (anal->fcnstore, addr);
-#else
-	RAnalFunction *fcn, *ret = NULL;
-	RListIter *iter;
 	if (type == R_ANAL_FCN_TYPE_ROOT) {
-		r_list_foreach (anal->fcns, iter, fcn) {
-			if (addr == fcn->addr) {
-				return fcn;
-			}
-		}
-		return NULL;
+		return fcn_find (anal, addr, 0, filter_root, false);
 	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn && fcn->type & type)) {
-			if (fcn->addr == addr || (!ret && r_anal_fcn_is_in_offset (fcn, addr))) {
-				ret = fcn;
-				break;
-			}
-		}
-	}
-	return ret;
-#endif
+	return fcn_find (anal, addr, type, filter_in, false);
 }
 
 R_API bool r_anal_fcn_in(RAnalFunction *fcn, ut64 addr) {
@@ -1400,31 +1401,10 @@ R_API bool r_anal_fcn_in(RAnalFunction *fcn, ut64 addr) {
 }
 
 R_API RAnalFunction *r_anal_get_fcn_in_bounds(RAnal *anal, ut64 addr, int type) {
-#if USE_NEW_FCN_STORE
-#warning TODO: r_anal_get_fcn_in_bounds
-	// TODO: type is ignored here? wtf.. we need more work on fcnstore
-	// if (root) return r_listrange_find_root (anal->fcnstore, addr);
-	return r_listrange_find_in_range (anal->fcnstore, addr);
-#else
-	RAnalFunction *fcn, *ret = NULL;
-	RListIter *iter;
 	if (type == R_ANAL_FCN_TYPE_ROOT) {
-		r_list_foreach (anal->fcns, iter, fcn) {
-			if (addr == fcn->addr) {
-				return fcn;
-			}
-		}
-		return NULL;
-	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn && fcn->type & type)) {
-			if (r_anal_fcn_in (fcn, addr)) {
-				return fcn;
-			}
-		}
+		return fcn_find (anal, addr, 0, filter_root, false);
 	}
-	return ret;
-#endif
+	return fcn_find (anal, addr, type, filter_in_bounds, false);
 }
 
 R_API RAnalFunction *r_anal_fcn_find_name(RAnal *anal, const char *name) {
@@ -1624,43 +1604,15 @@ R_API int r_anal_str_to_fcn(RAnal *a, RAnalFunction *f, const char *sig) {
 }
 
 R_API RAnalFunction *r_anal_get_fcn_at(RAnal *anal, ut64 addr, int type) {
-#if USE_NEW_FCN_STORE
-	// TODO: type is ignored here? wtf.. we need more work on fcnstore
-	// if (root) return r_listrange_find_root (anal->fcnstore, addr);
-	return r_listrange_find_root (anal->fcnstore, addr);
-#else
-	RAnalFunction *fcn, *ret = NULL;
-	RListIter *iter;
 	if (type == R_ANAL_FCN_TYPE_ROOT) {
-		r_list_foreach (anal->fcns, iter, fcn) {
-			if (addr == fcn->addr) {
-				return fcn;
-			}
-		}
-		return NULL;
-	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn->type & type)) {
-			if (addr == fcn->addr) {
-				ret = fcn;
-			}
-		}
+		return fcn_find (anal, addr, 0, filter_root, false);
 	}
-	return ret;
-#endif
+	return fcn_find (anal, addr, type, filter_root, true);
 }
 
 R_API RAnalFunction *r_anal_fcn_next(RAnal *anal, ut64 addr) {
-	RAnalFunction *fcni;
-	RListIter *iter;
-	RAnalFunction *closer = NULL;
-	r_list_foreach (anal->fcns, iter, fcni) {
-		// if (fcni->addr == addr)
-		if (fcni->addr > addr && (!closer || fcni->addr < closer->addr)) {
-			closer = fcni;
-		}
-	}
-	return closer;
+	RIntervalNode *node = r_interval_tree_next (&anal->fcnstore->entries, addr);
+	return node? node->data: NULL;
 }
 
 /* getters */
@@ -1691,14 +1643,15 @@ R_API int r_anal_fcn_is_in_offset(RAnalFunction *fcn, ut64 addr) {
 	return false;
 }
 
+static bool count_cb(RIntervalNode *node, void *user) {
+	(*(int *)user)++;
+	return true;
+}
+
 R_API int r_anal_fcn_count(RAnal *anal, ut64 from, ut64 to) {
 	int n = 0;
-	RAnalFunction *fcni;
-	RListIter *iter;
-	r_list_foreach (anal->fcns, iter, fcni) {
-		if (fcni->addr >= from && fcni->addr < to) {
-			n++;
-		}
+	if (from < to) {
+		r_interval_tree_all_intersect (&anal->fcnstore->entries, from, to - 1, count_cb, &n);
 	}
 	return n;
 }
@@ -1732,6 +1685,7 @@ R_API bool r_anal_fcn_bbadd(RAnalFunction *fcn, RAnalBlock *bb) {
 R_API void r_anal_fcn_set_size(RAnalFunction *fcn, ut32 size) {
 	if (fcn) {
 		fcn->_size = size;
+		r_anal_fcnstore_update (fcn);
 	}
 }
 
@@ -1,125 +1,114 @@
-/* radare - LGPL - Copyright 2011 -- pancake<nopcode.org> */
-/* this file contains a test implementation of the ~O(1) function search */
+/* radare - LGPL - Copyright 2011-2017 - pancake */
 
-// TODO: REFACTOR: This must be a generic data structure named RListRange
-// TODO: We need a standard struct named Surface1D {.addr, .size}, so we can
-// simplify all this by just passing the offset of the field of the given ptr
-// TODO: RListComparator does not supports *user
-// TODO: RRef - reference counting
+/* address index of the analyzed functions. anal->fcns is still the
+ * owner of the functions, the store only keeps two interval trees
+ * pointing to them so lookups by address are O(log n). Every function
+ * remembers its nodes, so the bounds are refreshed from the setters
+ * which grow it and the nodes are dropped when it is freed. */
 
-#define RANGEBITS 10
-// 1024
-#define RANGE (1<<RANGEBITS)
 #include <r_anal.h>
-#if USE_NEW_FCN_STORE
 
-#define STROFF(x) sdb_fmt (4, "flg.%"PFMT64x, x)
-
-static int cmpfun(void *a, void *b) {
-	RAnalFunction *fa = (RAnalFunction*)a;
-	RAnalFunction *fb = (RAnalFunction*)b;
-	// TODO: swap sort order here or wtf?
-	return (fb->addr - fa->addr);
-}
-
-static void listrange_free_kv(HtKv *kv) {
-	free (kv->key);
-	r_list_free (kv->value);
-	free (kv);
+/* range covering the entrypoint, the size and the basic blocks */
+static void fcn_bounds(RAnalFunction *f, ut64 *start, ut64 *end) {
+	ut64 from = f->addr;
+	ut64 to = f->addr + r_anal_fcn_size (f);
+	int i;
+	if (to < from) {
+		to = from;
+	}
+	for (i = 0; i < f->bbr.pairs; i++) {
+		from = R_MIN (from, f->bbr.ranges[i * 2]);
+		to = R_MAX (to, f->bbr.ranges[i * 2 + 1]);
+	}
+	*start = from;
+	// the entrypoint is always in, even for empty functions
+	*end = R_MAX ((to > from)? to - 1: from, f->addr);
 }
 
-R_API RListRange* r_listrange_new () {
-	RListRange *s = R_NEW (RListRange);
-	s->h = ht_new (NULL, listrange_free_kv, NULL);
-	//s->l shouldn't free is a helper structure to get data in order
-	//s->h will free the list that contains RAnalFunction
-	s->l = r_list_new ();
+R_API RAnalFcnStore *r_anal_fcnstore_new() {
+	RAnalFcnStore *s = R_NEW0 (RAnalFcnStore);
+	if (!s) {
+		return NULL;
+	}
+	r_interval_tree_init (&s->bounds, NULL);
+	r_interval_tree_init (&s->entries, NULL);
 	return s;
 }
 
-static inline ut64 r_listrange_next(ut64 addr) {
-	return (addr + RANGE);
+static bool fcn_unlink_cb(RIntervalNode *node, void *user) {
+	RAnalFunction *f = node->data;
+	f->_store = NULL;
+	f->_bnode = NULL;
+	f->_enode = NULL;
+	return true;
 }
 
-R_API void r_listrange_free(RListRange *s) {
-	if (!s) {
-		return;
-	}
-	ht_free (s->h);
-	r_list_free (s->l);
-	free (s);
+static void fcnstore_clear(RAnalFcnStore *s) {
+	r_interval_tree_foreach (&s->entries, fcn_unlink_cb, NULL);
+	r_interval_tree_fini (&s->bounds);
+	r_interval_tree_fini (&s->entries);
 }
 
-R_API void r_listrange_add(RListRange *s, RAnalFunction *f) {
-	ut64 addr;
-	RList *list;
-	ut64 from = f->addr;
-	ut64 to = f->addr + f->size;
-	for (addr = from; addr < to; addr = r_listrange_next (addr)) {
-		char *key = STROFF (addr);
-		list = ht_find (s->h, key, NULL);
-		if (list) {
-			if (!r_list_contains (list, f)) {
-				r_list_append (list, f);
-			}
-		} else {
-			list = r_list_new ((RListFree)r_anal_fcn_free);
-			r_list_append (list, f);
-			ht_insert (s->h, key, list);
-		}
+R_API void r_anal_fcnstore_free(RAnalFcnStore *s) {
+	if (s) {
+		fcnstore_clear (s);
+		free (s);
 	}
-	r_list_add_sorted (s->l, f, cmpfun);
 }
 
-R_API void r_listrange_del(RListRange *s, RAnalFunction *f) {
-	RList *list;
-	ut64 addr, from, to;
-	if (!f) return;
-	from = f->addr;
-	to = f->addr + f->size;
-	for (addr = from; addr < to; addr = r_listrange_next (addr)) {
-		list = ht_find (s->h, STROFF (addr), NULL);
-		if (list) {
-			r_list_delete_data (list, f);
-		}
+R_API bool r_anal_fcnstore_add(RAnalFcnStore *s, RAnalFunction *f) {
+	ut64 start, end;
+	if (!s || !f) {
+		return false;
+	}
+	if (f->_store) {
+		r_anal_fcnstore_del (f);
+	}
+	fcn_bounds (f, &start, &end);
+	f->_bnode = r_interval_tree_insert (&s->bounds, start, end, f);
+	f->_enode = r_interval_tree_insert (&s->entries, f->addr, f->addr, f);
+	if (!f->_bnode || !f->_enode) {
+		r_interval_tree_delete (&s->bounds, f->_bnode, false);
+		r_interval_tree_delete (&s->entries, f->_enode, false);
+		f->_bnode = f->_enode = NULL;
+		return false;
 	}
-	r_list_delete_data (s->l, f);
+	f->_store = s;
+	return true;
 }
 
-R_API void r_listrange_resize(RListRange *s, RAnalFunction *f, int newsize) {
-	if (!f) {
+R_API void r_anal_fcnstore_del(RAnalFunction *f) {
+	if (!f || !f->_store) {
 		return;
 	}
-	r_listrange_del (s, f);
-	f->size = newsize;
-	r_listrange_add (s, f);
+	r_interval_tree_delete (&f->_store->bounds, f->_bnode, false);
+	r_interval_tree_delete (&f->_store->entries, f->_enode, false);
+	f->_store = NULL;
+	f->_bnode = NULL;
+	f->_enode = NULL;
 }
 
-R_API RAnalFunction *r_listrange_find_in_range(RListRange* s, ut64 addr) {
-	RAnalFunction *f;
-	RListIter *iter;
-	RList *list = ht_find (s->h, STROFF (addr), NULL);
-	if (list) {
-		r_list_foreach (list, iter, f) {
-			if (R_BETWEEN (f->addr, addr, f->addr + f->_size))
-				return f;
-		}
+/* must be called after changing the address, size or blocks of f */
+R_API void r_anal_fcnstore_update(RAnalFunction *f) {
+	ut64 start, end;
+	if (!f || !f->_store) {
+		return;
 	}
-	return NULL;
+	fcn_bounds (f, &start, &end);
+	r_interval_tree_resize (&f->_store->bounds, f->_bnode, start, end);
+	r_interval_tree_resize (&f->_store->entries, f->_enode, f->addr, f->addr);
 }
 
-R_API RAnalFunction *r_listrange_find_root(RListRange* s, ut64 addr) {
+/* rebuild the store following the order of fcns, lookups returning
+ * the first match among overlapping functions depend on it */
+R_API void r_anal_fcnstore_reindex(RAnalFcnStore *s, RList *fcns) {
 	RAnalFunction *f;
 	RListIter *iter;
-	RList *list = ht_find (s->h, STROFF (addr), NULL);
-	if (list) {
-		r_list_foreach (list, iter, f) {
-			if (addr == f->addr) {
-				return f;
-			}
-		}
+	if (!s) {
+		return;
+	}
+	fcnstore_clear (s);
+	r_list_foreach (fcns, iter, f) {
+		r_anal_fcnstore_add (s, f);
 	}
-	return NULL;
 }
-
-#endif
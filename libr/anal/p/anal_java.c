@@ -600,8 +600,8 @@ static int java_analyze_fns_from_buffer( RAnal *anal, ut64 start, ut64 end, int
 			// XXX - TO Stop or not to Stop ??
 			break;
 		}
-		//r_listrange_add (anal->fcnstore, fcn);
 		r_list_append (anal->fcns, fcn);
+		r_anal_fcnstore_add (anal->fcnstore, fcn);
 		offset += r_anal_fcn_size (fcn);
 		if (!analyze_all) break;
 	}
@@ -650,8 +650,8 @@ static int java_analyze_fns( RAnal *anal, ut64 start, ut64 end, int reftype, int
 						eprintf ("Failed to parse java fn: %s @ 0x%04"PFMT64x"\n", fcn->name, fcn->addr);
 						// XXX - TO Stop or not to Stop ??
 					}
-					//r_listrange_add (anal->fcnstore, fcn);
 					r_list_append (anal->fcns, fcn);
+					r_anal_fcnstore_add (anal->fcnstore, fcn);
 				}
 			} // End of methods loop
 		}// end of methods_list is valid conditional
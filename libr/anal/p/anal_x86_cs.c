@@ -181,7 +181,7 @@ static bool is_xmm_reg(cs_x86_op op) {
  * @return         Pointer to esil operand in static array
  */
 static char *getarg(struct Getarg* gop, int n, int set, char *setop, int sel) {
-	static char buf[AR_DIM][BUF_SZ];
+	static R_TH_LOCAL char buf[AR_DIM][BUF_SZ];
 	char *out = buf[sel];
 	char *setarg = setop ? setop : "";
 	cs_insn *insn = gop->insn;
@@ -295,7 +295,16 @@ static char *getarg(struct Getarg* gop, int n, int set, char *setop, int sel) {
 	return NULL;
 }
 
-static csh handle = 0;
+/* capstone handles can't be shared by threads, each one opens its own
+ * so analop () can run from several at once (see anal.jobs) */
+static R_TH_LOCAL csh handle = 0;
+
+static void handle_close(void *user) {
+	if (handle) {
+		cs_close (&handle);
+		handle = 0;
+	}
+}
 
 static int cond_x862r2(int id) {
 	switch (id) {
@@ -2421,9 +2430,10 @@ static int cs_len_prefix_opcode(uint8_t *item) {
 }
 
 static int analop(RAnal *a, RAnalOp *op, ut64 addr, const ut8 *buf, int len) {
-	static int omode = 0;
+	static R_TH_LOCAL int omode = 0;
+	static R_TH_LOCAL bool closing = false;
 #if USE_ITER_API
-	static
+	static R_TH_LOCAL
 #endif
 	cs_insn *insn = NULL;
 	int mode = (a->bits==64)? CS_MODE_64:
@@ -2442,6 +2452,10 @@ static int analop(RAnal *a, RAnalOp *op, ut64 addr, const ut8 *buf, int len) {
 			handle = 0;
 			return 0;
 		}
+		if (!closing) {
+			// the workers of anal.jobs close theirs when they end
+			closing = r_th_atexit (handle_close, NULL);
+		}
 	}
 	memset (op, '\0', sizeof (RAnalOp));
 	op->cycles = 1; // aprox
@@ -2965,6 +2979,7 @@ RAnalPlugin r_anal_plugin_x86_cs = {
 	.name = "x86",
 	.desc = "Capstone X86 analysis",
 	.esil = true,
+	.reentrant = true,
 	.license = "BSD",
 	.arch = "x86",
 	.bits = 16|32|64,
@@ -774,6 +774,7 @@ RAnalPlugin r_anal_plugin_x86_udis = {
 	.license = "LGPL3",
 	.arch = "x86",
 	.esil = true,
+	.reentrant = true,
 	.bits = 16|32|64,
 	.op = &x86_udis86_op,
 	.set_reg_profile = &set_reg_profile,
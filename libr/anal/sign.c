@@ -13,7 +13,11 @@ const char *getRealRef(RCore *core, ut64 off) {
 	RListIter *iter = NULL;
 	RList *list = NULL;
 
-	list = ht_find (core->flags->ht_off, sdb_fmt (2, "flg.%"PFMT64x, off), NULL);
+	char key[64];
+
+	// no sdb_fmt, the index matches the functions from many threads
+	snprintf (key, sizeof (key), "flg.%"PFMT64x, off);
+	list = ht_find (core->flags->ht_off, key, NULL);
 	if (!list) {
 		return NULL;
 	}
@@ -1011,6 +1015,295 @@ R_API bool r_sign_match_refs(RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallbac
 	return r_sign_foreach (a, refsMatchCB, &ctx);
 }
 
+static void itemFini(RSignItem *item) {
+	free (item->name);
+	if (item->bytes) {
+		free (item->bytes->bytes);
+		free (item->bytes->mask);
+		free (item->bytes);
+	}
+	free (item->graph);
+	r_list_free (item->refs);
+}
+
+/* the zignatures deserialized once for matching many functions. The
+ * ones with all the graph metrics set are found by them, the others
+ * are compared one by one. Buckets keep the order of the items, which
+ * is the one r_sign_foreach walks them in. */
+
+static void kvBucketFree(HtKv *kv) {
+	free (kv->key);
+	r_list_free (kv->value);
+	free (kv);
+}
+
+static void graphKey(char *k, int size, int cc, int nbbs, int edges, int ebbs) {
+	snprintf (k, size, "%d,%d,%d,%d", cc, nbbs, edges, ebbs);
+}
+
+static char *refsKey(RList *refs) {
+	RListIter *iter = NULL;
+	char *k = NULL, *ref = NULL;
+	int i = 0;
+
+	r_list_foreach (refs, iter, ref) {
+		if (i++ > 0) {
+			k = r_str_appendch (k, ',');
+		}
+		k = r_str_append (k, ref);
+	}
+
+	return k? k: strdup ("");
+}
+
+static bool bucketAdd(SdbHash *ht, const char *k, RSignItem *it) {
+	RList *bucket = ht_find (ht, k, NULL);
+
+	if (!bucket) {
+		bucket = r_list_new ();
+		if (!bucket) {
+			return false;
+		}
+		ht_insert (ht, k, bucket);
+	}
+
+	return r_list_append (bucket, it) != NULL;
+}
+
+struct ctxIndexCB {
+	RAnal *anal;
+	RSignIndex *si;
+	int size;
+};
+
+static int indexCB(void *user, const char *k, const char *v) {
+	struct ctxIndexCB *ctx = (struct ctxIndexCB *) user;
+	RSignIndex *si = ctx->si;
+	RAnal *a = ctx->anal;
+	RSignItem *it;
+
+	if (si->count == ctx->size) {
+		int size = ctx->size? ctx->size * 2: 64;
+		RSignItem *items = realloc (si->items, size * sizeof (RSignItem));
+		if (!items) {
+			return 0;
+		}
+		si->items = items;
+		ctx->size = size;
+	}
+
+	it = &si->items[si->count];
+	memset (it, 0, sizeof (RSignItem));
+	it->offset = UT64_MAX;
+	it->space = -1;
+
+	if (!deserialize (a, it, k, v)) {
+		eprintf ("error: cannot deserialize zign\n");
+		itemFini (it);
+		return 1;
+	}
+
+	if (a->zign_spaces.space_idx != it->space && a->zign_spaces.space_idx != -1) {
+		itemFini (it);
+		return 1;
+	}
+
+	si->count++;
+
+	return 1;
+}
+
+R_API RSignIndex *r_sign_index_new(RAnal *a) {
+	struct ctxIndexCB ctx = { a, NULL, 0 };
+	char k[R_SIGN_KEY_MAXSZ];
+	RSignIndex *si = NULL;
+	RSignItem *it = NULL;
+	int i = 0;
+
+	if (!a) {
+		return NULL;
+	}
+
+	si = R_NEW0 (RSignIndex);
+	if (!si) {
+		return NULL;
+	}
+	ctx.si = si;
+
+	si->graph = ht_new (NULL, kvBucketFree, NULL);
+	si->graph_any = r_list_new ();
+	si->offset = ht_new (NULL, kvBucketFree, NULL);
+	si->refs = ht_new (NULL, kvBucketFree, NULL);
+	if (!si->graph || !si->graph_any || !si->offset || !si->refs) {
+		goto fail;
+	}
+
+	// the buckets point into the items once they stop moving
+	if (!sdb_foreach (a->sdb_zigns, indexCB, &ctx)) {
+		goto fail;
+	}
+
+	for (i = 0; i < si->count; i++) {
+		it = &si->items[i];
+		if (it->graph) {
+			RSignGraph *graph = it->graph;
+			if (graph->cc == -1 || graph->nbbs == -1 ||
+			    graph->edges == -1 || graph->ebbs == -1) {
+				if (!r_list_append (si->graph_any, it)) {
+					goto fail;
+				}
+			} else {
+				graphKey (k, sizeof (k), graph->cc, graph->nbbs, graph->edges, graph->ebbs);
+				if (!bucketAdd (si->graph, k, it)) {
+					goto fail;
+				}
+			}
+		}
+		if (it->offset != UT64_MAX) {
+			snprintf (k, sizeof (k), "%"PFMT64x, it->offset);
+			if (!bucketAdd (si->offset, k, it)) {
+				goto fail;
+			}
+		}
+		if (it->refs) {
+			char *rk = refsKey (it->refs);
+			bool ok = rk && bucketAdd (si->refs, rk, it);
+			free (rk);
+			if (!ok) {
+				goto fail;
+			}
+		}
+	}
+
+	return si;
+
+fail:
+	r_sign_index_free (si);
+
+	return NULL;
+}
+
+R_API void r_sign_index_free(RSignIndex *si) {
+	int i = 0;
+
+	if (!si) {
+		return;
+	}
+
+	ht_free (si->graph);
+	r_list_free (si->graph_any);
+	ht_free (si->offset);
+	ht_free (si->refs);
+	for (i = 0; i < si->count; i++) {
+		itemFini (&si->items[i]);
+	}
+	free (si->items);
+
+	free (si);
+}
+
+static bool graphCmp(RSignGraph *graph, int cc, int nbbs, int edges, int ebbs) {
+	return (graph->cc == -1 || graph->cc == cc) &&
+		(graph->nbbs == -1 || graph->nbbs == nbbs) &&
+		(graph->edges == -1 || graph->edges == edges) &&
+		(graph->ebbs == -1 || graph->ebbs == ebbs);
+}
+
+R_API bool r_sign_index_match_graph(RSignIndex *si, RAnalFunction *fcn, int mincc, RSignGraphMatchCallback cb, void *user) {
+	RListIter *iter = NULL, *iter2 = NULL;
+	char k[R_SIGN_KEY_MAXSZ];
+	RList *bucket = NULL;
+	RSignItem *it = NULL;
+	int cc, nbbs, edges, ebbs = 0;
+
+	if (!si || !fcn || !cb) {
+		return false;
+	}
+
+	cc = r_anal_fcn_cc (fcn);
+	nbbs = r_list_length (fcn->bbs);
+	edges = r_anal_fcn_count_edges (fcn, &ebbs);
+	graphKey (k, sizeof (k), cc, nbbs, edges, ebbs);
+	bucket = ht_find (si->graph, k, NULL);
+
+	// merge both lists in the order of the items
+	iter = bucket? bucket->head: NULL;
+	iter2 = si->graph_any->head;
+	while (iter || iter2) {
+		if (iter && (!iter2 || (RSignItem *) iter->data < (RSignItem *) iter2->data)) {
+			it = iter->data;
+			iter = iter->n;
+		} else {
+			it = iter2->data;
+			iter2 = iter2->n;
+			if (!graphCmp (it->graph, cc, nbbs, edges, ebbs)) {
+				continue;
+			}
+		}
+		if (it->graph->cc < mincc) {
+			continue;
+		}
+		if (!cb (it, fcn, user)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+R_API bool r_sign_index_match_offset(RSignIndex *si, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user) {
+	RListIter *iter = NULL;
+	char k[R_SIGN_KEY_MAXSZ];
+	RList *bucket = NULL;
+	RSignItem *it = NULL;
+
+	if (!si || !fcn || !cb) {
+		return false;
+	}
+
+	snprintf (k, sizeof (k), "%"PFMT64x, fcn->addr);
+	bucket = ht_find (si->offset, k, NULL);
+	r_list_foreach (bucket, iter, it) {
+		if (!cb (it, fcn, user)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+R_API bool r_sign_index_match_refs(RSignIndex *si, RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user) {
+	RListIter *iter = NULL;
+	RList *refs = NULL, *bucket = NULL;
+	RSignItem *it = NULL;
+	char *k = NULL;
+	bool retval = true;
+
+	if (!si || !fcn || !cb) {
+		return false;
+	}
+
+	refs = r_sign_fcn_refs (a, fcn);
+	if (!refs) {
+		return true;
+	}
+	k = refsKey (refs);
+	r_list_free (refs);
+	if (!k) {
+		return false;
+	}
+
+	bucket = ht_find (si->refs, k, NULL);
+	r_list_foreach (bucket, iter, it) {
+		if (!cb (it, fcn, user)) {
+			retval = false;
+			break;
+		}
+	}
+	free (k);
+
+	return retval;
+}
 
 R_API RSignItem *r_sign_item_new() {
 	RSignItem *ret = R_NEW0 (RSignItem);
@@ -1061,14 +1354,7 @@ R_API void r_sign_item_free(RSignItem *item) {
 		return;
 	}
 
-	free (item->name);
-	if (item->bytes) {
-		free (item->bytes->bytes);
-		free (item->bytes->mask);
-		free (item->bytes);
-	}
-	free (item->graph);
-	r_list_free (item->refs);
+	itemFini (item);
 
 	free (item);
 }
@@ -1,11 +1,37 @@
-/* radare - LGPL - Copyright 2009-2016 - pancake, nibble */
+/* radare - LGPL - Copyright 2009-2017 - pancake, nibble */
 
 #include <r_anal.h>
 #include <r_cons.h>
 #include <sdb.h>
 
+/* xrefs live in two hashtables keyed by address, dict_refs maps every
+ * source to its targets and dict_xrefs every target to its sources,
+ * both in insertion order. sdb_xrefs keeps the string format used by
+ * the projects and is only rebuilt from them when someone needs it. */
+
 #define DB anal->sdb_xrefs
 
+/* index the addresses of a vector once it grows past this */
+#define VEC_INDEX_MIN 16
+
+typedef struct {
+	ut64 *addr;
+	ut8 *type;
+	int len;
+	int size;
+	RHashTable64 *index; // addr -> mask of type_bit ()
+} XrefVec;
+
+/* the order in which the types are listed */
+static const RAnalRefType ref_types[] = {
+	R_ANAL_REF_TYPE_NULL,
+	R_ANAL_REF_TYPE_CODE,
+	R_ANAL_REF_TYPE_CALL,
+	R_ANAL_REF_TYPE_DATA,
+	R_ANAL_REF_TYPE_STRING
+};
+#define REF_TYPES (sizeof (ref_types) / sizeof (ref_types[0]))
+
 static const char *analref_toString(RAnalRefType type) {
 	switch (type) {
 	case R_ANAL_REF_TYPE_NULL:
@@ -29,90 +55,255 @@ static void XREFKEY(char * const key, const size_t key_len,
 	snprintf (key, key_len, "%s.%s.0x%"PFMT64x, kind, _sdb_type, addr);
 }
 
-R_API bool r_anal_xrefs_save(RAnal *anal, const char *prjDir) {
-	char *xrefs_path = r_str_newf ("%s" R_SYS_DIR "xrefs.sdb", prjDir);
-	sdb_file (anal->sdb_xrefs, xrefs_path);
-	free (xrefs_path);
-	return sdb_sync (anal->sdb_xrefs);
+static size_t type_bit(RAnalRefType type) {
+	size_t i;
+	for (i = 0; i < REF_TYPES; i++) {
+		if (ref_types[i] == type) {
+			return 1 << i;
+		}
+	}
+	return 0;
 }
 
-R_API int r_anal_xrefs_set (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to) {
-	char key[33];
-	if (!anal || !DB) {
+static void vec_free(void *p) {
+	XrefVec *v = p;
+	if (v) {
+		r_hashtable64_free (v->index);
+		free (v->addr);
+		free (v->type);
+		free (v);
+	}
+}
+
+static XrefVec *vec_get(RHashTable64 *ht, ut64 addr, bool create) {
+	XrefVec *v = r_hashtable64_lookup (ht, addr);
+	if (v || !create) {
+		return v;
+	}
+	v = R_NEW0 (XrefVec);
+	if (v && !r_hashtable64_insert (ht, addr, v)) {
+		R_FREE (v);
+	}
+	return v;
+}
+
+static bool vec_has(XrefVec *v, ut64 addr, RAnalRefType type) {
+	int i;
+	if (v->index) {
+		size_t mask = (size_t)r_hashtable64_lookup (v->index, addr);
+		return (mask & type_bit (type)) != 0;
+	}
+	for (i = 0; i < v->len; i++) {
+		if (v->addr[i] == addr && v->type[i] == type) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void vec_index_set(XrefVec *v, ut64 addr, size_t mask) {
+	if (mask) {
+		r_hashtable64_update (v->index, addr, (void *)mask);
+	} else {
+		r_hashtable64_remove (v->index, addr);
+	}
+}
+
+static bool vec_add(XrefVec *v, ut64 addr, RAnalRefType type) {
+	int i;
+	if (vec_has (v, addr, type)) {
+		return false;
+	}
+	if (v->len == v->size) {
+		int size = v->size? v->size * 2: 4;
+		ut64 *a = realloc (v->addr, size * sizeof (ut64));
+		ut8 *t = a? realloc (v->type, size): NULL;
+		if (a) {
+			v->addr = a;
+		}
+		if (!t) {
+			return false;
+		}
+		v->type = t;
+		v->size = size;
+	}
+	v->addr[v->len] = addr;
+	v->type[v->len] = type;
+	v->len++;
+	if (v->index) {
+		size_t mask = (size_t)r_hashtable64_lookup (v->index, addr);
+		vec_index_set (v, addr, mask | type_bit (type));
+	} else if (v->len > VEC_INDEX_MIN) {
+		v->index = r_hashtable64_new (NULL);
+		for (i = 0; v->index && i < v->len; i++) {
+			size_t mask = (size_t)r_hashtable64_lookup (v->index, v->addr[i]);
+			vec_index_set (v, v->addr[i], mask | type_bit (v->type[i]));
+		}
+	}
+	return true;
+}
+
+static bool vec_del(XrefVec *v, ut64 addr, RAnalRefType type) {
+	int i;
+	for (i = 0; i < v->len; i++) {
+		if (v->addr[i] == addr && v->type[i] == type) {
+			break;
+		}
+	}
+	if (i == v->len) {
+		return false;
+	}
+	memmove (v->addr + i, v->addr + i + 1, (v->len - i - 1) * sizeof (ut64));
+	memmove (v->type + i, v->type + i + 1, v->len - i - 1);
+	v->len--;
+	if (v->index) {
+		size_t mask = (size_t)r_hashtable64_lookup (v->index, addr);
+		vec_index_set (v, addr, mask & ~type_bit (type));
+	}
+	return true;
+}
+
+static void xref_changed(RAnal *anal, RAnalRefType type, ut64 from, ut64 to, bool add) {
+	if (anal->cb.on_xref) {
+		RAnalRef ref = { type, to, from };
+		anal->cb.on_xref (anal, anal->user, &ref, add);
+	}
+}
+
+static bool xref_add(RAnal *anal, RAnalRefType type, ut64 from, ut64 to) {
+	XrefVec *refs = vec_get (anal->dict_refs, from, true);
+	XrefVec *xrefs = vec_get (anal->dict_xrefs, to, true);
+	if (!refs || !xrefs) {
 		return false;
 	}
+	if (vec_add (refs, to, type)) {
+		vec_add (xrefs, from, type);
+		anal->xrefs_dirty = true;
+		xref_changed (anal, type, from, to, true);
+	}
+	return true;
+}
+
+static bool xref_valid(RAnal *anal, RAnalRefType type, ut64 to) {
 	if (!anal->iob.is_valid_offset (anal->iob.io, to, 0)) {
 		return false;
 	}
 	// unknown refs should not be stored. seems wrong
-	if (type == R_ANAL_REF_TYPE_NULL) {
+	return type != R_ANAL_REF_TYPE_NULL;
+}
+
+R_API int r_anal_xrefs_set (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to) {
+	if (!anal || !anal->dict_refs) {
 		return false;
 	}
-	XREFKEY (key, sizeof (key), "ref", type, from);
-	sdb_array_add_num (DB, key, to, 0);
-	XREFKEY (key, sizeof (key), "xref", type, to);
-	sdb_array_add_num (DB, key, from, 0);
-	return true;
+	if (!xref_valid (anal, type, to)) {
+		return false;
+	}
+	return xref_add (anal, type, from, to);
+}
+
+/* adds a batch of refs (at -> addr), returns how many were accepted */
+R_API int r_anal_xrefs_set_n(RAnal *anal, const RAnalRef *refs, int count) {
+	int i, n = 0;
+	if (!anal || !anal->dict_refs || !refs) {
+		return 0;
+	}
+	for (i = 0; i < count; i++) {
+		if (xref_valid (anal, refs[i].type, refs[i].addr)
+				&& xref_add (anal, refs[i].type, refs[i].at, refs[i].addr)) {
+			n++;
+		}
+	}
+	return n;
 }
 
 R_API int r_anal_xrefs_deln (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to) {
-	char key[33];
-	if (!anal || !DB) {
+	XrefVec *v;
+	if (!anal || !anal->dict_refs) {
 		return false;
 	}
-	XREFKEY (key, sizeof (key), "ref", type, from);
-	sdb_array_remove_num (DB, key, to, 0);
-	XREFKEY (key, sizeof (key), "xref", type, to);
-	sdb_array_remove_num (DB, key, from, 0);
+	if ((v = vec_get (anal->dict_refs, from, false))) {
+		if (vec_del (v, to, type)) {
+			xref_changed (anal, type, from, to, false);
+		}
+		if (!v->len) {
+			r_hashtable64_remove (anal->dict_refs, from);
+		}
+	}
+	if ((v = vec_get (anal->dict_xrefs, to, false))) {
+		vec_del (v, from, type);
+		if (!v->len) {
+			r_hashtable64_remove (anal->dict_xrefs, to);
+		}
+	}
+	anal->xrefs_dirty = true;
 	return true;
 }
 
-static int _type = -1;
-static RList *_list = NULL;
-static char *_kpfx = NULL;
+typedef struct {
+	RList *list;
+	RAnalRefType type;
+} XrefsAny;
 
-static int xrefs_list_cb_any(RAnal *anal, const char *k, const char *v) {
-	//ut64 dst, src = r_num_get (NULL, v);
-	if (!strncmp (_kpfx, k, strlen (_kpfx))) {
-		RAnalRef *ref = r_anal_ref_new ();
-		if (ref) {
-			ref->addr = r_num_get (NULL, k + strlen (_kpfx) + 1);
-			ref->at = r_num_get (NULL, v); // XXX
-			ref->type = _type;
-			r_list_append (_list, ref);
+static bool xrefs_any_cb(void *user, ut64 key, void *data) {
+	XrefsAny *xa = user;
+	XrefVec *v = data;
+	RAnalRef *ref;
+	int i;
+	for (i = 0; i < v->len; i++) {
+		if (v->type[i] == xa->type) {
+			break;
 		}
 	}
+	if (i < v->len && (ref = r_anal_ref_new ())) {
+		ref->addr = key;
+		ref->at = v->addr[i];
+		ref->type = xa->type;
+		r_list_append (xa->list, ref);
+	}
 	return true;
 }
 
+static int ref_cmp(const void *a, const void *b) {
+	const RAnalRef *ra = a, *rb = b;
+	return (ra->addr > rb->addr) - (ra->addr < rb->addr);
+}
+
 R_API int r_anal_xrefs_from (RAnal *anal, RList *list, const char *kind, const RAnalRefType type, ut64 addr) {
-	char *next, *s, *str, *ptr, key[256];
-	RAnalRef *ref = NULL;
+	RHashTable64 *ht = strcmp (kind, "ref")? anal->dict_xrefs: anal->dict_refs;
+	RAnalRef *ref;
+	XrefVec *v;
+	int i;
+	bool found = false;
 	if (addr == UT64_MAX) {
-		_type = type;
-		_list = list;
-		_kpfx = r_str_newf ("xref.%s", analref_toString (type));
-		sdb_foreach (DB, (SdbForeachCallback)xrefs_list_cb_any, anal);
-		free (_kpfx);
+		// every target of the given type with its first source
+		XrefsAny xa = { r_list_newf (NULL), type };
+		if (!xa.list) {
+			return false;
+		}
+		r_hashtable64_foreach (anal->dict_xrefs, xrefs_any_cb, &xa);
+		r_list_sort (xa.list, ref_cmp);
+		r_list_join (list, xa.list);
+		r_list_free (xa.list);
 		return true;
 	}
-	XREFKEY(key, sizeof (key), kind, type, addr);
-	str = sdb_get (DB, key, 0);
-	if (!str) {
+	if (!(v = vec_get (ht, addr, false))) {
 		return false;
 	}
-	for (next = ptr = str; next; ptr = next) {
-		s = sdb_anext (ptr, &next);
+	for (i = 0; i < v->len; i++) {
+		if (v->type[i] != type) {
+			continue;
+		}
 		if (!(ref = r_anal_ref_new ())) {
 			return false;
 		}
-		ref->addr = r_num_get (NULL, s);
+		ref->addr = v->addr[i];
 		ref->at = addr;
 		ref->type = type;
 		r_list_append (list, ref);
+		found = true;
 	}
-	free (str);
-	return true;
+	return found;
 }
 
 R_API RList *r_anal_xrefs_get (RAnal *anal, ut64 to) {
@@ -171,6 +362,17 @@ R_API RList *r_anal_xrefs_get_from (RAnal *anal, ut64 to) {
 
 R_API bool r_anal_xrefs_init(RAnal *anal) {
 	sdb_reset (DB);
+	if (anal->dict_refs) {
+		r_hashtable64_clear (anal->dict_refs);
+		r_hashtable64_clear (anal->dict_xrefs);
+		if (anal->cb.on_xref) {
+			anal->cb.on_xref (anal, anal->user, NULL, false);
+		}
+	} else {
+		anal->dict_refs = r_hashtable64_new (vec_free);
+		anal->dict_xrefs = r_hashtable64_new (vec_free);
+	}
+	anal->xrefs_dirty = false;
 	if (DB) {
 		sdb_array_set (DB, "types", -1, "code.jmp,code.call,data.mem,data.string", 0);
 		return true;
@@ -178,63 +380,219 @@ R_API bool r_anal_xrefs_init(RAnal *anal) {
 	return false;
 }
 
-static int xrefs_list_cb_rad(RAnal *anal, const char *k, const char *v) {
-	ut64 dst, src = r_num_get (NULL, v);
-	if (!strncmp (k, "ref.", 4)) {
-		const char *p = r_str_rchr (k, NULL, '.');
-		if (p) {
-			dst = r_num_get (NULL, p + 1);
-			anal->cb_printf ("ax 0x%"PFMT64x" 0x%"PFMT64x"\n", src, dst);
+static bool keys_cb(void *user, ut64 key, void *data) {
+	ut64 **p = user;
+	*(*p)++ = key;
+	return true;
+}
+
+static int addr_cmp(const void *a, const void *b) {
+	ut64 x = *(const ut64 *)a, y = *(const ut64 *)b;
+	return (x > y) - (x < y);
+}
+
+/* addresses of the table in ascending order */
+static ut64 *sorted_keys(RHashTable64 *ht, int *count) {
+	ut64 *keys, *p;
+	*count = ht? ht->count: 0;
+	if (!*count || !(keys = malloc (*count * sizeof (ut64)))) {
+		*count = 0;
+		return NULL;
+	}
+	p = keys;
+	r_hashtable64_foreach (ht, keys_cb, &p);
+	qsort (keys, *count, sizeof (ut64), addr_cmp);
+	return keys;
+}
+
+typedef void (*XrefsKeyCb)(RAnal *anal, const char *k, const char *v, void *user);
+
+/* walks the store as the sdb keys it stands for */
+static void xrefs_foreach_key(RAnal *anal, const char *kind, RHashTable64 *ht, XrefsKeyCb cb, void *user) {
+	char key[64], num[SDB_NUM_BUFSZ];
+	RStrBuf *sb = r_strbuf_new (NULL);
+	int i, j, n;
+	size_t t;
+	ut64 *keys = sorted_keys (ht, &n);
+	for (i = 0; sb && i < n; i++) {
+		XrefVec *v = r_hashtable64_lookup (ht, keys[i]);
+		for (t = 0; t < REF_TYPES; t++) {
+			r_strbuf_set (sb, "");
+			for (j = 0; j < v->len; j++) {
+				if (v->type[j] == ref_types[t]) {
+					if (sb->len) {
+						r_strbuf_append (sb, ",");
+					}
+					r_strbuf_append (sb, sdb_itoa (v->addr[j], num, 16));
+				}
+			}
+			if (sb->len) {
+				XREFKEY (key, sizeof (key), kind, ref_types[t], keys[i]);
+				cb (anal, key, r_strbuf_get (sb), user);
+			}
 		}
 	}
+	r_strbuf_free (sb);
+	free (keys);
+}
+
+static void sync_cb(RAnal *anal, const char *k, const char *v, void *user) {
+	sdb_set (DB, k, v, 0);
+}
+
+/* regenerates sdb_xrefs from the store if it is out of date */
+R_API bool r_anal_xrefs_sync(RAnal *anal) {
+	if (!anal || !DB) {
+		return false;
+	}
+	if (!anal->xrefs_dirty) {
+		return true;
+	}
+	sdb_reset (DB);
+	sdb_array_set (DB, "types", -1, "code.jmp,code.call,data.mem,data.string", 0);
+	xrefs_foreach_key (anal, "ref", anal->dict_refs, sync_cb, NULL);
+	xrefs_foreach_key (anal, "xref", anal->dict_xrefs, sync_cb, NULL);
+	anal->xrefs_dirty = false;
+	return true;
+}
+
+static RAnalRefType type_fromString(const char *s) {
+	size_t t;
+	for (t = 0; t < REF_TYPES; t++) {
+		const char *name = analref_toString (ref_types[t]);
+		size_t len = strlen (name);
+		if (!strncmp (s, name, len) && s[len] == '.') {
+			return ref_types[t];
+		}
+	}
+	return R_ANAL_REF_TYPE_NULL;
+}
+
+static int load_cb(RAnal *anal, const char *k, const char *v) {
+	char *str, *next, *ptr;
+	const char *p;
+	RAnalRefType type;
+	ut64 from;
+	if (strncmp (k, "ref.", 4) || !(p = r_str_rchr (k, NULL, '.'))) {
+		return 1;
+	}
+	type = type_fromString (k + 4);
+	from = r_num_get (NULL, p + 1);
+	if (!(str = strdup (v))) {
+		return 0;
+	}
+	for (next = ptr = str; next; ptr = next) {
+		xref_add (anal, type, from, r_num_get (NULL, sdb_anext (ptr, &next)));
+	}
+	free (str);
 	return 1;
 }
 
-static bool xrefs_list_cb_json(RAnal *anal, bool is_first, const char *k, const char *v) {
-	ut64 dst, src = r_num_get (NULL, v);
-	if (strlen (k) > 8) {
-		const char *p = r_str_rchr (k, NULL, '.');
-		if (p) {
-			if (is_first) {
-				is_first = false;
-			} else {
-				anal->cb_printf (",");
-			}
-			dst = r_num_get (NULL, p + 1);
-			sscanf (p + 1, "0x%"PFMT64x, &dst);
-			anal->cb_printf ("\"%"PFMT64d"\":%"PFMT64d, src, dst);
+/* rebuilds the store from the contents of sdb_xrefs */
+R_API bool r_anal_xrefs_load(RAnal *anal) {
+	Sdb *db;
+	if (!anal || !DB) {
+		return false;
+	}
+	db = DB;
+	DB = NULL; // keep init from resetting the loaded database
+	r_anal_xrefs_init (anal);
+	DB = db;
+	sdb_foreach (DB, (SdbForeachCallback)load_cb, anal);
+	anal->xrefs_dirty = false;
+	return true;
+}
+
+R_API bool r_anal_xrefs_save(RAnal *anal, const char *prjDir) {
+	char *xrefs_path = r_str_newf ("%s" R_SYS_DIR "xrefs.sdb", prjDir);
+	r_anal_xrefs_sync (anal);
+	sdb_file (anal->sdb_xrefs, xrefs_path);
+	free (xrefs_path);
+	return sdb_sync (anal->sdb_xrefs);
+}
+
+/* the refs of the store ordered by source, as r_anal_xrefs_restore takes them */
+R_API RAnalRef *r_anal_xrefs_dump(RAnal *anal, int *count) {
+	RAnalRef *refs, *r;
+	int i, j, n, total = 0;
+	ut64 *keys;
+	*count = 0;
+	if (!anal || !anal->dict_refs) {
+		return NULL;
+	}
+	keys = sorted_keys (anal->dict_refs, &n);
+	for (i = 0; i < n; i++) {
+		XrefVec *v = r_hashtable64_lookup (anal->dict_refs, keys[i]);
+		total += v->len;
+	}
+	if (!total || !(refs = malloc (total * sizeof (RAnalRef)))) {
+		free (keys);
+		return NULL;
+	}
+	for (r = refs, i = 0; i < n; i++) {
+		XrefVec *v = r_hashtable64_lookup (anal->dict_refs, keys[i]);
+		for (j = 0; j < v->len; j++, r++) {
+			r->type = v->type[j];
+			r->at = keys[i];
+			r->addr = v->addr[j];
+		}
+	}
+	free (keys);
+	*count = total;
+	return refs;
+}
+
+/* adds refs which were already in a store, they are not checked again */
+R_API int r_anal_xrefs_restore(RAnal *anal, const RAnalRef *refs, int count) {
+	int i, n = 0;
+	if (!anal || !anal->dict_refs || !refs) {
+		return 0;
+	}
+	for (i = 0; i < count; i++) {
+		if (xref_add (anal, refs[i].type, refs[i].at, refs[i].addr)) {
+			n++;
 		}
 	}
-	return is_first;
+	return n;
 }
 
-static int xrefs_list_cb_plain(RAnal *anal, const char *k, const char *v) {
+static void plain_cb(RAnal *anal, const char *k, const char *v, void *user) {
 	anal->cb_printf ("%s=%s\n", k, v);
-	return 1;
 }
 
 R_API void r_anal_xrefs_list(RAnal *anal, int rad) {
+	bool is_first = true;
+	int i, j, n;
+	ut64 *keys;
 	switch (rad) {
 	case 1:
 	case '*':
-		sdb_foreach (DB, (SdbForeachCallback)xrefs_list_cb_rad, anal);
-		break;
 	case 'j':
-		{
-		anal->cb_printf ("{");
-		bool is_first = true;
-		SdbListIter *sdb_iter;
-		SdbKv *kv;
-		SdbList *sdb_list = sdb_foreach_match (DB, "^ref.", false);
-		ls_foreach (sdb_list, sdb_iter, kv) {
-			is_first = xrefs_list_cb_json (anal, is_first, kv->key, kv->value);
+		if (rad == 'j') {
+			anal->cb_printf ("{");
 		}
-		ls_free (sdb_list);
-		anal->cb_printf ("}\n");
+		keys = sorted_keys (anal->dict_refs, &n);
+		for (i = 0; i < n; i++) {
+			XrefVec *v = r_hashtable64_lookup (anal->dict_refs, keys[i]);
+			for (j = 0; j < v->len; j++) {
+				if (rad != 'j') {
+					anal->cb_printf ("ax 0x%"PFMT64x" 0x%"PFMT64x"\n", v->addr[j], keys[i]);
+					continue;
+				}
+				anal->cb_printf ("%s\"%"PFMT64d"\":%"PFMT64d,
+					is_first? "": ",", v->addr[j], keys[i]);
+				is_first = false;
+			}
+		}
+		free (keys);
+		if (rad == 'j') {
+			anal->cb_printf ("}\n");
 		}
 		break;
 	default:
-		sdb_foreach (DB, (SdbForeachCallback)xrefs_list_cb_plain, anal);
+		anal->cb_printf ("types=code.jmp,code.call,data.mem,data.string\n");
+		xrefs_foreach_key (anal, "ref", anal->dict_refs, plain_cb, NULL);
+		xrefs_foreach_key (anal, "xref", anal->dict_xrefs, plain_cb, NULL);
 		break;
 	}
 }
@@ -255,19 +613,22 @@ R_API const char *r_anal_xrefs_type_tostring (char type) {
 	}
 }
 
-typedef struct {
-	RAnal *anal;
-	int count;
-} CountState;
-
-static int countcb(CountState *cs, const char *k, const char *v) {
-	if (!strncmp (k, "ref.", 4))
-		cs->count ++;
-	return 1;
+static bool countcb(void *user, ut64 key, void *data) {
+	XrefVec *v = data;
+	size_t mask = 0;
+	int i;
+	for (i = 0; i < v->len; i++) {
+		mask |= type_bit (v->type[i]);
+	}
+	for (; mask; mask &= mask - 1) {
+		(*(int *)user)++;
+	}
+	return true;
 }
 
+/* number of ref.<type>.<addr> keys, one per source and type */
 R_API int r_anal_xrefs_count(RAnal *anal) {
-	CountState cs = { anal, 0 };
-	sdb_foreach (DB, (SdbForeachCallback)countcb, &cs);
-	return cs.count;
+	int count = 0;
+	r_hashtable64_foreach (anal->dict_refs, countcb, &count);
+	return count;
 }
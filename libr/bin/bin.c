@@ -7,7 +7,11 @@
 #include <r_util.h>
 #include <r_lib.h>
 #include <r_io.h>
+#include <r_th.h>
 #include "../config.h"
+#if __SSE2__
+#include <emmintrin.h>
+#endif
 
 R_LIB_VERSION (r_bin);
 
@@ -84,6 +88,12 @@ static RBinFile *r_bin_file_new_from_bytes(RBin *bin, const char *file,
 					    const char *xtrname, ut64 offset,
 					    bool steal_ptr);
 
+static RBinFile *r_bin_file_new_from_buffer(RBin *bin, const char *file,
+					     RBuffer *buf, ut64 file_sz,
+					     int rawstr, ut64 baseaddr,
+					     ut64 loadaddr, int fd,
+					     const char *pluginname);
+
 static int getoffset(RBin *bin, int type, int idx);
 static const char *getname(RBin *bin, int type, int idx);
 static int r_bin_file_object_add(RBinFile *binfile, RBinObject *o);
@@ -195,20 +205,100 @@ R_API int r_bin_file_cur_set_plugin(RBinFile *binfile, RBinPlugin *plugin) {
 }
 
 #define R_STRING_SCAN_BUFFER_SIZE 2048
+/* ranges split between the bin.strjobs threads */
+#define R_STRING_SCAN_CHUNK (1024 * 1024)
+/* no string spans more bytes than this, so the scans started at the
+ * previous chunk and at this one agree before reaching it */
+#define R_STRING_SCAN_SYNC (4 * R_STRING_SCAN_BUFFER_SIZE)
+
+typedef struct {
+	const ut8 *buf;
+	int min;
+	int type;
+	ut64 limit; // strings start before it
+	ut64 to; // and end before this one
+	ut64 needle; // where the scan is
+	ut64 base; // the bitmaps cover R_STRING_SCAN_SYNC bytes from here
+	ut8 *tops; // marks the places where a string could start
+	const ut8 *stop; // stops the scan at the first of these places
+	bool synced; // stopped there
+} StrScan;
+
+typedef struct {
+	StrScan ss;
+	RList *list;
+	ut8 tops[R_STRING_SCAN_SYNC / 8];
+} StrChunk;
+
+typedef struct {
+	StrChunk *chunks;
+	int count;
+	int next; // next chunk to pick by a worker
+	RThreadLock *lock;
+} StrJobs;
+
+/* bytes which can not start a string, the scan just steps over them */
+static inline bool str_skip(ut8 b) {
+	return (b < 0x20 && (b < 7 || b > 13) && b != 0x1b) || b == 0x7f;
+}
+
+/* first byte from needle on which could start a string */
+static ut64 str_next(const ut8 *buf, ut64 needle, ut64 to) {
+#if __SSE2__
+	const __m128i c06 = _mm_set1_epi8 (0x06);
+	const __m128i c0e = _mm_set1_epi8 (0x0e);
+	const __m128i c1b = _mm_set1_epi8 (0x1b);
+	const __m128i c20 = _mm_set1_epi8 (0x20);
+	const __m128i c7f = _mm_set1_epi8 (0x7f);
+	for (; needle + 16 <= to; needle += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(buf + needle));
+		__m128i esc = _mm_and_si128 (_mm_cmpgt_epi8 (v, c06), _mm_cmplt_epi8 (v, c0e));
+		__m128i ctl;
+		int skip;
+		esc = _mm_or_si128 (esc, _mm_cmpeq_epi8 (v, c1b));
+		// signed compare, the bytes over 0x7f are masked out below
+		ctl = _mm_andnot_si128 (esc, _mm_cmplt_epi8 (v, c20));
+		skip = (_mm_movemask_epi8 (ctl) & ~_mm_movemask_epi8 (v))
+			| _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, c7f));
+		if (skip != 0xffff) {
+			return needle + __builtin_ctz (~skip);
+		}
+	}
+#endif
+	while (needle < to && str_skip (buf[needle])) {
+		needle++;
+	}
+	return needle;
+}
 
-static int string_scan_range(RList *list, const ut8 *buf, int min,
-			      const ut64 from, const ut64 to, int type) {
+static int string_scan(StrScan *ss, RList *list) {
 	ut8 tmp[R_STRING_SCAN_BUFFER_SIZE];
-	ut64 needle = from, str_start;
+	const ut8 *buf = ss->buf;
+	const ut64 to = ss->to;
+	ut64 needle = ss->needle, str_start;
 	int count = 0, i, rc, runes, str_type = R_STRING_TYPE_DETECT;
+	int type = ss->type;
 
 	if (type == -1) {
 		type = R_STRING_TYPE_DETECT;
 	}
-	if (!buf || !min) {
-		return -1;
-	}
-	while (needle < to) {
+	while (needle < ss->limit) {
+		/* stepping over the bytes which can not start a string
+		 * ends in the same place from any of them */
+		needle = str_next (buf, needle, ss->limit);
+		if (needle >= ss->limit) {
+			break;
+		}
+		if (needle - ss->base < R_STRING_SCAN_SYNC) {
+			ut64 bit = needle - ss->base;
+			if (ss->stop && ss->stop[bit / 8] & (1 << (bit % 8))) {
+				ss->synced = true;
+				break;
+			}
+			if (ss->tops) {
+				ss->tops[bit / 8] |= 1 << (bit % 8);
+			}
+		}
 		rc = r_utf8_decode (buf + needle, to - needle, NULL);
 		if (!rc) {
 			needle++;
@@ -278,7 +368,7 @@ static int string_scan_range(RList *list, const ut8 *buf, int min,
 
 		tmp[i++] = '\0';
 
-		if (runes >= min) {
+		if (runes >= ss->min) {
 			if (list) {
 				RBinString *new = R_NEW0 (RBinString);
 				new->type = str_type;
@@ -294,13 +384,120 @@ static int string_scan_range(RList *list, const ut8 *buf, int min,
 			}
 		}
 	}
+	ss->needle = needle;
 	return count;
 }
 
+static int string_scan_worker(RThread *th) {
+	StrJobs *sj = th->user;
+	StrChunk *c;
+	for (;;) {
+		r_th_lock_enter (sj->lock);
+		c = (sj->next < sj->count)? &sj->chunks[sj->next++]: NULL;
+		r_th_lock_leave (sj->lock);
+		if (!c) {
+			break;
+		}
+		string_scan (&c->ss, c->list);
+	}
+	return 0;
+}
+
+/* scans every chunk from its start in a thread, then walks them in
+ * order: where the previous string ran into a chunk, the range is
+ * scanned again from there until reaching a place the chunk scan went
+ * through, the strings found by it from there on are the same */
+static int string_scan_jobs(RList *list, StrScan *ss, int jobs) {
+	ut64 size = ss->limit - ss->needle;
+	int i, n = (size + R_STRING_SCAN_CHUNK - 1) / R_STRING_SCAN_CHUNK;
+	StrJobs sj = {0};
+	RThreadPool *pool;
+	RBinString *s;
+	RListIter *iter, *last = list->tail;
+	ut64 pos = ss->needle;
+	int count = 0;
+
+	sj.chunks = calloc (n, sizeof (StrChunk));
+	sj.lock = r_th_lock_new ();
+	if (!sj.chunks || !sj.lock) {
+		free (sj.chunks);
+		r_th_lock_free (sj.lock);
+		return string_scan (ss, list);
+	}
+	for (i = 0; i < n; i++) {
+		StrChunk *c = &sj.chunks[i];
+		c->ss = *ss;
+		c->ss.needle = c->ss.base = ss->needle + (ut64)i * R_STRING_SCAN_CHUNK;
+		c->ss.limit = R_MIN (c->ss.needle + R_STRING_SCAN_CHUNK, ss->limit);
+		c->ss.tops = c->tops;
+		c->list = r_list_newf (r_bin_string_free);
+	}
+	sj.count = n;
+	pool = r_th_pool_new (R_MIN (jobs, n), string_scan_worker, &sj);
+	if (pool) {
+		r_th_pool_free (pool);
+	} else {
+		for (i = 0; i < n; i++) {
+			string_scan (&sj.chunks[i].ss, sj.chunks[i].list);
+		}
+	}
+	for (i = 0; i < n; i++) {
+		StrChunk *c = &sj.chunks[i];
+		ut64 from = c->ss.base;
+		if (pos != from) {
+			StrScan rs = *ss;
+			rs.needle = pos;
+			rs.base = from;
+			rs.limit = c->ss.limit;
+			rs.tops = NULL;
+			rs.stop = c->tops;
+			string_scan (&rs, list);
+			if (!rs.synced) {
+				pos = rs.needle;
+				continue;
+			}
+			from = rs.needle;
+		}
+		c->list->free = NULL;
+		r_list_foreach (c->list, iter, s) {
+			if (s->paddr >= from) {
+				r_list_append (list, s);
+			} else {
+				r_bin_string_free (s);
+			}
+		}
+		pos = c->ss.needle;
+	}
+	for (i = 0; i < n; i++) {
+		r_list_free (sj.chunks[i].list);
+	}
+	free (sj.chunks);
+	r_th_lock_free (sj.lock);
+	ss->needle = pos;
+	for (iter = last? last->n: list->head; iter; iter = iter->n) {
+		s = iter->data;
+		s->ordinal = count++;
+	}
+	return count;
+}
+
+static int string_scan_range(RBin *bin, RList *list, const ut8 *buf, int min,
+			      const ut64 from, const ut64 to, int type) {
+	StrScan ss = { buf, min, type, to, to, from, from };
+	int jobs = bin? bin->strjobs: 1;
+	if (!buf || !min) {
+		return -1;
+	}
+	if (list && jobs > 1 && to - from > R_STRING_SCAN_CHUNK) {
+		return string_scan_jobs (list, &ss, jobs);
+	}
+	return string_scan (&ss, list);
+}
+
 static void get_strings_range(RBinFile *arch, RList *list, int min, ut64 from, ut64 to) {
 	RBinPlugin *plugin = r_bin_file_cur_plugin (arch);
 	RBinString *ptr;
-	RListIter *it;
+	RListIter *it, *last;
 
 	if (!arch || !arch->buf || !arch->buf->buf) {
 		return;
@@ -338,11 +535,18 @@ static void get_strings_range(RBinFile *arch, RList *list, int min, ut64 from, u
 			return;
 		}
 	}
-	if (string_scan_range (list, arch->buf->buf, min, from, to, -1) < 0) {
+	last = list? list->tail: NULL;
+	if (string_scan_range (arch->rbin, list, arch->buf->buf, min, from, to, -1) < 0) {
 		return;
 	}
-	r_list_foreach (list, it, ptr) {
-		RBinSection *s = r_bin_get_section_at (arch->o, ptr->paddr, false);
+	if (!list) {
+		return;
+	}
+	/* only the strings of this range */
+	for (it = last? last->n: list->head; it; it = it->n) {
+		RBinSection *s;
+		ptr = it->data;
+		s = r_bin_get_section_at (arch->o, ptr->paddr, false);
 		if (s) {
 			ptr->vaddr = s->vaddr + (ptr->paddr - s->paddr);
 		}
@@ -512,6 +716,7 @@ static void r_bin_object_delete_items(RBinObject *o) {
 	o->lines = NULL;
 	o->info = NULL;
 	o->kv = NULL;
+	o->loaded = 0;
 	for (i = 0; i < R_BIN_SYM_LAST; i++) {
 		free (o->binsym[i]);
 		o->binsym[i] = NULL;
@@ -577,7 +782,8 @@ static void r_bin_object_free(void /*RBinObject*/ *o_) {
 R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 	RBinObject *old_o;
 	RBinPlugin *cp;
-	int i, minlen;
+	ut64 loaded;
+	int i;
 	RBin *bin;
 	if (!binfile || !o || !o->plugin) {
 		return false;
@@ -585,12 +791,10 @@ R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 	bin = binfile->rbin;
 	old_o = binfile->o;
 	cp = o->plugin;
-	if (binfile->rbin->minstrlen > 0) {
-		minlen = binfile->rbin->minstrlen;
-	} else {
-		minlen = cp->minstrlen;
-	}
 	binfile->o = o;
+	// the lazy items are loaded again when rebasing
+	loaded = o->loaded;
+	o->loaded = 0;
 	if (cp->baddr) {
 		ut64 old_baddr = o->baddr;
 		o->baddr = cp->baddr (binfile);
@@ -624,24 +828,6 @@ R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 			REBASE_PADDR (o, o->fields, RBinField);
 		}
 	}
-	if (cp->imports) {
-		r_list_free (o->imports);
-		o->imports = cp->imports (binfile);
-		if (o->imports) {
-			o->imports->free = r_bin_import_free;
-		}
-	}
-	//if (bin->filter_rules & (R_BIN_REQ_SYMBOLS | R_BIN_REQ_IMPORTS)) {
-		if (cp->symbols) {
-			o->symbols = cp->symbols (binfile);
-			if (o->symbols) {
-				o->symbols->free = r_bin_symbol_free;
-				REBASE_PADDR (o, o->symbols, RBinSymbol);
-				if (bin->filter)
-					r_bin_filter_symbols (o->symbols);
-			}
-		}
-	//}
 	o->info = cp->info? cp->info (binfile): NULL;
 	if (cp->libs) {
 		o->libs = cp->libs (binfile);
@@ -656,13 +842,91 @@ R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 			r_bin_filter_sections (o->sections);
 		}
 	}
-	if (bin->filter_rules & (R_BIN_REQ_RELOCS | R_BIN_REQ_IMPORTS)) {
-		if (cp->relocs) {
-			o->relocs = cp->relocs (binfile);
-			REBASE_PADDR (o, o->relocs, RBinReloc);
+	if (cp->get_sdb) {
+		Sdb* new_kv = cp->get_sdb (binfile);
+		if (new_kv != o->kv) {
+			sdb_free (o->kv);
 		}
+		o->kv = new_kv;
+	}
+	if (cp->mem)  {
+		o->mem = cp->mem (binfile);
+	}
+	r_bin_object_load_items (binfile, o, loaded);
+	binfile->o = old_o;
+	return true;
+}
+
+/* filter_rules allowing each lazy item */
+static ut64 lazy_allowed(RBin *bin) {
+	ut64 items = R_BIN_REQ_IMPORTS | R_BIN_REQ_SYMBOLS | R_BIN_REQ_SRCLINE;
+	if (bin->filter_rules & (R_BIN_REQ_RELOCS | R_BIN_REQ_IMPORTS)) {
+		items |= R_BIN_REQ_RELOCS;
 	}
 	if (bin->filter_rules & R_BIN_REQ_STRINGS) {
+		items |= R_BIN_REQ_STRINGS;
+	}
+	if (bin->filter_rules & R_BIN_REQ_CLASSES) {
+		items |= R_BIN_REQ_CLASSES;
+	}
+	if (bin->filter_rules & (R_BIN_REQ_SYMBOLS | R_BIN_REQ_IMPORTS)) {
+		items |= R_BIN_REQ_LANG;
+	}
+	return items;
+}
+
+/* loads the R_BIN_REQ_LAZY items of o which are not there yet. They
+ * are loaded in the order set_items used to, with the ones they came
+ * after, because the plugins may depend on it. The ones the filter
+ * rules exclude are left out until these allow them. */
+R_API void r_bin_object_load_items(RBinFile *binfile, RBinObject *o, ut64 items) {
+	RBinObject *old_o;
+	RBinPlugin *cp;
+	RBin *bin;
+	if (!binfile || !o || !o->plugin || !binfile->rbin) {
+		return;
+	}
+	bin = binfile->rbin;
+	items &= R_BIN_REQ_LAZY & lazy_allowed (bin);
+	// the allowed items pull in what they are built from
+	if (items & R_BIN_REQ_LANG) {
+		items |= R_BIN_REQ_SYMBOLS;
+	}
+	if (items & (R_BIN_REQ_RELOCS | R_BIN_REQ_CLASSES)) {
+		items |= R_BIN_REQ_IMPORTS | R_BIN_REQ_SYMBOLS;
+	}
+	items &= ~o->loaded;
+	if (!items) {
+		return;
+	}
+	// marked first, the plugins can get other items while loading
+	o->loaded |= items;
+	cp = o->plugin;
+	old_o = binfile->o;
+	binfile->o = o;
+	if (items & R_BIN_REQ_IMPORTS && cp->imports) {
+		r_list_free (o->imports);
+		o->imports = cp->imports (binfile);
+		if (o->imports) {
+			o->imports->free = r_bin_import_free;
+		}
+	}
+	if (items & R_BIN_REQ_SYMBOLS && cp->symbols) {
+		o->symbols = cp->symbols (binfile);
+		if (o->symbols) {
+			o->symbols->free = r_bin_symbol_free;
+			REBASE_PADDR (o, o->symbols, RBinSymbol);
+			if (bin->filter) {
+				r_bin_filter_symbols (o->symbols);
+			}
+		}
+	}
+	if (items & R_BIN_REQ_RELOCS && cp->relocs) {
+		o->relocs = cp->relocs (binfile);
+		REBASE_PADDR (o, o->relocs, RBinReloc);
+	}
+	if (items & R_BIN_REQ_STRINGS) {
+		int minlen = (bin->minstrlen > 0)? bin->minstrlen: cp->minstrlen;
 		if (cp->strings) {
 			o->strings = cp->strings (binfile);
 		} else {
@@ -673,32 +937,35 @@ R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 		}
 		REBASE_PADDR (o, o->strings, RBinString);
 	}
-	if (bin->filter_rules & R_BIN_REQ_CLASSES) {
-		if (cp->classes) {
-			o->classes = cp->classes (binfile);
-			if (bin->filter) {
-				r_bin_filter_classes (o->classes);
-			}
+	if (items & R_BIN_REQ_CLASSES && cp->classes) {
+		// symbols loaded along may have demangled some into the list
+		r_list_free (o->classes);
+		o->classes = cp->classes (binfile);
+		if (bin->filter) {
+			r_bin_filter_classes (o->classes);
 		}
 	}
-	if (cp->lines) {
+	if (items & R_BIN_REQ_SRCLINE && cp->lines) {
 		o->lines = cp->lines (binfile);
 	}
-	if (cp->get_sdb) {
-		Sdb* new_kv = cp->get_sdb (binfile);
-		if (new_kv != o->kv) {
-			sdb_free (o->kv);
-		}
-		o->kv = new_kv;
-	}
-	if (cp->mem)  {
-		o->mem = cp->mem (binfile);
-	}
-	if (bin->filter_rules & (R_BIN_REQ_SYMBOLS | R_BIN_REQ_IMPORTS)) {
+	if (items & R_BIN_REQ_LANG) {
 		o->lang = r_bin_load_languages (binfile);
 	}
 	binfile->o = old_o;
-	return true;
+}
+
+/* loads the given items of the current object ahead of their use */
+R_API void r_bin_prefetch(RBin *bin, ut64 items) {
+	RBinFile *binfile = r_bin_cur (bin);
+	if (binfile) {
+		r_bin_object_load_items (binfile, binfile->o, items);
+	}
+}
+
+/* the current object with the items loaded */
+static RBinObject *cur_object_with(RBin *bin, ut64 items) {
+	r_bin_prefetch (bin, items);
+	return r_bin_cur_object (bin);
 }
 
 // XXX - this is a rather hacky way to do things, there may need to be a better
@@ -831,12 +1098,32 @@ R_API int r_bin_load_io(RBin *bin, RIODesc *desc, ut64 baseaddr, ut64 loadaddr,
 	return r_bin_load_io_at_offset_as (bin, desc, baseaddr, loadaddr, xtr_idx, 0, NULL);
 }
 
+/* maps the file behind desc when it is a plain file on disk, so the
+ * parsers work on its pages instead of a copy of the whole file */
+static RBuffer *bin_mmap_desc(RIODesc *desc, ut64 sz) {
+	const char *plugin = desc->plugin? desc->plugin->name: NULL;
+	RBuffer *b;
+	if (!plugin || (strcmp (plugin, "default") && strcmp (plugin, "mmap"))) {
+		return NULL;
+	}
+	if (!sz || !desc->name || !r_file_is_regular (desc->name)) {
+		return NULL;
+	}
+	b = r_buf_mmap_cow (desc->name);
+	if (b && b->length != sz) {
+		r_buf_free (b);
+		return NULL;
+	}
+	return b;
+}
+
 R_API int r_bin_load_io_at_offset_as_sz (RBin *bin, RIODesc *desc, ut64 baseaddr,
 		ut64 loadaddr, int xtr_idx, ut64 offset, const char *name, ut64 sz) {
 	RIOBind *iob = &(bin->iob);
 	RIO *io = iob? iob->get_io (iob): NULL;
 	RListIter *it;
 	ut8 *buf_bytes = NULL;
+	RBuffer *mapped = NULL;
 	RBinXtrPlugin *xtr;
 	ut64 file_sz = UT64_MAX;
 	RBinFile *binfile = NULL;
@@ -894,6 +1181,12 @@ R_API int r_bin_load_io_at_offset_as_sz (RBin *bin, RIODesc *desc, ut64 baseaddr
 		}
 	}
 	sz = R_MIN (file_sz, sz);
+	if (!buf_bytes && !is_debugger && !loadaddr && sz == file_sz) {
+		mapped = bin_mmap_desc (desc, sz);
+		if (mapped) {
+			buf_bytes = mapped->buf;
+		}
+	}
 	if (!buf_bytes) {
 		ut64 seekaddr = is_debugger? baseaddr: loadaddr;
 		iob->desc_seek (io, desc, seekaddr);
@@ -969,7 +1262,12 @@ R_API int r_bin_load_io_at_offset_as_sz (RBin *bin, RIODesc *desc, ut64 baseaddr
 			}
 		}
 	}
-	if (!binfile) {
+	if (binfile) {
+		r_buf_free (mapped);
+	} else if (mapped) {
+		binfile = r_bin_file_new_from_buffer (bin, desc->name, mapped,
+			file_sz, bin->rawstr, baseaddr, loadaddr, desc->fd, name);
+	} else {
 		bool steal_ptr = true; // transfer buf_bytes ownership to binfile
 		binfile = r_bin_file_new_from_bytes (
 			bin, desc->name, buf_bytes, sz, file_sz, bin->rawstr,
@@ -1375,40 +1673,13 @@ R_API bool r_bin_file_object_new_from_xtr_data(RBin *bin, RBinFile *bf,
 	return true;
 }
 
-static RBinFile *r_bin_file_new_from_bytes(RBin *bin, const char *file,
-					    const ut8 *bytes, ut64 sz,
-					    ut64 file_sz, int rawstr,
-					    ut64 baseaddr, ut64 loadaddr,
-					    int fd, const char *pluginname,
-					    const char *xtrname, ut64 offset,
-					    bool steal_ptr) {
-	ut8 binfile_created = false;
+/* picks the plugin for the bytes of bf and loads its first object */
+static RBinFile *r_bin_file_load_object(RBin *bin, RBinFile *bf,
+					 const ut8 *bytes, ut64 sz,
+					 ut64 file_sz, ut64 baseaddr,
+					 ut64 loadaddr, const char *pluginname) {
 	RBinPlugin *plugin = NULL;
-	RBinXtrPlugin *xtr = NULL;
 	RBinObject *o = NULL;
-	RBinFile *bf = NULL;
-
-	if (xtrname) {
-		xtr = r_bin_get_xtrplugin_by_name (bin, xtrname);
-	}
-
-	if (xtr && xtr->check && xtr->check_bytes (bytes, sz)) {
-		return r_bin_file_xtr_load_bytes (bin, xtr, file,
-						bytes, sz, file_sz, baseaddr, loadaddr, 0,
-						fd, rawstr);
-	}
-
-	if (!bf) {
-		bf = r_bin_file_create_append (bin, file, bytes, sz, file_sz,
-					       rawstr, fd, xtrname, steal_ptr);
-		if (!bf) {
-			if (steal_ptr) { // we own the ptr, free on error
-				free ((void*) bytes);
-			}
-			return NULL;
-		}
-		binfile_created = true;
-	}
 
 	if (bin->force) {
 		plugin = r_bin_get_binplugin_by_name (bin, bin->force);
@@ -1434,9 +1705,7 @@ static RBinFile *r_bin_file_new_from_bytes(RBin *bin, const char *file,
 	}
 
 	if (!o) {
-		if (bf && binfile_created) {
-			r_list_delete_data (bin->binfiles, bf);
-		}
+		r_list_delete_data (bin->binfiles, bf);
 		return NULL;
 	}
 	/* WTF */
@@ -1448,6 +1717,84 @@ static RBinFile *r_bin_file_new_from_bytes(RBin *bin, const char *file,
 	return bf;
 }
 
+static RBinFile *r_bin_file_new_from_bytes(RBin *bin, const char *file,
+					    const ut8 *bytes, ut64 sz,
+					    ut64 file_sz, int rawstr,
+					    ut64 baseaddr, ut64 loadaddr,
+					    int fd, const char *pluginname,
+					    const char *xtrname, ut64 offset,
+					    bool steal_ptr) {
+	RBinXtrPlugin *xtr = NULL;
+	RBinFile *bf = NULL;
+
+	if (xtrname) {
+		xtr = r_bin_get_xtrplugin_by_name (bin, xtrname);
+	}
+
+	if (xtr && xtr->check && xtr->check_bytes (bytes, sz)) {
+		return r_bin_file_xtr_load_bytes (bin, xtr, file,
+						bytes, sz, file_sz, baseaddr, loadaddr, 0,
+						fd, rawstr);
+	}
+
+	bf = r_bin_file_create_append (bin, file, bytes, sz, file_sz,
+				       rawstr, fd, xtrname, steal_ptr);
+	if (!bf) {
+		if (steal_ptr) { // we own the ptr, free on error
+			free ((void*) bytes);
+		}
+		return NULL;
+	}
+	return r_bin_file_load_object (bin, bf, bytes, sz, file_sz,
+				       baseaddr, loadaddr, pluginname);
+}
+
+/* same as r_bin_file_new_from_bytes, but the binfile keeps buf as is */
+static RBinFile *r_bin_file_new_from_buffer(RBin *bin, const char *file,
+					     RBuffer *buf, ut64 file_sz,
+					     int rawstr, ut64 baseaddr,
+					     ut64 loadaddr, int fd,
+					     const char *pluginname) {
+	RBinFile *bf = r_bin_file_create_append (bin, file, NULL, 0, file_sz,
+						 rawstr, fd, NULL, false);
+	if (!bf) {
+		r_buf_free (buf);
+		return NULL;
+	}
+	r_buf_free (bf->buf);
+	bf->buf = buf;
+	return r_bin_file_load_object (bin, bf, buf->buf, buf->length,
+				       file_sz, baseaddr, loadaddr, pluginname);
+}
+
+/* buffer for a plugin to parse the bytes of bf from. it points into
+ * bf->buf when that is a mapping of the file, so only the pages the
+ * parser touches are read, and holds a copy of them otherwise */
+R_API RBuffer *r_bin_file_buffer(RBinFile *bf, const ut8 *bytes, ut64 sz) {
+	RBuffer *b = bf? bf->buf: NULL;
+	if (b && b->mmap && bytes >= b->buf && sz <= b->length - (bytes - b->buf)) {
+		return r_buf_new_with_pointers (bytes, sz);
+	}
+	return r_buf_new_with_bytes (bytes, sz);
+}
+
+/* the write plugins patch the buffer of their object, which replaces the
+ * one of bf. when it is still a view of bf->buf the bytes are already
+ * there, and the view is dropped instead */
+R_API void r_bin_file_set_buf(RBinFile *bf, RBuffer *buf) {
+	RBuffer *b = bf->buf;
+	if (buf == b) {
+		return;
+	}
+	if (buf && buf->ro && b && b->mmap && buf->buf >= b->buf
+			&& buf->buf + buf->length <= b->buf + b->length) {
+		r_buf_free (buf);
+		return;
+	}
+	r_buf_free (b);
+	bf->buf = buf;
+}
+
 static void plugin_free(RBinPlugin *p) {
 	if (p && p->fini) {
 		p->fini (NULL);
@@ -1680,12 +2027,12 @@ R_API RList *r_bin_get_fields(RBin *bin) {
 }
 
 R_API RList *r_bin_get_imports(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_IMPORTS);
 	return o? o->imports: NULL;
 }
 
 R_API RBinInfo *r_bin_get_info(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_LANG);
 	return o? o->info: NULL;
 }
 
@@ -1697,7 +2044,7 @@ R_API RList *r_bin_get_libs(RBin *bin) {
 
 R_API RList * r_bin_patch_relocs(RBin *bin) {
 	static bool first = true;
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_RELOCS);
 	if (!o) {
 		return NULL;
 	}
@@ -1721,7 +2068,7 @@ R_API RList * r_bin_patch_relocs(RBin *bin) {
 }
 
 R_API RList *r_bin_get_relocs(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_RELOCS);
 	return o? o->relocs: NULL;
 }
 
@@ -1761,6 +2108,7 @@ R_API RList *r_bin_reset_strings(RBin *bin) {
 		r_list_purge (o->strings);
 		o->strings = NULL;
 	}
+	o->loaded |= R_BIN_REQ_STRINGS;
 
 	if (bin->minstrlen <= 0) {
 		return NULL;
@@ -1779,7 +2127,7 @@ R_API RList *r_bin_reset_strings(RBin *bin) {
 }
 
 R_API RList *r_bin_get_strings(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_STRINGS);
 	return o? o->strings: NULL;
 }
 
@@ -1832,7 +2180,7 @@ R_API RBinSymbol *r_bin_get_symbol_at_paddr(RBin *bin, ut64 addr) {
 }
 
 R_API RList *r_bin_get_symbols(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_SYMBOLS);
 	return o? o->symbols: NULL;
 }
 
@@ -1887,6 +2235,7 @@ R_API RBin *r_bin_new() {
 	bin->cb_printf = (PrintfCallback)printf;
 	bin->plugins = r_list_newf ((RListFree)plugin_free);
 	bin->minstrlen = 0;
+	bin->strjobs = 1;
 	bin->cur = NULL;
 
 	bin->binfiles = r_list_newf ((RListFree)r_bin_file_free);
@@ -2417,10 +2766,19 @@ R_API RBinObject *r_bin_get_object(RBin *bin) {
 }
 
 R_API RList * /*<RBinClass>*/ r_bin_get_classes(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = cur_object_with (bin, R_BIN_REQ_CLASSES);
 	return o? o->classes: NULL;
 }
 
+static void bin_class_free(void *_c) {
+	RBinClass *c = (RBinClass *)_c;
+	if (c) {
+		r_list_free (c->methods);
+		r_list_free (c->fields);
+		r_bin_class_free (c);
+	}
+}
+
 R_API RBinClass *r_bin_class_new(RBinFile *binfile, const char *name,
 				  const char *super, int view) {
 	RBinObject *o = binfile? binfile->o: NULL;
@@ -2448,11 +2806,11 @@ R_API RBinClass *r_bin_class_new(RBinFile *binfile, const char *name,
 	c->name = strdup (name);
 	c->super = super? strdup (super): NULL;
 	c->index = r_list_length (list);
-	c->methods = r_list_new ();
-	c->fields = r_list_new ();
+	c->methods = r_list_newf (r_bin_symbol_free);
+	c->fields = r_list_newf (r_bin_field_free);
 	c->visibility = view;
 	if (!list) {
-		list = o->classes = r_list_new ();
+		list = o->classes = r_list_newf (bin_class_free);
 	}
 	r_list_append (list, c);
 	return c;
@@ -35,6 +35,18 @@ R_API bool r_bin_wr_rpath_del(RBin *bin) {
 R_API int r_bin_wr_output(RBin *bin, const char *filename) {
 	RBinFile *binfile = r_bin_cur (bin);
 	if (!filename || !binfile || !binfile->buf) return false;
+	if (binfile->buf->mmap) {
+		/* the file may be the one mapped, which is truncated first */
+		ut64 len = binfile->buf->length;
+		ut8 *bytes = malloc (len);
+		int ret = false;
+		if (bytes) {
+			memcpy (bytes, binfile->buf->buf, len);
+			ret = r_file_dump (filename, bytes, len, 0);
+			free (bytes);
+		}
+		return ret;
+	}
 	return r_file_dump (filename, binfile->buf->buf,
 			binfile->buf->length, 0);
 }
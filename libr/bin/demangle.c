@@ -178,8 +178,12 @@ R_API char *r_bin_demangle_objc(RBinFile *binfile, const char *sym) {
 	if (!binfile || !sym) {
 		return NULL;
 	}
-	if (binfile && binfile->o && binfile->o->classes) {
-		binfile = NULL;
+	if (binfile->o) {
+		/* the classes of the plugin win over the ones guessed here */
+		r_bin_object_load_items (binfile, binfile->o, R_BIN_REQ_CLASSES);
+		if (binfile->o->classes) {
+			binfile = NULL;
+		}
 	}
 	/* classes */
 	if (!strncmp (sym, "_OBJC_Class_", 12)) {
@@ -428,6 +432,10 @@ R_API int r_bin_lang_type(RBinFile *binfile, const char *def, const char *sym) {
 	if (plugin && plugin->demangle_type) {
 		type = plugin->demangle_type (def);
 	} else {
+		if (binfile->o) {
+			// the language is guessed from the symbols on demand
+			r_bin_object_load_items (binfile, binfile->o, R_BIN_REQ_LANG);
+		}
 		if (binfile->o && binfile->o->info) {
 			type = r_bin_demangle_type (binfile->o->info->lang);
 		}
@@ -2972,10 +2972,10 @@ ELFOBJ* Elf_(r_bin_elf_new)(const char* file, bool verbose) {
 ELFOBJ* Elf_(r_bin_elf_new_buf)(RBuffer *buf, bool verbose) {
 	ELFOBJ *bin = R_NEW0 (ELFOBJ);
 	bin->kv = sdb_new0 ();
-	bin->b = r_buf_new ();
+	bin->b = r_buf_new_view (buf);
 	bin->size = (ut32)buf->length;
 	bin->verbose = verbose;
-	if (!r_buf_set_bytes (bin->b, buf->buf, buf->length)) {
+	if (!bin->b || !bin->b->buf) {
 		return Elf_(r_bin_elf_free) (bin);
 	}
 	if (!elf_init (bin)) {
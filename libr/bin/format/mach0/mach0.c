@@ -1261,10 +1261,10 @@ struct MACH0_(obj_t)* MACH0_(new_buf)(RBuffer *buf, bool verbose) {
 		return NULL;
 	}
 	bin->kv = sdb_new (NULL, "bin.mach0", 0);
-	bin->b = r_buf_new ();
+	bin->b = r_buf_new_view (buf);
 	bin->size = buf->length;
 	bin->verbose = verbose;
-	if (!r_buf_set_bytes (bin->b, buf->buf, bin->size)){
+	if (!bin->b || !bin->b->buf) {
 		return MACH0_(mach0_free) (bin);
 	}
 	if (!init (bin)) {
@@ -1025,6 +1025,7 @@ static RList *parse_swift_classes(RBinFile *bf) {
 
 	int idx = 0;
 	ret = r_list_newf (r_bin_string_free);
+	r_bin_object_load_items (bf, bf->o, R_BIN_REQ_STRINGS);
 	r_list_foreach (bf->o->strings, iter, str) {
 		if (!strncmp (str->string, "_TtC", 4)) {
 			char *msg = strdup (str->string + 4);
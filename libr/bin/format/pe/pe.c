@@ -3194,10 +3194,10 @@ struct PE_(r_bin_pe_obj_t)* PE_(r_bin_pe_new_buf)(RBuffer * buf, bool verbose) {
 		return NULL;
 	}
 	bin->kv = sdb_new0 ();
-	bin->b = r_buf_new ();
+	bin->b = r_buf_new_view (buf);
 	bin->verbose = verbose;
 	bin->size = buf->length;
-	if (!r_buf_set_bytes (bin->b, buf->buf, bin->size)) {
+	if (!bin->b || !bin->b->buf) {
 		return PE_(r_bin_pe_free)(bin);
 	}
 	if (!bin_pe_init (bin)) {
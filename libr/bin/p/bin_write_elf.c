@@ -7,8 +7,7 @@
 static ut64 scn_resize(RBinFile *arch, const char *name, ut64 size) {
 	struct Elf_(r_bin_elf_obj_t) *obj = arch->o->bin_obj;
 	int ret = Elf_(r_bin_elf_resize_section) (arch->o->bin_obj, name, size);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
@@ -16,8 +15,7 @@ static ut64 scn_resize(RBinFile *arch, const char *name, ut64 size) {
 static bool scn_perms(RBinFile *arch, const char *name, int perms) {
 	struct Elf_(r_bin_elf_obj_t) *obj = arch->o->bin_obj;
 	int ret = Elf_(r_bin_elf_section_perms) (arch->o->bin_obj, name, perms);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
@@ -25,8 +23,7 @@ static bool scn_perms(RBinFile *arch, const char *name, int perms) {
 static int rpath_del(RBinFile *arch) {
 	struct Elf_(r_bin_elf_obj_t) *obj = arch->o->bin_obj;
 	int ret = Elf_(r_bin_elf_del_rpath) (arch->o->bin_obj);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
@@ -34,8 +31,7 @@ static int rpath_del(RBinFile *arch) {
 static bool chentry(RBinFile *arch, ut64 addr) {
 	struct Elf_(r_bin_elf_obj_t) *obj = arch->o->bin_obj;
 	int ret = Elf_(r_bin_elf_entry_write) (arch->o->bin_obj, addr);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
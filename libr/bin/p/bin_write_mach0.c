@@ -12,8 +12,7 @@ static bool MACH0_(write_addlib)(struct MACH0_(obj_t) *obj, const char *lib) {
 static bool addlib(RBinFile *arch, const char *lib) {
 	struct MACH0_(obj_t) *obj = arch->o->bin_obj;
 	bool ret = MACH0_(write_addlib) (arch->o->bin_obj, lib);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
@@ -7,8 +7,7 @@
 static bool scn_perms(RBinFile *arch, const char *name, int perms) {
 	struct PE_(r_bin_pe_obj_t) *obj = arch->o->bin_obj;
 	bool ret = PE_(r_bin_pe_section_perms) (arch->o->bin_obj, name, perms);
-	r_buf_free (arch->buf);
-	arch->buf = obj->b;
+	r_bin_file_set_buf (arch, obj->b);
 	obj->b = NULL;
 	return ret;
 }
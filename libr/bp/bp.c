@@ -29,6 +29,7 @@ R_API RBreakpoint *r_bp_new() {
 	bp->traces = r_bp_traptrace_new ();
 	bp->cb_printf = (PrintfCallback)printf;
 	bp->bps = r_list_newf ((RListFree)r_bp_item_free);
+	bp->tree = r_interval_tree_new (NULL);
 	bp->plugins = r_list_newf ((RListFree)free);
 	for (i = 0; bp_static_plugins[i]; i++) {
 		static_plugin = R_NEW (RBreakpointPlugin);
@@ -44,7 +45,9 @@ R_API RBreakpoint *r_bp_free(RBreakpoint *bp) {
 	r_list_free (bp->bps);
 	r_list_free (bp->plugins);
 	r_list_free (bp->traces);
+	r_interval_tree_free (bp->tree);
 	free (bp->bps_idx);
+	free (bp->tracelog);
 	free (bp);
 	return NULL;
 }
@@ -84,35 +87,29 @@ repeat:
 	return 0;
 }
 
-R_API RBreakpointItem *r_bp_get_at(RBreakpoint *bp, ut64 addr) {
-	RListIter *iter;
-	RBreakpointItem *b;
-	r_list_foreach(bp->bps, iter, b) {
-		if (b->addr == addr)
-			return b;
-	}
-	return NULL;
+static bool startsAt(RIntervalNode *node, void *user) {
+	RBreakpointItem *b = node->data;
+	return b->addr == *(ut64 *)user;
 }
 
-static inline bool inRange(RBreakpointItem *b, ut64 addr) {
-	return (addr >= b->addr && addr < (b->addr + b->size));
+/* the breakpoints are indexed by their range, the first one added wins */
+R_API RBreakpointItem *r_bp_get_at(RBreakpoint *bp, ut64 addr) {
+	RIntervalNode *node = r_interval_tree_first_intersect (bp->tree,
+		addr, addr, startsAt, &addr);
+	return node? node->data: NULL;
 }
 
-static inline bool matchProt(RBreakpointItem *b, int rwx) {
+static bool matchProt(RIntervalNode *node, void *user) {
+	RBreakpointItem *b = node->data;
+	int rwx = *(int *)user;
 	return (!rwx || (rwx && b->rwx));
 }
 
 R_API RBreakpointItem *r_bp_get_in(RBreakpoint *bp, ut64 addr, int rwx) {
-	RBreakpointItem *b;
-	RListIter *iter;
-	r_list_foreach (bp->bps, iter, b) {
-		// eprintf ("---ataddr--- 0x%08"PFMT64x" %d %d %x\n", b->addr, b->size, b->recoil, b->rwx);
-		// Check addr within range and provided rwx matches (or null)
-		if (inRange (b, addr) && matchProt (b, rwx)) {
-			return b;
-		}
-	}
-	return NULL;
+	// Check addr within range and provided rwx matches (or null)
+	RIntervalNode *node = r_interval_tree_first_intersect (bp->tree,
+		addr, addr, matchProt, &rwx);
+	return node? node->data: NULL;
 }
 
 R_API RBreakpointItem *r_bp_enable(RBreakpoint *bp, ut64 addr, int set) {
@@ -175,6 +172,7 @@ static RBreakpointItem *r_bp_add(RBreakpoint *bp, const ut8 *obytes, ut64 addr,
 	}
 	bp->nbps++;
 	r_list_append (bp->bps, b);
+	r_interval_tree_insert (bp->tree, b->addr, b->addr + b->size - 1, b);
 	return b;
 }
 
@@ -205,23 +203,38 @@ R_API RBreakpointItem* r_bp_add_hw(RBreakpoint *bp, ut64 addr, int size, int rwx
 	return r_bp_add (bp, NULL, addr, size, R_BP_TYPE_HW, rwx);
 }
 
+/* drops b from the list, the index and its slot */
+static void r_bp_item_del(RBreakpoint *bp, RBreakpointItem *b) {
+	RIntervalNode *node = r_interval_tree_node_at_data (bp->tree, b->addr, b);
+	int i;
+	if (node) {
+		r_interval_tree_delete (bp->tree, node, false);
+	}
+	for (i = 0; i < bp->bps_idx_count; i++) {
+		if (bp->bps_idx[i] == b) {
+			bp->bps_idx[i] = NULL;
+			break;
+		}
+	}
+	r_list_delete_data (bp->bps, b);
+}
+
 R_API int r_bp_del_all(RBreakpoint *bp) {
 	if (!r_list_empty (bp->bps)) {
 		r_list_purge (bp->bps);
+		r_interval_tree_fini (bp->tree);
+		r_interval_tree_init (bp->tree, NULL);
+		memset (bp->bps_idx, 0, bp->bps_idx_count * sizeof (RBreakpointItem*));
 		return true;
 	}
 	return false;
 }
 
 R_API int r_bp_del(RBreakpoint *bp, ut64 addr) {
-	RListIter *iter;
-	RBreakpointItem *b;
-	/* No _safe loop necessary because we return immediately after the delete. */
-	r_list_foreach (bp->bps, iter, b) {
-		if (b->addr == addr) {
-			r_list_delete (bp->bps, iter);
-			return true;
-		}
+	RBreakpointItem *b = r_bp_get_at (bp, addr);
+	if (b) {
+		r_bp_item_del (bp, b);
+		return true;
 	}
 	return false;
 }
@@ -243,6 +256,68 @@ R_API int r_bp_set_trace_all(RBreakpoint *bp, int set) {
 	}
 	return true;
 }
+
+/* trace-only breakpoints log their hits in bp->tracelog and are
+ * stepped over without stopping, see r_debug_wait */
+R_API int r_bp_set_traceonly(RBreakpoint *bp, ut64 addr, int set) {
+	RBreakpointItem *b = r_bp_get_in (bp, addr, 0);
+	if (b && !b->hw) {
+		b->traceonly = set;
+		return true;
+	}
+	return false;
+}
+
+R_API int r_bp_set_traceonly_all(RBreakpoint *bp, int set) {
+	RListIter *iter;
+	RBreakpointItem *b;
+	r_list_foreach (bp->bps, iter, b) {
+		if (!b->hw) {
+			b->traceonly = set;
+		}
+	}
+	return true;
+}
+
+/* room for size hits, the logged ones are dropped */
+R_API bool r_bp_tracelog_init(RBreakpoint *bp, int size) {
+	ut64 *log = NULL;
+	if (size > 0) {
+		log = malloc (size * sizeof (ut64));
+		if (!log) {
+			return false;
+		}
+	}
+	free (bp->tracelog);
+	bp->tracelog = log;
+	bp->tracelog_size = R_MAX (size, 0);
+	bp->tracelog_count = 0;
+	return true;
+}
+
+/* false when it is full */
+R_API bool r_bp_tracelog_add(RBreakpoint *bp, ut64 addr) {
+	if (bp->tracelog_count >= bp->tracelog_size) {
+		return false;
+	}
+	bp->tracelog[bp->tracelog_count++] = addr;
+	return true;
+}
+
+R_API void r_bp_tracelog_list(RBreakpoint *bp, int rad) {
+	int i;
+	if (rad == 'j') {
+		bp->cb_printf ("[");
+		for (i = 0; i < bp->tracelog_count; i++) {
+			bp->cb_printf ("%s%"PFMT64d, i? ",": "", bp->tracelog[i]);
+		}
+		bp->cb_printf ("]\n");
+		return;
+	}
+	for (i = 0; i < bp->tracelog_count; i++) {
+		bp->cb_printf ("0x%08"PFMT64x"\n", bp->tracelog[i]);
+	}
+}
 // TODO: deprecate
 R_API int r_bp_list(RBreakpoint *bp, int rad) {
 	int n = 0;
@@ -261,7 +336,7 @@ R_API int r_bp_list(RBreakpoint *bp, int rad) {
 				(b->rwx & R_BP_PROT_WRITE) ? 'w' : '-',
 				(b->rwx & R_BP_PROT_EXEC) ? 'x' : '-',
 				b->hw ? "hw": "sw",
-				b->trace ? "trace" : "break",
+				b->traceonly ? "log" : b->trace ? "trace" : "break",
 				b->enabled ? "enabled" : "disabled",
 				r_str_get2 (b->data),
 				r_str_get2 (b->cond),
@@ -335,10 +410,8 @@ R_API RBreakpointItem *r_bp_get_index(RBreakpoint *bp, int idx) {
 }
 
 R_API int r_bp_del_index(RBreakpoint *bp, int idx) {
-	if (idx >= 0 && idx < bp->bps_idx_count) {
-		r_list_delete_data (bp->bps, bp->bps_idx[idx]);
-		free (bp->bps_idx[idx]);
-		bp->bps_idx[idx] = NULL;
+	if (idx >= 0 && idx < bp->bps_idx_count && bp->bps_idx[idx]) {
+		r_bp_item_del (bp, bp->bps_idx[idx]);
 		return true;
 	}
 	return false;
@@ -145,6 +145,13 @@ R_API int r_config_set_setter(RConfig *cfg, const char *key, RConfigCallback cb)
 	return 0;
 }
 
+/* unique among the configs, so a handle can not mistake another one
+ * allocated at the same address for the config it resolved */
+static ut32 config_keys(void) {
+	static ut32 keys = 0;
+	return ++keys;
+}
+
 static bool is_true(const char *s) {
 	return !strcasecmp ("true", s) || !strcasecmp ("1", s);
 }
@@ -153,17 +160,31 @@ static bool is_bool(const char *s) {
 	return !strcasecmp ("true", s) || !strcasecmp ("false", s);
 }
 
+static const char *node_get(RConfig *cfg, RConfigNode *node) {
+	if (node->getter) {
+		node->getter (cfg->user, node);
+	}
+	cfg->last_notfound = 0;
+	if (node->flags & CN_BOOL) {
+		return r_str_bool (is_true (node->value));
+	}
+	return node->value;
+}
+
+static ut64 node_get_i(RConfig *cfg, RConfigNode *node) {
+	if (node->getter) {
+		node->getter (cfg->user, node);
+	}
+	if (node->i_value || !strcmp (node->value, "false")) {
+		return node->i_value;
+	}
+	return (ut64) r_num_math (cfg->num, node->value);
+}
+
 R_API const char* r_config_get(RConfig *cfg, const char *name) {
 	RConfigNode *node = r_config_node_get (cfg, name);
 	if (node) {
-		if (node->getter) {
-			node->getter (cfg->user, node);
-		}
-		cfg->last_notfound = 0;
-		if (node->flags & CN_BOOL) {
-			return r_str_bool (is_true (node->value));
-		}
-		return node->value;
+		return node_get (cfg, node);
 	} else {
 		eprintf ("r_config_get: variable '%s' not found\n", name);
 	}
@@ -182,16 +203,7 @@ R_API int r_config_toggle(RConfig *cfg, const char *name) {
 
 R_API ut64 r_config_get_i(RConfig *cfg, const char *name) {
 	RConfigNode *node = r_config_node_get (cfg, name);
-	if (node) {
-		if (node->getter) {
-			node->getter (cfg->user, node);
-		}
-		if (node->i_value || !strcmp (node->value, "false")) {
-			return node->i_value;
-		}
-		return (ut64) r_num_math (cfg->num, node->value);
-	}
-	return (ut64) 0LL;
+	return node? node_get_i (cfg, node): 0LL;
 }
 
 R_API const char* r_config_node_type(RConfigNode *node) {
@@ -317,6 +329,7 @@ R_API RConfigNode* r_config_set(RConfig *cfg, const char *name, const char *valu
 			node->value = strdup (ov? ov: "");
 		}
 	}
+	cfg->gen++;
 beach:
 	free (ov);
 	return node;
@@ -347,6 +360,8 @@ R_API int r_config_rm(RConfig *cfg, const char *name) {
 		ht_delete (cfg->ht, node->name);
 		r_list_delete_data (cfg->nodes, node);
 		cfg->n_nodes--;
+		cfg->keys = config_keys ();
+		cfg->gen++;
 		return true;
 	}
 	return false;
@@ -418,6 +433,7 @@ R_API RConfigNode* r_config_set_i(RConfig *cfg, const char *name, const ut64 i)
 			node->value = strdup (ov? ov: "");
 		}
 	}
+	cfg->gen++;
 beach:
 	free (ov);
 	return node;
@@ -492,6 +508,60 @@ R_API int r_config_readonly(RConfig *cfg, const char *key) {
 	return true;
 }
 
+/* resolves the handle for cfg. A node is kept until its key is
+ * removed, so the handle only looks the name up again then */
+R_API RConfigNode *r_config_handle_node(RConfig *cfg, RConfigHandle *h) {
+	if (!h->node || h->keys != cfg->keys) {
+		h->node = r_config_node_get (cfg, h->name);
+		h->keys = cfg->keys;
+		h->gen = cfg->gen - 1;
+	}
+	return h->node;
+}
+
+/* the number is kept until the config changes, keys holding
+ * expressions must be read with r_config_get_i */
+R_API ut64 r_config_handle_get_i(RConfig *cfg, RConfigHandle *h) {
+	RConfigNode *node = r_config_handle_node (cfg, h);
+	if (!node) {
+		return 0LL;
+	}
+	if (h->gen != cfg->gen || node->getter) {
+		h->i_value = node_get_i (cfg, node);
+		h->gen = cfg->gen;
+	}
+	return h->i_value;
+}
+
+R_API const char *r_config_handle_get(RConfig *cfg, RConfigHandle *h) {
+	RConfigNode *node = r_config_handle_node (cfg, h);
+	return node? node_get (cfg, node): NULL;
+}
+
+/* sets the key unless it already has that value, which would run its
+ * setter again for nothing. Returns if it was set */
+R_API bool r_config_handle_set(RConfig *cfg, RConfigHandle *h, const char *value) {
+	RConfigNode *node = r_config_handle_node (cfg, h);
+	if (node && value && node->value && !node->getter) {
+		if (node->flags & CN_BOOL) {
+			if (node->i_value == (is_true (value)? 1: 0)) {
+				return false;
+			}
+		} else if (!strcmp (node->value, value)) {
+			return false;
+		}
+	}
+	return r_config_set (cfg, h->name, value) != NULL;
+}
+
+R_API bool r_config_handle_set_i(RConfig *cfg, RConfigHandle *h, ut64 i) {
+	RConfigNode *node = r_config_handle_node (cfg, h);
+	if (node && node->value && !node->getter && node->i_value == i) {
+		return false;
+	}
+	return r_config_set_i (cfg, h->name, i) != NULL;
+}
+
 static void _ht_node_free_kv(HtKv *kv) {
 	free (kv->key);
 	//we do not free kv->value because there is other reference 
@@ -513,6 +583,7 @@ R_API RConfig* r_config_new(void *user) {
 	cfg->num = NULL;
 	cfg->n_nodes = 0;
 	cfg->lock = 0;
+	cfg->keys = config_keys ();
 	cfg->cb_printf = (void *) printf;
 	return cfg;
 }
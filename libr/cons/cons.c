@@ -2,6 +2,7 @@
 
 #include <r_cons.h>
 #include <r_print.h>
+#include <r_th.h>
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
@@ -15,8 +16,13 @@
 
 R_LIB_VERSION (r_cons);
 
-static RCons r_cons_instance;
+static RConsContext r_cons_context_default;
+/* context is set before r_cons_new so early prints still have a buffer */
+static RCons r_cons_instance = { .context = &r_cons_context_default };
+/* the output of the calling thread, the main one unless loaded */
+static R_TH_LOCAL RConsContext *r_cons_context_current = NULL;
 #define I r_cons_instance
+#define C (r_cons_context_current? r_cons_context_current: I.context)
 
 //this structure goes into cons_stack when r_cons_push/pop
 typedef struct {
@@ -44,6 +50,25 @@ static void cons_stack_free(void *ptr) {
 	free (s);
 }
 
+static bool context_init(RConsContext *ctx) {
+	memset (ctx, 0, sizeof (RConsContext));
+	ctx->grep.line = -1;
+	ctx->grep.sort = -1;
+	ctx->cons_stack = r_stack_newf (6, cons_stack_free);
+	return ctx->cons_stack != NULL;
+}
+
+static void context_fini(RConsContext *ctx) {
+	R_FREE (ctx->buffer);
+	ctx->buffer_len = ctx->buffer_sz = 0;
+	ctx->lastline = NULL;
+	R_FREE (ctx->grep.str);
+	free (ctx->grep.json_path);
+	ctx->grep.json_path = NULL;
+	r_stack_free (ctx->cons_stack);
+	ctx->cons_stack = NULL;
+}
+
 static void break_signal(int sig) {
 	I.breaked = true;
 	r_print_set_interrupted (I.breaked);
@@ -180,7 +205,8 @@ R_API void r_cons_break_clear() {
 }
 
 R_API void r_cons_break_push(RConsBreak cb, void *user) {
-	if (I.break_stack) {
+	/* the signal and the stack belong to the main thread */
+	if (I.break_stack && C == I.context) {
 		//if we don't have any element in the stack start the signal
 		RConsBreakStack *b = R_NEW0 (RConsBreakStack);
 		if (!b) return;
@@ -202,7 +228,7 @@ R_API void r_cons_break_push(RConsBreak cb, void *user) {
 
 R_API void r_cons_break_pop() {
 	//restore old state
-	if (I.break_stack) {
+	if (I.break_stack && C == I.context) {
 		RConsBreakStack *b = NULL;
 		r_print_set_interrupted (I.breaked);
 		b = r_stack_pop (I.break_stack);
@@ -221,6 +247,9 @@ R_API void r_cons_break_pop() {
 }
 
 R_API bool r_cons_is_breaked() {
+	if (C != I.context) {
+		return C->breaked;
+	}
 	if (I.timeout) {
 		if (r_sys_now () > I.timeout) {
 			I.breaked = true;
@@ -327,10 +356,8 @@ R_API RCons *r_cons_new() {
 	I.fdin = stdin;
 	I.fdout = 1;
 	I.breaked = false;
-	//I.lines = 0;
-	I.buffer = NULL;
-	I.buffer_sz = 0;
-	I.buffer_len = 0;
+	I.context = &r_cons_context_default;
+	context_init (I.context);
 	r_cons_get_size (&I.pagesize);
 	I.num = NULL;
 	I.null = 0;
@@ -359,7 +386,6 @@ R_API RCons *r_cons_new() {
 	I.pager = NULL; /* no pager by default */
 	I.truecolor = 0;
 	I.mouse = 0;
-	I.cons_stack = r_stack_newf (6, cons_stack_free);
 	I.break_stack = r_stack_newf (6, break_stack_free);
 	r_cons_pal_null ();
 	r_cons_pal_init (NULL);
@@ -378,23 +404,61 @@ R_API RCons *r_cons_free() {
 		r_line_free ();
 		I.line = NULL;
 	}
-	if (I.buffer) {
-		free (I.buffer);
-		I.buffer = NULL;
-	}
+	context_fini (I.context);
 	R_FREE (I.break_word);
-	r_stack_free (I.cons_stack);
 	r_stack_free (I.break_stack);
 	return NULL;
 }
 
+R_API RConsContext *r_cons_context_new() {
+	RConsContext *ctx = R_NEW0 (RConsContext);
+	if (ctx && !context_init (ctx)) {
+		R_FREE (ctx);
+	}
+	return ctx;
+}
+
+R_API void r_cons_context_free(RConsContext *ctx) {
+	if (ctx && ctx != I.context) {
+		if (r_cons_context_current == ctx) {
+			r_cons_context_current = NULL;
+		}
+		context_fini (ctx);
+		free (ctx);
+	}
+}
+
+/* the calling thread prints into ctx from now on, NULL goes back to
+ * the main output */
+R_API void r_cons_context_load(RConsContext *ctx) {
+	r_cons_context_current = (ctx == I.context)? NULL: ctx;
+}
+
+R_API RConsContext *r_cons_context() {
+	return C;
+}
+
+R_API bool r_cons_context_is_main() {
+	return C == I.context;
+}
+
+/* makes r_cons_is_breaked true for the threads printing into ctx, it
+ * can be called from any thread */
+R_API void r_cons_context_break(RConsContext *ctx) {
+	if (!ctx || ctx == I.context) {
+		I.breaked = true;
+	} else {
+		ctx->breaked = true;
+	}
+}
+
 #define MOAR (4096 * 8)
 static bool palloc(int moar) {
 	void *temp;
 	if (moar <= 0) {
 		return false;
 	}
-	if (!I.buffer) {
+	if (!C->buffer) {
 		int new_sz;
 		if ((INT_MAX - MOAR) < moar) {
 			return false;
@@ -402,22 +466,22 @@ static bool palloc(int moar) {
 		new_sz = moar + MOAR;
 		temp = calloc (1, new_sz);
 		if (temp) {
-			I.buffer_sz = new_sz;
-			I.buffer = temp;
-			I.buffer[0] = '\0';
+			C->buffer_sz = new_sz;
+			C->buffer = temp;
+			C->buffer[0] = '\0';
 		}
-	} else if (moar + I.buffer_len > I.buffer_sz) {
+	} else if (moar + C->buffer_len > C->buffer_sz) {
 		char *new_buffer;
-		int old_buffer_sz = I.buffer_sz;
-		if ((INT_MAX - MOAR - moar) < I.buffer_sz) {
+		int old_buffer_sz = C->buffer_sz;
+		if ((INT_MAX - MOAR - moar) < C->buffer_sz) {
 			return false;
 		}
-		I.buffer_sz += moar + MOAR;
-		new_buffer = realloc (I.buffer, I.buffer_sz);
+		C->buffer_sz += moar + MOAR;
+		new_buffer = realloc (C->buffer, C->buffer_sz);
 		if (new_buffer) {
-			I.buffer = new_buffer;
+			C->buffer = new_buffer;
 		} else {
-			I.buffer_sz = old_buffer_sz;
+			C->buffer_sz = old_buffer_sz;
 			return false;
 		}
 	}
@@ -485,69 +549,101 @@ R_API void r_cons_reset_colors() {
 
 R_API void r_cons_clear() {
 	r_cons_strcat (Color_RESET"\x1b[2J");
-	I.lines = 0;
+	C->lines = 0;
 }
 
 R_API void r_cons_reset() {
-	if (I.buffer) {
-		I.buffer[0] = '\0';
-	}
-	I.buffer_len = 0;
-	I.lines = 0;
-	I.lastline = I.buffer;
-	I.grep.strings[0][0] = '\0';
-	I.grep.nstrings = 0; // XXX
-	I.grep.line = -1;
-	I.grep.sort = -1;
-	I.grep.sort_invert = false;
-	I.grep.str = NULL;
-	memset (I.grep.tokens, 0, R_CONS_GREP_TOKENS);
-	I.grep.tokens_used = 0;
+	if (C->buffer) {
+		C->buffer[0] = '\0';
+	}
+	C->buffer_len = 0;
+	C->sink_sent = 0;
+	C->lines = 0;
+	C->lastline = C->buffer;
+	C->grep.strings[0][0] = '\0';
+	C->grep.nstrings = 0; // XXX
+	C->grep.line = -1;
+	C->grep.sort = -1;
+	C->grep.sort_invert = false;
+	C->grep.str = NULL;
+	memset (C->grep.tokens, 0, R_CONS_GREP_TOKENS);
+	C->grep.tokens_used = 0;
 }
 
 R_API const char *r_cons_get_buffer() {
 	//check len otherwise it will return trash
-	return I.buffer_len? I.buffer : NULL;
+	return C->buffer_len? C->buffer : NULL;
+}
+
+static bool grepping() {
+	return C->grep.nstrings > 0 || C->grep.tokens_used || C->grep.less || C->grep.json;
+}
+
+/* passes the complete lines to the sink as the output grows, when nothing
+ * needs to see it whole. The buffer is left as is, the last line stays
+ * back because r_cons_lastline, r_cons_chop or r_cons_drop can still
+ * change it */
+static void context_stream() {
+	int end;
+	if (C->sink_chunk < 1 || !C->sink || !r_stack_is_empty (C->cons_stack) || grepping ()) {
+		return;
+	}
+	if (C->sink_sent > C->buffer_len) {
+		C->sink_sent = C->buffer_len;
+	}
+	if (C->buffer_len - C->sink_sent < C->sink_chunk) {
+		return;
+	}
+	for (end = C->buffer_len - 2; end >= C->sink_sent; end--) {
+		if (C->buffer[end] == '\n') {
+			break;
+		}
+	}
+	end++;
+	if (end > C->sink_sent) {
+		C->sink (C->sink_user, C->buffer + C->sink_sent, end - C->sink_sent);
+		C->sink_sent = end;
+	}
 }
 
 R_API void r_cons_filter() {
 	/* grep */
-	if (I.grep.nstrings > 0 || I.grep.tokens_used || I.grep.less || I.grep.json) {
-		r_cons_grepbuf (I.buffer, I.buffer_len);
+	if (grepping ()) {
+		r_cons_grepbuf (C->buffer, C->buffer_len);
 	}
 	/* html */
 	/* TODO */
 }
 
 R_API void r_cons_push() {
-	if (I.cons_stack) {
+	if (C->cons_stack) {
 		RConsStack *data = R_NEW0 (RConsStack);
-		data->buf = malloc (I.buffer_len);
+		data->buf = malloc (C->buffer_len);
 		if (!data->buf) {
 			free (data);
 			return;
 		}
-		memcpy (data->buf, I.buffer, I.buffer_len);
-		data->buf_len = I.buffer_len;
-		data->buf_size = I.buffer_sz;
+		memcpy (data->buf, C->buffer, C->buffer_len);
+		data->buf_len = C->buffer_len;
+		data->buf_size = C->buffer_sz;
 		data->grep = R_NEW0 (RConsGrep);
 		if (data->grep) {
-			memcpy (data->grep, &I.grep, sizeof (RConsGrep));
-			if (I.grep.str) {
-				data->grep->str = strdup (I.grep.str);
+			memcpy (data->grep, &C->grep, sizeof (RConsGrep));
+			if (C->grep.str) {
+				data->grep->str = strdup (C->grep.str);
 			}
 		}
-		r_stack_push (I.cons_stack, data);
-		I.buffer_len = 0;
-		if (I.buffer) {
-			memset (I.buffer, 0, I.buffer_sz);
+		r_stack_push (C->cons_stack, data);
+		C->buffer_len = 0;
+		if (C->buffer) {
+			memset (C->buffer, 0, C->buffer_sz);
 		}
 	}
 }
 
 R_API void r_cons_pop() {
-	if (I.cons_stack) {
-		RConsStack *data = (RConsStack *)r_stack_pop (I.cons_stack);
+	if (C->cons_stack) {
+		RConsStack *data = (RConsStack *)r_stack_pop (C->cons_stack);
 		char *tmp;
 		if (!data) {
 			return;
@@ -561,16 +657,16 @@ R_API void r_cons_pop() {
 			cons_stack_free ((void *)data);
 			return;
 		}
-		free (I.buffer);
-		I.buffer = tmp;
-		memcpy (I.buffer, data->buf, data->buf_len);
-		I.buffer_len = data->buf_len;
-		I.buffer_sz = data->buf_size;
+		free (C->buffer);
+		C->buffer = tmp;
+		memcpy (C->buffer, data->buf, data->buf_len);
+		C->buffer_len = data->buf_len;
+		C->buffer_sz = data->buf_size;
 		if (data->grep) {
-			memcpy (&I.grep, data->grep, sizeof (RConsGrep));
+			memcpy (&C->grep, data->grep, sizeof (RConsGrep));
 			if (data->grep->str) {
-				free (I.grep.str);
-				I.grep.str = data->grep->str;
+				free (C->grep.str);
+				C->grep.str = data->grep->str;
 			}
 		}
 		cons_stack_free ((void *)data);
@@ -587,19 +683,29 @@ R_API void r_cons_flush() {
 		return;
 	}
 	r_cons_filter ();
-	if (I.is_interactive && I.fdout == 1) {
+	if (C->sink) {
+		if (C->sink_sent > C->buffer_len) {
+			C->sink_sent = C->buffer_len;
+		}
+		if (C->buffer_len > C->sink_sent) {
+			C->sink (C->sink_user, C->buffer + C->sink_sent, C->buffer_len - C->sink_sent);
+		}
+		r_cons_reset ();
+		return;
+	}
+	if (I.is_interactive && I.fdout == 1 && C == I.context) {
 		/* Use a pager if the output doesn't fit on the terminal window. */
-		if (I.pager && *I.pager && I.buffer_len > 0
-				&& r_str_char_count (I.buffer, '\n') >= I.rows) {
-			I.buffer[I.buffer_len-1] = 0;
-			r_sys_cmd_str_full (I.pager, I.buffer, NULL, NULL, NULL);
+		if (I.pager && *I.pager && C->buffer_len > 0
+				&& r_str_char_count (C->buffer, '\n') >= I.rows) {
+			C->buffer[C->buffer_len-1] = 0;
+			r_sys_cmd_str_full (I.pager, C->buffer, NULL, NULL, NULL);
 			r_cons_reset ();
 
-		} else if (I.buffer_len > CONS_MAX_USER) {
+		} else if (C->buffer_len > CONS_MAX_USER) {
 #if COUNT_LINES
 			int i, lines = 0;
-			for (i = 0; I.buffer[i]; i++) {
-				if (I.buffer[i] == '\n') {
+			for (i = 0; C->buffer[i]; i++) {
+				if (C->buffer[i] == '\n') {
 					lines ++;
 				}
 			}
@@ -609,7 +715,7 @@ R_API void r_cons_flush() {
 			}
 #else
 			char buf[64];
-			char *buflen = r_num_units (buf, I.buffer_len);
+			char *buflen = r_num_units (buf, C->buffer_len);
 			if (buflen && !r_cons_yesno ('n',"Do you want to print %s chars? (y/N)", buflen)) {
 				r_cons_reset ();
 				return;
@@ -622,7 +728,7 @@ R_API void r_cons_flush() {
 	if (tee && *tee) {
 		FILE *d = r_sandbox_fopen (tee, "a+");
 		if (d) {
-			if (I.buffer_len != fwrite (I.buffer, 1, I.buffer_len, d)) {
+			if (C->buffer_len != fwrite (C->buffer, 1, C->buffer_len, d)) {
 				eprintf ("r_cons_flush: fwrite: error (%s)\n", tee);
 			}
 			fclose (d);
@@ -633,16 +739,16 @@ R_API void r_cons_flush() {
 	r_cons_highlight (I.highlight);
 	// is_html must be a filter, not a write endpoint
 	if (I.is_html) {
-		r_cons_html_print (I.buffer);
+		r_cons_html_print (C->buffer);
 	} else {
 		if (I.is_interactive && !r_sandbox_enable (false)) {
 			if (I.linesleep > 0 && I.linesleep < 1000) {
 				int i = 0;
 				int pagesize = R_MAX (1, I.pagesize);
-				char *ptr = I.buffer;
+				char *ptr = C->buffer;
 				char *nl = strchr (ptr, '\n');
-				int len = I.buffer_len;
-				I.buffer[I.buffer_len] = 0;
+				int len = C->buffer_len;
+				C->buffer[C->buffer_len] = 0;
 				r_cons_break_push (NULL, NULL);
 				while (nl && !r_cons_is_breaked ()) {
 					r_cons_write (ptr, nl - ptr + 1);
@@ -653,13 +759,13 @@ R_API void r_cons_flush() {
 					nl = strchr (ptr, '\n');
 					i++;
 				}
-				r_cons_write (ptr, I.buffer + len - ptr);
+				r_cons_write (ptr, C->buffer + len - ptr);
 				r_cons_break_pop ();
 			} else {
-				r_cons_write (I.buffer, I.buffer_len);
+				r_cons_write (C->buffer, C->buffer_len);
 			}
 		} else {
-			r_cons_write (I.buffer, I.buffer_len);
+			r_cons_write (C->buffer, C->buffer_len);
 		}
 	}
 
@@ -679,12 +785,12 @@ R_API void r_cons_visual_flush() {
 /* TODO: this ifdef must go in the function body */
 #if __WINDOWS__ && !__CYGWIN__
 		if (I.ansicon) {
-			r_cons_visual_write (I.buffer);
+			r_cons_visual_write (C->buffer);
 		} else {
-			r_cons_w32_print ((const ut8*)I.buffer, I.buffer_len, 1);
+			r_cons_w32_print ((const ut8*)C->buffer, C->buffer_len, 1);
 		}
 #else
-		r_cons_visual_write (I.buffer);
+		r_cons_visual_write (C->buffer);
 #endif
 	}
 	r_cons_reset ();
@@ -789,20 +895,21 @@ R_API void r_cons_printf_list(const char *format, va_list ap) {
 	if (strchr (format, '%')) {
 		palloc (MOAR + strlen (format) * 20);
 club:
-		size = I.buffer_sz - I.buffer_len - 1; /* remaining space in I.buffer */
-		written = vsnprintf (I.buffer + I.buffer_len, size, format, ap);
+		size = C->buffer_sz - C->buffer_len - 1; /* remaining space in C->buffer */
+		written = vsnprintf (C->buffer + C->buffer_len, size, format, ap);
 		if (written >= size) { /* not all bytes were written */
 			palloc (written);
 			va_copy (ap, ap2);
 			va_copy (ap2, ap);
-			written = vsnprintf (I.buffer + I.buffer_len, written, format, ap2);
+			written = vsnprintf (C->buffer + C->buffer_len, written, format, ap2);
 			if (written >= size) {
 				palloc (written);
 				goto club;
 			}
 			va_end (ap2);
 		}
-		I.buffer_len += written;
+		C->buffer_len += written;
+		context_stream ();
 	} else {
 		r_cons_strcat (format);
 	}
@@ -817,17 +924,17 @@ R_API void r_cons_printf(const char *format, ...) {
 }
 
 R_API int r_cons_get_column() {
-	char *line = strrchr (I.buffer, '\n');
+	char *line = strrchr (C->buffer, '\n');
 	if (!line) {
-		line = I.buffer;
+		line = C->buffer;
 	}
-	I.buffer[I.buffer_len] = 0;
+	C->buffer[C->buffer_len] = 0;
 	return r_str_ansi_len (line);
 }
 
 /* final entrypoint for adding stuff in the buffer screen */
 R_API int r_cons_memcat(const char *str, int len) {
-	if (len < 0 || (I.buffer_len + len) < 0) {
+	if (len < 0 || (C->buffer_len + len) < 0) {
 		return -1;
 	}
 	if (I.echo) {
@@ -835,10 +942,11 @@ R_API int r_cons_memcat(const char *str, int len) {
 	}
 	if (str && len > 0 && !I.null) {
 		if (palloc (len + 1)) {
-			memcpy (I.buffer + I.buffer_len, str, len);
-			I.buffer_len += len;
-			I.buffer[I.buffer_len] = 0;
+			memcpy (C->buffer + C->buffer_len, str, len);
+			C->buffer_len += len;
+			C->buffer[C->buffer_len] = 0;
 		}
+		context_stream ();
 	}
 	if (I.flush) {
 		r_cons_flush ();
@@ -854,9 +962,9 @@ R_API int r_cons_memcat(const char *str, int len) {
 R_API void r_cons_memset(char ch, int len) {
 	if (!I.null && len > 0) {
 		palloc (len + 1);
-		memset (I.buffer + I.buffer_len, ch, len);
-		I.buffer_len += len;
-		I.buffer[I.buffer_len] = 0;
+		memset (C->buffer + C->buffer_len, ch, len);
+		C->buffer_len += len;
+		C->buffer[C->buffer_len] = 0;
 	}
 }
 
@@ -890,11 +998,11 @@ R_API int r_cons_get_cursor(int *rows) {
 	int i, col = 0;
 	int row = 0;
 	// TODO: we need to handle GOTOXY and CLRSCR ansi escape code too
-	for (i = 0; i < I.buffer_len; i++) {
+	for (i = 0; i < C->buffer_len; i++) {
 		// ignore ansi chars, copypasta from r_str_ansi_len
-		if (I.buffer[i] == 0x1b) {
-			char ch2 = I.buffer[i+1];
-			char *str = I.buffer;
+		if (C->buffer[i] == 0x1b) {
+			char ch2 = C->buffer[i+1];
+			char *str = C->buffer;
 			if (ch2 == '\\') {
 				i++;
 			} else if (ch2 == ']') {
@@ -903,7 +1011,7 @@ R_API int r_cons_get_cursor(int *rows) {
 			} else if (ch2 == '[') {
 				for (++i; str[i] && str[i] != 'J' && str[i] != 'm' && str[i] != 'H'; i++);
 			}
-		} else if (I.buffer[i] == '\n') {
+		} else if (C->buffer[i] == '\n') {
 			row++;
 			col = 0;
 		} else {
@@ -1119,12 +1227,12 @@ R_API void r_cons_set_cup(int enable) {
 }
 
 R_API void r_cons_column(int c) {
-	char *b = malloc (I.buffer_len+1);
+	char *b = malloc (C->buffer_len+1);
 	if (!b) {
 		return;
 	}
-	memcpy (b, I.buffer, I.buffer_len);
-	b[I.buffer_len] = 0;
+	memcpy (b, C->buffer, C->buffer_len);
+	b[C->buffer_len] = 0;
 	r_cons_reset ();
 	// align current buffer N chars right
 	r_cons_strcat_justify (b, c, 0);
@@ -1166,12 +1274,12 @@ R_API void r_cons_highlight (const char *word) {
 		strlen (inv[1])
 	};
 
-	if (word && *word && I.buffer) {
+	if (word && *word && C->buffer) {
 		int word_len = strlen (word);
 		char *orig;
-		clean = I.buffer;
+		clean = C->buffer;
 		l = r_str_ansi_filter (clean, &orig, &cpos, 0);
-		I.buffer = orig;
+		C->buffer = orig;
 		if (I.highlight) {
 			if (strcmp (word, I.highlight)) {
 				free (I.highlight);
@@ -1188,17 +1296,17 @@ R_API void r_cons_highlight (const char *word) {
 		strcpy (rword, inv[0]);
 		strcpy (rword + linv[0], word);
 		strcpy (rword + linv[0] + word_len, inv[1]);
-		res = r_str_replace_thunked (I.buffer, clean, cpos,
+		res = r_str_replace_thunked (C->buffer, clean, cpos,
 					     l, word, rword, 1);
 		if (res) {
-			I.buffer = res;
-			I.buffer_len = I.buffer_sz = strlen (res);
+			C->buffer = res;
+			C->buffer_len = C->buffer_sz = strlen (res);
 		}
 		free (rword);
 		free (clean);
 		free (cpos);
 		/* don't free orig - it's assigned
-		 * to I.buffer and possibly realloc'd */
+		 * to C->buffer and possibly realloc'd */
 	} else {
 		free (I.highlight);
 		I.highlight = NULL;
@@ -1206,8 +1314,8 @@ R_API void r_cons_highlight (const char *word) {
 }
 
 R_API char *r_cons_lastline (int *len) {
-	char *b = I.buffer + I.buffer_len;
-	while (b > I.buffer) {
+	char *b = C->buffer + C->buffer_len;
+	while (b > C->buffer) {
 		if (*b == '\n') {
 			b++;
 			break;
@@ -1215,8 +1323,8 @@ R_API char *r_cons_lastline (int *len) {
 		b--;
 	}
 	if (len) {
-		int delta = b - I.buffer;
-		*len = I.buffer_len - delta;
+		int delta = b - C->buffer;
+		*len = C->buffer_len - delta;
 	}
 	return b;
 }
@@ -1243,21 +1351,21 @@ R_API char *r_cons_swap_ground(const char *col) {
 }
 
 R_API bool r_cons_drop (int n) {
-	if (n > I.buffer_len) {
-		I.buffer_len = 0;
+	if (n > C->buffer_len) {
+		C->buffer_len = 0;
 		return false;
 	}
-	I.buffer_len -= n;
+	C->buffer_len -= n;
 	return true;
 }
 
 R_API void r_cons_chop () {
-	while (I.buffer_len > 0) {
-		char ch = I.buffer[I.buffer_len - 1];
+	while (C->buffer_len > 0) {
+		char ch = C->buffer[C->buffer_len - 1];
 		if (ch != '\n' && !IS_WHITESPACE (ch)) {
 			break;
 		}
-		I.buffer_len--;
+		C->buffer_len--;
 	}
 }
 
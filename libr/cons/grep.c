@@ -3,6 +3,7 @@
 #include <r_cons.h>
 #include <r_util.h>
 #include <r_print.h>
+#include <r_th.h>
 #include <sdb.h>
 #undef SDB_API
 #define SDB_API static
@@ -11,11 +12,10 @@ int js0n(const ut8 *js, RangstrType len, RangstrType *out);
 #include "../../shlr/sdb/src/json/path.c"
 // #include "../../shlr/sdb/src/json.c"
 
-#define I(x) r_cons_singleton ()->x
 /* TODO: remove globals */
-static RList *sorted_lines = NULL;
-static RList *unsorted_lines = NULL;
-static int sorted_column = -1;
+static R_TH_LOCAL RList *sorted_lines = NULL;
+static R_TH_LOCAL RList *unsorted_lines = NULL;
+static R_TH_LOCAL int sorted_column = -1;
 
 R_API void r_cons_grep_help() {
 	eprintf (
@@ -51,28 +51,30 @@ R_API void r_cons_grep_help() {
 #define R_CONS_GREP_BUFSIZE 4096
 
 R_API void r_cons_grep(const char *str) {
-	static char buf[R_CONS_GREP_BUFSIZE];
+	static R_TH_LOCAL char buf[R_CONS_GREP_BUFSIZE];
 	int wlen, len, is_range, num_is_parsed, fail = 0;
 	char *ptr, *optr, *ptr2, *ptr3;
 	ut64 range_begin, range_end;
+	RConsContext *ctx;
 	RCons *cons;
 
 	if (!str || !*str) {
 		return;
 	}
 	cons = r_cons_singleton ();
-	memset (&(cons->grep), 0, sizeof (cons->grep));
+	ctx = r_cons_context ();
+	memset (&(ctx->grep), 0, sizeof (ctx->grep));
 	sorted_column = 0;
-	cons->grep.sort = -1;
-	cons->grep.line = -1;
+	ctx->grep.sort = -1;
+	ctx->grep.line = -1;
 	while (*str) {
 		switch (*str) {
 		case '.':
 			if (str[1] == '.') {
 				if (str[2] == '.') {
-					cons->grep.less = 2;
+					ctx->grep.less = 2;
 				} else {
-					cons->grep.less = 1;
+					ctx->grep.less = 1;
 				}
 				return;
 			}
@@ -80,9 +82,9 @@ R_API void r_cons_grep(const char *str) {
 			break;
 		case '{':
 			if (str[1] == '}') {
-				cons->grep.json = 1;
+				ctx->grep.json = 1;
 				if (!strncmp (str, "{}..", 4)) {
-					cons->grep.less = 1;
+					ctx->grep.less = 1;
 				}
 				str++;
 				return;
@@ -92,9 +94,9 @@ R_API void r_cons_grep(const char *str) {
 				if (jsonPathEnd) {
 					*jsonPathEnd = 0;
 				}
-				free (cons->grep.json_path);
-				cons->grep.json_path = jsonPath;
-				cons->grep.json = 1;
+				free (ctx->grep.json_path);
+				ctx->grep.json_path = jsonPath;
+				ctx->grep.json = 1;
 				return;
 			}
 			str++;
@@ -102,37 +104,37 @@ R_API void r_cons_grep(const char *str) {
 		case '$':
 			str++;
 			if (*str == '!') {
-				cons->grep.sort_invert = true;
+				ctx->grep.sort_invert = true;
 				str++;
 			} else {
-				cons->grep.sort_invert = false;
+				ctx->grep.sort_invert = false;
 			}
-			cons->grep.sort = atoi (str);
+			ctx->grep.sort = atoi (str);
 			while (IS_DIGIT (*str)) {
 				str++;
 			}
 			if (*str == ':') {
-				cons->grep.sort_row = atoi (++str);
+				ctx->grep.sort_row = atoi (++str);
 				str++;
 			}
 			break;
 		case '&':
 			str++;
-			cons->grep.amp = 1;
+			ctx->grep.amp = 1;
 			break;
 		case '^':
 			str++;
-			cons->grep.begin = 1;
+			ctx->grep.begin = 1;
 			break;
 		case '!':
 			str++;
-			cons->grep.neg = 1;
+			ctx->grep.neg = 1;
 			break;
 		case '?':
 			str++;
-			cons->grep.counter = 1;
+			ctx->grep.counter = 1;
 			if (*str == '.') {
-				cons->grep.charCounter = true;
+				ctx->grep.charCounter = true;
 				str++;
 			} else if (*str == '?') {
 				r_cons_grep_help ();
@@ -151,7 +153,7 @@ while_end:
 		return;
 	}
 	if (len > 0 && str[len] == '?') {
-		cons->grep.counter = 1;
+		ctx->grep.counter = 1;
 		strncpy (buf, str, R_MIN (len, sizeof (buf) - 1));
 		buf[len] = 0;
 		len--;
@@ -160,7 +162,7 @@ while_end:
 	}
 
 	if (len > 1 && buf[len] == '$' && buf[len - 1] != '\\') {
-		cons->grep.end = 1;
+		ctx->grep.end = 1;
 		buf[len] = 0;
 	}
 
@@ -177,8 +179,8 @@ while_end:
 		ptr2++;
 		for (; ptr2 <= ptr3; ++ptr2) {
 			if (fail) {
-				memset (cons->grep.tokens, 0, R_CONS_GREP_TOKENS);
-				cons->grep.tokens_used = 0;
+				memset (ctx->grep.tokens, 0, R_CONS_GREP_TOKENS);
+				ctx->grep.tokens_used = 0;
 				fail = 0;
 				break;
 			}
@@ -194,8 +196,8 @@ while_end:
 						fail = 1;
 						break;
 					}
-					cons->grep.tokens[range_begin] = 1;
-					cons->grep.tokens_used = 1;
+					ctx->grep.tokens[range_begin] = 1;
+					ctx->grep.tokens_used = 1;
 				}
 				is_range = 0;
 				num_is_parsed = 0;
@@ -214,32 +216,32 @@ while_end:
 	}
 
 	ptr2 = strchr (ptr, ':'); // line number
-	cons->grep.range_line = 2; // there is not :
+	ctx->grep.range_line = 2; // there is not :
 	if (ptr2 && ptr2[1] != ':') {
 		*ptr2 = '\0';
 		char *p, *token = ptr + 1;
 		p = strstr (token, "..");
 		if (!p) {
-			cons->grep.line = r_num_get (cons->num, ptr2 + 1);
-			cons->grep.range_line = 0;
+			ctx->grep.line = r_num_get (cons->num, ptr2 + 1);
+			ctx->grep.range_line = 0;
 		} else {
 			*p = '\0';
-			cons->grep.range_line = 1;
+			ctx->grep.range_line = 1;
 			if (!*token) {
-				cons->grep.f_line = 0;
+				ctx->grep.f_line = 0;
 			} else {
-				cons->grep.f_line = r_num_get (cons->num, token);
+				ctx->grep.f_line = r_num_get (cons->num, token);
 			}
 			if (!p[2]) {
-				cons->grep.l_line = -1;
+				ctx->grep.l_line = -1;
 			} else {
-				cons->grep.l_line = r_num_get (cons->num, p + 2);
+				ctx->grep.l_line = r_num_get (cons->num, p + 2);
 			}
 		}
 	}
-	free (cons->grep.str);
+	free (ctx->grep.str);
 	if (*ptr) {
-		cons->grep.str = (char *) strdup (ptr);
+		ctx->grep.str = (char *) strdup (ptr);
 		do {
 			optr = ptr;
 			ptr = strchr (ptr, ','); // grep keywords
@@ -254,18 +256,18 @@ while_end:
 				eprintf ("grep string too long\n");
 				continue;
 			}
-			strncpy (cons->grep.strings[cons->grep.nstrings],
+			strncpy (ctx->grep.strings[ctx->grep.nstrings],
 				optr, R_CONS_GREP_WORD_SIZE - 1);
-			cons->grep.nstrings++;
-			if (cons->grep.nstrings > R_CONS_GREP_WORDS - 1) {
+			ctx->grep.nstrings++;
+			if (ctx->grep.nstrings > R_CONS_GREP_WORDS - 1) {
 				eprintf ("too many grep strings\n");
 				break;
 			}
 		} while (ptr);
 	} else {
-		cons->grep.str = strdup (ptr);
-		cons->grep.nstrings++;
-		cons->grep.strings[0][0] = 0;
+		ctx->grep.str = strdup (ptr);
+		ctx->grep.nstrings++;
+		ctx->grep.strings[0][0] = 0;
 	}
 }
 
@@ -305,46 +307,47 @@ static int cmp(const void *a, const void *b) {
 }
 
 R_API int r_cons_grepbuf(char *buf, int len) {
+	RConsContext *ctx = r_cons_context ();
 	RCons *cons = r_cons_singleton ();
 	char *tline, *tbuf, *p, *out, *in = buf;
 	int ret, total_lines = 0, buffer_len = 0, l = 0, tl = 0;
 	bool show = false;
 
 	if ((!len || !buf || buf[0] == '\0') &&
-	    (cons->grep.json || cons->grep.less)) {
-		cons->grep.json = 0;
-		cons->grep.less = 0;
+	    (ctx->grep.json || ctx->grep.less)) {
+		ctx->grep.json = 0;
+		ctx->grep.less = 0;
 		return 0;
 	}
-	if (cons->grep.json) {
-		if (cons->grep.json_path) {
-			Rangstr rs = json_get (cons->buffer, cons->grep.json_path);
+	if (ctx->grep.json) {
+		if (ctx->grep.json_path) {
+			Rangstr rs = json_get (ctx->buffer, ctx->grep.json_path);
 			char *u = rangstr_dup (&rs);
 			if (u) {
-				cons->buffer = u;
-				cons->buffer_len = strlen (u);
-				cons->buffer_sz = cons->buffer_len + 1;
-				cons->grep.json = 0;
+				ctx->buffer = u;
+				ctx->buffer_len = strlen (u);
+				ctx->buffer_sz = ctx->buffer_len + 1;
+				ctx->grep.json = 0;
 				r_cons_newline ();
 			}
-			R_FREE (cons->grep.json_path);
+			R_FREE (ctx->grep.json_path);
 		} else {
-			char *out = r_print_json_indent (buf, I (use_color), "  ");
-			free (cons->buffer);
-			cons->buffer = out;
-			cons->buffer_len = strlen (out);
-			cons->buffer_sz = cons->buffer_len + 1;
-			cons->grep.json = 0;
-			if (cons->grep.less) {
-				cons->grep.less = 0;
-				r_cons_less_str (cons->buffer, NULL);
+			char *out = r_print_json_indent (buf, cons->use_color, "  ");
+			free (ctx->buffer);
+			ctx->buffer = out;
+			ctx->buffer_len = strlen (out);
+			ctx->buffer_sz = ctx->buffer_len + 1;
+			ctx->grep.json = 0;
+			if (ctx->grep.less) {
+				ctx->grep.less = 0;
+				r_cons_less_str (ctx->buffer, NULL);
 			}
 		}
 		return 3;
 	}
-	if (cons->grep.less) {
-		int less = cons->grep.less;
-		cons->grep.less = 0;
+	if (ctx->grep.less) {
+		int less = ctx->grep.less;
+		ctx->grep.less = 0;
 		if (less == 2) {
 			char *res = r_cons_hud_string (buf);
 			r_cons_println (res);
@@ -352,22 +355,22 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 		} else {
 			r_cons_less_str (buf, NULL);
 			buf[0] = 0;
-			cons->buffer_len = 0;
-			if (cons->buffer) {
-				cons->buffer[0] = 0;
+			ctx->buffer_len = 0;
+			if (ctx->buffer) {
+				ctx->buffer[0] = 0;
 			}
-			R_FREE (cons->buffer);
+			R_FREE (ctx->buffer);
 		}
 		return 0;
 	}
-	if (!cons->buffer) {
-		cons->buffer_len = len + 20;
-		cons->buffer = malloc (cons->buffer_len);
-		cons->buffer[0] = 0;
+	if (!ctx->buffer) {
+		ctx->buffer_len = len + 20;
+		ctx->buffer = malloc (ctx->buffer_len);
+		ctx->buffer[0] = 0;
 	}
 	out = tbuf = calloc (1, len);
 	tline = malloc (len);
-	cons->lines = 0;
+	ctx->lines = 0;
 	// used to count lines and change negative grep.line values
 	while ((int) (size_t) (in - buf) < len) {
 		p = strchr (in, '\n');
@@ -382,15 +385,15 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 		}
 		total_lines++;
 	}
-	if (!cons->grep.range_line && cons->grep.line < 0) {
-		cons->grep.line = total_lines + cons->grep.line;
+	if (!ctx->grep.range_line && ctx->grep.line < 0) {
+		ctx->grep.line = total_lines + ctx->grep.line;
 	}
-	if (cons->grep.range_line == 1) {
-		if (cons->grep.f_line < 0) {
-			cons->grep.f_line = total_lines + cons->grep.f_line;
+	if (ctx->grep.range_line == 1) {
+		if (ctx->grep.f_line < 0) {
+			ctx->grep.f_line = total_lines + ctx->grep.f_line;
 		}
-		if (cons->grep.l_line < 0) {
-			cons->grep.l_line = total_lines + cons->grep.l_line;
+		if (ctx->grep.l_line < 0) {
+			ctx->grep.l_line = total_lines + ctx->grep.l_line;
 		}
 	}
 	in = buf;
@@ -409,15 +412,15 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 				ret = -1;
 			} else {
 				ret = r_cons_grep_line (tline, tl);
-				if (!cons->grep.range_line) {
-					if (cons->grep.line == cons->lines) {
+				if (!ctx->grep.range_line) {
+					if (ctx->grep.line == ctx->lines) {
 						show = true;
 					}
-				} else if (cons->grep.range_line == 1) {
-					if (cons->grep.f_line == cons->lines) {
+				} else if (ctx->grep.range_line == 1) {
+					if (ctx->grep.f_line == ctx->lines) {
 						show = true;
 					}
-					if (cons->grep.l_line == cons->lines) {
+					if (ctx->grep.l_line == ctx->lines) {
 						show = false;
 					}
 				} else {
@@ -431,10 +434,10 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 					out += ret + 1;
 					buffer_len += ret + 1;
 				}
-				if (!cons->grep.range_line) {
+				if (!ctx->grep.range_line) {
 					show = false;
 				}
-				cons->lines++;
+				ctx->lines++;
 			} else if (ret < 0) {
 				free (tbuf);
 				free (tline);
@@ -446,19 +449,19 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 		}
 	}
 	memcpy (buf, tbuf, len);
-	cons->buffer_len = buffer_len;
+	ctx->buffer_len = buffer_len;
 	free (tbuf);
 	free (tline);
-	if (cons->grep.counter) {
-		int cnt = cons->grep.charCounter? strlen (cons->buffer): cons->lines;
-		if (cons->buffer_len < 10) {
-			cons->buffer_len = 10; // HACK
+	if (ctx->grep.counter) {
+		int cnt = ctx->grep.charCounter? strlen (ctx->buffer): ctx->lines;
+		if (ctx->buffer_len < 10) {
+			ctx->buffer_len = 10; // HACK
 		}
-		snprintf (cons->buffer, cons->buffer_len, "%d\n", cnt);
-		cons->buffer_len = strlen (cons->buffer);
-		cons->num->value = cons->lines;
+		snprintf (ctx->buffer, ctx->buffer_len, "%d\n", cnt);
+		ctx->buffer_len = strlen (ctx->buffer);
+		cons->num->value = ctx->lines;
 	}
-	if (cons->grep.sort != -1) {
+	if (ctx->grep.sort != -1) {
 #define INSERT_LINES(list)\
 	do {\
 		r_list_foreach (list, iter, str) {\
@@ -473,29 +476,29 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 
 		RListIter *iter;
 		int nl = 0;
-		char *ptr = cons->buffer;
+		char *ptr = ctx->buffer;
 		char *str;
-		sorted_column = cons->grep.sort;
+		sorted_column = ctx->grep.sort;
 		r_list_sort (sorted_lines, cmp);
-		if (cons->grep.sort_invert) {
+		if (ctx->grep.sort_invert) {
 			r_list_reverse (sorted_lines);
 		}
 		INSERT_LINES (unsorted_lines);
 		INSERT_LINES (sorted_lines);
-		cons->lines = nl;
+		ctx->lines = nl;
 		r_list_free (sorted_lines);
 		sorted_lines = NULL;
 		r_list_free (unsorted_lines);
 		unsorted_lines = NULL;
 	}
-	return cons->lines;
+	return ctx->lines;
 }
 
 R_API int r_cons_grep_line(char *buf, int len) {
-	RCons *cons = r_cons_singleton ();
+	RConsContext *ctx = r_cons_context ();
 	const char *delims = " |,;=\t";
 	char *in, *out, *tok = NULL;
-	int hit = cons->grep.neg;
+	int hit = ctx->grep.neg;
 	int outlen = 0;
 	bool use_tok = false;
 	size_t i;
@@ -511,28 +514,28 @@ R_API int r_cons_grep_line(char *buf, int len) {
 	}
 	memcpy (in, buf, len);
 
-	if (cons->grep.nstrings > 0) {
-		int ampfail = cons->grep.amp;
-		for (i = 0; i < cons->grep.nstrings; i++) {
-			char *p = strstr (in, cons->grep.strings[i]);
+	if (ctx->grep.nstrings > 0) {
+		int ampfail = ctx->grep.amp;
+		for (i = 0; i < ctx->grep.nstrings; i++) {
+			char *p = strstr (in, ctx->grep.strings[i]);
 			if (!p) {
 				ampfail = 0;
 				continue;
 			}
-			if (cons->grep.begin) {
+			if (ctx->grep.begin) {
 				hit = (p == in)? 1: 0;
 			} else {
-				hit = !cons->grep.neg;
+				hit = !ctx->grep.neg;
 			}
 			// TODO: optimize without strlen without breaking t/feat_grep (grep end)
-			if (cons->grep.end && (strlen (cons->grep.strings[i]) != strlen (p))) {
+			if (ctx->grep.end && (strlen (ctx->grep.strings[i]) != strlen (p))) {
 				hit = 0;
 			}
-			if (!cons->grep.amp) {
+			if (!ctx->grep.amp) {
 				break;
 			}
 		}
-		if (cons->grep.amp) {
+		if (ctx->grep.amp) {
 			hit = ampfail;
 		}
 	} else {
@@ -540,26 +543,26 @@ R_API int r_cons_grep_line(char *buf, int len) {
 	}
 
 	if (hit) {
-		if (!cons->grep.range_line) {
-			if (cons->grep.line == cons->lines) {
+		if (!ctx->grep.range_line) {
+			if (ctx->grep.line == ctx->lines) {
 				use_tok = true;
 			}
-		} else if (cons->grep.range_line == 1) {
-			if (cons->grep.f_line == cons->lines) {
+		} else if (ctx->grep.range_line == 1) {
+			if (ctx->grep.f_line == ctx->lines) {
 				use_tok = true;
 			}
-			if (cons->grep.l_line == cons->lines) {
+			if (ctx->grep.l_line == ctx->lines) {
 				use_tok = false;
 			}
 		} else {
 			use_tok = true;
 		}
-		if (use_tok && cons->grep.tokens_used) {
+		if (use_tok && ctx->grep.tokens_used) {
 			for (i = 0; i < R_CONS_GREP_TOKENS; i++) {
 				tok = strtok (i? NULL: in, delims);
 
 				if (tok) {
-					if (cons->grep.tokens[i]) {
+					if (ctx->grep.tokens[i]) {
 						int toklen = strlen (tok);
 						memcpy (out + outlen, tok, toklen);
 						memcpy (out + outlen + toklen, " ", 2);
@@ -597,7 +600,7 @@ R_API int r_cons_grep_line(char *buf, int len) {
 	}
 	free (in);
 	free (out);
-	if (cons->grep.sort != -1) {
+	if (ctx->grep.sort != -1) {
 		char ch = buf[len];
 		buf[len] = 0;
 		if (!sorted_lines) {
@@ -606,7 +609,7 @@ R_API int r_cons_grep_line(char *buf, int len) {
 		if (!unsorted_lines) {
 			unsorted_lines = r_list_newf (free);
 		}
-		if (cons->lines > cons->grep.sort_row) {
+		if (ctx->lines > ctx->grep.sort_row) {
 			r_list_append (sorted_lines, strdup (buf));
 		} else {
 			r_list_append (unsorted_lines, strdup (buf));
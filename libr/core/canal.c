@@ -7,6 +7,9 @@
 #include <r_bin.h>
 
 #include <string.h>
+#if __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define SLOW_IO 0
 #define HASNEXT_FOREVER 1
@@ -1428,6 +1431,7 @@ R_API int r_core_anal_fcn_clean(RCore *core, ut64 addr) {
 		r_list_purge (core->anal->fcns);
 		if (!(core->anal->fcns = r_anal_fcn_list_new ()))
 			return false;
+		r_anal_fcnstore_reindex (core->anal->fcnstore, core->anal->fcns);
 	} else {
 		r_list_foreach_safe (core->anal->fcns, iter, iter_tmp, fcni) {
 			if (r_anal_fcn_in (fcni, addr)) {
@@ -2125,18 +2129,21 @@ static int fcn_list_legacy(RCore *core, RList *fcns)
 	return 0;
 }
 
+/* lists a sorted copy of the functions, so it leaves the analysis as is
+ * and can run along other readers */
 R_API int r_core_anal_fcn_list(RCore *core, const char *input, const char *rad) {
 	RList *fcns = NULL;
 	if (!core || !core->anal) {
 		return 0;
 	}
-	fcns = core->anal->fcns;
-	if (r_list_empty (fcns)) {
+	if (r_list_empty (core->anal->fcns)) {
 		return 0;
 	}
-
+	fcns = r_list_clone (core->anal->fcns);
+	if (!fcns) {
+		return -1;
+	}
 	r_list_sort (fcns, &cmpfcn);
-	fcnlist_gather_metadata (core->anal, fcns);
 
 	if (input) {// input points to a filter argument
 		const char *name = input;
@@ -2147,25 +2154,29 @@ R_API int r_core_anal_fcn_list(RCore *core, const char *input, const char *rad)
 			addr = r_num_math (core->num, name);
 		}
 
+		RList *all = fcns;
 		fcns = r_list_new ();
 		if (!fcns) {
+			r_list_free (all);
 			return -1;
 		}
 		RListIter *iter;
 		RAnalFunction *fcn;
-		r_list_foreach (core->anal->fcns, iter, fcn) {
+		r_list_foreach (all, iter, fcn) {
 			if (r_anal_fcn_in (fcn, addr) || (!strcmp (name, fcn->name))) {
 				r_list_append (fcns, fcn);
 			}
 		}
+		r_list_free (all);
 	}
 
-	r_list_sort (core->anal->fcns, &cmpfcn);
 	switch (*rad) {
 	case 's':
 		r_core_anal_fcn_list_size (core);
 		break;
 	case 'l':
+		// only the verbose listing shows it
+		fcnlist_gather_metadata (core->anal, fcns);
 		fcn_list_verbose (core, fcns);
 		break;
 	case 'q':
@@ -2188,11 +2199,8 @@ R_API int r_core_anal_fcn_list(RCore *core, const char *input, const char *rad)
 		fcn_list_default (core, fcns, false);
 		break;
 	}
-	//make sure you don't free core->anal->fcns
-	if (input && core->anal->fcns != fcns) {
-		// The list does not own the its members, so don't purge.
-		free (fcns);
-	}
+	// the list does not own its members
+	r_list_free (fcns);
 	return 0;
 }
 
@@ -2537,12 +2545,625 @@ R_API int r_core_anal_search(RCore *core, ut64 from, ut64 to, ut64 ref) {
 	return count;
 }
 
+/* anal.jobs: worker threads decode the searched range ahead of the
+ * sweep. The sweep itself stays serial and only takes an opcode from
+ * them if it was decoded at the same address with at least a full
+ * window of bytes, so the result does not depend on the number of
+ * jobs. The workers call the plugin directly because r_anal_op () goes
+ * through the core and sdb, so this is only used with reentrant anal
+ * plugins and when asm.bits can not change along the range. */
+
+#define XREFS_CHUNK 0x40000
+#define XREFS_WINDOW 32
+
+typedef struct {
+	ut64 type;
+	ut64 jump;
+	ut64 ptr;
+	ut32 delta;
+	int ret;
+} XrefsOp;
+
+typedef struct {
+	ut64 from;
+	ut8 *buf; // len + XREFS_WINDOW bytes
+	int len;
+	XrefsOp *ops;
+	int count;
+	int cur; // where the sweep is
+} XrefsChunk;
+
+typedef struct {
+	RCore *core;
+	RThreadLock *lock;
+	XrefsChunk *chunks;
+	int nchunks;
+	int used;
+	int next; // next chunk to pick by a worker
+	ut64 from; // range covered by the chunks
+	ut64 to;
+	ut64 end;
+} XrefsJobs;
+
+static int xrefs_anal_op(RAnal *anal, RAnalOp *op, ut64 addr, const ut8 *buf, int len) {
+	int ret;
+	memset (op, 0, sizeof (RAnalOp));
+	if (anal->pcalign && addr % anal->pcalign) {
+		op->type = R_ANAL_OP_TYPE_ILL;
+		return -1;
+	}
+	ret = anal->cur->op (anal, op, addr, buf, len);
+	if (ret < 1) {
+		op->type = R_ANAL_OP_TYPE_ILL;
+	}
+	return ret;
+}
+
+static void xrefs_chunk_decode(RAnal *anal, XrefsChunk *c) {
+	RAnalOp op;
+	int pos = 0, size = 0;
+	while (pos < c->len) {
+		XrefsOp *x;
+		if (c->count == size) {
+			size = size? size * 2: 1024;
+			x = realloc (c->ops, size * sizeof (XrefsOp));
+			if (!x) {
+				return;
+			}
+			c->ops = x;
+		}
+		x = &c->ops[c->count++];
+		x->delta = pos;
+		x->ret = xrefs_anal_op (anal, &op, c->from + pos, c->buf + pos,
+			c->len + XREFS_WINDOW - pos);
+		x->type = op.type;
+		x->jump = op.jump;
+		x->ptr = op.ptr;
+		r_anal_op_fini (&op);
+		pos += (x->ret > 0)? x->ret: 1;
+	}
+}
+
+static int xrefs_worker(RThread *th) {
+	XrefsJobs *xj = th->user;
+	XrefsChunk *c;
+	for (;;) {
+		r_th_lock_enter (xj->lock);
+		c = (xj->next < xj->used)? &xj->chunks[xj->next++]: NULL;
+		r_th_lock_leave (xj->lock);
+		if (!c) {
+			break;
+		}
+		xrefs_chunk_decode (xj->core->anal, c);
+	}
+	return 0;
+}
+
+static void xrefs_jobs_clear(XrefsJobs *xj) {
+	int i;
+	for (i = 0; i < xj->used; i++) {
+		free (xj->chunks[i].buf);
+		free (xj->chunks[i].ops);
+	}
+	memset (xj->chunks, 0, xj->nchunks * sizeof (XrefsChunk));
+	xj->used = 0;
+}
+
+/* decodes the next round of chunks starting at from */
+static bool xrefs_jobs_round(XrefsJobs *xj, ut64 from) {
+	RThreadPool *pool;
+	ut64 at = from;
+	xrefs_jobs_clear (xj);
+	while (xj->used < xj->nchunks && at < xj->end) {
+		XrefsChunk *c = &xj->chunks[xj->used];
+		c->from = at;
+		c->len = R_MIN (XREFS_CHUNK, xj->end - at);
+		if (!(c->buf = malloc (c->len + XREFS_WINDOW))) {
+			break;
+		}
+		r_io_read_at (xj->core->io, at, c->buf, c->len + XREFS_WINDOW);
+		at += c->len;
+		xj->used++;
+	}
+	xj->next = 0;
+	pool = r_th_pool_new (xj->nchunks, xrefs_worker, xj);
+	if (!pool) {
+		xrefs_jobs_clear (xj);
+		return false;
+	}
+	r_th_pool_free (pool);
+	xj->from = from;
+	xj->to = at;
+	return true;
+}
+
+/* the sweep is only shortcut when this does not change the result */
+static bool xrefs_jobs_usable(RCore *core) {
+	RAnalPlugin *cur = core->anal->cur;
+	RListIter *iter;
+	RIOSection *s;
+	if (!cur || !cur->op || !cur->reentrant) {
+		return false;
+	}
+	r_anal_build_range_on_hints (core->anal);
+	if (!r_list_empty (core->anal->bits_ranges)) {
+		return false;
+	}
+	r_list_foreach (core->io->sections, iter, s) {
+		if (s->arch && s->bits) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static XrefsJobs *xrefs_jobs_new(RCore *core, ut64 from, ut64 to) {
+	int jobs = r_config_get_i (core->config, "anal.jobs");
+	XrefsJobs *xj;
+	if (jobs < 2 || to - from < XREFS_CHUNK || !xrefs_jobs_usable (core)) {
+		return NULL;
+	}
+	if (!(xj = R_NEW0 (XrefsJobs))) {
+		return NULL;
+	}
+	xj->core = core;
+	xj->lock = r_th_lock_new ();
+	xj->chunks = calloc (jobs, sizeof (XrefsChunk));
+	xj->nchunks = jobs;
+	xj->from = xj->to = from;
+	xj->end = to;
+	if (!xj->lock || !xj->chunks) {
+		r_th_lock_free (xj->lock);
+		free (xj->chunks);
+		free (xj);
+		return NULL;
+	}
+	return xj;
+}
+
+static void xrefs_jobs_free(XrefsJobs *xj) {
+	if (xj) {
+		xrefs_jobs_clear (xj);
+		r_th_lock_free (xj->lock);
+		free (xj->chunks);
+		free (xj);
+	}
+}
+
+/* the opcode at addr if a worker decoded it, len is what the sweep has */
+static bool xrefs_jobs_op(XrefsJobs *xj, RAnalOp *op, ut64 addr, int len, int *ret) {
+	XrefsChunk *c;
+	XrefsOp *x;
+	ut32 delta;
+	if (!xj || len < XREFS_WINDOW || addr < xj->from || addr >= xj->end) {
+		return false;
+	}
+	if (addr >= xj->to && !xrefs_jobs_round (xj, addr)) {
+		return false;
+	}
+	c = &xj->chunks[(addr - xj->from) / XREFS_CHUNK];
+	delta = addr - c->from;
+	while (c->cur < c->count && c->ops[c->cur].delta < delta) {
+		c->cur++;
+	}
+	if (c->cur == c->count || c->ops[c->cur].delta != delta) {
+		return false;
+	}
+	x = &c->ops[c->cur];
+	memset (op, 0, sizeof (RAnalOp));
+	op->addr = addr;
+	op->type = x->type;
+	op->jump = x->jump;
+	op->ptr = x->ptr;
+	*ret = x->ret;
+	return true;
+}
+
+#define XREFS_BATCH 256
+#define XREFS_FAST_CHUNK 0x100000
+#define XREFS_FAST_TAIL 16 // longest x86 instruction and some more
+
+typedef struct {
+	RCore *core;
+	int rad;
+	int cfg_debug;
+	bool cfg_anal_strings;
+	RAnalRef refs[XREFS_BATCH];
+	int nrefs;
+	int count;
+} XrefsScan;
+
+/* validates the reference made by op and stores or prints it */
+static void xrefs_scan_op(XrefsScan *xs, RAnalOp *op, ut64 xref_from) {
+	RCore *core = xs->core;
+	RAnalRefType type = R_ANAL_REF_TYPE_NULL;
+	ut64 xref_to = UT64_MAX;
+	// Get reference type and target address
+	switch (op->type) {
+	case R_ANAL_OP_TYPE_JMP:
+	case R_ANAL_OP_TYPE_CJMP:
+		type = R_ANAL_REF_TYPE_CODE;
+		xref_to = op->jump;
+		break;
+	case R_ANAL_OP_TYPE_CALL:
+	case R_ANAL_OP_TYPE_CCALL:
+		type = R_ANAL_REF_TYPE_CALL;
+		xref_to = op->jump;
+		break;
+	case R_ANAL_OP_TYPE_UJMP:
+	case R_ANAL_OP_TYPE_IJMP:
+	case R_ANAL_OP_TYPE_RJMP:
+	case R_ANAL_OP_TYPE_IRJMP:
+	case R_ANAL_OP_TYPE_MJMP:
+	case R_ANAL_OP_TYPE_UCJMP:
+		type = R_ANAL_REF_TYPE_CODE;
+		xref_to = op->ptr;
+		break;
+	case R_ANAL_OP_TYPE_UCALL:
+	case R_ANAL_OP_TYPE_ICALL:
+	case R_ANAL_OP_TYPE_RCALL:
+	case R_ANAL_OP_TYPE_IRCALL:
+	case R_ANAL_OP_TYPE_UCCALL:
+		type = R_ANAL_REF_TYPE_CALL;
+		xref_to = op->ptr;
+		break;
+	case R_ANAL_OP_TYPE_LOAD:
+		type = R_ANAL_REF_TYPE_DATA;
+		xref_to = op->ptr;
+		break;
+	default:
+		if (op->ptr != -1) {
+			type = R_ANAL_REF_TYPE_DATA;
+			xref_to = op->ptr;
+		}
+		break;
+	}
+
+	// Validate the reference. If virtual addressing is enabled, we
+	// allow only references to virtual addresses in order to reduce
+	// the number of false positives. In debugger mode, the reference
+	// must point to a mapped memory region.
+	if (type == R_ANAL_REF_TYPE_NULL) {
+		return;
+	}
+	if (!r_core_is_valid_offset (core, xref_to)) {
+		return;
+	}
+	if (xs->cfg_debug) {
+		if (!r_debug_map_get (core->dbg, xref_to)) {
+			return;
+		}
+	} else if (core->io->va) {
+		RListIter *iter = NULL;
+		RIOSection *s;
+		r_list_foreach (core->io->sections, iter, s) {
+			if (xref_to >= s->vaddr && xref_to < s->vaddr + s->vsize) {
+				if (s->vaddr) break;
+			}
+		}
+		if (!iter) {
+			return;
+		}
+	}
+	if (!xs->rad) {
+		if (xs->cfg_anal_strings && type == R_ANAL_REF_TYPE_DATA) {
+			int len = 0;
+			char *str_string = is_string_at (core, xref_to, &len);
+			if (str_string) {
+				r_name_filter (str_string, -1);
+				char *str_flagname = r_str_newf ("str.%s", str_string);
+				r_flag_space_push (core->flags, "strings");
+				(void)r_flag_set (core->flags, str_flagname, xref_to, 1);
+				r_flag_space_pop (core->flags);
+			}
+			if (len > 0) {
+				r_meta_add (core->anal, R_META_TYPE_STRING, xref_to,
+						xref_to + len, (const char *)str_string);
+			}
+			free (str_string);
+		}
+		// queue it, the refs are stored in batches
+		xs->refs[xs->nrefs].type = type;
+		xs->refs[xs->nrefs].at = xref_from;
+		xs->refs[xs->nrefs].addr = xref_to;
+		if (++xs->nrefs == XREFS_BATCH) {
+			r_anal_xrefs_set_n (core->anal, xs->refs, xs->nrefs);
+			xs->nrefs = 0;
+		}
+	} else if (xs->rad == 'j') {
+		// Output JSON
+		if (xs->count > 0) {
+			r_cons_printf (",");
+		}
+		r_cons_printf ("\"0x%"PFMT64x"\":\"0x%"PFMT64x"\"", xref_to, xref_from);
+	} else {
+		int len = 0;
+		// Display in radare commands format
+		char *cmd;
+		switch (type) {
+		case R_ANAL_REF_TYPE_CODE: cmd = "axc"; break;
+		case R_ANAL_REF_TYPE_CALL: cmd = "axC"; break;
+		case R_ANAL_REF_TYPE_DATA: cmd = "axd"; break;
+		default: cmd = "ax"; break;
+		}
+		r_cons_printf ("%s 0x%08"PFMT64x" 0x%08"PFMT64x"\n", cmd, xref_to, xref_from);
+		if (xs->cfg_anal_strings && type == R_ANAL_REF_TYPE_DATA) {
+			char *str_flagname = is_string_at (core, xref_to, &len);
+			if (str_flagname) {
+				ut64 str_addr = xref_to;
+				r_name_filter (str_flagname, -1);
+				r_cons_printf ("f str.%s=0x%"PFMT64x"\n", str_flagname, str_addr);
+				r_cons_printf ("Cs %d @ 0x%"PFMT64x"\n", len, str_addr);
+				free (str_flagname);
+			}
+		}
+	}
+	xs->count++;
+}
+
+/* anal.fastxrefs: instead of sweeping linearly only the instructions
+ * which can make a reference are decoded. The bytes are prefiltered on
+ * their opcode (16 at a time with sse2) and only the candidates go to
+ * the anal plugin, so most of the code is never decoded. Candidates
+ * overlapping the last accepted instruction are skipped, but it is
+ * still less precise than the sweep. */
+enum {
+	XREFS_FAST_NONE,
+	XREFS_FAST_X86,
+	XREFS_FAST_ARM,
+	XREFS_FAST_ARM64
+};
+
+typedef struct {
+	ut32 mask;
+	ut32 value;
+} XrefsInsn;
+
+static const XrefsInsn xrefs_arm[] = {
+	{ 0x0e000000, 0x0a000000 }, // b, bl, blx
+	{ 0x0e5f0000, 0x041f0000 }, // ldr rd, [pc, imm]
+	{ 0, 0 }
+};
+
+static const XrefsInsn xrefs_arm64[] = {
+	{ 0x7c000000, 0x14000000 }, // b, bl
+	{ 0xff000010, 0x54000000 }, // b.cond
+	{ 0x7e000000, 0x34000000 }, // cbz, cbnz
+	{ 0x7e000000, 0x36000000 }, // tbz, tbnz
+	{ 0x1f000000, 0x10000000 }, // adr, adrp
+	{ 0x3b000000, 0x18000000 }, // ldr literal
+	{ 0, 0 }
+};
+
+static int xrefs_fast_kind(RCore *core) {
+	RAnal *anal = core->anal;
+	RListIter *iter;
+	RIOSection *s;
+	if (!r_config_get_i (core->config, "anal.fastxrefs")) {
+		return XREFS_FAST_NONE;
+	}
+	if (!anal->cur || !anal->cur->op || !anal->cur->arch) {
+		return XREFS_FAST_NONE;
+	}
+	// mixed code needs the sweep
+	r_anal_build_range_on_hints (anal);
+	if (!r_list_empty (anal->bits_ranges)) {
+		return XREFS_FAST_NONE;
+	}
+	r_list_foreach (core->io->sections, iter, s) {
+		if (s->arch && s->bits) {
+			return XREFS_FAST_NONE;
+		}
+	}
+	if (!strcmp (anal->cur->arch, "x86")) {
+		return (anal->bits == 32 || anal->bits == 64)? XREFS_FAST_X86: XREFS_FAST_NONE;
+	}
+	if (!strcmp (anal->cur->arch, "arm") && !anal->big_endian) {
+		switch (anal->bits) {
+		case 32: return XREFS_FAST_ARM;
+		case 64: return XREFS_FAST_ARM64;
+		}
+	}
+	return XREFS_FAST_NONE;
+}
+
+/* opcodes taking a modrm byte which can address memory */
+static bool x86_modrm_op(ut8 c) {
+	switch (c) {
+	case 0x01: case 0x03: case 0x09: case 0x0b:
+	case 0x11: case 0x13: case 0x19: case 0x1b:
+	case 0x21: case 0x23: case 0x29: case 0x2b:
+	case 0x31: case 0x33: case 0x39: case 0x3b:
+	case 0x63: case 0x69: case 0x6b:
+	case 0x80: case 0x81: case 0x83: case 0x84: case 0x85:
+	case 0x86: case 0x87: case 0x88: case 0x89: case 0x8a:
+	case 0x8b: case 0x8d: case 0xc6: case 0xc7: case 0xd9:
+	case 0xdd: case 0xf6: case 0xf7: case 0xfe: case 0xff:
+		return true;
+	}
+	return false;
+}
+
+static inline bool x86_interesting(ut8 c) {
+	return c == 0xe8 || c == 0xe9 || c == 0xeb || c == 0x0f
+		|| (c & 0xf0) == 0x70 || (c & 0xc7) == 0x05;
+}
+
+/* next position from p which can be a branch opcode or a modrm byte
+ * addressing [rip + disp32] (absolute disp32 in 32 bits) */
+static int x86_next(const ut8 *buf, int p, int len) {
+#if __SSE2__
+	const __m128i e8 = _mm_set1_epi8 ((char)0xe8);
+	const __m128i e9 = _mm_set1_epi8 ((char)0xe9);
+	const __m128i eb = _mm_set1_epi8 ((char)0xeb);
+	const __m128i of = _mm_set1_epi8 (0x0f);
+	const __m128i hi = _mm_set1_epi8 ((char)0xf0);
+	const __m128i jcc = _mm_set1_epi8 (0x70);
+	const __m128i mrm = _mm_set1_epi8 ((char)0xc7);
+	const __m128i rip = _mm_set1_epi8 (0x05);
+	for (; p + 16 <= len; p += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(buf + p));
+		__m128i m = _mm_or_si128 (
+			_mm_or_si128 (_mm_cmpeq_epi8 (v, e8), _mm_cmpeq_epi8 (v, e9)),
+			_mm_or_si128 (_mm_cmpeq_epi8 (v, eb), _mm_cmpeq_epi8 (v, of)));
+		m = _mm_or_si128 (m, _mm_cmpeq_epi8 (_mm_and_si128 (v, hi), jcc));
+		m = _mm_or_si128 (m, _mm_cmpeq_epi8 (_mm_and_si128 (v, mrm), rip));
+		int bits = _mm_movemask_epi8 (m);
+		if (bits) {
+			return p + __builtin_ctz (bits);
+		}
+	}
+#endif
+	while (p < len && !x86_interesting (buf[p])) {
+		p++;
+	}
+	return p;
+}
+
+/* where the instruction using the byte at p would start, -1 if none.
+ * size is the minimum length it must decode to */
+static int x86_candidate(const ut8 *buf, int p, int bits, int *size) {
+	ut8 c = buf[p];
+	int start = -1;
+	switch (c) {
+	case 0xe8:
+	case 0xe9:
+		*size = 5;
+		return p;
+	case 0xeb:
+		*size = 2;
+		return p;
+	case 0x0f:
+		if ((buf[p + 1] & 0xf0) == 0x80) {
+			*size = 6;
+			return p;
+		}
+		break;
+	}
+	if ((c & 0xf0) == 0x70) {
+		*size = 2;
+		return p;
+	}
+	if ((c & 0xc7) == 0x05) {
+		if (p >= 2 && buf[p - 2] == 0x0f) {
+			if ((buf[p - 1] & 0xf0) != 0x80) {
+				start = p - 2;
+			}
+		} else if (p >= 1 && x86_modrm_op (buf[p - 1])) {
+			start = p - 1;
+		}
+		if (start < 0) {
+			return -1;
+		}
+		if (start > 0 && bits == 64 && (buf[start - 1] & 0xf0) == 0x40) {
+			start--; // rex
+		}
+		if (start > 0 && buf[start - 1] == 0x66) {
+			start--;
+		}
+		*size = p - start + 5;
+	}
+	return start;
+}
+
+/* first aligned word from p matching one of the instructions */
+static int arm_next(const XrefsInsn *insns, const ut8 *buf, int p, int len) {
+	int i;
+#if __SSE2__
+	for (; p + 16 <= len; p += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(buf + p));
+		__m128i m = _mm_setzero_si128 ();
+		int bits;
+		for (i = 0; insns[i].mask; i++) {
+			__m128i mask = _mm_set1_epi32 (insns[i].mask);
+			__m128i value = _mm_set1_epi32 (insns[i].value);
+			m = _mm_or_si128 (m, _mm_cmpeq_epi32 (_mm_and_si128 (v, mask), value));
+		}
+		bits = _mm_movemask_epi8 (m);
+		if (bits) {
+			return p + __builtin_ctz (bits);
+		}
+	}
+#endif
+	for (; p + 4 <= len; p += 4) {
+		ut32 w = r_read_le32 (buf + p);
+		for (i = 0; insns[i].mask; i++) {
+			if ((w & insns[i].mask) == insns[i].value) {
+				return p;
+			}
+		}
+	}
+	return len;
+}
+
+/* decodes the candidates in the len bytes at, avail are readable */
+static void xrefs_fast_block(XrefsScan *xs, int kind, ut64 at, const ut8 *buf, int len, int avail, int *skip) {
+	RAnal *anal = xs->core->anal;
+	const XrefsInsn *insns = (kind == XREFS_FAST_ARM64)? xrefs_arm64: xrefs_arm;
+	RAnalOp op = { 0 };
+	int p = *skip;
+	if (kind != XREFS_FAST_X86) {
+		p += (4 - ((at + p) & 3)) & 3;
+	}
+	while (p < len && !r_cons_is_breaked ()) {
+		int start = p, size = 4, ret;
+		if (kind == XREFS_FAST_X86) {
+			p = x86_next (buf, p, len);
+			if (p == len) {
+				break;
+			}
+			start = x86_candidate (buf, p, anal->bits, &size);
+			if (start < *skip) {
+				p++;
+				continue;
+			}
+		} else {
+			p = start = arm_next (insns, buf, p, len);
+			if (p == len) {
+				break;
+			}
+		}
+		r_anal_op_fini (&op);
+		ret = r_anal_op (anal, &op, at + start, buf + start, avail - start);
+		if (ret < size) {
+			p += (kind == XREFS_FAST_X86)? 1: 4;
+			continue;
+		}
+		xrefs_scan_op (xs, &op, at + start);
+		p = *skip = start + ret;
+	}
+	r_anal_op_fini (&op);
+	*skip = (*skip > len)? *skip - len: 0;
+}
+
+static void xrefs_fast_scan(XrefsScan *xs, int kind, ut64 from, ut64 to) {
+	RIO *io = xs->core->io;
+	ut8 *buf = malloc (XREFS_FAST_CHUNK + XREFS_FAST_TAIL);
+	ut64 at = from;
+	int skip = 0;
+	if (!buf) {
+		return;
+	}
+	while (at < to && !r_cons_is_breaked ()) {
+		int len = R_MIN (XREFS_FAST_CHUNK, to - at);
+		int avail = len + XREFS_FAST_TAIL;
+		const ut8 *data;
+		if (!r_io_read_at_ptr (io, at, avail, &data)) {
+			r_io_read_at (io, at, buf, avail);
+			data = buf;
+		}
+		xrefs_fast_block (xs, kind, at, data, len, avail, &skip);
+		at += len;
+	}
+	free (buf);
+}
+
 R_API int r_core_anal_search_xrefs(RCore *core, ut64 from, ut64 to, int rad) {
-	int cfg_debug = r_config_get_i (core->config, "cfg.debug");
-	bool cfg_anal_strings = r_config_get_i (core->config, "anal.strings");
+	XrefsScan xs = { 0 };
+	XrefsJobs *jobs;
 	ut8 *buf;
 	ut64 at;
-	int count = 0;
+	int kind;
 	RAnalOp op = { 0 };
 	if (from == to) {
 		return -1;
@@ -2562,156 +3183,60 @@ R_API int r_core_anal_search_xrefs(RCore *core, ut64 from, ut64 to, int rad) {
 		eprintf ("Error: cannot allocate a block\n");
 		return -1;
 	}
+	xs.core = core;
+	xs.rad = rad;
+	xs.cfg_debug = r_config_get_i (core->config, "cfg.debug");
+	xs.cfg_anal_strings = r_config_get_i (core->config, "anal.strings");
 	if (rad == 'j') {
 		r_cons_printf ("{");
 	}
 	r_io_use_desc (core->io, core->file->desc);
+	kind = xrefs_fast_kind (core);
+	jobs = kind? NULL: xrefs_jobs_new (core, from, to);
 	r_cons_break_push (NULL, NULL);
-	at = from;
+	if (kind) {
+		xrefs_fast_scan (&xs, kind, from, to);
+		at = to;
+	} else {
+		at = from;
+	}
 	while (at < to && !r_cons_is_breaked ()) {
+		const ut8 *data;
 		int i, ret;
-		ret = r_io_read_at (core->io, at, buf, core->blocksize);
+		// nothing below writes, so the mapped bytes can be used directly
+		ret = r_io_read_at_ptr (core->io, at, core->blocksize, &data);
+		if (!ret) {
+			ret = r_io_read_at (core->io, at, buf, core->blocksize);
+			data = buf;
+		}
 		if (ret != core->blocksize && at + ret-OPSZ < to) {
 			break;
 		}
 		i = 0;
 		while (at + i < to && i < ret-OPSZ && !r_cons_is_breaked ()) {
-			RAnalRefType type;
-			ut64 xref_from, xref_to;
-			xref_from = at + i;
+			ut64 xref_from = at + i;
 			r_anal_op_fini (&op);
-			ret = r_anal_op (core->anal, &op, at + i, buf + i, core->blocksize - i);
+			if (!xrefs_jobs_op (jobs, &op, at + i, core->blocksize - i, &ret)) {
+				ret = r_anal_op (core->anal, &op, at + i, data + i, core->blocksize - i);
+			}
 			i += (ret > 0) ? ret : 1;
 			if (ret <= 0 || at + i > to) {
 				continue;
 			}
-			// Get reference type and target address
-			type = R_ANAL_REF_TYPE_NULL;
-			switch (op.type) {
-			case R_ANAL_OP_TYPE_JMP:
-			case R_ANAL_OP_TYPE_CJMP:
-				type = R_ANAL_REF_TYPE_CODE;
-				xref_to = op.jump;
-				break;
-			case R_ANAL_OP_TYPE_CALL:
-			case R_ANAL_OP_TYPE_CCALL:
-				type = R_ANAL_REF_TYPE_CALL;
-				xref_to = op.jump;
-				break;
-			case R_ANAL_OP_TYPE_UJMP:
-			case R_ANAL_OP_TYPE_IJMP:
-			case R_ANAL_OP_TYPE_RJMP:
-			case R_ANAL_OP_TYPE_IRJMP:
-			case R_ANAL_OP_TYPE_MJMP:
-			case R_ANAL_OP_TYPE_UCJMP:
-				type = R_ANAL_REF_TYPE_CODE;
-				xref_to = op.ptr;
-				break;
-			case R_ANAL_OP_TYPE_UCALL:
-			case R_ANAL_OP_TYPE_ICALL:
-			case R_ANAL_OP_TYPE_RCALL:
-			case R_ANAL_OP_TYPE_IRCALL:
-			case R_ANAL_OP_TYPE_UCCALL:
-				type = R_ANAL_REF_TYPE_CALL;
-				xref_to = op.ptr;
-				break;
-			case R_ANAL_OP_TYPE_LOAD:
-				type = R_ANAL_REF_TYPE_DATA;
-				xref_to = op.ptr;
-				break;
-			default:
-				if (op.ptr != -1) {
-					type = R_ANAL_REF_TYPE_DATA;
-					xref_to = op.ptr;
-				}
-				break;
-			}
-
-			// Validate the reference. If virtual addressing is enabled, we
-			// allow only references to virtual addresses in order to reduce
-			// the number of false positives. In debugger mode, the reference
-			// must point to a mapped memory region.
-			if (type == R_ANAL_REF_TYPE_NULL) {
-				continue;
-			}
-			if (!r_core_is_valid_offset (core, xref_to)) {
-				continue;
-			}
-			if (cfg_debug) {
-				if (!r_debug_map_get (core->dbg, xref_to)) {
-					continue;
-				}
-			} else if (core->io->va) {
-				RListIter *iter = NULL;
-				RIOSection *s;
-				r_list_foreach (core->io->sections, iter, s) {
-					if (xref_to >= s->vaddr && xref_to < s->vaddr + s->vsize) {
-						if (s->vaddr) break;
-					}
-				}
-				if (!iter) {
-					continue;
-				}
-			}
-			if (!rad) {
-				if (cfg_anal_strings && type == R_ANAL_REF_TYPE_DATA) {
-					int len = 0;
-					char *str_string = is_string_at (core, xref_to, &len);
-					if (str_string) {
-						r_name_filter (str_string, -1);
-						char *str_flagname = r_str_newf ("str.%s", str_string);
-						r_flag_space_push (core->flags, "strings");
-						(void)r_flag_set (core->flags, str_flagname, xref_to, 1);
-						r_flag_space_pop (core->flags);
-					}
-					if (len > 0) {
-						r_meta_add (core->anal, R_META_TYPE_STRING, xref_to,
-								xref_to + len, (const char *)str_string);
-					}
-					free (str_string);
-				}
-				// Add to SDB
-				r_anal_xrefs_set (core->anal, type, xref_from, xref_to);
-			} else if (rad == 'j') {
-				// Output JSON
-				if (count > 0) {
-					r_cons_printf (",");
-				}
-				r_cons_printf ("\"0x%"PFMT64x"\":\"0x%"PFMT64x"\"", xref_to, xref_from);
-			} else {
-				int len = 0;
-				// Display in radare commands format
-				char *cmd;
-				switch (type) {
-				case R_ANAL_REF_TYPE_CODE: cmd = "axc"; break;
-				case R_ANAL_REF_TYPE_CALL: cmd = "axC"; break;
-				case R_ANAL_REF_TYPE_DATA: cmd = "axd"; break;
-				default: cmd = "ax"; break;
-				}
-				r_cons_printf ("%s 0x%08"PFMT64x" 0x%08"PFMT64x"\n", cmd, xref_to, xref_from);
-				if (cfg_anal_strings && type == R_ANAL_REF_TYPE_DATA) {
-					char *str_flagname = is_string_at (core, xref_to, &len);
-					if (str_flagname) {
-						ut64 str_addr = xref_to;
-						r_name_filter (str_flagname, -1);
-						r_cons_printf ("f str.%s=0x%"PFMT64x"\n", str_flagname, str_addr);
-						r_cons_printf ("Cs %d @ 0x%"PFMT64x"\n", len, str_addr);
-						free (str_flagname);
-					}
-				}
-			}
-			count++;
+			xrefs_scan_op (&xs, &op, xref_from);
 		}
 
 		at += i;
 	}
 	r_cons_break_pop ();
+	r_anal_xrefs_set_n (core->anal, xs.refs, xs.nrefs);
+	xrefs_jobs_free (jobs);
 	free (buf);
 	r_anal_op_fini (&op);
 	if (rad == 'j') {
 		r_cons_printf ("}\n");
 	}
-	return count;
+	return xs.count;
 }
 
 R_API int r_core_anal_ref_list(RCore *core, int rad) {
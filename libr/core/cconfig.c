@@ -1414,6 +1414,22 @@ static int cb_trace(void *user, void *data) {
 	return true;
 }
 
+static int cb_dbgrecord(void *user, void *data) {
+	RCore *core = (RCore *) user;
+	RConfigNode *node = (RConfigNode *) data;
+	r_debug_record_set (core->dbg, node->i_value);
+	return true;
+}
+
+static int cb_dbgtracelog(void *user, void *data) {
+	RCore *core = (RCore *) user;
+	RConfigNode *node = (RConfigNode *) data;
+	if (core->dbg->bp->tracelog) {
+		return r_bp_tracelog_init (core->dbg->bp, node->i_value);
+	}
+	return true;
+}
+
 static int cb_tracetag(void *user, void *data) {
 	RCore *core = (RCore *) user;
 	RConfigNode *node = (RConfigNode *) data;
@@ -1524,6 +1540,30 @@ static int cb_binmaxstrbuf(void *user, void *data) {
 	return true;
 }
 
+static int cb_binstrjobs(void *user, void *data) {
+	RCore *core = (RCore *) user;
+	RConfigNode *node = (RConfigNode *) data;
+	if (node->i_value < 1) {
+		node->i_value = 1;
+	}
+	if (core->bin) {
+		core->bin->strjobs = node->i_value;
+	}
+	return true;
+}
+
+static int cb_diffjobs(void *user, void *data) {
+	RCore *core = (RCore *) user;
+	RConfigNode *node = (RConfigNode *) data;
+	if (node->i_value < 1) {
+		node->i_value = 1;
+	}
+	if (core->anal) {
+		core->anal->diff_jobs = node->i_value;
+	}
+	return true;
+}
+
 static int cb_binmaxstr(void *user, void *data) {
 	RCore *core = (RCore *) user;
 	RConfigNode *node = (RConfigNode *) data;
@@ -1763,6 +1803,8 @@ R_API int r_core_config_init(RCore *core) {
 	SETCB("anal.eobjmp", "false", &cb_analeobjmp, "jmp is end of block mode (option)");
 	SETCB("anal.afterjmp", "true", &cb_analafterjmp, "Continue analysis after jmp/ujmp");
 	SETI("anal.depth", 16, "Max depth at code analysis"); // XXX: warn if depth is > 50 .. can be problematic
+	SETI("anal.jobs", 1, "Threads decoding ahead in the xref search, only used by aar (and aaa), needs a reentrant anal plugin");
+	SETPREF("anal.fastxrefs", "false", "Only decode the instructions which can make refs in aar (x86, arm), faster but less precise");
 	SETICB("anal.sleep", 0, &cb_analsleep, "Sleep N usecs every so often during analysis. Avoid 100% CPU usage");
 	SETPREF("anal.calls", "false", "Make basic af analysis walk into calls");
 	SETPREF("anal.autoname", "true", "Automatically set a name for the functions, may result in some false positives");
@@ -1919,6 +1961,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETICB("bin.minstr", 0, &cb_binminstr, "Minimum string length for r_bin");
 	SETICB("bin.maxstr", 0, &cb_binmaxstr, "Maximum string length for r_bin");
 	SETICB("bin.maxstrbuf", 1024*1024*10, & cb_binmaxstrbuf, "Maximum size of range to load strings from");
+	SETICB("bin.strjobs", 1, &cb_binstrjobs, "Threads extracting the strings of big sections");
 	SETCB("bin.prefix", NULL, &cb_binprefix, "Prefix all symbols/sections/relocs with a specific string");
 	SETCB("bin.rawstr", "false", &cb_rawstr, "Load strings from raw binaries");
 	SETCB("bin.strings", "true", &cb_binstrings, "Load strings from rbin on startup");
@@ -1932,6 +1975,8 @@ R_API int r_core_config_init(RCore *core) {
 	SETPREF("prj.files", "false", "Save the target binary inside the project directory");
 	SETPREF("prj.git", "false", "Every project is a git repo and saving is committing");
 	SETPREF("prj.zip", "false", "Use ZIP format for project files");
+	SETPREF("prj.snapshot", "true", "Save the analysis in a binary snapshot, the rc script only keeps the rest");
+	SETPREF("prj.journal", "true", "Append the changes to the journal of the snapshot instead of rewriting it");
 	SETPREF("prj.gpg", "false", "TODO: Encrypt project with GnuPGv2");
 
 	/* cfg */
@@ -1963,6 +2008,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETI("zign.maxsz", 500, "Maximum zignature length");
 	SETI("zign.minsz", 16, "Minimum zignature length for matching");
 	SETI("zign.mincc", 10, "Minimum cyclomatic complexity for matching");
+	SETI("zign.jobs", 1, "Threads matching the functions against the zignatures (z/)");
 	SETPREF("zign.graph", "true", "Use graph metrics for matching");
 	SETPREF("zign.bytes", "true", "Use bytes patterns for matching");
 	SETPREF("zign.offset", "true", "Use original offset for matching");
@@ -1974,6 +2020,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETI("diff.to", 0, "Set destination diffing address for px (uses cc command)");
 	SETPREF("diff.bare", "false", "Never show function names in diff output");
 	SETPREF("diff.levenstein", "false", "Use faster (and buggy) levenstein algorithm for buffer distance diffing");
+	SETICB("diff.jobs", 1, &cb_diffjobs, "Threads comparing the functions in the code diff");
 
 	/* dir */
 	SETPREF("dir.magic", R_MAGIC_PATH, "Path to r_magic files");
@@ -2041,6 +2088,8 @@ R_API int r_core_config_init(RCore *core) {
 	SETICB("dbg.btdepth", 128, &cb_dbgbtdepth, "Depth of backtrace");
 	SETCB("dbg.trace", "false", &cb_trace, "Trace program execution (see asm.trace)");
 	SETICB("dbg.trace.tag", 0, &cb_tracetag, "Trace tag");
+	SETICB("dbg.record", 0, &cb_dbgrecord, "Record the last N steps to undo them with dsb and dcb (0 to disable)");
+	SETICB("dbg.tracelog", 65536, &cb_dbgtracelog, "Number of hits the trace-only breakpoints can log (see dbtl)");
 
 	/* cmd */
 	char *xdotPath = r_file_path ("xdot");
@@ -2068,6 +2117,7 @@ R_API int r_core_config_init(RCore *core) {
 	r_config_desc (cfg, "cmd.graph", "Command executed by 'agv' command to view graphs");
 	SETPREF("cmd.xterm", "xterm -bg black -fg gray -e", "xterm command to spawn with V@");
 	SETICB("cmd.depth", 10, &cb_cmddepth, "Maximum command depth");
+	SETI("tasks.jobs", 2, "Threads running the background tasks (&), read when the first one is queued");
 	SETPREF("cmd.bp", "", "Run when a breakpoint is hit");
 	SETICB("cmd.hitinfo", 1, &cb_debug_hitinfo, "Show info when a tracepoint/breakpoint is hit");
 	SETPREF("cmd.times", "", "Run when a command is repeated (number prefix)");
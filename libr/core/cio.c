@@ -259,7 +259,11 @@ static void choose_bits_anal_hints(RCore *core, ut64 addr, int *bits) {
 }
 
 
+/* called for every instruction printed, the setters only run when the
+ * address changes the arch or bits */
 R_API void r_core_seek_archbits(RCore *core, ut64 addr) {
+	static RConfigHandle asm_arch = R_CONFIG_HANDLE ("asm.arch");
+	static RConfigHandle asm_bits = R_CONFIG_HANDLE ("asm.bits");
 	int bits = 0;
 	const char *arch = r_io_section_get_archbits (core->io, addr, &bits);
 	if (!bits) {
@@ -267,10 +271,10 @@ R_API void r_core_seek_archbits(RCore *core, ut64 addr) {
 		choose_bits_anal_hints (core, addr, &bits);
 	}
 	if (bits) {
-		r_config_set_i (core->config, "asm.bits", bits);
+		r_config_handle_set_i (core->config, &asm_bits, bits);
 	}
 	if (arch) {
-		r_config_set (core->config, "asm.arch", arch);
+		r_config_handle_set (core->config, &asm_arch, arch);
 	}
 }
 
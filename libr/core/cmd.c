@@ -689,6 +689,8 @@ static int cmd_kuery(void *data, const char *input) {
 	const int buflen = sizeof (buf) - 1;
 	Sdb *s = core->sdb;
 
+	// the xrefs are only kept in sdb format on demand
+	r_anal_xrefs_sync (core->anal);
 	switch (input[0]) {
 	case ' ':
 		out = sdb_querys (s, NULL, 0, input + 1);
@@ -972,22 +974,20 @@ static int cmd_visual(void *data, const char *input) {
 	return r_core_visual ((RCore *)data, input);
 }
 
-static int task_finished(void *user, void *data) {
-	eprintf ("TASK FINISHED\n");
-	return 0;
+static void task_finished(void *user, char *out) {
+	RCoreTask *task = user;
+	if (!out) {
+		eprintf ("Task %d finished\n", task->id);
+	}
 }
 
-static int taskbgrun(RThread *th) {
-	char *res;
-	RCoreTask *task = th->user;
-	RCore *core = task->core;
-	close (2); // no stderr
-	res = r_core_cmd_str (core, task->msg->text);
-	task->msg->res = res;
-	task->state = 'd';
-	eprintf ("Task %d finished\n", task->id);
-// TODO: run callback and pass result
-	return 0;
+static void task_bg(RCore *core, const char *cmd, bool readonly) {
+	RCoreTask *task = r_core_task_new (core, cmd, task_finished, NULL);
+	if (task) {
+		task->user = task;
+		task->readonly = readonly;
+		r_core_task_add_bg (core, task);
+	}
 }
 
 static int cmd_thread(void *data, const char *input) {
@@ -1021,17 +1021,34 @@ static int cmd_thread(void *data, const char *input) {
 		if (tid) {
 			RCoreTask *task = r_core_task_get (core, tid);
 			if (task) {
+				char *out = r_core_task_output (core, task);
 				r_cons_printf ("Task %d Status %c Command %s\n",
 					task->id, task->state, task->msg->text);
-				if (task->msg->res)
-					r_cons_println (task->msg->res);
+				r_cons_println (out);
+				free (out);
 			} else eprintf ("Cannot find task\n");
 		} else {
 			r_core_task_list (core, 1);
 		}}
 		break;
 	case '+':
-		r_core_task_add (core, r_core_task_new (core, input + 1, (RCoreTaskCallback)task_finished, core));
+		r_core_task_add (core, r_core_task_new (core, input + 1, NULL, NULL));
+		break;
+	case 'r':
+		if (input[1] == ' ') {
+			task_bg (core, input + 2, true);
+		} else {
+			eprintf ("Usage: &r [cmd]\n");
+		}
+		break;
+	case 'b': {
+		RCoreTask *task = r_core_task_get (core, r_num_math (core->num, input + 1));
+		if (task) {
+			r_core_task_break (core, task);
+		} else {
+			eprintf ("Cannot find task\n");
+		}
+		}
 		break;
 	case '-':
 		if (input[1] == '*') {
@@ -1056,13 +1073,8 @@ static int cmd_thread(void *data, const char *input) {
 					eprintf ("Cannot find task\n");
 				}
 			} else {
-				RCoreTask *task = r_core_task_add (core, r_core_task_new (
-							core, input + 1, (RCoreTaskCallback)task_finished, core));
-				RThread *th = r_th_new (taskbgrun, task, 0);
-				task->msg->th = th;
+				task_bg (core, input + 1, false);
 			}
-			//r_core_cmd0 (core, task->msg->text);
-			//r_core_task_del (core, task->id);
 		}
 		break;
 	default:
@@ -2441,7 +2453,7 @@ R_API int r_core_cmd_foreach(RCore *core, const char *cmd, char *each) {
 			RAnalFunction *fcn;
 			RListIter *iter;
 			if (core->anal) {
-				RConsGrep grep = core->cons->grep;
+				RConsGrep grep = r_cons_context ()->grep;
 				r_list_foreach (core->anal->fcns, iter, fcn) {
 					char *buf;
 					r_core_seek (core, fcn->addr, 1);
@@ -2458,7 +2470,7 @@ R_API int r_core_cmd_foreach(RCore *core, const char *cmd, char *each) {
 						break;
 					}
 				}
-				core->cons->grep = grep;
+				r_cons_context ()->grep = grep;
 			}
 			free (ostr);
 			goto out_finish;
@@ -3960,7 +3960,10 @@ static bool cmd_anal_refs(RCore *core, const char *input) {
 		break;
 	case 'k': // "axk"
 		if (input[1] == ' ') {
-			sdb_query (core->anal->sdb_xrefs, input + 2);
+			r_anal_xrefs_sync (core->anal);
+			if (sdb_query (core->anal->sdb_xrefs, input + 2)) {
+				r_anal_xrefs_load (core->anal);
+			}
 		} else {
 			eprintf ("|ERROR| Usage: axk [query]\n");
 		}
@@ -5430,6 +5433,7 @@ static bool anal_fcn_data_gaps (RCore *core, const char *input) {
 	RListIter *iter;
 	int i, wordsize = (core->assembler->bits == 64)? 8: 4;
 	r_list_sort (core->anal->fcns, cmpaddr);
+	r_anal_fcnstore_reindex (core->anal->fcnstore, core->anal->fcns);
 	r_list_foreach (core->anal->fcns, iter, fcn) {
 		if (end != UT64_MAX) {
 			int range = fcn->addr - end;
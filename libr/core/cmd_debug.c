@@ -2085,6 +2085,9 @@ static void r_core_cmd_bp(RCore *core, const char *input) {
 		"dbte", " <addr>", "Enable Breakpoint Trace",
 		"dbtd", " <addr>", "Disable Breakpoint Trace",
 		"dbts", " <addr>", "Swap Breakpoint Trace",
+		"dbtl", " <addr>", "Log the hits of the breakpoint without stopping (* for all)",
+		"dbtl-", " <addr>", "Make the breakpoint stop again (* for all)",
+		"dbtL", "[j]", "List the logged hits (dbtL- to clear them)",
 		"dbm", " <module> <offset>", "Add a breakpoint at an offset from a module's base",
 		"dbn", " [<name>]", "Show or set name for current breakpoint",
 		//
@@ -2182,6 +2185,28 @@ static void r_core_cmd_bp(RCore *core, const char *input) {
 					eprintf ("Cannot unset tracepoint\n");
 				}
 				break;
+			case 'l': // "dbtl"
+				if (!core->dbg->bp->tracelog) {
+					r_bp_tracelog_init (core->dbg->bp,
+						r_config_get_i (core->config, "dbg.tracelog"));
+				}
+				for (p = input + 3; *p == '-' || *p == ' '; p++) {
+					/* nothing to do here */
+				}
+				if (*p == '*') {
+					r_bp_set_traceonly_all (core->dbg->bp, input[3] != '-');
+				} else if (!r_bp_set_traceonly (core->dbg->bp,
+						r_num_math (core->num, p), input[3] != '-')) {
+					eprintf ("Cannot set trace-only breakpoint\n");
+				}
+				break;
+			case 'L': // "dbtL"
+				if (input[3] == '-') {
+					core->dbg->bp->tracelog_count = 0;
+				} else {
+					r_bp_tracelog_list (core->dbg->bp, input[3]);
+				}
+				break;
 			case 'j': // "dbtj"
 				addr = UT64_MAX;
 				if (input[2] == ' ' && input[3]) {
@@ -2336,6 +2361,9 @@ static void r_core_cmd_bp(RCore *core, const char *input) {
 					"dbte", " <addr>", "Enable Breakpoint Trace",
 					"dbtd", " <addr>", "Disable Breakpoint Trace",
 					"dbts", " <addr>", "Swap Breakpoint Trace",
+					"dbtl", " <addr>", "Log the hits of the breakpoint without stopping (* for all)",
+					"dbtl-", " <addr>", "Make the breakpoint stop again (* for all)",
+					"dbtL", "[j]", "List the logged hits (dbtL- to clear them)",
 					NULL};
 				r_core_cmd_help (core, dbt_help_msg);
 				}
@@ -3059,6 +3087,7 @@ static int cmd_debug_continue (RCore *core, const char *input) {
 		"dc", " <pid>", "Continue execution of pid",
 		"dc", "[-pid]", "Stop execution of pid",
 		"dca", " [sym] [sym].", "Continue at every hit on any given symbol",
+		"dcb", "", "Continue back until breakpoint (needs dbg.record)",
 		"dcc", "", "Continue until call (use step into)",
 		"dccu", "", "Continue until unknown call (call reg)",
 #if __WINDOWS__ && !__CYGWIN__
@@ -3139,6 +3168,13 @@ beach:
 		// r_core_cmd0 (core, "dcs vfork fork");
 		r_core_cmd0 (core, "dcs vfork fork clone");
 		break;
+	case 'b': // "dcb"
+		if (!core->dbg->record) {
+			eprintf ("dcb needs dbg.record\n");
+		} else if (!r_debug_continue_back (core->dbg)) {
+			eprintf ("cannot continue back\n");
+		}
+		break;
 	case 'c': // "dcc"
 		r_reg_arena_swap (core->dbg->reg, true);
 		if (input[2] == 'u') {
@@ -3466,7 +3502,7 @@ static int cmd_debug(void *data, const char *input) {
 				r_debug_session_add (core->dbg);
 				break;
 			case 'A':
-				r_debug_session_set_idx (core->dbg, atoi (input + 2));
+				r_debug_session_set_idx (core->dbg, atoi (input + 3));
 				break;
 			default:
 				{
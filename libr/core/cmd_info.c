@@ -424,14 +424,13 @@ static int cmd_info(void *data, const char *input) {
 				input++;
 				break;
 			} else {
-				RBinObject *obj = r_bin_cur_object (core->bin);
-				RBININFO ("symbols", R_CORE_BIN_ACC_SYMBOLS, NULL, obj? r_list_length (obj->symbols): 0);
+				RBININFO ("symbols", R_CORE_BIN_ACC_SYMBOLS, NULL, r_list_length (r_bin_get_symbols (core->bin)));
 				break;
 			}
 		case 'R':
 		case 'r': RBININFO ("relocs", R_CORE_BIN_ACC_RELOCS, NULL, 0); break;
 		case 'd': RBININFO ("dwarf", R_CORE_BIN_ACC_DWARF, NULL, -1); break;
-		case 'i': RBININFO ("imports",R_CORE_BIN_ACC_IMPORTS, NULL, obj? r_list_length (obj->imports): 0); break;
+		case 'i': RBININFO ("imports",R_CORE_BIN_ACC_IMPORTS, NULL, r_list_length (r_bin_get_imports (core->bin))); break;
 		case 'I': RBININFO ("info", R_CORE_BIN_ACC_INFO, NULL, 0); break;
 		case 'e': RBININFO ("entries", R_CORE_BIN_ACC_ENTRIES, NULL, 0); break;
 		case 'M': RBININFO ("main", R_CORE_BIN_ACC_MAIN, NULL, 0); break;
@@ -471,7 +470,7 @@ static int cmd_info(void *data, const char *input) {
 				}
 				if (obj) {
 					RBININFO ("strings", R_CORE_BIN_ACC_STRINGS, NULL,
-						obj? r_list_length (obj->strings): 0);
+						r_list_length (r_bin_get_strings (core->bin)));
 				}
 			}
 			break;
@@ -487,7 +486,7 @@ static int cmd_info(void *data, const char *input) {
 				int count = 0;
 				if (obj) {
 					if (input[2]) {
-						r_list_foreach (obj->classes, iter, cls) {
+						r_list_foreach (r_bin_get_classes (core->bin), iter, cls) {
 							if (idx != count++) {
 								continue;
 							}
@@ -529,9 +528,9 @@ static int cmd_info(void *data, const char *input) {
 							goto done;
 						}
 					} else {
-						playMsg (core, "classes", r_list_length (obj->classes));
+						playMsg (core, "classes", r_list_length (r_bin_get_classes (core->bin)));
 						if (input[1] == 'l' && obj) { // "icl"
-							r_list_foreach (obj->classes, iter, cls) {
+							r_list_foreach (r_bin_get_classes (core->bin), iter, cls) {
 								r_list_foreach (cls->methods, iter2, sym) {
 									const char *comma = iter2->p? " ": "";
 									r_cons_printf ("%s0x%"PFMT64d, comma, sym->vaddr);
@@ -541,13 +540,12 @@ static int cmd_info(void *data, const char *input) {
 								}
 							}
 						} else {
-							RBININFO ("classes", R_CORE_BIN_ACC_CLASSES, NULL, r_list_length (obj->classes));
+							RBININFO ("classes", R_CORE_BIN_ACC_CLASSES, NULL, r_list_length (r_bin_get_classes (core->bin)));
 						}
 					}
 				}
 			} else {
-				RBinObject *obj = r_bin_cur_object (core->bin);
-				int len = obj? r_list_length (obj->classes): 0;
+				int len = r_list_length (r_bin_get_classes (core->bin));
 				RBININFO ("classes", R_CORE_BIN_ACC_CLASSES, NULL, len);
 			}
 			break;
@@ -185,8 +185,7 @@ static void cmd_open_map (RCore *core, const char *input) {
 				r_io_map_get (core->io, cur);
 			if (map) {
 				ut64 diff = map->to - map->from;
-				map->from = new;
-				map->to = new+diff;
+				r_io_map_set_range (core->io, map, new, new + diff);
 			} else eprintf ("Cannot find any map here\n");
 		} else {
 			cur = core->offset;
@@ -194,8 +193,7 @@ static void cmd_open_map (RCore *core, const char *input) {
 			map = r_io_map_resolve (core->io, core->file->desc->fd);
 			if (map) {
 				ut64 diff = map->to - map->from;
-				map->from = new;
-				map->to = new+diff;
+				r_io_map_set_range (core->io, map, new, new + diff);
 			} else eprintf ("Cannot find any map here\n");
 		}
 		break;
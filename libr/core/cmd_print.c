@@ -495,13 +495,15 @@ static void helpCmdTasks(RCore *core) {
 		"Usage:", "&[-|<cmd>]", "Manage tasks",
 		"&", "", "list all running threads",
 		"&=", "", "show output of all tasks",
-		"&=", " 3", "show output of task 3",
+		"&=", " 3", "show output of task 3, so far if it is running",
 		"&j", "", "list all running threads (in JSON)",
 		"&?", "", "show this help",
 		"&+", " aa", "push to the task list",
 		"&-", " 1", "delete task #1",
 		"&", "-*", "delete all threads",
-		"&", " aa", "run analysis in background",
+		"&", " aa", "run analysis in background, after the tasks before it",
+		"&r", " aflq", "list functions in background, along other readonly tasks (afl, aflq, afls)",
+		"&b", " 1", "cancel task #1",
 		"&", " &&", "run all tasks in background",
 		"&&", "", "run all pendings tasks (and join threads)",
 		"&&&", "", "run all pendings tasks until ^C",
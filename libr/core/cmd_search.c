@@ -1827,6 +1827,7 @@ static void do_asm_search(RCore *core, struct search_parameters *param, const ch
 static void do_string_search(RCore *core, struct search_parameters *param) {
 	ut64 at;
 	ut8 *buf;
+	const ut8 *data;
 	int ret;
 	int oraise = core->io->raised;
 	int bufsz;
@@ -1923,13 +1924,20 @@ static void do_string_search(RCore *core, struct search_parameters *param) {
 				if ((at + bufsz) > param->to) {
 					bufsz = param->to - at;
 				}
+				data = buf;
 				if (param->use_mread) {
 					// what about a config var to choose which io api to use?
 					ret = r_io_mread (core->io, fd, at, buf, bufsz);
 				} else {
 					// if seek fails we shouldnt read at all
 					(void) r_io_seek (core->io, at, R_IO_SEEK_SET);
-					ret = r_io_read (core->io, buf, bufsz);
+					// keywords are matched on the mapped file when cmd.hit can't write to it
+					ret = (!param->crypto_search && STRNULL (cmdhit))
+						? r_io_read_ptr (core->io, bufsz, &data): 0;
+					if (!ret) {
+						data = buf;
+						ret = r_io_read (core->io, buf, bufsz);
+					}
 				}
 				if (ret < 1) {
 					break;
@@ -1947,7 +1955,7 @@ static void do_string_search(RCore *core, struct search_parameters *param) {
 						}
 						aeskw.count++;
 					}
-				} else if (r_search_update (core->search, &at, buf, ret) == -1) {
+				} else if (r_search_update (core->search, &at, data, ret) == -1) {
 					// eprintf ("search: update read error at 0x%08"PFMT64x"\n", at);
 					break;
 				}
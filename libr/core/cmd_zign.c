@@ -651,6 +651,113 @@ static bool searchRange(RCore *core, ut64 from, ut64 to, bool rad, struct ctxSea
 	return retval;
 }
 
+typedef struct {
+	RSignItem **items;
+	int count;
+	int size;
+} ZignHits;
+
+/* graph, offset and refs hits of each function, matched by zign.jobs
+ * threads and flagged afterwards in the order of the functions */
+typedef struct {
+	RCore *core;
+	RSignIndex *si;
+	RAnalFunction **fcns;
+	ZignHits *hits;
+	int count;
+	int next;
+	int mincc;
+	bool useGraph;
+	bool useOffset;
+	bool useRefs;
+	RThreadLock *lock;
+} ZignJobs;
+
+static int hitCB(RSignItem *it, RAnalFunction *fcn, void *user) {
+	ZignHits *h = (ZignHits *) user;
+
+	if (h->count == h->size) {
+		int size = h->size? h->size * 2: 4;
+		RSignItem **items = realloc (h->items, size * sizeof (RSignItem *));
+		if (!items) {
+			return 0;
+		}
+		h->items = items;
+		h->size = size;
+	}
+	h->items[h->count++] = it;
+
+	return 1;
+}
+
+static int matchWorker(RThread *th) {
+	ZignJobs *zj = (ZignJobs *) th->user;
+	RAnalFunction *fcn;
+	ZignHits *h;
+	int i;
+
+	for (;;) {
+		r_th_lock_enter (zj->lock);
+		i = (zj->next < zj->count && !r_cons_is_breaked ())? zj->next++: -1;
+		r_th_lock_leave (zj->lock);
+		if (i < 0) {
+			break;
+		}
+		fcn = zj->fcns[i];
+		h = &zj->hits[i * 3];
+		if (zj->useGraph) {
+			r_sign_index_match_graph (zj->si, fcn, zj->mincc, hitCB, &h[0]);
+		}
+		if (zj->useOffset) {
+			r_sign_index_match_offset (zj->si, fcn, hitCB, &h[1]);
+		}
+		if (zj->useRefs) {
+			r_sign_index_match_refs (zj->si, zj->core->anal, fcn, hitCB, &h[2]);
+		}
+	}
+
+	return 0;
+}
+
+static bool matchFcnsJobs(RCore *core, RSignIndex *si, int jobs, ZignJobs *zj, struct ctxSearchCB *ctx) {
+	RThreadPool *pool = NULL;
+	RAnalFunction *fcni = NULL;
+	RListIter *iter;
+	int i, j, n = r_list_length (core->anal->fcns);
+
+	zj->fcns = calloc (R_MAX (n, 1), sizeof (RAnalFunction *));
+	zj->hits = calloc (R_MAX (n, 1) * 3, sizeof (ZignHits));
+	zj->lock = r_th_lock_new ();
+	if (!zj->fcns || !zj->hits || !zj->lock) {
+		free (zj->fcns);
+		free (zj->hits);
+		r_th_lock_free (zj->lock);
+		return false;
+	}
+	r_list_foreach (core->anal->fcns, iter, fcni) {
+		zj->fcns[zj->count++] = fcni;
+	}
+
+	pool = r_th_pool_new (R_MIN (jobs, R_MAX (n, 1)), matchWorker, zj);
+	if (pool) {
+		r_th_pool_free (pool);
+	}
+
+	for (i = 0; i < zj->count * 3; i++) {
+		ZignHits *h = &zj->hits[i];
+		for (j = 0; j < h->count; j++) {
+			fcnMatchCB (h->items[j], zj->fcns[i / 3], &ctx[i % 3]);
+		}
+		free (h->items);
+	}
+
+	free (zj->fcns);
+	free (zj->hits);
+	r_th_lock_free (zj->lock);
+
+	return pool != NULL;
+}
+
 static bool search(RCore *core, bool rad) {
 	RList *list;
 	RListIter *iter;
@@ -661,12 +768,15 @@ static bool search(RCore *core, bool rad) {
 	int hits = 0;
 
 	struct ctxSearchCB bytes_search_ctx = { core, rad, 0, "bytes" };
-	struct ctxSearchCB graph_match_ctx = { core, rad, 0, "graph" };
-	struct ctxSearchCB offset_match_ctx = { core, rad, 0, "offset" };
-	struct ctxSearchCB refs_match_ctx = { core, rad, 0, "refs" };
+	struct ctxSearchCB match_ctx[3] = {
+		{ core, rad, 0, "graph" },
+		{ core, rad, 0, "offset" },
+		{ core, rad, 0, "refs" }
+	};
 
 	const char *zign_prefix = r_config_get (core->config, "zign.prefix");
 	int mincc = r_config_get_i (core->config, "zign.mincc");
+	int jobs = r_config_get_i (core->config, "zign.jobs");
 	const char *mode = r_config_get (core->config, "search.in");
 	bool useBytes = r_config_get_i (core->config, "zign.bytes");
 	bool useGraph = r_config_get_i (core->config, "zign.graph");
@@ -699,25 +809,37 @@ static bool search(RCore *core, bool rad) {
 
 	// Function search
 	if (useGraph || useOffset || useRefs) {
+		ZignJobs zj = { core, NULL, NULL, NULL, 0, 0, mincc, useGraph, useOffset, useRefs, NULL };
+		RSignIndex *si = r_sign_index_new (core->anal);
+		if (!si) {
+			eprintf ("error: cannot index zignatures\n");
+			retval = false;
+			goto pop;
+		}
+		zj.si = si;
 		eprintf ("[+] searching function metrics\n");
 		r_cons_break_push (NULL, NULL);
-		r_list_foreach (core->anal->fcns, iter, fcni) {
-			if (r_cons_is_breaked ()) {
-				break;
-			}
-			if (useGraph) {
-				r_sign_match_graph (core->anal, fcni, mincc, fcnMatchCB, &graph_match_ctx);
-			}
-			if (useOffset) {
-				r_sign_match_offset (core->anal, fcni, fcnMatchCB, &offset_match_ctx);
-			}
-			if (useRefs){
-				r_sign_match_refs (core->anal, fcni, fcnMatchCB, &refs_match_ctx);
+		if (jobs < 2 || !matchFcnsJobs (core, si, jobs, &zj, match_ctx)) {
+			r_list_foreach (core->anal->fcns, iter, fcni) {
+				if (r_cons_is_breaked ()) {
+					break;
+				}
+				if (useGraph) {
+					r_sign_index_match_graph (si, fcni, mincc, fcnMatchCB, &match_ctx[0]);
+				}
+				if (useOffset) {
+					r_sign_index_match_offset (si, fcni, fcnMatchCB, &match_ctx[1]);
+				}
+				if (useRefs){
+					r_sign_index_match_refs (si, core->anal, fcni, fcnMatchCB, &match_ctx[2]);
+				}
 			}
 		}
 		r_cons_break_pop ();
+		r_sign_index_free (si);
 	}
 
+pop:
 	if (rad) {
 		r_cons_printf ("fs-\n");
 	} else {
@@ -727,8 +849,8 @@ static bool search(RCore *core, bool rad) {
 		}
 	}
 
-	hits = bytes_search_ctx.count + graph_match_ctx.count +
-		offset_match_ctx.count + refs_match_ctx.count;
+	hits = bytes_search_ctx.count + match_ctx[0].count +
+		match_ctx[1].count + match_ctx[2].count;
 	eprintf ("hits: %d\n", hits);
 
 	return retval;
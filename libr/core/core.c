@@ -192,11 +192,13 @@ R_API void r_core_set_asmqjmps(RCore *core, char *str, size_t len, int pos) {
 }
 
 static void setab(RCore *core, const char *arch, int bits) {
+	static RConfigHandle asm_arch = R_CONFIG_HANDLE ("asm.arch");
+	static RConfigHandle asm_bits = R_CONFIG_HANDLE ("asm.bits");
 	if (arch) {
-		r_config_set (core->config, "asm.arch", arch);
+		r_config_handle_set (core->config, &asm_arch, arch);
 	}
 	if (bits > 0) {
-		r_config_set_i (core->config, "asm.bits", bits);
+		r_config_handle_set_i (core->config, &asm_bits, bits);
 	}
 }
 
@@ -1552,7 +1554,7 @@ R_API int r_core_init(RCore *core) {
 	core->print->use_comments = false;
 	core->rtr_n = 0;
 	core->blocksize_max = R_CORE_BLOCKSIZE_MAX;
-	core->tasks = r_list_new ();
+	core->tasks = r_list_newf ((RListFree)r_core_task_free);
 	core->watchers = r_list_new ();
 	core->watchers->free = (RListFree)r_core_cmpwatch_free;
 	core->scriptstack = r_list_new ();
@@ -1702,7 +1704,8 @@ R_API RCore *r_core_fini(RCore *c) {
 	r_core_free_autocomplete(c);
 	R_FREE (c->lastsearch);
 	c->cons->pager = NULL;
-	r_core_task_join (c, NULL);
+	r_core_task_fini (c);
+	r_core_project_snapshot_fini (c);
 	free (c->cmdqueue);
 	free (c->lastcmd);
 	free (c->block);
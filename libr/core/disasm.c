@@ -15,6 +15,14 @@
 #define COLOR_CONST(ds, color) (ds->show_color ? Color_ ## color : "")
 #define COLOR_RESET(ds) COLOR_CONST(ds, RESET)
 
+/* read for every line */
+static RConfigHandle cfg_asm_arch = R_CONFIG_HANDLE ("asm.arch");
+static RConfigHandle cfg_asm_syntax = R_CONFIG_HANDLE ("asm.syntax");
+static RConfigHandle cfg_asm_relsub = R_CONFIG_HANDLE ("asm.relsub");
+static RConfigHandle cfg_asm_emuskip = R_CONFIG_HANDLE ("asm.emuskip");
+static RConfigHandle cfg_bin_demangle = R_CONFIG_HANDLE ("bin.demangle");
+static RConfigHandle cfg_bin_lang = R_CONFIG_HANDLE ("bin.lang");
+
 
 static const char* r_vline_a[] = {
 	"|",  // LINE_VERT
@@ -43,6 +51,22 @@ static const char* r_vline_u[] = {
 	"<", // ARROW_LEFT
 };
 
+/* the annotations of an address being disassembled, looked up once
+ * and shared by the ds_* helpers */
+typedef struct r_disasm_annot_t {
+	ut64 addr;
+	RAnalFunction *fcn;
+	RFlagItem *flag;
+	const RList *flags;
+	RFlagItem *flag_at; // only with asm.symbol
+	bool has_flag_at;
+	char *comment;
+	char *metas;
+	RList *xrefs;
+} RDisasmAnnot;
+
+#define ANNOT_MAX 1024
+
 // TODO: what about using bit shifting and enum for keys? see libr/util/bitmap.c
 // the problem of this is that the fields will be more opaque to bindings, but we will earn some bits
 typedef struct r_disam_options_t {
@@ -197,6 +221,11 @@ typedef struct r_disam_options_t {
 	bool show_nodup;
 	bool has_description;
 	// caches
+	RDisasmAnnot *annot; // sorted by address
+	int annot_count;
+	int annot_size;
+	int annot_cur;
+	RDisasmAnnot annot_tmp;
 	char *_tabsbuf;
 	int _tabsoff;
 	bool dwarfFile;
@@ -245,6 +274,8 @@ static void ds_print_asmop_payload(RDisasmState *ds);
 static void ds_print_op_push_info(RDisasmState *ds);
 static void ds_print_comments_right(RDisasmState *ds);
 static void ds_print_ptr(RDisasmState *ds, int len, int idx);
+static RDisasmAnnot *ds_annot(RDisasmState *ds);
+static RAnalFunction *ds_fcn_in(RDisasmState *ds, ut64 addr);
 
 static ut64 p2v(RDisasmState *ds, ut64 addr) {
 	if (ds->core->io->pava) {
@@ -364,13 +395,12 @@ static void ds_comment_esil(RDisasmState *ds, bool up, bool end, const char *for
 }
 
 static void ds_print_spacy(RDisasmState *ds, int pre) {
-	RCore *core = ds->core;
 	RAnalFunction *f = NULL;
 	if (pre) {
 		r_cons_newline ();
 	}
 	if (ds->show_functions) {
-		f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
+		f = ds_fcn_in (ds, ds->at);
 		if (!f) {
 			r_cons_print ("  ");
 			ds_print_lines_left (ds);
@@ -616,10 +646,113 @@ static void ds_reflines_fcn_init(RDisasmState *ds,  RAnalFunction *fcn, const ut
 	}
 }
 
+static void ds_annot_fini(RDisasmAnnot *a) {
+	free (a->comment);
+	free (a->metas);
+	r_list_free (a->xrefs);
+}
+
+/* forgets the annotations, the flags or metas may have changed */
+static void ds_annot_reset(RDisasmState *ds) {
+	int i;
+	for (i = 0; i < ds->annot_count; i++) {
+		ds_annot_fini (&ds->annot[i]);
+	}
+	ds->annot_count = ds->annot_cur = 0;
+}
+
+static void ds_annot_fetch(RDisasmState *ds, RDisasmAnnot *a, ut64 addr) {
+	RCore *core = ds->core;
+	char key[64];
+	const char *metas;
+	memset (a, 0, sizeof (RDisasmAnnot));
+	a->addr = addr;
+	a->fcn = r_anal_get_fcn_in (core->anal, addr, R_ANAL_FCN_TYPE_NULL);
+	a->flags = r_flag_get_list (core->flags, addr);
+	if (a->flags) {
+		a->flag = r_flag_get_i (core->flags, addr);
+	}
+	snprintf (key, sizeof (key), "meta.0x%"PFMT64x, addr);
+	metas = sdb_const_get (core->anal->sdb_meta, key, 0);
+	a->metas = metas? strdup (metas): NULL;
+	if (ds->show_comments) {
+		a->comment = r_meta_get_string (core->anal, R_META_TYPE_COMMENT, addr);
+	}
+	if (ds->show_comments && ds->show_xrefs) {
+		a->xrefs = r_anal_xref_get (core->anal, addr);
+		if (a->xrefs) {
+			a->xrefs->free = r_anal_ref_free;
+		}
+	}
+}
+
+/* the annotations at addr. The lines come in order, so the one wanted
+ * is mostly the last fetched or the next to append */
+static RDisasmAnnot *ds_annot_at(RDisasmState *ds, ut64 addr) {
+	RDisasmAnnot *a;
+	int lo, hi, i = ds->annot_cur;
+	if (i < ds->annot_count && ds->annot[i].addr == addr) {
+		return &ds->annot[i];
+	}
+	if (!ds->annot_count || ds->annot[ds->annot_count - 1].addr < addr) {
+		lo = ds->annot_count;
+	} else {
+		lo = 0;
+		hi = ds->annot_count;
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (ds->annot[mid].addr < addr) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		if (lo < ds->annot_count && ds->annot[lo].addr == addr) {
+			ds->annot_cur = lo;
+			return &ds->annot[lo];
+		}
+	}
+	if (lo == ds->annot_count && ds->annot_count >= ANNOT_MAX) {
+		/* the lines behind are not printed again */
+		for (i = 0; i < ds->annot_count; i++) {
+			ds_annot_fini (&ds->annot[i]);
+		}
+		ds->annot_count = lo = 0;
+	}
+	if (ds->annot_count == ds->annot_size) {
+		int size = ds->annot_size? ds->annot_size * 2: 64;
+		a = realloc (ds->annot, size * sizeof (RDisasmAnnot));
+		if (!a) {
+			ds_annot_fini (&ds->annot_tmp);
+			ds_annot_fetch (ds, &ds->annot_tmp, addr);
+			return &ds->annot_tmp;
+		}
+		ds->annot = a;
+		ds->annot_size = size;
+	}
+	a = ds->annot + lo;
+	memmove (a + 1, a, (ds->annot_count - lo) * sizeof (RDisasmAnnot));
+	ds->annot_count++;
+	ds->annot_cur = lo;
+	ds_annot_fetch (ds, a, addr);
+	return a;
+}
+
+static RDisasmAnnot *ds_annot(RDisasmState *ds) {
+	return ds_annot_at (ds, ds->at);
+}
+
+static RAnalFunction *ds_fcn_in(RDisasmState *ds, ut64 addr) {
+	return ds_annot_at (ds, addr)->fcn;
+}
+
 static void ds_free(RDisasmState *ds) {
 	if (!ds) {
 		return;
 	}
+	ds_annot_reset (ds);
+	ds_annot_fini (&ds->annot_tmp);
+	free (ds->annot);
 	r_anal_op_fini (&ds->analop);
 	r_anal_hint_free (ds->hint);
 	free (ds->comment);
@@ -690,11 +823,11 @@ static void ds_build_op_str(RDisasmState *ds) {
 	}
 	/* initialize */
 	core->parser->hint = ds->hint;
-	core->parser->relsub = r_config_get_i (core->config, "asm.relsub");
+	core->parser->relsub = r_config_handle_get_i (core->config, &cfg_asm_relsub);
 	core->parser->relsub_addr = 0;
 	if (ds->varsub && ds->opstr) {
 		ut64 at = ds->vat;
-		RAnalFunction *f = r_anal_get_fcn_in (core->anal, at, R_ANAL_FCN_TYPE_NULL);
+		RAnalFunction *f = ds_fcn_in (ds, at);
 		core->parser->varlist = r_anal_var_list_dynamic;
 		r_parse_varsub (core->parser, f, at, ds->analop.size,
 			ds->opstr, ds->strsub, sizeof (ds->strsub));
@@ -780,30 +913,33 @@ static void ds_build_op_str(RDisasmState *ds) {
 R_API RAnalHint *r_core_hint_begin(RCore *core, RAnalHint* hint, ut64 at) {
 	static char *hint_arch = NULL;
 	static char *hint_syntax = NULL;
+	RConfig *cfg = core->config;
 	r_anal_hint_free (hint);
 	hint = r_anal_hint_get (core->anal, at);
-	if (hint_arch) {
-		r_config_set (core->config, "asm.arch", hint_arch);
-		hint_arch = NULL;
+	/* the setters reload the plugins, only run them on changes and
+	 * keep the hinted values between hinted instructions */
+	if (hint_arch && (!hint || !hint->arch)) {
+		r_config_handle_set (cfg, &cfg_asm_arch, hint_arch);
+		R_FREE (hint_arch);
 	}
-	if (hint_syntax) {
-		r_config_set (core->config, "asm.syntax", hint_syntax);
-		hint_syntax = NULL;
+	if (hint_syntax && (!hint || !hint->syntax)) {
+		r_config_handle_set (cfg, &cfg_asm_syntax, hint_syntax);
+		R_FREE (hint_syntax);
 	}
 	if (hint) {
 		/* arch */
 		if (hint->arch) {
 			if (!hint_arch) {
-				hint_arch = strdup (r_config_get (core->config, "asm.arch"));
+				hint_arch = strdup (r_config_handle_get (cfg, &cfg_asm_arch));
 			}
-			r_config_set (core->config, "asm.arch", hint->arch);
+			r_config_handle_set (cfg, &cfg_asm_arch, hint->arch);
 		}
 		/* arch */
 		if (hint->syntax) {
 			if (!hint_syntax) {
-				hint_syntax = strdup (r_config_get (core->config, "asm.syntax"));
+				hint_syntax = strdup (r_config_handle_get (cfg, &cfg_asm_syntax));
 			}
-			r_config_set (core->config, "asm.syntax", hint->syntax);
+			r_config_handle_set (cfg, &cfg_asm_syntax, hint->syntax);
 		}
 	}
 	return hint;
@@ -899,15 +1035,15 @@ static void ds_show_xrefs(RDisasmState *ds) {
 	RAnalRef *refi;
 	RListIter *iter;
 	RCore *core = ds->core;
-	bool demangle = r_config_get_i (core->config, "bin.demangle");
-	const char *lang = demangle ? r_config_get (core->config, "bin.lang") : NULL;
+	bool demangle = r_config_handle_get_i (core->config, &cfg_bin_demangle);
+	const char *lang = demangle ? r_config_handle_get (core->config, &cfg_bin_lang) : NULL;
 	char *name, *tmp;
 	int count = 0;
 	if (!ds->show_xrefs || !ds->show_comments) {
 		return;
 	}
 	/* show xrefs */
-	xrefs = r_anal_xref_get (core->anal, ds->at);
+	xrefs = ds_annot (ds)->xrefs;
 	if (!xrefs) {
 		return;
 	}
@@ -934,7 +1070,6 @@ static void ds_show_xrefs(RDisasmState *ds) {
 		}
 		ds_print_color_reset (ds);
 		r_cons_newline ();
-		r_list_free (xrefs);
 		return;
 	}
 
@@ -966,7 +1101,6 @@ static void ds_show_xrefs(RDisasmState *ds) {
 			R_FREE (name);
 		}
 	}
-	r_list_free (xrefs);
 }
 
 static void ds_atabs_option(RDisasmState *ds) {
@@ -1114,10 +1248,10 @@ static void ds_show_functions(RDisasmState *ds) {
 	if (!ds->show_functions) {
 		return;
 	}
-	demangle = r_config_get_i (core->config, "bin.demangle");
-	call = r_config_get_i (core->config, "asm.calls");
-	lang = demangle ? r_config_get (core->config, "bin.lang") : NULL;
-	f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
+	demangle = r_config_handle_get_i (core->config, &cfg_bin_demangle);
+	call = ds->show_calls;
+	lang = demangle ? r_config_handle_get (core->config, &cfg_bin_lang) : NULL;
+	f = ds_fcn_in (ds, ds->at);
 	if (!f || (f->addr != ds->at)) {
 		return;
 	}
@@ -1316,7 +1450,7 @@ static void ds_setup_pre(RDisasmState *ds, bool tail, bool middle) {
 	if (!ds->show_functions) {
 		return;
 	}
-	f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
+	f = ds_fcn_in (ds, ds->at);
 	if (f) {
 		if (f->addr == ds->at) {
 			if (ds->analop.size == r_anal_fcn_size (f) && !middle) {
@@ -1340,13 +1474,12 @@ static void ds_setup_pre(RDisasmState *ds, bool tail, bool middle) {
 }
 
 static void ds_print_pre(RDisasmState *ds) {
-	RCore *core = ds->core;
 	RAnalFunction *f;
 
 	if (!ds->show_functions) {
 		return;
 	}
-	f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
+	f = ds_fcn_in (ds, ds->at);
 	if (f) {
 		r_cons_printf ("%s%s%s", COLOR (ds, color_fline),
 			ds->pre, COLOR_RESET (ds));
@@ -1366,12 +1499,14 @@ static void ds_show_comments_right(RDisasmState *ds) {
 	RFlagItem *item;
 	/* show comment at right? */
 	int scr = ds->show_comment_right;
+	RDisasmAnnot *annot;
 	if (!ds->show_comments) {
 		return;
 	}
 	//RAnalFunction *f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
-	item = r_flag_get_i (core->flags, ds->at);
-	ds->comment = r_meta_get_string (core->anal, R_META_TYPE_COMMENT, ds->at);
+	annot = ds_annot (ds);
+	item = annot->flag;
+	ds->comment = annot->comment? strdup (annot->comment): NULL;
 	if (!ds->comment && item && item->comment && *item->comment) {
 		ds->ocomment = item->comment;
 		ds->comment = strdup (item->comment);
@@ -1446,8 +1581,8 @@ static void ds_show_flags(RDisasmState *ds) {
 		return;
 	}
 	RCore *core = ds->core;
-	f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
-	flaglist = r_flag_get_list (core->flags, ds->at);
+	f = ds_fcn_in (ds, ds->at);
+	flaglist = ds_annot (ds)->flags;
 	r_list_foreach (flaglist, iter, flag) {
 		if (f && f->addr == flag->offset && !strcmp (flag->name, f->name)) {
 			// do not show flags that have the same name as the function
@@ -1473,7 +1608,7 @@ static void ds_show_flags(RDisasmState *ds) {
 			r_cons_strcat (ds->color_flag);
 		}
 		if (ds->asm_demangle && flag->realname) {
-			const char *lang = r_config_get (core->config, "bin.lang");
+			const char *lang = r_config_handle_get (core->config, &cfg_bin_lang);
 			char *name = r_bin_demangle (core->bin->cur, lang, flag->realname, flag->offset);
 			r_cons_printf ("%s:\n", name? name: flag->realname);
 			R_FREE (name);
@@ -1529,8 +1664,7 @@ static int ds_disassemble(RDisasmState *ds, ut8 *buf, int len) {
 	ut64 mt_sz = UT64_MAX;
 
 	//handle meta info to fix ds->oplen
-	snprintf (key, sizeof (key) - 1, "meta.0x%"PFMT64x, ds->at);
-	info = sdb_const_get (s, key, 0);
+	info = ds_annot (ds)->metas;
 	if (info) {
 		for (;*info; info++) {
 			switch (*info) {
@@ -1703,7 +1837,13 @@ static void ds_print_lines_left(RDisasmState *ds) {
 			sfi.name = ds->fcn->name;
 			ds->lastflag = &sfi;
 		} else {
-			RFlagItem *fi = r_flag_get_at (core->flags, ds->at, false);
+			RDisasmAnnot *a = ds_annot (ds);
+			RFlagItem *fi;
+			if (!a->has_flag_at) {
+				a->flag_at = r_flag_get_at (core->flags, ds->at, false);
+				a->has_flag_at = true;
+			}
+			fi = a->flag_at;
 			if (fi) { // && (!ds->lastflag || fi->offset != ds->at)) {
 				sfi.offset = fi->offset;
 				sfi.name = fi->name;
@@ -1785,7 +1925,7 @@ static void ds_print_offset(RDisasmState *ds) {
 		if (ds->show_reloff) {
 			RAnalFunction *f = r_anal_get_fcn_at (core->anal, at, R_ANAL_FCN_TYPE_NULL);
 			if (!f) {
-				f = r_anal_get_fcn_in (core->anal, at, R_ANAL_FCN_TYPE_NULL);
+				f = ds_fcn_in (ds, at);
 			}
 			if (f) {
 				delta = at - f->addr;
@@ -1796,7 +1936,7 @@ static void ds_print_offset(RDisasmState *ds) {
 			} else {
 				if (ds->show_reloff_flags) {
 					/* XXX: this is wrong if starting to disasm after a flag */
-					fi = r_flag_get_i (core->flags, at);
+					fi = ds_annot_at (ds, at)->flag;
 					if (fi) {
 						ds->lastflag = fi;
 					}
@@ -1960,9 +2100,9 @@ static int ds_print_meta_infos(RDisasmState *ds, ut8* buf, int len, int idx) {
 	RAnalMetaItem MI, *mi = &MI;
 	RCore * core = ds->core;
 	Sdb *s = core->anal->sdb_meta;
+	bool run = false;
 
-	snprintf (key, sizeof (key)-1, "meta.0x%"PFMT64x, ds->at);
-	infos = sdb_const_get (s, key, 0);
+	infos = ds_annot (ds)->metas;
 
 	ds->mi_found = false;
 	if (infos) {
@@ -2023,6 +2163,7 @@ static int ds_print_meta_infos(RDisasmState *ds, ut8* buf, int len, int idx) {
 					break;
 				case R_META_TYPE_RUN:
 					r_core_cmdf (core, "%s @ 0x%"PFMT64x, mi->str, ds->at);
+					run = true;
 					ds->asmop.size = mi->size;
 					ds->oplen = mi->size;
 					ds->mi_found = true;
@@ -2065,6 +2206,10 @@ static int ds_print_meta_infos(RDisasmState *ds, ut8* buf, int len, int idx) {
 			}
 		}
 	}
+	if (run) {
+		/* the command may have changed them */
+		ds_annot_reset (ds);
+	}
 	return ret;
 }
 
@@ -2311,7 +2456,7 @@ static bool ds_print_labels(RDisasmState *ds, RAnalFunction *f) {
 	RCore *core = ds->core;
 	const char *label;
 	if (!f) {
-		f = r_anal_get_fcn_in (core->anal, ds->at, 0);
+		f = ds_fcn_in (ds, ds->at);
 	}
 	label = r_anal_fcn_label_at (core->anal, f, ds->at);
 	if (!label) {
@@ -2336,8 +2481,8 @@ static void ds_print_import_name(RDisasmState *ds) {
 	case R_ANAL_OP_TYPE_JMP:
 	case R_ANAL_OP_TYPE_CJMP:
 	case R_ANAL_OP_TYPE_CALL:
-		if (core->bin->cur->o->imports && core->bin->cur->o->relocs) {
-			r_list_foreach (core->bin->cur->o->relocs, iter, rel) {
+		if (r_bin_get_imports (core->bin) && r_bin_get_relocs (core->bin)) {
+			r_list_foreach (r_bin_get_relocs (core->bin), iter, rel) {
 				if ((rel->vaddr == ds->analop.jump) &&
 					(rel->import != NULL)) {
 					if (ds->show_color) {
@@ -2388,7 +2533,7 @@ static void ds_print_fcn_name(RDisasmState *ds) {
 				ALIGN;
 				ds_comment (ds, true, "; %s.%s%s", f->name, label, nl);
 			} else {
-				RAnalFunction *f2 = r_anal_get_fcn_in (core->anal, ds->at, 0);
+				RAnalFunction *f2 = ds_fcn_in (ds, ds->at);
 				if (f != f2) {
 					ALIGN;
 					if (delta > 0) {
@@ -3102,7 +3247,7 @@ static char * resolve_fcn_name(RAnal *anal, const char * func_name) {
 
 static bool can_emulate_metadata(RCore * core, ut64 at) {
 	const char *infos;
-	const char *emuskipmeta = r_config_get (core->config, "asm.emuskip");
+	const char *emuskipmeta = r_config_handle_get (core->config, &cfg_asm_emuskip);
 	char key[32];
 	Sdb *s = core->anal->sdb_meta;
 	snprintf (key, sizeof (key)-1, "meta.0x%"PFMT64x, at);
@@ -3358,9 +3503,7 @@ beach:
 }
 
 static void ds_print_calls_hints(RDisasmState *ds) {
-	int emu = r_config_get_i (ds->core->config, "asm.emu");
-	int emuwrite = r_config_get_i (ds->core->config, "asm.emuwrite");
-	if (emu && emuwrite) {
+	if (ds->show_emu && ds->show_emu_write) {
 		// this is done by ESIL
 		return;
 	}
@@ -3464,13 +3607,30 @@ static void ds_print_as_string(RDisasmState *ds) {
 }
 
 // int l is for lines
+/* reads the next len bytes at ds->addr like r_core_read_at, pointing
+ * buf to the mapped file instead when the emulation can't write to it.
+ * wbuf is where they are copied otherwise */
+static int ds_read_at(RDisasmState *ds, ut8 **buf, ut8 *wbuf, int len) {
+	RCore *core = ds->core;
+	const ut8 *ptr;
+	if (!ds->show_emu_write && core->file && core->file->desc) {
+		r_io_use_desc (core->io, core->file->desc);
+		if (r_io_read_at_ptr (core->io, ds->addr, len, &ptr) == len) {
+			*buf = (ut8 *)ptr;
+			return len;
+		}
+	}
+	*buf = wbuf;
+	return r_core_read_at (core, ds->addr, wbuf, len);
+}
+
 R_API int r_core_print_disasm(RPrint *p, RCore *core, ut64 addr, ut8 *buf, int len, int l, int invbreak, int cbytes) {
 	int continueoninvbreak = (len == l) && invbreak;
 	RAnalFunction *of = NULL;
 	RAnalFunction *f = NULL;
 	int ret, i, inc, skip_bytes = 0, idx = 0;
 	int dorepeat = 1;
-	ut8 *nbuf = NULL;
+	ut8 *nbuf = NULL, *wbuf = buf;
 	RDisasmState *ds;
 
 	// TODO: All those ds must be print flags
@@ -3552,7 +3712,7 @@ toro:
 		ds->hint = r_core_hint_begin (core, ds->hint, ds->at);
 		r_asm_set_pc (core->assembler, ds->at);
 		ds_update_ref_lines (ds);
-		f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
+		f = ds_fcn_in (ds, ds->at);
 		ds->fcn = f;
 		if (f && f->folded && r_anal_fcn_is_in_offset (f, ds->at)) {
 			int delta = (ds->at <= f->addr)? (ds->at - f->addr + r_anal_fcn_size (f)): 0;
@@ -3572,7 +3732,7 @@ toro:
 					delta = -delta;
 				}
 				ds->addr += delta + idx;
-				r_io_read_at (core->io, ds->addr, buf, len);
+				ds_read_at (ds, &buf, wbuf, len);
 				inc = 0; //delta;
 				idx = 0;
 				of = f;
@@ -3583,7 +3743,7 @@ toro:
 			} else {
 				ds->lines--;
 				ds->addr += 1;
-				r_io_read_at (core->io, ds->addr, buf, len);
+				ds_read_at (ds, &buf, wbuf, len);
 				inc = 0; //delta;
 				idx = 0;
 				continue;
@@ -3673,7 +3833,7 @@ toro:
 		}
 		ds_setup_print_pre (ds, false, false);
 		ds_print_lines_left (ds);
-		f = r_anal_get_fcn_in (core->anal, ds->addr, 0);
+		f = ds_fcn_in (ds, ds->addr);
 		if (ds_print_labels (ds, f)) {
 			ds_show_functions (ds);
 			ds_show_xrefs (ds);
@@ -3754,15 +3914,15 @@ toro:
 		if (len < 4) {
 			len = 4;
 		}
-		buf = nbuf = malloc (len);
+		buf = wbuf = nbuf = malloc (len);
 		if (ds->tries > 0) {
-			if (r_core_read_at (core, ds->addr, buf, len)) {
+			if (ds_read_at (ds, &buf, wbuf, len)) {
 				goto toro;
 			}
 		}
 		if (ds->lines < ds->l) {
 			//ds->addr += idx;
-			if (r_core_read_at (core, ds->addr, buf, len) != len) {
+			if (ds_read_at (ds, &buf, wbuf, len) != len) {
 				//ds->tries = -1;
 			}
 			goto toro;
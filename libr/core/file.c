@@ -61,7 +61,7 @@ R_API int r_core_file_reopen(RCore *core, const char *args, int perm, int loadbi
 	// XXX - why does this hack work?
 	if (ofile->map) {
 		ofrom = ofile->map->from;
-		ofile->map->from = UT32_MAX;
+		r_io_map_set_range (core->io, ofile->map, UT32_MAX, ofile->map->to);
 	}
 	// closing the file to make sure there are no collisions
 	// when the new memory maps are created.
@@ -74,7 +74,7 @@ R_API int r_core_file_reopen(RCore *core, const char *args, int perm, int loadbi
 		bool had_rbin_info = false;
 
 		if (ofile->map) {
-			ofile->map->from = ofrom;
+			r_io_map_set_range (core->io, ofile->map, ofrom, ofile->map->to);
 		}
 		if (ofile->desc) {
 			if (r_bin_file_delete (core->bin, ofile->desc->fd)) {
@@ -112,7 +112,7 @@ R_API int r_core_file_reopen(RCore *core, const char *args, int perm, int loadbi
 		//ofile = r_core_file_open (core, path, R_IO_READ, addr);
 		r_core_file_set_by_file (core, ofile);
 		if (ofile->map) {
-			ofile->map->from = ofrom;
+			r_io_map_set_range (core->io, ofile->map, ofrom, ofile->map->to);
 		}
 	} else {
 		eprintf ("Cannot reopen\n");
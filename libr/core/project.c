@@ -61,6 +61,18 @@ static char *projectScriptPath(RCore *core, const char *file) {
 	return prjfile;
 }
 
+/* the snapshot lives in the directory of the project */
+static char *projectSnapshotPath(const char *scriptPath) {
+	char *dir, *path;
+	if (!r_str_endswith (scriptPath, R_SYS_DIR "rc")) {
+		return r_str_newf ("%s.d" R_SYS_DIR "snapshot", scriptPath);
+	}
+	dir = r_file_dirname (scriptPath);
+	path = dir? r_str_newf ("%s" R_SYS_DIR "snapshot", dir): NULL;
+	free (dir);
+	return path;
+}
+
 static int projectInit(RCore *core) {
 	char *prjdir = r_file_abspath (r_config_get (
 			core->config, "dir.projects"));
@@ -527,6 +539,8 @@ static bool projectSaveScript(RCore *core, const char *file, int opts) {
 		r_str_write (fd, "# meta\n");
 		r_meta_list (core->anal, R_META_TYPE_ANY, 1);
 		r_cons_flush ();
+	}
+	if (opts & R_CORE_PRJ_VMARKS) {
 		r_core_cmd (core, "fV*", 0);
 		r_cons_flush ();
 	}
@@ -588,9 +602,10 @@ R_API bool r_core_project_save_rdb(RCore *core, const char *file, int opts) {
 #define TRANSITION 1
 
 R_API bool r_core_project_save(RCore *core, const char *prjName) {
+	bool snapshot = r_config_get_i (core->config, "prj.snapshot");
 	bool scr_null = false;
 	bool ret = true;
-	char *scriptPath, *prjDir;
+	char *scriptPath, *prjDir, *snapPath;
 	SdbListIter *it;
 	SdbNs *ns;
 
@@ -643,7 +658,21 @@ R_API bool r_core_project_save(RCore *core, const char *prjName) {
 	}
 	projectInit (core);
 
-	r_anal_project_save (core->anal, prjDir);
+	snapPath = r_str_newf ("%s" R_SYS_DIR "snapshot", prjDir);
+	if (snapshot && !r_core_project_snapshot_save (core, snapPath)) {
+		eprintf ("Cannot save the snapshot, using the rc script\n");
+		snapshot = false;
+	}
+	if (!snapshot) {
+		/* it would be loaded instead of the script */
+		char *journalPath = r_str_newf ("%s.journal", snapPath);
+		r_core_project_snapshot_fini (core);
+		r_file_rm (snapPath);
+		r_file_rm (journalPath);
+		r_anal_project_save (core->anal, prjDir);
+		free (journalPath);
+	}
+	free (snapPath);
 
 	Sdb *rop_db = sdb_ns (core->sdb, "rop", false);
 	if (rop_db) {
@@ -655,7 +684,9 @@ R_API bool r_core_project_save(RCore *core, const char *prjName) {
 			free (rop_path);
 		}
 	}
-	if (!projectSaveScript (core, scriptPath, R_CORE_PRJ_ALL ^ R_CORE_PRJ_XREFS)) {
+	if (!projectSaveScript (core, scriptPath, snapshot
+			? R_CORE_PRJ_ALL ^ R_CORE_PRJ_SNAPSHOT
+			: R_CORE_PRJ_ALL ^ R_CORE_PRJ_XREFS)) {
 		eprintf ("Cannot open '%s' for writing\n", prjName);
 		ret = false;
 	}
@@ -674,6 +705,10 @@ R_API bool r_core_project_save(RCore *core, const char *prjName) {
 		free (prjBinDir);
 		free (binFile);
 	}
+	if (r_config_get_i (core->config, "prj.git") || r_config_get_i (core->config, "prj.zip")) {
+		/* the snapshot may still be being written */
+		r_core_project_snapshot_wait (core);
+	}
 	if (r_config_get_i (core->config, "prj.git")) {
 		char *cwd = r_sys_getdir ();
 		char *gitDir = r_str_newf ("%s" R_SYS_DIR ".git", prjDir);
@@ -767,6 +802,7 @@ static bool projectLoadXrefs(RCore *core, const char *prjName) {
 		return false;
 	}
 	sdb_ns_set (core->anal->sdb, "xrefs", DB);
+	r_anal_xrefs_load (core->anal);
 	free (path);
 
 	free (db);
@@ -777,9 +813,19 @@ R_API bool r_core_project_load(RCore *core, const char *prjName, const char *rcp
 	const bool cfg_fortunes = r_config_get_i (core->config, "cfg.fortunes");
 	const bool scr_interactive = r_config_get_i (core->config, "scr.interactive");
 	const bool scr_prompt = r_config_get_i (core->config, "scr.prompt");
+	char *snapPath = projectSnapshotPath (rcpath);
+	const bool snapshot = snapPath && r_file_exists (snapPath);
 	(void) projectLoadRop (core, prjName);
-	(void) projectLoadXrefs (core, prjName);
+	if (!snapshot) {
+		r_core_project_snapshot_fini (core);
+		(void) projectLoadXrefs (core, prjName);
+	}
 	bool ret = r_core_cmd_file (core, rcpath);
+	/* after the script, the eval vars may reset the types */
+	if (snapshot && !r_core_project_snapshot_load (core, snapPath)) {
+		ret = false;
+	}
+	free (snapPath);
 	r_config_set_i (core->config, "cfg.fortunes", cfg_fortunes);
 	r_config_set_i (core->config, "scr.interactive", scr_interactive);
 	r_config_set_i (core->config, "scr.prompt", scr_prompt);
@@ -832,7 +832,12 @@ static int r_core_rtr_http_thread (RThread *th) {
 	if (!ht || !ht->core) {
 		return false;
 	}
+	/* the commands of the clients print apart from the prompt */
+	RConsContext *ctx = r_cons_context_new ();
+	r_cons_context_load (ctx);
 	int ret = r_core_rtr_http_run (ht->core, ht->launch, ht->path);
+	r_cons_context_load (NULL);
+	r_cons_context_free (ctx);
 	R_FREE (ht->path);
 	if (ret) {
 		int p = r_config_get_i (ht->core->config, "http.port");
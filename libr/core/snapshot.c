@@ -0,0 +1,1168 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_core.h>
+
+/* binary snapshot of the analysis of a project. A header and a table
+ * of sections are followed by arrays of fixed size little endian
+ * records and a string table, the records refer to the strings by
+ * their offset in it (0 is NULL). Loading maps the file, checks the
+ * bounds once and fixes up those offsets into pointers to the mapped
+ * strings, so the records go straight into the stores without any
+ * command being parsed.
+ *
+ * Saving again appends to snapshot.journal an image with the same
+ * layout holding only what changed. Every flag, function and sdb key
+ * is known by the hash of its key, and RCorePrjJournal keeps the hash
+ * of the contents of each one on disk: the items whose hash differs
+ * are written and the keys which are gone are listed as deleted. The
+ * xrefs are too many to compare, so their changes are logged by the
+ * on_xref callback instead. The sdb stores are not even walked when
+ * their hook saw no change since the last save. Loading applies the
+ * newest version of each key. Once the journal is bigger than half of the snapshot, the next
+ * save rewrites the snapshot and leaves writing the file to a thread. */
+
+#define SNAP_MAGIC "R2PRJSNP"
+#define SNAP_VERSION 2
+#define SNAP_HDRSZ 40 // magic, version, sections, strings offset and size, id
+#define SNAP_SECTSZ 16 // id, count, offset
+#define SNAP_XLOG_MIN 65536 // xref changes logged before rewriting them all
+#define SNAP_FNV_BASIS 0xcbf29ce484222325ULL
+#define SNAP_FNV_PRIME 0x100000001b3ULL
+
+enum {
+	SNAP_FLAGSPACES = 1, // idx, name
+	SNAP_FLAGS, // offset, size, space, name, realname, comment, alias, color
+	SNAP_FCNS, // addr, name, cc, type, diff, bits, stack, maxstack, folded, bbs
+	SNAP_BBS, // addr, jump, fail, size, type, diff
+	SNAP_XREFS, // from, to, type
+	SNAP_MAPS, // delta, from, to, fd, flags
+	SNAP_METASPACES, // idx, name
+	SNAP_META, // key, value of sdb_meta
+	SNAP_HINTS, // key, value of sdb_hints
+	SNAP_TYPES, // key, value of sdb_types
+	SNAP_FCNSDB, // key, value of sdb_fcns (vars and labels)
+	SNAP_DELETED, // key hash of a flag, function or sdb key removed
+	SNAP_XREFLOG, // from, to, type, added
+	SNAP_LAST
+};
+
+static const ut32 snap_recsz[SNAP_LAST] = {
+	0, 8, 40, 44, 36, 20, 32, 8, 8, 8, 8, 8, 8, 24
+};
+
+/* bitmask of the 32 bit words of each record which are string offsets */
+static const ut32 snap_strs[SNAP_LAST] = {
+	0, 0x2, 0x3e0, 0xc, 0, 0, 0, 0x2, 0x3, 0x3, 0x3, 0x3, 0, 0
+};
+
+typedef struct {
+	ut8 *buf;
+	ut64 len;
+	ut64 size;
+} SnapBuf;
+
+typedef struct {
+	SnapBuf sect[SNAP_LAST];
+	ut32 count[SNAP_LAST];
+	SnapBuf str;
+	bool oom;
+	RHashTable64 *base; // hashes of the items on disk, NULL to write them all
+	RHashTable64 *cur; // hashes of the items written or skipped
+	ut32 kept; // bitmask of the sections not encoded, unchanged since base
+} SnapWriter;
+
+/* rollback point taken before encoding an item */
+typedef struct {
+	ut64 len;
+	ut64 bblen;
+	ut64 strlen;
+	ut32 count;
+	ut32 bbcount;
+} SnapMark;
+
+typedef struct {
+	ut64 from;
+	ut64 to;
+	ut32 type;
+	bool add;
+} SnapXref;
+
+#define SNAP_SDBS (SNAP_FCNSDB - SNAP_META + 1)
+
+/* an sdb store as it was at the last save */
+typedef struct {
+	Sdb *db;
+	SdbHash *ht; // sdb_reset replaces it
+	ut32 count;
+	ut32 gen;
+	bool taken;
+} SnapSdb;
+
+/* sets done on each sdb store, counted by snap_sdb_hook. They are not
+ * per core, another one only makes the stores look changed */
+static ut32 snap_sdb_gen[SNAP_SDBS];
+
+struct r_core_prj_journal_t {
+	char *path; // of the snapshot
+	ut64 id; // of the snapshot, written in each journal segment too
+	RHashTable64 *items; // key hash -> contents hash of the items on disk
+	SnapXref *xlog; // xref changes since the last save
+	int xlen;
+	int xsize;
+	int xmax;
+	bool full; // the xref log overflowed or the xrefs were reset
+	RThread *th; // writing the snapshot after a compaction
+	SnapWriter *thw;
+	char *thpath;
+	bool thok;
+	ut64 fixed; // hash of the sections written in full every time
+	SnapSdb sdbs[SNAP_SDBS];
+};
+
+typedef struct {
+	const ut8 *sect[SNAP_LAST];
+	ut32 count[SNAP_LAST];
+	const char *str;
+	ut64 strsize;
+	ut64 id;
+	ut64 size; // of the whole image
+} SnapReader;
+
+/* FNV-1a taking 8 bytes at a time, the key hashes are stored so it has
+ * to read them in the same order everywhere */
+static ut64 snap_hash(ut64 h, const void *buf, ut64 len) {
+	const ut8 *p = buf;
+	ut8 tail[8] = {0};
+	for (; len >= 8; p += 8, len -= 8) {
+		h = (h ^ r_read_le64 (p)) * SNAP_FNV_PRIME;
+		h ^= h >> 32;
+	}
+	if (len) {
+		memcpy (tail, p, len);
+		h = (h ^ r_read_le64 (tail) ^ (len << 56)) * SNAP_FNV_PRIME;
+		h ^= h >> 32;
+	}
+	return h;
+}
+
+static const char *snap_strat(const char *str, ut64 strsize, ut32 off) {
+	return (off && off < strsize)? str + off: NULL;
+}
+
+/* hashes the record with the strings it refers to instead of their offsets */
+static ut64 snap_rec_hash(ut64 h, int id, const ut8 *rec, const char *str, ut64 strsize) {
+	ut8 buf[64];
+	ut32 i, words = snap_recsz[id] / 4;
+	memcpy (buf, rec, snap_recsz[id]);
+	for (i = 0; i < words; i++) {
+		if (snap_strs[id] & (1U << i)) {
+			const char *s = snap_strat (str, strsize, r_read_le32 (rec + i * 4));
+			r_write_le32 (buf + i * 4, s? 1: 0);
+			if (s) {
+				h = snap_hash (h, s, strlen (s) + 1);
+			}
+		}
+	}
+	return snap_hash (h, buf, snap_recsz[id]);
+}
+
+/* whether the records of the section are compared one by one */
+static bool snap_keyed(int id) {
+	switch (id) {
+	case SNAP_FLAGS:
+	case SNAP_FCNS:
+	case SNAP_META:
+	case SNAP_HINTS:
+	case SNAP_TYPES:
+	case SNAP_FCNSDB:
+		return true;
+	}
+	return false;
+}
+
+/* hash of what identifies the item of the record */
+static ut64 snap_key(int id, const ut8 *rec, const char *str, ut64 strsize) {
+	ut8 sid = id;
+	ut64 h = snap_hash (SNAP_FNV_BASIS, &sid, 1);
+	const char *s;
+	switch (id) {
+	case SNAP_FLAGS:
+		s = snap_strat (str, strsize, r_read_le32 (rec + 20));
+		break;
+	case SNAP_FCNS:
+		return snap_hash (h, rec, 8);
+	default:
+		s = snap_strat (str, strsize, r_read_le32 (rec));
+		break;
+	}
+	return s? snap_hash (h, s, strlen (s) + 1): h;
+}
+
+/* the low bits of the contents hash are replaced by the section */
+#define SNAP_HVAL(h, id) ((void *)(size_t)(((h) & ~0xfULL) | (id)))
+
+static ut8 *snap_put(SnapWriter *w, SnapBuf *b, ut64 len) {
+	ut8 *p;
+	if (b->len + len > b->size) {
+		ut64 size = R_MAX (b->size * 2, b->len + len + 4096);
+		if (size > ST32_MAX || !(p = realloc (b->buf, size))) {
+			w->oom = true;
+			return NULL;
+		}
+		b->buf = p;
+		b->size = size;
+	}
+	p = b->buf + b->len;
+	memset (p, 0, len);
+	b->len += len;
+	return p;
+}
+
+static ut8 *snap_rec(SnapWriter *w, int id) {
+	ut8 *r = snap_put (w, &w->sect[id], snap_recsz[id]);
+	if (r) {
+		w->count[id]++;
+	}
+	return r;
+}
+
+static ut32 snap_str(SnapWriter *w, const char *s) {
+	ut64 len, off = w->str.len;
+	ut8 *p;
+	if (!s) {
+		return 0;
+	}
+	len = strlen (s) + 1;
+	if (!(p = snap_put (w, &w->str, len))) {
+		return 0;
+	}
+	memcpy (p, s, len);
+	return (ut32)off;
+}
+
+static void snap_mark(SnapWriter *w, int id, SnapMark *m) {
+	m->len = w->sect[id].len;
+	m->count = w->count[id];
+	m->bblen = w->sect[SNAP_BBS].len;
+	m->bbcount = w->count[SNAP_BBS];
+	m->strlen = w->str.len;
+}
+
+/* records the hash of the item encoded since the mark, and drops it
+ * again when it is the same as the one on disk */
+static void snap_item(SnapWriter *w, int id, SnapMark *m) {
+	const char *str = (const char *)w->str.buf;
+	const ut8 *rec = w->sect[id].buf + m->len;
+	ut64 key, h;
+	ut32 i;
+	if (w->oom || !w->cur) {
+		return;
+	}
+	key = snap_key (id, rec, str, w->str.len);
+	h = snap_rec_hash (SNAP_FNV_BASIS, id, rec, str, w->str.len);
+	for (i = 0; i < w->count[SNAP_BBS] - m->bbcount; i++) {
+		h = snap_rec_hash (h, SNAP_BBS, w->sect[SNAP_BBS].buf + m->bblen + i * snap_recsz[SNAP_BBS], str, w->str.len);
+	}
+	r_hashtable64_update (w->cur, key, SNAP_HVAL (h, id));
+	if (w->base && r_hashtable64_lookup (w->base, key) == SNAP_HVAL (h, id)) {
+		w->sect[id].len = m->len;
+		w->count[id] = m->count;
+		w->sect[SNAP_BBS].len = m->bblen;
+		w->count[SNAP_BBS] = m->bbcount;
+		w->str.len = m->strlen;
+	}
+}
+
+typedef struct {
+	SnapWriter *w;
+	int id;
+} SnapKv;
+
+static int snap_kv_cb(void *user, const char *k, const char *v) {
+	SnapKv *kv = user;
+	SnapMark m;
+	ut8 *r;
+	snap_mark (kv->w, kv->id, &m);
+	if (!(r = snap_rec (kv->w, kv->id))) {
+		return 0;
+	}
+	r_write_le32 (r, snap_str (kv->w, k));
+	r_write_le32 (r + 4, snap_str (kv->w, v));
+	snap_item (kv->w, kv->id, &m);
+	return 1;
+}
+
+static void snap_sdb(SnapWriter *w, int id, Sdb *db) {
+	SnapKv kv = { w, id };
+	if (db) {
+		sdb_foreach (db, snap_kv_cb, &kv);
+	}
+}
+
+static void snap_flags(SnapWriter *w, RFlag *f) {
+	RListIter *iter;
+	RFlagItem *fi;
+	SnapMark m;
+	ut8 *r;
+	int i;
+	for (i = 0; i < R_FLAG_SPACES_MAX; i++) {
+		if (f->spaces[i] && (r = snap_rec (w, SNAP_FLAGSPACES))) {
+			r_write_le32 (r, i);
+			r_write_le32 (r + 4, snap_str (w, f->spaces[i]));
+		}
+	}
+	r_list_foreach (f->flags, iter, fi) {
+		snap_mark (w, SNAP_FLAGS, &m);
+		if (!(r = snap_rec (w, SNAP_FLAGS))) {
+			return;
+		}
+		r_write_le64 (r, fi->offset);
+		r_write_le64 (r + 8, fi->size);
+		r_write_le32 (r + 16, (ut32)fi->space);
+		r_write_le32 (r + 20, snap_str (w, fi->name));
+		r_write_le32 (r + 24, snap_str (w, fi->realname));
+		r_write_le32 (r + 28, snap_str (w, fi->comment));
+		r_write_le32 (r + 32, snap_str (w, fi->alias));
+		r_write_le32 (r + 36, snap_str (w, fi->color));
+		snap_item (w, SNAP_FLAGS, &m);
+	}
+}
+
+static void snap_fcns(SnapWriter *w, RAnal *anal) {
+	RListIter *iter, *iter2;
+	RAnalFunction *fcn;
+	RAnalBlock *bb;
+	SnapMark m;
+	ut8 *r;
+	r_list_foreach (anal->fcns, iter, fcn) {
+		snap_mark (w, SNAP_FCNS, &m);
+		if (!(r = snap_rec (w, SNAP_FCNS))) {
+			return;
+		}
+		r_write_le64 (r, fcn->addr);
+		r_write_le32 (r + 8, snap_str (w, fcn->name));
+		r_write_le32 (r + 12, snap_str (w, fcn->cc));
+		r_write_le32 (r + 16, fcn->type);
+		r_write_le32 (r + 20, fcn->diff? fcn->diff->type: R_ANAL_DIFF_TYPE_NULL);
+		r_write_le32 (r + 24, fcn->bits);
+		r_write_le32 (r + 28, fcn->stack);
+		r_write_le32 (r + 32, fcn->maxstack);
+		r_write_le32 (r + 36, fcn->folded);
+		r_write_le32 (r + 40, r_list_length (fcn->bbs));
+		r_list_foreach (fcn->bbs, iter2, bb) {
+			if (!(r = snap_rec (w, SNAP_BBS))) {
+				return;
+			}
+			r_write_le64 (r, bb->addr);
+			r_write_le64 (r + 8, bb->jump);
+			r_write_le64 (r + 16, bb->fail);
+			r_write_le32 (r + 24, bb->size);
+			r_write_le32 (r + 28, bb->type);
+			r_write_le32 (r + 32, bb->diff? (ut32)bb->diff->type: UT32_MAX);
+		}
+		snap_item (w, SNAP_FCNS, &m);
+	}
+}
+
+static void snap_xrefs(SnapWriter *w, RAnal *anal) {
+	int i, count;
+	RAnalRef *refs = r_anal_xrefs_dump (anal, &count);
+	ut8 *r;
+	for (i = 0; i < count && (r = snap_rec (w, SNAP_XREFS)); i++) {
+		r_write_le64 (r, refs[i].at);
+		r_write_le64 (r + 8, refs[i].addr);
+		r_write_le32 (r + 16, refs[i].type);
+	}
+	free (refs);
+}
+
+static void snap_xreflog(SnapWriter *w, RCorePrjJournal *j) {
+	ut8 *r;
+	int i;
+	for (i = 0; i < j->xlen && (r = snap_rec (w, SNAP_XREFLOG)); i++) {
+		r_write_le64 (r, j->xlog[i].from);
+		r_write_le64 (r + 8, j->xlog[i].to);
+		r_write_le32 (r + 16, j->xlog[i].type);
+		r_write_le32 (r + 20, j->xlog[i].add);
+	}
+}
+
+static void snap_maps(SnapWriter *w, RIO *io) {
+	RListIter *iter;
+	RIOMap *map;
+	ut8 *r;
+	r_list_foreach (io->maps, iter, map) {
+		if (!(r = snap_rec (w, SNAP_MAPS))) {
+			return;
+		}
+		r_write_le64 (r, map->delta);
+		r_write_le64 (r + 8, map->from);
+		r_write_le64 (r + 16, map->to);
+		r_write_le32 (r + 24, map->fd);
+		r_write_le32 (r + 28, map->flags);
+	}
+}
+
+static void snap_metaspaces(SnapWriter *w, RSpaces *s) {
+	ut8 *r;
+	int i;
+	for (i = 0; i < R_SPACES_MAX; i++) {
+		if (s->spaces[i] && (r = snap_rec (w, SNAP_METASPACES))) {
+			r_write_le32 (r, i);
+			r_write_le32 (r + 4, snap_str (w, s->spaces[i]));
+		}
+	}
+}
+
+static Sdb *snap_sdb_of(RAnal *anal, int id) {
+	switch (id) {
+	case SNAP_META:
+		return anal->sdb_meta;
+	case SNAP_HINTS:
+		return anal->sdb_hints;
+	case SNAP_TYPES:
+		return anal->sdb_types;
+	case SNAP_FCNSDB:
+		return anal->sdb_fcns;
+	}
+	return NULL;
+}
+
+static void snap_sdb_hook(Sdb *s, void *user, const char *k, const char *v) {
+	(*(ut32 *)user)++;
+}
+
+/* whether the sdb store of section id is still the one j saved. Sets
+ * (and so unsets) go through the hook, sdb_reset and sdb_remove do not
+ * but change the hashtable or its count */
+static bool snap_sdb_same(RCorePrjJournal *j, RAnal *anal, int id) {
+	SnapSdb *ss = &j->sdbs[id - SNAP_META];
+	Sdb *db = snap_sdb_of (anal, id);
+	return ss->taken && db && ss->db == db && ss->ht == db->ht
+		&& ss->count == db->ht->count && ss->gen == snap_sdb_gen[id - SNAP_META];
+}
+
+/* takes the state of the sdb stores once the items of j are on disk */
+static void snap_sdb_take(RCorePrjJournal *j, RAnal *anal) {
+	int i;
+	for (i = 0; i < SNAP_SDBS; i++) {
+		SnapSdb *ss = &j->sdbs[i];
+		Sdb *db = snap_sdb_of (anal, SNAP_META + i);
+		if (!db || !db->ht) {
+			ss->taken = false;
+			continue;
+		}
+		sdb_hook (db, snap_sdb_hook, &snap_sdb_gen[i]);
+		ss->db = db;
+		ss->ht = db->ht;
+		ss->count = db->ht->count;
+		ss->gen = snap_sdb_gen[i];
+		ss->taken = true;
+	}
+}
+
+/* the items of the sections left out are still the ones on disk */
+static bool snap_kept_cb(void *user, ut64 key, void *data) {
+	SnapWriter *w = user;
+	if (w->kept & (1U << ((size_t)data & 0xf))) {
+		r_hashtable64_update (w->cur, key, data);
+	}
+	return true;
+}
+
+static bool snap_deleted_cb(void *user, ut64 key, void *data) {
+	SnapWriter *w = user;
+	ut8 *r;
+	if (!r_hashtable64_lookup (w->cur, key)) {
+		if (!(r = snap_rec (w, SNAP_DELETED))) {
+			return false;
+		}
+		r_write_le64 (r, key);
+	}
+	return true;
+}
+
+/* encodes everything, or only the changes since j was saved */
+static void snap_encode(SnapWriter *w, RCore *core, RCorePrjJournal *j) {
+	int id;
+	snap_put (w, &w->str, 1); // offset 0 stands for NULL
+	snap_flags (w, core->flags);
+	snap_fcns (w, core->anal);
+	if (j) {
+		snap_xreflog (w, j);
+	} else {
+		snap_xrefs (w, core->anal);
+	}
+	snap_maps (w, core->io);
+	snap_metaspaces (w, &core->anal->meta_spaces);
+	for (id = SNAP_META; id <= SNAP_FCNSDB; id++) {
+		if (j && w->base && snap_sdb_same (j, core->anal, id)) {
+			w->kept |= 1U << id;
+		} else {
+			snap_sdb (w, id, snap_sdb_of (core->anal, id));
+		}
+	}
+	if (w->base && w->cur) {
+		if (w->kept) {
+			r_hashtable64_foreach (w->base, snap_kept_cb, w);
+		}
+		r_hashtable64_foreach (w->base, snap_deleted_cb, w);
+	}
+}
+
+/* hash of the sections which are not made of keyed items */
+static ut64 snap_fixed_hash(const SnapReader *r) {
+	static const int ids[] = { SNAP_FLAGSPACES, SNAP_MAPS, SNAP_METASPACES };
+	ut64 h = SNAP_FNV_BASIS;
+	ut32 i, n;
+	for (i = 0; i < sizeof (ids) / sizeof (ids[0]); i++) {
+		const ut8 *p = r->sect[ids[i]];
+		for (n = 0; n < r->count[ids[i]]; n++, p += snap_recsz[ids[i]]) {
+			h = snap_rec_hash (h, ids[i], p, r->str, r->strsize);
+		}
+		h = snap_hash (h, &n, sizeof (n));
+	}
+	return h;
+}
+
+/* whether the delta in w has nothing new for the journal j */
+static bool snap_unchanged(SnapWriter *w, RCorePrjJournal *j, ut64 fixed) {
+	int i;
+	for (i = 1; i < SNAP_LAST; i++) {
+		if (w->count[i] && i != SNAP_FLAGSPACES && i != SNAP_MAPS && i != SNAP_METASPACES) {
+			return false;
+		}
+	}
+	return fixed == j->fixed;
+}
+
+static void snap_writer_free(SnapWriter *w) {
+	int i;
+	if (!w) {
+		return;
+	}
+	for (i = 0; i < SNAP_LAST; i++) {
+		free (w->sect[i].buf);
+	}
+	free (w->str.buf);
+	r_hashtable64_free (w->cur);
+	free (w);
+}
+
+static bool snap_write(SnapWriter *w, const char *file, ut64 id, bool append) {
+	ut8 hdr[SNAP_HDRSZ + SNAP_SECTSZ * (SNAP_LAST - 1)];
+	ut64 off = sizeof (hdr);
+	int i;
+	memcpy (hdr, SNAP_MAGIC, 8);
+	r_write_le32 (hdr + 8, SNAP_VERSION);
+	r_write_le32 (hdr + 12, SNAP_LAST - 1);
+	for (i = 1; i < SNAP_LAST; i++) {
+		ut8 *s = hdr + SNAP_HDRSZ + SNAP_SECTSZ * (i - 1);
+		r_write_le32 (s, i);
+		r_write_le32 (s + 4, w->count[i]);
+		r_write_le64 (s + 8, off);
+		off += w->sect[i].len;
+	}
+	r_write_le64 (hdr + 16, off);
+	r_write_le64 (hdr + 24, w->str.len);
+	r_write_le64 (hdr + 32, id);
+	if (!r_file_dump (file, hdr, sizeof (hdr), append)) {
+		return false;
+	}
+	for (i = 1; i < SNAP_LAST; i++) {
+		if (w->sect[i].len && !r_file_dump (file, w->sect[i].buf, w->sect[i].len, true)) {
+			return false;
+		}
+	}
+	return r_file_dump (file, w->str.buf, w->str.len, true);
+}
+
+static void snap_view(SnapWriter *w, SnapReader *r) {
+	int i;
+	memset (r, 0, sizeof (SnapReader));
+	for (i = 1; i < SNAP_LAST; i++) {
+		r->sect[i] = w->sect[i].buf;
+		r->count[i] = w->count[i];
+	}
+	r->str = (const char *)w->str.buf;
+	r->strsize = w->str.len;
+}
+
+/* writes a new snapshot next to file and moves it over, the journal of
+ * the old one goes away after it */
+static bool snap_replace(SnapWriter *w, const char *file, ut64 id) {
+	char *tmp = r_str_newf ("%s.tmp", file);
+	char *jpath = r_str_newf ("%s.journal", file);
+	bool ret = snap_write (w, tmp, id, false);
+	if (ret) {
+#if __WINDOWS__
+		r_file_rm (file);
+#endif
+		ret = !rename (tmp, file);
+	}
+	if (ret) {
+		r_file_rm (jpath);
+	} else {
+		r_file_rm (tmp);
+	}
+	free (tmp);
+	free (jpath);
+	return ret;
+}
+
+static ut64 snap_file_id(const char *file) {
+	int len = 0;
+	char *hdr = r_file_slurp_range (file, 0, SNAP_HDRSZ, &len);
+	ut64 id = 0;
+	if (hdr && len == SNAP_HDRSZ && !memcmp (hdr, SNAP_MAGIC, 8)
+			&& r_read_le32 (hdr + 8) == SNAP_VERSION) {
+		id = r_read_le64 (hdr + 32);
+	}
+	free (hdr);
+	return id;
+}
+
+static int snap_on_xref(void *anal, void *user, const RAnalRef *ref, bool add) {
+	RCore *core = user;
+	RCorePrjJournal *j = core->prj_journal;
+	SnapXref *x;
+	if (!j || j->full) {
+		return 0;
+	}
+	if (!ref || j->xlen >= j->xmax) {
+		/* cheaper to write them all again */
+		j->full = true;
+		R_FREE (j->xlog);
+		j->xlen = j->xsize = 0;
+		return 0;
+	}
+	if (j->xlen == j->xsize) {
+		int size = R_MAX (j->xsize * 2, 256);
+		if (!(x = realloc (j->xlog, size * sizeof (SnapXref)))) {
+			j->full = true;
+			return 0;
+		}
+		j->xlog = x;
+		j->xsize = size;
+	}
+	x = &j->xlog[j->xlen++];
+	x->from = ref->at;
+	x->to = ref->addr;
+	x->type = ref->type;
+	x->add = add;
+	return 0;
+}
+
+static RCorePrjJournal *snap_journal(RCore *core, const char *file, ut64 id, RHashTable64 *items, ut32 nxrefs) {
+	RCorePrjJournal *j = R_NEW0 (RCorePrjJournal);
+	if (!j) {
+		r_hashtable64_free (items);
+		return NULL;
+	}
+	j->path = strdup (file);
+	j->id = id;
+	j->items = items;
+	j->xmax = R_MAX (SNAP_XLOG_MIN, nxrefs / 2);
+	core->prj_journal = j;
+	core->anal->cb.on_xref = snap_on_xref;
+	return j;
+}
+
+static int snap_write_th(RThread *th) {
+	RCorePrjJournal *j = th->user;
+	j->thok = snap_replace (j->thw, j->thpath, j->id);
+	return 0;
+}
+
+/* waits for the snapshot being written in the background */
+R_API void r_core_project_snapshot_wait(RCore *core) {
+	RCorePrjJournal *j = core? core->prj_journal: NULL;
+	if (!j || !j->th) {
+		return;
+	}
+	r_th_wait (j->th);
+	r_th_lock_free (j->th->lock);
+	free (j->th);
+	j->th = NULL;
+	if (!j->thok) {
+		eprintf ("Cannot write the project snapshot '%s'\n", j->thpath);
+		j->full = true;
+	}
+	snap_writer_free (j->thw);
+	j->thw = NULL;
+	R_FREE (j->thpath);
+}
+
+/* stops tracking the changes since the last save or load */
+R_API void r_core_project_snapshot_fini(RCore *core) {
+	RCorePrjJournal *j = core? core->prj_journal: NULL;
+	int i;
+	if (!j) {
+		return;
+	}
+	r_core_project_snapshot_wait (core);
+	core->prj_journal = NULL;
+	for (i = 0; i < SNAP_SDBS; i++) {
+		Sdb *db = snap_sdb_of (core->anal, SNAP_META + i);
+		if (j->sdbs[i].taken && db == j->sdbs[i].db) {
+			sdb_unhook (db, snap_sdb_hook);
+		}
+	}
+	r_hashtable64_free (j->items);
+	free (j->xlog);
+	free (j->path);
+	free (j);
+}
+
+/* writes the analysis of core to file, or appends what changed since
+ * it was saved or loaded to its journal */
+R_API bool r_core_project_snapshot_save(RCore *core, const char *file) {
+	RCorePrjJournal *j;
+	SnapReader view;
+	SnapWriter *w;
+	char *jpath;
+	bool journal, delta, compact = false, ret = false;
+	ut64 id, fixed;
+	if (!core || !file) {
+		return false;
+	}
+	r_core_project_snapshot_wait (core);
+	journal = r_config_get_i (core->config, "prj.journal");
+	j = core->prj_journal;
+	jpath = r_str_newf ("%s.journal", file);
+	delta = journal && j && !j->full && !strcmp (j->path, file) && snap_file_id (file) == j->id;
+	if (delta && r_file_size (jpath) > r_file_size (file) / 2) {
+		delta = false;
+		compact = true;
+	}
+	if (!(w = R_NEW0 (SnapWriter))) {
+		free (jpath);
+		return false;
+	}
+	w->base = delta? j->items: NULL;
+	w->cur = journal? r_hashtable64_new (NULL): NULL;
+	snap_encode (w, core, delta? j: NULL);
+	if (w->oom || (journal && !w->cur)) {
+		eprintf ("Cannot allocate the project snapshot\n");
+		snap_writer_free (w);
+		free (jpath);
+		if (j) {
+			j->full = true;
+		}
+		return false;
+	}
+	snap_view (w, &view);
+	fixed = snap_fixed_hash (&view);
+	if (delta) {
+		id = j->id;
+		ret = snap_unchanged (w, j, fixed) || snap_write (w, jpath, id, true);
+	} else {
+		id = r_sys_now ();
+		if (j && id == j->id) {
+			id++;
+		}
+		if (!compact) {
+			ret = snap_replace (w, file, id);
+		}
+	}
+	free (jpath);
+	if (!journal) {
+		r_core_project_snapshot_fini (core);
+		snap_writer_free (w);
+		return ret;
+	}
+	if (!delta) {
+		ut32 nxrefs = w->count[SNAP_XREFS];
+		r_core_project_snapshot_fini (core);
+		if (!(j = snap_journal (core, file, id, w->cur, nxrefs))) {
+			w->cur = NULL;
+			snap_writer_free (w);
+			return ret;
+		}
+		w->cur = NULL;
+		j->fixed = fixed;
+		snap_sdb_take (j, core->anal);
+		if (compact) {
+			j->thw = w;
+			j->thpath = strdup (file);
+			if ((j->th = r_th_new (snap_write_th, j, false))) {
+				r_th_start (j->th, true);
+				return true;
+			}
+			j->thw = NULL;
+			R_FREE (j->thpath);
+			ret = snap_replace (w, file, id);
+		}
+		j->full = !ret;
+	} else if (ret) {
+		r_hashtable64_free (j->items);
+		j->items = w->cur;
+		w->cur = NULL;
+		j->fixed = fixed;
+		j->xlen = 0;
+		snap_sdb_take (j, core->anal);
+	} else {
+		j->full = true;
+	}
+	snap_writer_free (w);
+	return ret;
+}
+
+static const char *snap_fix(SnapReader *r, ut32 off) {
+	return snap_strat (r->str, r->strsize, off);
+}
+
+static bool snap_open(SnapReader *r, const ut8 *buf, ut64 len) {
+	ut64 stroff;
+	ut32 i, n;
+	if (len < SNAP_HDRSZ || memcmp (buf, SNAP_MAGIC, 8)) {
+		eprintf ("Invalid project snapshot\n");
+		return false;
+	}
+	if (r_read_le32 (buf + 8) != SNAP_VERSION) {
+		eprintf ("Unsupported project snapshot version %d\n", r_read_le32 (buf + 8));
+		return false;
+	}
+	n = r_read_le32 (buf + 12);
+	stroff = r_read_le64 (buf + 16);
+	r->strsize = r_read_le64 (buf + 24);
+	r->id = r_read_le64 (buf + 32);
+	if (n > (len - SNAP_HDRSZ) / SNAP_SECTSZ || stroff > len || r->strsize > len - stroff) {
+		eprintf ("Truncated project snapshot\n");
+		return false;
+	}
+	r->size = stroff + r->strsize;
+	r->str = (const char *)buf + stroff;
+	if (r->strsize && r->str[r->strsize - 1]) {
+		eprintf ("Corrupted project snapshot\n");
+		return false;
+	}
+	for (i = 0; i < n; i++) {
+		const ut8 *s = buf + SNAP_HDRSZ + SNAP_SECTSZ * i;
+		ut32 id = r_read_le32 (s);
+		ut32 count = r_read_le32 (s + 4);
+		ut64 off = r_read_le64 (s + 8);
+		if (id < 1 || id >= SNAP_LAST) {
+			continue; // newer minor additions are skipped
+		}
+		if (off > len || (ut64)count * snap_recsz[id] > len - off) {
+			eprintf ("Truncated project snapshot\n");
+			return false;
+		}
+		r->sect[id] = buf + off;
+		r->count[id] = count;
+	}
+	return true;
+}
+
+/* the images of the snapshot and its journal, oldest first. Each key
+ * is applied from the newest image having it only */
+typedef struct {
+	SnapReader *r;
+	int n;
+	RHashTable64 *owner; // key hash -> index of the image + 1, n + 1 if deleted
+	RHashTable64 *items; // baseline for the journal, NULL if disabled
+} SnapLoad;
+
+static void snap_owners(SnapLoad *l) {
+	int i, id;
+	ut32 n;
+	for (i = l->n - 1; i >= 0; i--) {
+		SnapReader *r = &l->r[i];
+		const ut8 *p = r->sect[SNAP_DELETED];
+		for (n = 0; n < r->count[SNAP_DELETED]; n++, p += 8) {
+			r_hashtable64_insert (l->owner, r_read_le64 (p), (void *)(size_t)(l->n + 1));
+		}
+		for (id = 1; id < SNAP_LAST; id++) {
+			if (!snap_keyed (id)) {
+				continue;
+			}
+			p = r->sect[id];
+			for (n = 0; n < r->count[id]; n++, p += snap_recsz[id]) {
+				ut64 key = snap_key (id, p, r->str, r->strsize);
+				r_hashtable64_insert (l->owner, key, (void *)(size_t)(i + 1));
+			}
+		}
+	}
+}
+
+/* whether the record of image i is the one to apply, bbs are the blocks
+ * of a function record to add to the hash of the baseline */
+static bool snap_live(SnapLoad *l, int i, int id, const ut8 *rec, const ut8 *bbs, ut32 nbbs) {
+	SnapReader *r = &l->r[i];
+	ut64 key = snap_key (id, rec, r->str, r->strsize);
+	ut64 h;
+	ut32 n;
+	if (r_hashtable64_lookup (l->owner, key) != (void *)(size_t)(i + 1)) {
+		return false;
+	}
+	if (l->items) {
+		h = snap_rec_hash (SNAP_FNV_BASIS, id, rec, r->str, r->strsize);
+		for (n = 0; n < nbbs; n++) {
+			h = snap_rec_hash (h, SNAP_BBS, bbs + n * snap_recsz[SNAP_BBS], r->str, r->strsize);
+		}
+		r_hashtable64_update (l->items, key, SNAP_HVAL (h, id));
+	}
+	return true;
+}
+
+static void load_flags(SnapLoad *l, int i, RFlag *f) {
+	SnapReader *r = &l->r[i];
+	int spaces[R_FLAG_SPACES_MAX];
+	int old = f->space_idx;
+	const ut8 *p;
+	ut32 n;
+	for (n = 0; n < R_FLAG_SPACES_MAX; n++) {
+		spaces[n] = -1;
+	}
+	for (n = 0, p = r->sect[SNAP_FLAGSPACES]; n < r->count[SNAP_FLAGSPACES]; n++, p += 8) {
+		ut32 idx = r_read_le32 (p);
+		const char *name = snap_fix (r, r_read_le32 (p + 4));
+		if (idx < R_FLAG_SPACES_MAX && name) {
+			spaces[idx] = r_flag_space_set (f, name);
+		}
+	}
+	for (n = 0, p = r->sect[SNAP_FLAGS]; n < r->count[SNAP_FLAGS]; n++, p += 40) {
+		ut32 space = r_read_le32 (p + 16);
+		const char *name = snap_fix (r, r_read_le32 (p + 20));
+		const char *realname = snap_fix (r, r_read_le32 (p + 24));
+		const char *comment = snap_fix (r, r_read_le32 (p + 28));
+		const char *alias = snap_fix (r, r_read_le32 (p + 32));
+		const char *color = snap_fix (r, r_read_le32 (p + 36));
+		RFlagItem *fi;
+		if (!name || !snap_live (l, i, SNAP_FLAGS, p, NULL, 0)) {
+			continue;
+		}
+		f->space_idx = space < R_FLAG_SPACES_MAX? spaces[space]: -1;
+		fi = r_flag_set (f, name, r_read_le64 (p), (ut32)r_read_le64 (p + 8));
+		if (!fi) {
+			continue;
+		}
+		if (realname && strcmp (realname, name)) {
+			r_flag_item_set_realname (fi, realname);
+		}
+		if (comment) {
+			r_flag_item_set_comment (fi, comment);
+		}
+		if (alias) {
+			r_flag_item_set_alias (fi, alias);
+		}
+		if (color) {
+			r_flag_color (f, fi, color);
+		}
+	}
+	f->space_idx = old;
+}
+
+static void load_fcns(SnapLoad *l, int i, RAnal *anal) {
+	SnapReader *r = &l->r[i];
+	const ut8 *p = r->sect[SNAP_FCNS];
+	const ut8 *b = r->sect[SNAP_BBS];
+	ut32 n, k, nbbs = r->count[SNAP_BBS];
+	RAnalDiff diff = {0};
+	diff.addr = UT64_MAX;
+	for (n = 0; n < r->count[SNAP_FCNS]; n++, p += 44) {
+		ut64 addr = r_read_le64 (p);
+		const char *name = snap_fix (r, r_read_le32 (p + 8));
+		const char *cc = snap_fix (r, r_read_le32 (p + 12));
+		ut32 count = R_MIN (r_read_le32 (p + 40), nbbs);
+		const ut8 *bbs = b;
+		RAnalFunction *fcn;
+		b += count * 36;
+		nbbs -= count;
+		if (!snap_live (l, i, SNAP_FCNS, p, bbs, count)) {
+			continue;
+		}
+		diff.type = r_read_le32 (p + 20);
+		if (!r_anal_fcn_add (anal, addr, 0, name, r_read_le32 (p + 16), &diff)) {
+			eprintf ("Cannot add function (duplicated)\n");
+		}
+		if (!(fcn = r_anal_get_fcn_at (anal, addr, R_ANAL_FCN_TYPE_ROOT))) {
+			continue;
+		}
+		for (k = 0; k < count; k++, bbs += 36) {
+			ut32 bbdiff = r_read_le32 (bbs + 32);
+			diff.type = bbdiff;
+			r_anal_fcn_add_bb (anal, fcn, r_read_le64 (bbs),
+				r_read_le32 (bbs + 24), r_read_le64 (bbs + 8),
+				r_read_le64 (bbs + 16), r_read_le32 (bbs + 28),
+				bbdiff == UT32_MAX? NULL: &diff);
+		}
+		fcn->cc = cc? r_anal_cc_to_constant (anal, (char *)cc): NULL;
+		fcn->bits = r_read_le32 (p + 24);
+		fcn->stack = r_read_le32 (p + 28);
+		fcn->maxstack = r_read_le32 (p + 32);
+		fcn->folded = r_read_le32 (p + 36);
+	}
+}
+
+static void load_xrefs(SnapReader *r, RAnal *anal) {
+	const ut8 *p = r->sect[SNAP_XREFS];
+	ut32 n, count = r->count[SNAP_XREFS];
+	RAnalRef *refs;
+	if (count && (refs = malloc (count * sizeof (RAnalRef)))) {
+		for (n = 0; n < count; n++, p += 20) {
+			refs[n].at = r_read_le64 (p);
+			refs[n].addr = r_read_le64 (p + 8);
+			refs[n].type = r_read_le32 (p + 16);
+		}
+		r_anal_xrefs_restore (anal, refs, count);
+		free (refs);
+	}
+	p = r->sect[SNAP_XREFLOG];
+	for (n = 0; n < r->count[SNAP_XREFLOG]; n++, p += 24) {
+		RAnalRef ref;
+		ref.at = r_read_le64 (p);
+		ref.addr = r_read_le64 (p + 8);
+		ref.type = r_read_le32 (p + 16);
+		if (r_read_le32 (p + 20)) {
+			r_anal_xrefs_restore (anal, &ref, 1);
+		} else {
+			r_anal_xrefs_deln (anal, ref.type, ref.at, ref.addr);
+		}
+	}
+}
+
+/* the nth map of fd in maps, or NULL */
+static RIOMap *snap_nth_map(RList *maps, int fd, int nth) {
+	RListIter *iter;
+	RIOMap *map;
+	r_list_foreach (maps, iter, map) {
+		if (map->fd == fd && !nth--) {
+			return map;
+		}
+	}
+	return NULL;
+}
+
+/* the saved maps of each fd are matched in order with the ones it has
+ * now, moving those that were relocated and adding the missing ones */
+static void load_maps(SnapReader *r, RIO *io) {
+	const ut8 *p = r->sect[SNAP_MAPS];
+	RList *live = r_list_clone (io->maps);
+	ut32 n, i;
+	if (!live) {
+		return;
+	}
+	for (n = 0; n < r->count[SNAP_MAPS]; n++, p += 32) {
+		ut64 delta = r_read_le64 (p);
+		ut64 from = r_read_le64 (p + 8);
+		ut64 to = r_read_le64 (p + 16);
+		int fd = r_read_le32 (p + 24);
+		int nth = 0;
+		RIOMap *map;
+		for (i = 0; i < n; i++) {
+			if ((int)r_read_le32 (r->sect[SNAP_MAPS] + i * 32 + 24) == fd) {
+				nth++;
+			}
+		}
+		map = snap_nth_map (live, fd, nth);
+		if (map && map->delta == delta) {
+			if (map->from != from || map->to != to) {
+				r_io_map_set_range (io, map, from, to);
+			}
+		} else if (r_io_desc_get (io, fd)) {
+			r_io_map_add (io, fd, r_read_le32 (p + 28), delta, from, to - from);
+		}
+	}
+	r_list_free (live);
+}
+
+static void load_metaspaces(SnapReader *r, RSpaces *s) {
+	const ut8 *p = r->sect[SNAP_METASPACES];
+	ut32 n;
+	for (n = 0; n < r->count[SNAP_METASPACES]; n++, p += 8) {
+		ut32 idx = r_read_le32 (p);
+		const char *name = snap_fix (r, r_read_le32 (p + 4));
+		/* the metas refer to their space by index */
+		if (idx < R_SPACES_MAX && name && !s->spaces[idx]) {
+			s->spaces[idx] = strdup (name);
+		}
+	}
+}
+
+static void load_sdb(SnapLoad *l, int i, int id, Sdb *db) {
+	SnapReader *r = &l->r[i];
+	const ut8 *p = r->sect[id];
+	ut32 n;
+	if (!db) {
+		return;
+	}
+	for (n = 0; n < r->count[id]; n++, p += 8) {
+		const char *k = snap_fix (r, r_read_le32 (p));
+		const char *v = snap_fix (r, r_read_le32 (p + 4));
+		if (k && v && snap_live (l, i, id, p, NULL, 0)) {
+			sdb_set (db, k, v, 0);
+		}
+	}
+}
+
+/* adds the analysis saved by r_core_project_snapshot_save */
+R_API bool r_core_project_snapshot_load(RCore *core, const char *file) {
+	SnapLoad l = {0};
+	RMmap *m, *jm = NULL;
+	char *jpath;
+	int i;
+	if (!core || !file) {
+		return false;
+	}
+	r_core_project_snapshot_fini (core);
+	if (!(m = r_file_mmap (file, false, 0))) {
+		eprintf ("Cannot map '%s'\n", file);
+		return false;
+	}
+	if (!(l.r = R_NEW0 (SnapReader)) || !snap_open (&l.r[0], m->buf, m->len)) {
+		free (l.r);
+		r_file_mmap_free (m);
+		return false;
+	}
+	l.n = 1;
+	jpath = r_str_newf ("%s.journal", file);
+	if (r_file_exists (jpath) && (jm = r_file_mmap (jpath, false, 0))) {
+		ut64 off = 0;
+		while (off < jm->len) {
+			SnapReader *rs, r = {{0}};
+			if (!snap_open (&r, jm->buf + off, jm->len - off)) {
+				eprintf ("Ignoring the end of '%s'\n", jpath);
+				break;
+			}
+			off += r.size;
+			if (r.id != l.r[0].id) {
+				continue; // left by a snapshot rewritten since
+			}
+			if (!(rs = realloc (l.r, (l.n + 1) * sizeof (SnapReader)))) {
+				break;
+			}
+			l.r = rs;
+			l.r[l.n++] = r;
+		}
+	}
+	free (jpath);
+	l.owner = r_hashtable64_new (NULL);
+	l.items = r_config_get_i (core->config, "prj.journal")? r_hashtable64_new (NULL): NULL;
+	snap_owners (&l);
+	for (i = 0; i < l.n; i++) {
+		SnapReader *r = &l.r[i];
+		load_metaspaces (r, &core->anal->meta_spaces);
+		load_sdb (&l, i, SNAP_META, core->anal->sdb_meta);
+		load_sdb (&l, i, SNAP_TYPES, core->anal->sdb_types);
+		load_sdb (&l, i, SNAP_HINTS, core->anal->sdb_hints);
+		load_maps (r, core->io);
+		load_flags (&l, i, core->flags);
+		load_fcns (&l, i, core->anal);
+		load_sdb (&l, i, SNAP_FCNSDB, core->anal->sdb_fcns);
+		load_xrefs (r, core->anal);
+	}
+	core->anal->bits_hints_changed = true;
+	if (l.items) {
+		RCorePrjJournal *j = snap_journal (core, file, l.r[0].id, l.items, l.r[0].count[SNAP_XREFS]);
+		if (j) {
+			j->fixed = snap_fixed_hash (&l.r[l.n - 1]);
+		}
+	}
+	r_hashtable64_free (l.owner);
+	free (l.r);
+	r_file_mmap_free (jm);
+	r_file_mmap_free (m);
+	return true;
+}
@@ -1,25 +1,219 @@
-/* radare - LGPL - Copyright 2014-2016 - pancake */
+/* radare - LGPL - Copyright 2014-2017 - pancake */
 
 #include <r_core.h>
 
+/* the background tasks run on a pool of tasks.jobs threads, taking the
+ * queue in order: a readonly task starts as soon as no mutating one is
+ * running, and a mutating one waits for all the others to end, so each
+ * task sees the changes of the ones sent before it. Each task prints
+ * into its own RConsContext, which is also how it is cancelled, and
+ * gets its output handed over in chunks while it runs. */
+
+#define TASK_CHUNK (64 * 1024)
+
+struct r_core_task_sched_t {
+	RThreadLock *lock; // of this and of the state and output of the tasks
+	RThreadCond *cond; // signaled when a task is queued or ends
+	RThreadPool *pool;
+	RList *queue; // tasks waiting to start, oldest first
+	int readers; // readonly tasks running
+	bool writer; // a mutating task is running
+	bool quit;
+};
+
+static bool task_pending(RCoreTask *task) {
+	return task->state == 'q' || task->state == 'r';
+}
+
+static void task_sink(void *user, const char *buf, int len) {
+	RCoreTask *task = user;
+	RCoreTaskSched *s = task->core->task_sched;
+	char *chunk = NULL;
+	if (s) {
+		r_th_lock_enter (s->lock);
+	}
+	if (task->outlen + len + 1 > task->outsize) {
+		int size = R_MAX (task->outsize * 2, task->outlen + len + 1);
+		char *out = realloc (task->out, size);
+		if (out) {
+			task->out = out;
+			task->outsize = size;
+		}
+	}
+	if (task->outlen + len + 1 <= task->outsize) {
+		chunk = task->out + task->outlen;
+		memcpy (chunk, buf, len);
+		task->outlen += len;
+		task->out[task->outlen] = 0;
+	}
+	if (s) {
+		r_th_lock_leave (s->lock);
+	}
+	// only this task grows its output, the chunk stays there
+	if (task->cb && chunk) {
+		task->cb (task->user, chunk);
+	}
+}
+
+/* the commands a readonly task can run. r_core_cmd writes the seek, the
+ * block, core->num and the other state of the core, so these are run
+ * by calling the function behind them, which only reads */
+static const struct {
+	const char *cmd;
+	const char *rad; // listing mode of r_core_anal_fcn_list
+} task_readers[] = {
+	{ "afl", "o" },
+	{ "aflq", "q" },
+	{ "afls", "s" },
+	{ NULL, NULL }
+};
+
+static const char *task_reader(const char *cmd) {
+	int i, len;
+	while (*cmd == ' ' || *cmd == '\t') {
+		cmd++;
+	}
+	for (len = strlen (cmd); len > 0 && (cmd[len - 1] == ' ' || cmd[len - 1] == '\t'); len--) {
+		;
+	}
+	for (i = 0; task_readers[i].cmd; i++) {
+		if (strlen (task_readers[i].cmd) == len && !strncmp (task_readers[i].cmd, cmd, len)) {
+			return task_readers[i].rad;
+		}
+	}
+	return NULL;
+}
+
+/* runs the command of the task in the calling thread */
+static void task_exec(RCore *core, RCoreTask *task) {
+	RConsContext *ctx = task->cons;
+	ctx->sink = task_sink;
+	ctx->sink_user = task;
+	/* pipes and redirections want the whole output */
+	ctx->sink_chunk = strpbrk (task->msg->text, "|>")? 0: TASK_CHUNK;
+	task->started = r_sys_now ();
+	r_cons_context_load (ctx);
+	if (!ctx->breaked) {
+		const char *rad = task->readonly? task_reader (task->msg->text): NULL;
+		if (rad) {
+			r_core_anal_fcn_list (core, NULL, rad);
+		} else {
+			r_core_cmd (core, task->msg->text, 0);
+		}
+	}
+	r_cons_flush ();
+	r_cons_context_load (NULL);
+	task->ended = r_sys_now ();
+}
+
+static void task_end(RCoreTask *task) {
+	free (task->msg->res);
+	task->msg->res = strdup (task->out? task->out: "");
+	task->msg->done = 1;
+	task->state = 'd';
+}
+
+/* the head of the queue, if it can start now */
+static RCoreTask *task_next(RCoreTaskSched *s) {
+	RCoreTask *task = r_list_first (s->queue);
+	if (!task || s->writer || (!task->readonly && s->readers)) {
+		return NULL;
+	}
+	r_list_pop_head (s->queue);
+	if (task->readonly) {
+		s->readers++;
+	} else {
+		s->writer = true;
+	}
+	task->state = 'r';
+	return task;
+}
+
+static int task_worker(RThread *th) {
+	RCoreTaskSched *s = th->user;
+	RCoreTask *task;
+	r_th_lock_enter (s->lock);
+	while (!(task = task_next (s))) {
+		if (s->quit) {
+			r_th_lock_leave (s->lock);
+			return 0;
+		}
+		r_th_cond_wait (s->cond, s->lock);
+	}
+	r_th_lock_leave (s->lock);
+	task_exec (task->core, task);
+	if (task->cb) {
+		task->cb (task->user, NULL);
+	}
+	r_th_lock_enter (s->lock);
+	if (task->readonly) {
+		s->readers--;
+	} else {
+		s->writer = false;
+	}
+	task_end (task);
+	r_th_cond_signal_all (s->cond);
+	r_th_lock_leave (s->lock);
+	return 1;
+}
+
+static RCoreTaskSched *task_sched(RCore *core) {
+	RCoreTaskSched *s = core->task_sched;
+	if (s) {
+		return s;
+	}
+	if (!(s = R_NEW0 (RCoreTaskSched))) {
+		return NULL;
+	}
+	s->lock = r_th_lock_new ();
+	s->cond = r_th_cond_new ();
+	s->queue = r_list_new ();
+	if (!s->lock || !s->cond || !s->queue) {
+		goto fail;
+	}
+	s->pool = r_th_pool_new (R_MAX (1, r_config_get_i (core->config, "tasks.jobs")), task_worker, s);
+	if (!s->pool) {
+		goto fail;
+	}
+	core->task_sched = s;
+	return s;
+fail:
+	r_th_lock_free (s->lock);
+	r_th_cond_free (s->cond);
+	r_list_free (s->queue);
+	free (s);
+	return NULL;
+}
+
 R_API void r_core_task_list (RCore *core, int mode) {
+	RCoreTaskSched *s = core->task_sched;
 	RListIter *iter;
 	RCoreTask *task;
 	if (mode == 'j') {
 		r_cons_printf ("[");
 	}
+	if (s) {
+		r_th_lock_enter (s->lock);
+	}
 	r_list_foreach (core->tasks, iter, task) {
+		ut64 now = task->ended? task->ended: r_sys_now ();
+		double secs = task->started? (now - task->started) / 1000000.0: 0;
 		switch (mode) {
 		case 'j':
-			r_cons_printf ("{\"id\":%d,\"status\":\"%c\",\"text\":\"%s\"}%s",
-				task->id, task->state, task->msg->text, iter->n?",":"");
+			r_cons_printf ("{\"id\":%d,\"status\":\"%c\",\"readonly\":%s,"
+				"\"breaked\":%s,\"time\":%.3f,\"output\":%d,\"text\":\"%s\"}%s",
+				task->id, task->state, r_str_bool (task->readonly),
+				r_str_bool (task->cons->breaked), secs, task->outlen,
+				task->msg->text, iter->n?",":"");
 			break;
 		default:
-			r_cons_printf ("Task %d Status %c Command %s\n",
-					task->id, task->state, task->msg->text);
+			r_cons_printf ("Task %d Status %c%s%s Time %.3fs Output %d Command %s\n",
+				task->id, task->state, task->readonly? " readonly": "",
+				task->cons->breaked? " breaked": "", secs, task->outlen,
+				task->msg->text);
 			if (mode == 1) {
-				if (task->msg->res) {
-					r_cons_println (task->msg->res);
+				if (task->out) {
+					r_cons_println (task->out);
 				} else {
 					r_cons_newline ();
 				}
@@ -27,46 +221,75 @@ R_API void r_core_task_list (RCore *core, int mode) {
 			break;
 		}
 	}
+	if (s) {
+		r_th_lock_leave (s->lock);
+	}
 	if (mode == 'j') {
 		r_cons_printf ("]\n");
 	}
 }
 
+static void task_join_break(void *user) {
+	RCoreTask *task = user;
+	r_cons_context_break (task->cons);
+}
+
+/* waits for the task to end, or for all of them when it is NULL. ^C
+ * cancels the task being waited for */
 R_API void r_core_task_join (RCore *core, RCoreTask *task) {
-	RListIter *iter;
-	if( task) {
-		r_cons_break_push (NULL, NULL);
-		r_th_wait (task->msg->th);
+	RCoreTaskSched *s = core->task_sched;
+	if (!s) {
+		return;
+	}
+	if (task) {
+		r_cons_break_push (task_join_break, task);
+	}
+	r_th_lock_enter (s->lock);
+	while (task? task_pending (task): (s->readers || s->writer || !r_list_empty (s->queue))) {
+		r_th_cond_wait (s->cond, s->lock);
+	}
+	r_th_lock_leave (s->lock);
+	if (task) {
 		r_cons_break_pop ();
-	} else {
-		r_list_foreach_prev (core->tasks, iter, task) {
-			r_th_wait (task->msg->th);
-		}
 	}
 }
 
-static int r_core_task_thread(RCore *core, RCoreTask *task) {
-	// TODO
-	return 0;
-}
-
 R_API RCoreTask *r_core_task_new (RCore *core, const char *cmd, RCoreTaskCallback cb, void *user) {
+	RCoreTask *last = r_list_get_top (core->tasks);
 	RCoreTask *task = R_NEW0 (RCoreTask);
-	if (task) {
-		task->msg = r_th_msg_new (cmd, r_core_task_thread);
-		task->id = r_list_length (core->tasks)+1;
-		task->state = 's'; // stopped
-		task->core = core;
-		task->user = user;
-		task->cb = cb;
+	if (!task) {
+		return NULL;
 	}
+	task->msg = r_th_msg_new (cmd, NULL);
+	task->cons = r_cons_context_new ();
+	if (!task->msg || !task->cons) {
+		r_core_task_free (task);
+		return NULL;
+	}
+	task->id = last? last->id + 1: 1;
+	task->state = 's'; // stopped
+	task->core = core;
+	task->user = user;
+	task->cb = cb;
 	return task;
 }
 
+/* the task must not be queued or running */
+R_API void r_core_task_free (RCoreTask *task) {
+	if (task) {
+		if (task->msg) {
+			r_th_msg_free (task->msg);
+		}
+		r_cons_context_free (task->cons);
+		free (task->out);
+		free (task);
+	}
+}
+
+/* runs the stopped tasks, or just _task, in the calling thread */
 R_API void r_core_task_run(RCore *core, RCoreTask *_task) {
 	RCoreTask *task;
 	RListIter *iter;
-	char *str;
 	r_list_foreach_prev (core->tasks, iter, task) {
 		if (_task && task != _task) {
 			continue;
@@ -75,39 +298,47 @@ R_API void r_core_task_run(RCore *core, RCoreTask *_task) {
 			continue;
 		}
 		task->state = 'r'; // running
-		str = r_core_cmd_str (core, task->msg->text);
-		eprintf ("Task %d finished width %d bytes: %s\n%s\n",
-				task->id, (int)strlen (str), task->msg->text, str);
-		task->state = 'd'; // done
-		task->msg->done = 1; // done DUP!!
-		task->msg->res = str;
+		task_exec (core, task);
 		if (task->cb) {
-			task->cb (task->user, str);
+			task->cb (task->user, NULL);
 		}
+		eprintf ("Task %d finished width %d bytes: %s\n%s\n",
+				task->id, task->outlen, task->msg->text, task->out? task->out: "");
+		task_end (task);
 	}
 }
 
+/* queues the stopped tasks, or just _task, for the workers */
 R_API void r_core_task_run_bg(RCore *core, RCoreTask *_task) {
+	RCoreTaskSched *s = task_sched (core);
 	RCoreTask *task;
 	RListIter *iter;
-	char *str;
-	r_list_foreach_prev (core->tasks, iter, task) {
-		if (_task && task != _task) {
+	if (!s) {
+		eprintf ("Cannot start the task workers\n");
+		return;
+	}
+	r_th_lock_enter (s->lock);
+	r_list_foreach (core->tasks, iter, task) {
+		if ((_task && task != _task) || task->state != 's') {
 			continue;
 		}
-		task->state = 'r'; // running
-		str = r_core_cmd_str (core, task->msg->text);
-		eprintf ("Task %d finished width %d bytes: %s\n%s\n",
-				task->id, (int)strlen (str), task->msg->text, str);
-		task->state = 'd'; // done
-		task->msg->done = 1; // done DUP!!
-		task->msg->res = str;
+		if (task->readonly && !task_reader (task->msg->text)) {
+			task->readonly = false;
+		}
+		if (task->readonly && core->bin->cur && core->bin->cur->o) {
+			// the readers demangle names, which guesses the language
+			r_bin_object_load_items (core->bin->cur, core->bin->cur->o, R_BIN_REQ_LANG);
+		}
+		task->state = 'q'; // queued
+		r_list_append (s->queue, task);
 	}
+	r_th_cond_signal_all (s->cond);
+	r_th_lock_leave (s->lock);
 }
 
 R_API RCoreTask *r_core_task_add (RCore *core, RCoreTask *task) {
 	//r_th_pipe_push (core->pipe, task->cb, task);
-	if (core->tasks) {
+	if (core->tasks && task) {
 		r_list_append (core->tasks, task);
 		return task;
 	}
@@ -115,30 +346,73 @@ R_API RCoreTask *r_core_task_add (RCore *core, RCoreTask *task) {
 }
 
 R_API void r_core_task_add_bg (RCore *core, RCoreTask *task) {
-	//r_th_pipe_push (core->pipe, task->cb, task);
-	r_list_append (core->tasks, task);
+	if (r_core_task_add (core, task)) {
+		r_core_task_run_bg (core, task);
+	}
+}
+
+/* cancels the task: it won't start if it was queued, and the command
+ * it runs sees r_cons_is_breaked otherwise */
+R_API void r_core_task_break (RCore *core, RCoreTask *task) {
+	RCoreTaskSched *s = core->task_sched;
+	if (s) {
+		r_th_lock_enter (s->lock);
+	}
+	r_cons_context_break (task->cons);
+	if (s && task->state == 'q') {
+		r_list_delete_data (s->queue, task);
+		task_end (task);
+		r_th_cond_signal_all (s->cond);
+	}
+	if (s) {
+		r_th_lock_leave (s->lock);
+	}
+}
+
+/* what the task printed so far */
+R_API char *r_core_task_output (RCore *core, RCoreTask *task) {
+	RCoreTaskSched *s = core->task_sched;
+	char *out;
+	if (s) {
+		r_th_lock_enter (s->lock);
+	}
+	out = strdup (task->out? task->out: "");
+	if (s) {
+		r_th_lock_leave (s->lock);
+	}
+	return out;
 }
 
 R_API int r_core_task_cat (RCore *core, int id) {
 	RCoreTask *task = r_core_task_get (core, id);
+	if (!task) {
+		return false;
+	}
+	r_core_task_join (core, task);
 	r_cons_println (task->msg->res);
 	r_core_task_del (core, id);
 	return true;
 }
 
+static void task_del(RCore *core, RCoreTask *task) {
+	if (task_pending (task)) {
+		r_core_task_break (core, task);
+		r_core_task_join (core, task);
+	}
+	r_list_delete_data (core->tasks, task);
+}
+
 R_API int r_core_task_del (RCore *core, int id) {
 	RCoreTask *task;
-	RListIter *iter;
 	if (id == -1) {
-		r_list_free (core->tasks);
-		core->tasks = r_list_new ();
+		while ((task = r_list_get_top (core->tasks))) {
+			task_del (core, task);
+		}
 		return true;
 	}
-	r_list_foreach (core->tasks, iter, task) {
-		if (task->id == id) {
-			r_list_delete (core->tasks, iter);
-			return true;
-		}
+	if ((task = r_core_task_get (core, id))) {
+		task_del (core, task);
+		return true;
 	}
 	return false;
 }
@@ -153,3 +427,28 @@ R_API RCoreTask *r_core_task_get (RCore *core, int id) {
 	}
 	return NULL;
 }
+
+/* cancels what did not end yet and stops the workers */
+R_API void r_core_task_fini (RCore *core) {
+	RCoreTaskSched *s = core->task_sched;
+	RListIter *iter;
+	RCoreTask *task;
+	if (!s) {
+		return;
+	}
+	r_list_foreach (core->tasks, iter, task) {
+		if (task_pending (task)) {
+			r_core_task_break (core, task);
+		}
+	}
+	r_th_lock_enter (s->lock);
+	s->quit = true;
+	r_th_cond_signal_all (s->cond);
+	r_th_lock_leave (s->lock);
+	r_th_pool_free (s->pool);
+	core->task_sched = NULL;
+	r_th_cond_free (s->cond);
+	r_th_lock_free (s->lock);
+	r_list_free (s->queue);
+	free (s);
+}
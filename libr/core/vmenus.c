@@ -1434,10 +1434,11 @@ static void config_visual_hit(RCore *core, const char *name, int editor) {
 	if (node->flags & CN_BOOL) {
 		r_config_set_i (core->config, name, node->i_value? 0:1);
 	} else {
-// XXX: must use config_set () to run callbacks!
 		if (editor) {
 			char * buf = r_core_editor (core, NULL, node->value);
-			node->value = r_str_dup (node->value, buf);
+			if (buf) {
+				r_config_set (core->config, name, buf);
+			}
 			free (buf);
 		} else {
 			// FGETS AND SO
@@ -119,6 +119,52 @@ static int r_debug_bp_hit(RDebug *dbg, RRegItem *pc_ri, ut64 pc, RBreakpointItem
 	return true;
 }
 
+/* trace-only breakpoints log the hit and step over their place with
+ * only themselves removed, the process goes on without the recoil.
+ * returns the reason of that step, or none for the other breakpoints */
+static int r_debug_bp_tracelog(RDebug *dbg, RRegItem *pc_ri, ut64 pc) {
+	RBreakpoint *bp = dbg->bp;
+	RBreakpointItem *b;
+	int reason;
+
+	if (!bp->tracelog || dbg->swstep || dbg->recoil_mode != R_DBG_RECOIL_NONE) {
+		return R_DEBUG_REASON_NONE;
+	}
+# if !__mips__
+	pc -= dbg->bpsize;
+# endif
+	b = r_bp_get_at (bp, pc);
+	if (!b || !b->traceonly || !b->enabled || b->hw || !b->obytes) {
+		return R_DEBUG_REASON_NONE;
+	}
+	if (!r_bp_tracelog_add (bp, b->addr)) {
+		eprintf ("Trace log is full\n");
+		return R_DEBUG_REASON_NONE;
+	}
+	b->hits++;
+	if (!r_reg_set_value (dbg->reg, pc_ri, b->addr) ||
+	    !r_debug_reg_sync (dbg, R_REG_TYPE_GPR, true)) {
+		return R_DEBUG_REASON_ERROR;
+	}
+	r_bp_restore_one (bp, b, false);
+	if (!dbg->h->step (dbg)) {
+		return R_DEBUG_REASON_ERROR;
+	}
+	reason = dbg->h->wait (dbg, dbg->pid);
+	if (reason == R_DEBUG_REASON_DEAD) {
+		return reason;
+	}
+	r_bp_restore_one (bp, b, true);
+	if (!r_debug_reg_sync (dbg, R_REG_TYPE_GPR, false)) {
+		return R_DEBUG_REASON_ERROR;
+	}
+	if (reason == R_DEBUG_REASON_BREAKPOINT || reason == R_DEBUG_REASON_STEP) {
+		dbg->reason.bp_addr = 0;
+		return R_DEBUG_REASON_TRACELOG;
+	}
+	return reason;
+}
+
 /* enable all software breakpoints */
 static int r_debug_bps_enable(RDebug *dbg) {
 	/* restore all sw breakpoints. we are about to step/continue so these need
@@ -303,6 +349,7 @@ R_API RDebug *r_debug_new(int hard) {
 	dbg->anal = NULL;
 	dbg->snaps = r_list_newf (r_debug_snap_free);
 	dbg->sessions = r_list_newf (r_debug_session_free);
+	dbg->pagestore = r_debug_pagestore_new ();
 	dbg->pid = -1;
 	dbg->bpsize = 1;
 	dbg->tid = -1;
@@ -347,6 +394,8 @@ R_API RDebug *r_debug_free(RDebug *dbg) {
 		//r_reg_free(&dbg->reg);
 		r_list_free (dbg->snaps);
 		r_list_free (dbg->sessions);
+		r_debug_pagestore_free (dbg->pagestore);
+		r_debug_record_free (dbg->record);
 		r_list_free (dbg->maps);
 		r_list_free (dbg->maps_user);
 		r_list_free (dbg->threads);
@@ -551,6 +600,7 @@ R_API const char *r_debug_reason_to_string(int type) {
 	case R_DEBUG_REASON_INT: return "interrupt";
 	case R_DEBUG_REASON_FPU: return "fpu";
 	case R_DEBUG_REASON_STEP: return "step";
+	case R_DEBUG_REASON_TRACELOG: return "tracelog";
 	}
 	return "unhandled";
 }
@@ -605,6 +655,19 @@ R_API RDebugReasonType r_debug_wait(RDebug *dbg, RBreakpointItem **bp) {
 			return R_DEBUG_REASON_ERROR;
 		}
 
+		if (reason == R_DEBUG_REASON_BREAKPOINT) {
+			RRegItem *pc_ri = r_reg_get (dbg->reg, dbg->reg->name[R_REG_NAME_PC], -1);
+			if (pc_ri) {
+				int r = r_debug_bp_tracelog (dbg, pc_ri, r_reg_get_value (dbg->reg, pc_ri));
+				if (r == R_DEBUG_REASON_DEAD || r == R_DEBUG_REASON_ERROR) {
+					return r;
+				}
+				if (r != R_DEBUG_REASON_NONE) {
+					reason = r;
+				}
+			}
+		}
+
 		bool libs_bp = (dbg->glob_libs || dbg->glob_unlibs) ? true : false;
 		/* if the underlying stop reason is a breakpoint, call the handlers */
 		if (reason == R_DEBUG_REASON_BREAKPOINT || reason == R_DEBUG_REASON_STEP || 
@@ -819,15 +882,20 @@ R_API int r_debug_step(RDebug *dbg, int steps) {
 	dbg->reason.type = R_DEBUG_REASON_STEP;
 
 	for (; steps_taken < steps; steps_taken++) {
+		bool record = dbg->record && r_debug_record_begin (dbg);
 		if (dbg->swstep) {
 			ret = r_debug_step_soft (dbg);
 		} else {
 			ret = r_debug_step_hard (dbg);
 		}
 		if (!ret) {
+			r_debug_record_reset (dbg);
 			eprintf ("Stepping failed!\n");
 			return steps_taken;
 		}
+		if (record) {
+			r_debug_record_end (dbg);
+		}
 		dbg->steps++;
 		dbg->reason.type = R_DEBUG_REASON_STEP;
 	}
@@ -918,6 +986,10 @@ R_API int r_debug_step_back(RDebug *dbg) {
 	if (!dbg->anal || !dbg->reg)
 		return 0;
 
+	/* undo the recorded step */
+	if (r_debug_record_undo (dbg)) {
+		return 1;
+	}
 	end = r_debug_reg_get (dbg, dbg->reg->name[R_REG_NAME_PC]);
 	/* rollback to previous state */
 	before = r_debug_session_get (dbg, end);
@@ -954,6 +1026,7 @@ R_API int r_debug_continue_kill(RDebug *dbg, int sig) {
 #if __WINDOWS__
 	r_cons_break_push (w32_break_process, dbg);
 #endif
+	r_debug_record_reset (dbg);
 repeat:
 	if (r_debug_is_dead (dbg)) {
 		return false;
@@ -967,6 +1040,7 @@ repeat:
 			return false;
 		}
 		/* tell the inferior to go! */
+resume:
 		ret = dbg->h->cont (dbg, dbg->pid, dbg->tid, sig);
 		//XXX(jjd): why? //dbg->reason.signum = 0;
 
@@ -1022,6 +1096,12 @@ repeat:
 			goto repeat;
 		}
 
+		/* a trace-only breakpoint logged the hit and is back in place */
+		if (reason == R_DEBUG_REASON_TRACELOG) {
+			sig = 0;
+			goto resume;
+		}
+
 		/* choose the thread that was returned from the continue function */
 		// XXX(jjd): there must be a cleaner way to do this...
 		r_debug_select (dbg, dbg->pid, ret);
@@ -0,0 +1,403 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+/* memory of the trace sessions, kept page by page. Pages with the same
+ * contents are stored once and shared by every session which saw them.
+ * On linux the soft-dirty bits of /proc/pid/pagemap tell which pages
+ * were written since the last checkpoint or restore, so only those are
+ * read back from the process and compared. */
+
+#include <r_debug.h>
+#include <r_hash.h>
+#if __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define PS R_DEBUG_PAGE_SIZE
+#define PAGE_BATCH 256
+
+R_API RDebugPageStore *r_debug_pagestore_new(void) {
+	RDebugPageStore *s = R_NEW0 (RDebugPageStore);
+	if (!s) {
+		return NULL;
+	}
+	s->nbuckets = 1024;
+	s->buckets = calloc (s->nbuckets, sizeof (RDebugPage *));
+	if (!s->buckets) {
+		free (s);
+		return NULL;
+	}
+	return s;
+}
+
+R_API void r_debug_pagestore_free(RDebugPageStore *s) {
+	int i;
+	if (!s) {
+		return;
+	}
+	for (i = 0; i < s->nbuckets; i++) {
+		RDebugPage *p = s->buckets[i], *next;
+		for (; p; p = next) {
+			next = p->next;
+			free (p);
+		}
+	}
+	free (s->buckets);
+	free (s);
+}
+
+static void pagestore_grow(RDebugPageStore *s) {
+	int i, n = s->nbuckets * 2;
+	RDebugPage **b = calloc (n, sizeof (RDebugPage *));
+	if (!b) {
+		return;
+	}
+	for (i = 0; i < s->nbuckets; i++) {
+		RDebugPage *p = s->buckets[i], *next;
+		for (; p; p = next) {
+			next = p->next;
+			p->next = b[p->hash % n];
+			b[p->hash % n] = p;
+		}
+	}
+	free (s->buckets);
+	s->buckets = b;
+	s->nbuckets = n;
+}
+
+/* referenced page holding data, a new one if no page has it yet */
+R_API RDebugPage *r_debug_pagestore_get(RDebugPageStore *s, const ut8 *data) {
+	ut32 hash = r_hash_xxhash (data, PS);
+	RDebugPage *p;
+	for (p = s->buckets[hash % s->nbuckets]; p; p = p->next) {
+		if (p->hash == hash && !memcmp (p->data, data, PS)) {
+			p->refs++;
+			return p;
+		}
+	}
+	p = malloc (sizeof (RDebugPage));
+	if (!p) {
+		return NULL;
+	}
+	p->hash = hash;
+	p->refs = 1;
+	memcpy (p->data, data, PS);
+	p->next = s->buckets[hash % s->nbuckets];
+	s->buckets[hash % s->nbuckets] = p;
+	if (++s->count > s->nbuckets * 2) {
+		pagestore_grow (s);
+	}
+	return p;
+}
+
+R_API void r_debug_pagestore_unref(RDebugPageStore *s, RDebugPage *page) {
+	RDebugPage **p;
+	if (!page || --page->refs > 0) {
+		return;
+	}
+	for (p = &s->buckets[page->hash % s->nbuckets]; *p; p = &(*p)->next) {
+		if (*p == page) {
+			*p = page->next;
+			s->count--;
+			break;
+		}
+	}
+	free (page);
+}
+
+static RDebugPage *session_page(RDebugSession *session, ut64 addr) {
+	int lo = 0, hi = session->npages;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (session->pages[mid].addr < addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo < session->npages && session->pages[lo].addr == addr) {
+		return session->pages[lo].page;
+	}
+	return NULL;
+}
+
+static bool session_append(RDebugSession *session, int *size, ut64 addr, RDebugPage *page) {
+	if (session->npages == *size) {
+		int n = *size? *size * 2: 256;
+		RDebugPageRef *pages = realloc (session->pages, n * sizeof (RDebugPageRef));
+		if (!pages) {
+			return false;
+		}
+		session->pages = pages;
+		*size = n;
+	}
+	session->pages[session->npages].addr = addr;
+	session->pages[session->npages].page = page;
+	session->npages++;
+	return true;
+}
+
+static int ref_cmp(const void *a, const void *b) {
+	const RDebugPageRef *x = a, *y = b;
+	return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+#if __linux__
+#define PM_SOFT_DIRTY (1ULL << 55)
+#define PM_SWAP (1ULL << 62)
+#define PM_PRESENT (1ULL << 63)
+
+static bool is_native(RDebug *dbg) {
+	return dbg->pid > 0 && dbg->h && dbg->h->name && !strcmp (dbg->h->name, "native");
+}
+
+static int pagemap_open(RDebug *dbg) {
+	char path[64];
+	if (!is_native (dbg) || sysconf (_SC_PAGESIZE) < PS) {
+		return -1;
+	}
+	snprintf (path, sizeof (path), "/proc/%d/pagemap", dbg->pid);
+	return open (path, O_RDONLY);
+}
+
+/* a page is clean when it is mapped and was not written since the
+ * soft-dirty bits were cleared. dirty tells if any mapped one was */
+static bool pagemap_clean(int fd, ut64 addr, int n, bool *clean, bool *dirty) {
+	ut64 psize = sysconf (_SC_PAGESIZE);
+	ut64 first = addr / psize;
+	ut64 count = (addr + (ut64)n * PS - 1) / psize - first + 1;
+	ut64 *ents = malloc (count * sizeof (ut64));
+	int i;
+	if (!ents) {
+		return false;
+	}
+	if (pread (fd, ents, count * sizeof (ut64), first * sizeof (ut64)) != count * sizeof (ut64)) {
+		free (ents);
+		return false;
+	}
+	for (i = 0; i < n; i++) {
+		ut64 e = ents[(addr + (ut64)i * PS) / psize - first];
+		bool mapped = e & (PM_PRESENT | PM_SWAP);
+		clean[i] = mapped && !(e & PM_SOFT_DIRTY);
+		if (mapped && (e & PM_SOFT_DIRTY)) {
+			*dirty = true;
+		}
+	}
+	free (ents);
+	return true;
+}
+
+static bool clear_refs(RDebug *dbg) {
+	char path[64];
+	int fd;
+	bool ret;
+	if (!is_native (dbg)) {
+		return false;
+	}
+	snprintf (path, sizeof (path), "/proc/%d/clear_refs", dbg->pid);
+	fd = open (path, O_WRONLY);
+	if (fd == -1) {
+		return false;
+	}
+	ret = write (fd, "4", 1) == 1;
+	close (fd);
+	return ret;
+}
+#else
+static int pagemap_open(RDebug *dbg) {
+	return -1;
+}
+
+static bool pagemap_clean(int fd, ut64 addr, int n, bool *clean, bool *dirty) {
+	return false;
+}
+
+static bool clear_refs(RDebug *dbg) {
+	return false;
+}
+#endif
+
+static void pagemap_close(int fd) {
+#if __linux__
+	if (fd != -1) {
+		close (fd);
+	}
+#endif
+}
+
+static void read_pages(RDebug *dbg, RIOVec *vec, int n) {
+	int i;
+	if (n > 0 && dbg->iob.read_vec) {
+		dbg->iob.read_vec (dbg->iob.io, vec, n);
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		dbg->iob.read_at (dbg->iob.io, vec[i].addr, vec[i].buf, vec[i].len);
+	}
+}
+
+/* session the memory matches in every page not written since then */
+static RDebugSession *synced_session(RDebug *dbg, int fd) {
+	RDebugPageStore *s = dbg->pagestore;
+	if (fd != -1 && s->softdirty && s->synced && s->pid == dbg->pid) {
+		return s->synced;
+	}
+	return NULL;
+}
+
+static void sync_session(RDebug *dbg, RDebugSession *session) {
+	RDebugPageStore *s = dbg->pagestore;
+	s->synced = NULL;
+	if (s->softdirty && clear_refs (dbg)) {
+		s->synced = session;
+		s->pid = dbg->pid;
+	}
+}
+
+/* saves the pages of the maps with perms in session. The pages not
+ * written since the last sync are taken from the synced session, the
+ * others are read and shared with the store when already in it */
+R_API bool r_debug_pagestore_capture(RDebug *dbg, RDebugSession *session, int perms) {
+	RDebugPageStore *s = dbg->pagestore;
+	RDebugSession *base;
+	RDebugMap *map;
+	RListIter *iter;
+	bool clean[PAGE_BATCH], dirty = false;
+	RIOVec vec[PAGE_BATCH];
+	bool ret = true;
+	int size = 0, fd;
+	ut8 *buf;
+
+	if (!s || !(buf = malloc (PAGE_BATCH * PS))) {
+		return false;
+	}
+	session->store = s;
+	fd = pagemap_open (dbg);
+	base = synced_session (dbg, fd);
+	r_debug_map_sync (dbg);
+	r_list_foreach (dbg->maps, iter, map) {
+		ut64 addr, to = map->addr_end - (map->addr_end - map->addr) % PS;
+		if (perms && (map->perm & perms) != perms) {
+			continue;
+		}
+		for (addr = map->addr; ret && addr < to; ) {
+			RDebugPage *old[PAGE_BATCH];
+			int i, j, nvec = 0, n = R_MIN ((to - addr) / PS, PAGE_BATCH);
+			if (fd == -1 || !pagemap_clean (fd, addr, n, clean, &dirty)) {
+				memset (clean, 0, sizeof (clean));
+			}
+			for (i = 0; i < n; i++) {
+				old[i] = base? session_page (base, addr + (ut64)i * PS): NULL;
+			}
+			/* runs of pages to read, in one go */
+			for (i = 0; i < n; i = j) {
+				if (old[i] && clean[i]) {
+					j = i + 1;
+					continue;
+				}
+				for (j = i + 1; j < n && !(old[j] && clean[j]); j++) {
+					;
+				}
+				vec[nvec].addr = addr + (ut64)i * PS;
+				vec[nvec].buf = buf + (ut64)i * PS;
+				vec[nvec].len = (j - i) * PS;
+				nvec++;
+			}
+			read_pages (dbg, vec, nvec);
+			for (i = 0; ret && i < n; i++) {
+				const ut8 *data = buf + (ut64)i * PS;
+				RDebugPage *p = old[i];
+				if (p && (clean[i] || !memcmp (p->data, data, PS))) {
+					p->refs++;
+				} else {
+					p = r_debug_pagestore_get (s, data);
+					if (p && p->refs == 1) {
+						session->fresh++;
+					}
+				}
+				ret = p && session_append (session, &size, addr + (ut64)i * PS, p);
+			}
+			addr += (ut64)n * PS;
+		}
+	}
+	free (buf);
+	pagemap_close (fd);
+	if (!ret) {
+		return false;
+	}
+	qsort (session->pages, session->npages, sizeof (RDebugPageRef), ref_cmp);
+	if (dirty) {
+		s->softdirty = true;
+	}
+	sync_session (dbg, session);
+	return true;
+}
+
+static void write_run(RDebug *dbg, ut64 addr, const ut8 *buf, int len) {
+	if (len > 0) {
+		dbg->iob.write_at (dbg->iob.io, addr, buf, len);
+	}
+}
+
+/* writes back the pages of session which differ from the memory */
+R_API bool r_debug_pagestore_restore(RDebug *dbg, RDebugSession *session) {
+	RDebugSession *base;
+	bool clean[PAGE_BATCH], synced[PAGE_BATCH], dirty = false;
+	RIOVec vec[PAGE_BATCH];
+	int i, j, k, n, w, nvec, fd;
+	ut8 *buf, *out;
+
+	if (!dbg->pagestore || !(buf = malloc (2 * PAGE_BATCH * PS))) {
+		return false;
+	}
+	out = buf + PAGE_BATCH * PS;
+	fd = pagemap_open (dbg);
+	base = synced_session (dbg, fd);
+	for (i = 0; i < session->npages; i += n) {
+		RDebugPageRef *run = session->pages + i;
+		ut64 addr = run->addr;
+		/* contiguous pages */
+		for (n = 1; i + n < session->npages && n < PAGE_BATCH; n++) {
+			if (run[n].addr != addr + (ut64)n * PS) {
+				break;
+			}
+		}
+		if (!base || !pagemap_clean (fd, addr, n, clean, &dirty)) {
+			memset (clean, 0, sizeof (clean));
+		}
+		for (j = 0; j < n; j++) {
+			synced[j] = clean[j] && session_page (base, run[j].addr) == run[j].page;
+		}
+		/* runs of pages to read, in one go */
+		for (j = 0, nvec = 0; j < n; j = k) {
+			if (synced[j]) {
+				k = j + 1;
+				continue;
+			}
+			for (k = j + 1; k < n && !synced[k]; k++) {
+				;
+			}
+			vec[nvec].addr = run[j].addr;
+			vec[nvec].buf = buf + (ut64)j * PS;
+			vec[nvec].len = (k - j) * PS;
+			nvec++;
+		}
+		read_pages (dbg, vec, nvec);
+		/* coalesce the consecutive pages which differ */
+		for (j = 0, w = 0; j < n; j++) {
+			const ut8 *data = run[j].page->data;
+			if (!synced[j] && memcmp (buf + (ut64)j * PS, data, PS)) {
+				memcpy (out + (ut64)w * PS, data, PS);
+				w++;
+			} else {
+				write_run (dbg, run[j].addr - (ut64)w * PS, out, w * PS);
+				w = 0;
+			}
+		}
+		write_run (dbg, run[n - 1].addr + PS - (ut64)w * PS, out, w * PS);
+	}
+	free (buf);
+	pagemap_close (fd);
+	sync_session (dbg, session);
+	return true;
+}
@@ -0,0 +1,352 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+/* undo log of the steps. With dbg.record set, every step saves the
+ * register bytes it changes and the old contents of the memory it
+ * writes, found by evaluating the esil of the instruction on the
+ * registers before stepping. dsb and dcb undo the steps from the log
+ * instead of re-executing from the last session. Steps which can not
+ * be recorded (syscalls, no esil) and continuing forget the log. */
+
+#include <r_debug.h>
+
+#define REC_REG 'r'
+#define REC_MEM 'm'
+#define REC_MAXLEN (1024 * 1024)
+
+typedef struct r_debug_record_step_t {
+	ut64 pc; // where it ended
+	int len;
+	ut8 data[]; // REC_REG and REC_MEM records
+} RDebugRecordStep;
+
+R_API RDebugRecord *r_debug_record_new(int size) {
+	RDebugRecord *r = R_NEW0 (RDebugRecord);
+	if (!r) {
+		return NULL;
+	}
+	r->size = size;
+	r->steps = calloc (size, sizeof (RDebugRecordStep *));
+	if (!r->steps) {
+		free (r);
+		return NULL;
+	}
+	return r;
+}
+
+static void record_clear(RDebugRecord *r) {
+	int i;
+	for (i = 0; i < r->size; i++) {
+		R_FREE (r->steps[i]);
+	}
+	r->head = r->count = 0;
+}
+
+R_API void r_debug_record_free(RDebugRecord *r) {
+	int i;
+	if (!r) {
+		return;
+	}
+	record_clear (r);
+	for (i = 0; i < R_REG_TYPE_LAST; i++) {
+		free (r->regs[i]);
+	}
+	r_anal_esil_free (r->esil);
+	free (r->steps);
+	free (r->buf);
+	free (r);
+}
+
+/* keeps the last size steps, 0 stops recording */
+R_API void r_debug_record_set(RDebug *dbg, int size) {
+	if (dbg->record && dbg->record->size == size) {
+		return;
+	}
+	r_debug_record_free (dbg->record);
+	dbg->record = (size > 0)? r_debug_record_new (size): NULL;
+}
+
+/* the state is not the one the log undoes to anymore */
+R_API void r_debug_record_reset(RDebug *dbg) {
+	if (dbg && dbg->record) {
+		record_clear (dbg->record);
+	}
+}
+
+static bool record_put(RDebugRecord *r, const ut8 *data, int len) {
+	if (r->len + len > r->cap) {
+		int cap = R_MAX (r->cap * 2, r->len + len + 256);
+		ut8 *buf;
+		if (cap > REC_MAXLEN) {
+			return false;
+		}
+		buf = realloc (r->buf, cap);
+		if (!buf) {
+			return false;
+		}
+		r->buf = buf;
+		r->cap = cap;
+	}
+	memcpy (r->buf + r->len, data, len);
+	r->len += len;
+	return true;
+}
+
+static bool record_change(RDebugRecord *r, ut8 kind, ut64 at, const ut8 *old, ut32 len) {
+	ut8 hdr[13];
+	hdr[0] = kind;
+	r_write_le64 (hdr + 1, at);
+	r_write_le32 (hdr + 9, len);
+	return record_put (r, hdr, sizeof (hdr)) && record_put (r, old, len);
+}
+
+/* the esil of the step runs on dbg->reg, its memory writes are only
+ * recorded along with the bytes they would overwrite */
+static int rec_reg_read(RAnalEsil *esil, const char *name, ut64 *res, int *size) {
+	RDebug *dbg = esil->user;
+	RRegItem *ri = r_reg_get (dbg->reg, name, -1);
+	if (!ri) {
+		return 0;
+	}
+	*res = r_reg_get_value (dbg->reg, ri);
+	if (size) {
+		*size = ri->size;
+	}
+	return 1;
+}
+
+static int rec_reg_write(RAnalEsil *esil, const char *name, ut64 *val) {
+	RDebug *dbg = esil->user;
+	RRegItem *ri = r_reg_get (dbg->reg, name, -1);
+	if (!ri) {
+		return 0;
+	}
+	r_reg_set_value (dbg->reg, ri, *val);
+	return 1;
+}
+
+static int rec_mem_write(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len) {
+	RDebug *dbg = esil->user;
+	RDebugRecord *r = dbg->record;
+	ut8 *old = malloc (R_MAX (len, 1));
+	if (!old) {
+		esil->trap = R_ANAL_TRAP_WRITE_ERR;
+		return len;
+	}
+	dbg->iob.read_at (dbg->iob.io, addr, old, len);
+	if (!record_change (r, REC_MEM, addr, old, len)) {
+		esil->trap = R_ANAL_TRAP_WRITE_ERR;
+	}
+	free (old);
+	return len;
+}
+
+static bool record_esil(RDebug *dbg, const char *expr) {
+	RDebugRecord *r = dbg->record;
+	RAnalEsil *esil = r->esil;
+	int ret;
+	if (!esil) {
+		esil = r->esil = r_anal_esil_new (32, 0);
+		if (!esil) {
+			return false;
+		}
+		r_anal_esil_setup (esil, dbg->anal, 0, 0, 0);
+	}
+	esil->user = dbg;
+	esil->trap = 0;
+	esil->cb.hook_reg_read = rec_reg_read;
+	esil->cb.hook_reg_write = rec_reg_write;
+	esil->cb.hook_mem_write = rec_mem_write;
+	ret = r_anal_esil_parse (esil, expr);
+	r_anal_esil_stack_free (esil);
+	/* BREAK stops the parse with 0 too, anything else that stops it
+	 * early (errors, TODO words, traps) left writes uncaptured */
+	if (ret < 0 || (!ret && esil->parse_stop != 1)) {
+		return false;
+	}
+	return !esil->trap;
+}
+
+static RRegArena *record_arena(RDebug *dbg, int type) {
+	RRegArena *a = dbg->reg->regset[type].arena;
+	int i;
+	if (!a || !a->bytes) {
+		return NULL;
+	}
+	/* some sets share the arena */
+	for (i = 0; i < type; i++) {
+		if (dbg->reg->regset[i].arena == a) {
+			return NULL;
+		}
+	}
+	return a;
+}
+
+/* saves what the next step needs to be undone */
+R_API bool r_debug_record_begin(RDebug *dbg) {
+	RDebugRecord *r = dbg->record;
+	const char *pcname;
+	RAnalOp op = {0};
+	ut8 code[32];
+	bool ok = false;
+	ut64 pc;
+	int i;
+
+	r->len = 0;
+	r->pending = false;
+	if (!dbg->anal || !dbg->reg) {
+		r_debug_record_reset (dbg);
+		return false;
+	}
+	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, false);
+	for (i = 0; i < R_REG_TYPE_LAST; i++) {
+		RRegArena *a = record_arena (dbg, i);
+		if (a) {
+			ut8 *regs = realloc (r->regs[i], a->size);
+			if (!regs) {
+				r_debug_record_reset (dbg);
+				return false;
+			}
+			memcpy (regs, a->bytes, a->size);
+			r->regs[i] = regs;
+			r->regsize[i] = a->size;
+		} else {
+			r->regsize[i] = 0;
+		}
+	}
+	pcname = dbg->reg->name[R_REG_NAME_PC];
+	pc = r_reg_getv (dbg->reg, pcname);
+	if (dbg->iob.read_at (dbg->iob.io, pc, code, sizeof (code)) > 0 &&
+	    r_anal_op (dbg->anal, &op, pc, code, sizeof (code)) > 0) {
+		const char *expr = r_strbuf_get (&op.esil);
+		switch (op.type & R_ANAL_OP_TYPE_MASK) {
+		case R_ANAL_OP_TYPE_SWI:
+		case R_ANAL_OP_TYPE_TRAP:
+			// the kernel may write anywhere
+			break;
+		case R_ANAL_OP_TYPE_NOP:
+			ok = true;
+			break;
+		case R_ANAL_OP_TYPE_STORE:
+		case R_ANAL_OP_TYPE_PUSH:
+		case R_ANAL_OP_TYPE_UPUSH:
+		case R_ANAL_OP_TYPE_CALL:
+		case R_ANAL_OP_TYPE_UCALL:
+			// an esil without the write is missing it
+			ok = expr && *expr && record_esil (dbg, expr) && r->len > 0;
+			break;
+		default:
+			ok = expr && *expr && record_esil (dbg, expr);
+			break;
+		}
+	}
+	r_anal_op_fini (&op);
+	/* the esil changed the registers */
+	for (i = 0; i < R_REG_TYPE_LAST; i++) {
+		if (r->regsize[i]) {
+			memcpy (dbg->reg->regset[i].arena->bytes, r->regs[i], r->regsize[i]);
+		}
+	}
+	if (!ok) {
+		r_debug_record_reset (dbg);
+		return false;
+	}
+	r->pending = true;
+	return true;
+}
+
+/* logs the step done since r_debug_record_begin */
+R_API void r_debug_record_end(RDebug *dbg) {
+	RDebugRecord *r = dbg->record;
+	RDebugRecordStep *step;
+	int i, j, k;
+	if (!r || !r->pending) {
+		return;
+	}
+	r->pending = false;
+	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, false);
+	for (i = 0; i < R_REG_TYPE_LAST; i++) {
+		RRegArena *a = r->regsize[i]? dbg->reg->regset[i].arena: NULL;
+		int size = a? R_MIN (a->size, r->regsize[i]): 0;
+		/* runs of changed bytes */
+		for (j = 0; j < size; j = k) {
+			if (a->bytes[j] == r->regs[i][j]) {
+				k = j + 1;
+				continue;
+			}
+			for (k = j + 1; k < size && a->bytes[k] != r->regs[i][k]; k++) {
+				;
+			}
+			if (!record_change (r, REC_REG, ((ut64)i << 32) | j, r->regs[i] + j, k - j)) {
+				r_debug_record_reset (dbg);
+				return;
+			}
+		}
+	}
+	step = malloc (sizeof (RDebugRecordStep) + r->len);
+	if (!step) {
+		r_debug_record_reset (dbg);
+		return;
+	}
+	step->pc = r_reg_getv (dbg->reg, dbg->reg->name[R_REG_NAME_PC]);
+	step->len = r->len;
+	memcpy (step->data, r->buf, r->len);
+	if (r->count == r->size) {
+		free (r->steps[r->head]);
+	} else {
+		r->count++;
+	}
+	r->steps[r->head] = step;
+	r->head = (r->head + 1) % r->size;
+}
+
+/* puts back the registers and memory the last step changed */
+R_API bool r_debug_record_undo(RDebug *dbg) {
+	RDebugRecord *r = dbg->record;
+	RDebugRecordStep *step;
+	int idx, off;
+	if (!r || !r->count) {
+		return false;
+	}
+	idx = (r->head + r->size - 1) % r->size;
+	step = r->steps[idx];
+	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, false);
+	if (r_reg_getv (dbg->reg, dbg->reg->name[R_REG_NAME_PC]) != step->pc) {
+		// moved without recording
+		r_debug_record_reset (dbg);
+		return false;
+	}
+	for (off = 0; off + 13 <= step->len; ) {
+		const ut8 *rec = step->data + off;
+		ut64 at = r_read_le64 (rec + 1);
+		ut32 len = r_read_le32 (rec + 9);
+		if (rec[0] == REC_MEM) {
+			dbg->iob.write_at (dbg->iob.io, at, rec + 13, len);
+		} else {
+			RRegArena *a = dbg->reg->regset[at >> 32].arena;
+			ut32 pos = at & UT32_MAX;
+			if (a && a->bytes && pos + len <= a->size) {
+				memcpy (a->bytes + pos, rec + 13, len);
+			}
+		}
+		off += 13 + len;
+	}
+	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, true);
+	free (step);
+	r->steps[idx] = NULL;
+	r->head = idx;
+	r->count--;
+	return true;
+}
+
+/* undoes the recorded steps until reaching a breakpoint */
+R_API int r_debug_continue_back(RDebug *dbg) {
+	int steps = 0;
+	while (r_debug_record_undo (dbg)) {
+		ut64 pc = r_reg_getv (dbg->reg, dbg->reg->name[R_REG_NAME_PC]);
+		steps++;
+		if (r_bp_get_at (dbg->bp, pc)) {
+			break;
+		}
+	}
+	return steps;
+}
@@ -2,7 +2,21 @@
 #include <r_debug.h>
 
 R_API void r_debug_session_free(void *p) {
-	free (p);
+	RDebugSession *session = (RDebugSession *)p;
+	int i;
+	if (!session) {
+		return;
+	}
+	if (session->store) {
+		for (i = 0; i < session->npages; i++) {
+			r_debug_pagestore_unref (session->store, session->pages[i].page);
+		}
+		if (session->store->synced == session) {
+			session->store->synced = NULL;
+		}
+	}
+	free (session->pages);
+	free (session);
 }
 
 static int r_debug_session_lastid(RDebug *dbg) {
@@ -10,21 +24,24 @@ static int r_debug_session_lastid(RDebug *dbg) {
 }
 
 R_API void r_debug_session_list(RDebug *dbg) {
-	const char *comment;
-	ut32 count = 0;
-	RListIter *iterse, *itersn;
-	RDebugSnap *snap;
+	ut32 count;
+	RListIter *iter;
 	RDebugSession *session;
-	r_list_foreach (dbg->sessions, iterse, session) {
+	int i, j;
+	r_list_foreach (dbg->sessions, iter, session) {
 		count = 0;
-		dbg->cb_printf ("session:%2d\tat:0x%08"PFMT64x "\n", session->key.id, session->key.addr);
-		r_list_foreach (session->memlist, itersn, snap) {
-			comment = "";
-			if (snap->comment && *snap->comment) {
-				comment = snap->comment;
+		dbg->cb_printf ("session:%2d\tat:0x%08"PFMT64x "\tpages: %d new: %d\n",
+			session->key.id, session->key.addr, session->npages, session->fresh);
+		/* contiguous ranges of saved pages */
+		for (i = 0; i < session->npages; i = j) {
+			ut64 addr = session->pages[i].addr;
+			for (j = i + 1; j < session->npages; j++) {
+				if (session->pages[j].addr != addr + (ut64)(j - i) * R_DEBUG_PAGE_SIZE) {
+					break;
+				}
 			}
-			dbg->cb_printf ("%d 0x%08"PFMT64x " - 0x%08"PFMT64x " size: %d crc: %x  --  %s\n",
-				count, snap->addr, snap->addr_end, snap->size, snap->crc, comment);
+			dbg->cb_printf ("%d 0x%08"PFMT64x " - 0x%08"PFMT64x " size: %d\n", count, addr,
+				addr + (ut64)(j - i) * R_DEBUG_PAGE_SIZE, (j - i) * R_DEBUG_PAGE_SIZE);
 			count++;
 		}
 	}
@@ -32,14 +49,17 @@ R_API void r_debug_session_list(RDebug *dbg) {
 
 R_API bool r_debug_session_add(RDebug *dbg) {
 	RDebugSession *session;
-	RDebugSnap *snap;
-	RListIter *iter, *start;
 	ut64 addr;
 	int i;
 	session = R_NEW0 (RDebugSession);
 	if (!session) {
 		return false;
 	}
+	/* save the memory pages, sharing the unchanged ones */
+	if (!r_debug_pagestore_capture (dbg, session, R_IO_RW)) {
+		r_debug_session_free (session);
+		return false;
+	}
 
 	addr = r_debug_reg_get (dbg, dbg->reg->name[R_REG_NAME_PC]);
 	session->key = (RDebugKey) {
@@ -53,28 +73,13 @@ R_API bool r_debug_session_add(RDebug *dbg) {
 	}
 	r_reg_arena_push (dbg->reg);
 
-	/* save memory snapshots */
-	session->memlist = r_list_newf (r_debug_snap_free);
-	start = r_list_tail (dbg->snaps);
-	r_debug_snap_all (dbg, R_IO_RW);
-	if (!start) {
-		start = r_list_head (dbg->snaps);
-	} else {
-		start = start->n;
-	}
-	// XXX
-	for (iter = start; iter && (snap = iter->data); iter = iter->n) {
-		r_list_append (session->memlist, snap);
-	}
-
 	r_list_append (dbg->sessions, session);
 	return true;
 }
 
 R_API void r_debug_session_set(RDebug *dbg, RDebugSession *session) {
-	RDebugSnap *snap;
 	RRegArena *arena;
-	RListIter *iter, *iterr;
+	RListIter *iterr;
 	int i;
 	/* Restore all regsiter values from the stack area pointed by session */
 	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, 0);
@@ -87,10 +92,9 @@ R_API void r_debug_session_set(RDebug *dbg, RDebugSession *session) {
 	}
 	r_debug_reg_sync (dbg, R_REG_TYPE_ALL, 1);
 
-	/* Restore all memory values from memory snapshots*/
-	r_list_foreach (session->memlist, iter, snap) {
-		r_debug_snap_set (dbg, snap);
-	}
+	/* write back the pages which differ */
+	r_debug_pagestore_restore (dbg, session);
+	r_debug_record_reset (dbg);
 }
 
 R_API bool r_debug_session_set_idx(RDebug *dbg, int idx) {
@@ -106,14 +106,14 @@ R_API int r_debug_snap_set_idx (RDebug *dbg, int idx) {
 	return 1;
 }
 
-static int r_debug_snap_map (RDebug *dbg, RDebugMap *map) {
+static RDebugSnap *r_debug_snap_new (RDebug *dbg, RDebugMap *map) {
 	if (!dbg || !map || map->size < 1) {
 		eprintf ("Invalid map size\n");
-		return 0;
+		return NULL;
 	}
 	RDebugSnap *snap = R_NEW0 (RDebugSnap);
 	if (!snap) {
-		return 0;
+		return NULL;
 	}
 	snap->timestamp = sdb_now ();
 	snap->addr = map->addr;
@@ -122,25 +122,63 @@ static int r_debug_snap_map (RDebug *dbg, RDebugMap *map) {
 	snap->data = malloc (map->size);
 	if (!snap->data) {
 		free (snap);
-		return 0;
+		return NULL;
 	}
 	eprintf ("Reading %d bytes from 0x%08"PFMT64x"...\n", snap->size, snap->addr);
+	return snap;
+}
+
+static int r_debug_snap_map (RDebug *dbg, RDebugMap *map) {
+	RDebugSnap *snap = r_debug_snap_new (dbg, map);
+	if (!snap) {
+		return 0;
+	}
 	dbg->iob.read_at (dbg->iob.io, snap->addr, snap->data, snap->size);
 	snap->crc = r_hash_crc32 (snap->data, snap->size);
-
 	r_list_append (dbg->snaps, snap);
 	return 1;
 }
 
+/* the maps are read with a single batched read */
 R_API int r_debug_snap_all(RDebug *dbg, int perms) {
 	RDebugMap *map;
 	RListIter *iter;
+	RDebugSnap *snap;
+	RIOVec *vec;
+	int i, n = 0;
 	r_debug_map_sync (dbg);
+	vec = calloc (R_MAX (r_list_length (dbg->maps), 1), sizeof (RIOVec));
+	if (!vec) {
+		return 0;
+	}
 	r_list_foreach (dbg->maps, iter, map) {
 		if (!perms || (map->perm & perms) == perms) {
-			r_debug_snap_map (dbg, map);
+			snap = r_debug_snap_new (dbg, map);
+			if (snap) {
+				vec[n].addr = snap->addr;
+				vec[n].buf = snap->data;
+				vec[n].len = snap->size;
+				n++;
+				r_list_append (dbg->snaps, snap);
+			}
+		}
+	}
+	if (n > 0) {
+		if (dbg->iob.read_vec) {
+			dbg->iob.read_vec (dbg->iob.io, vec, n);
+		} else {
+			for (i = 0; i < n; i++) {
+				dbg->iob.read_at (dbg->iob.io, vec[i].addr, vec[i].buf, vec[i].len);
+			}
+		}
+		/* the new snaps are the last n */
+		iter = r_list_tail (dbg->snaps);
+		for (i = 0; i < n; i++, iter = iter->p) {
+			snap = iter->data;
+			snap->crc = r_hash_crc32 (snap->data, snap->size);
 		}
 	}
+	free (vec);
 	return 0;
 }
 
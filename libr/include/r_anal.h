@@ -33,9 +33,6 @@ R_LIB_VERSION_HEADER(r_anal);
    bb_has_ops=1 -> 600M
    bb_has_ops=0 -> 350MB
  */
-/* TODO: work in progress */
-#define USE_NEW_FCN_STORE 0
-
 // TODO: Remove this define? /cc @nibble_ds
 #define VERBOSE_ANAL if(0)
 
@@ -247,9 +244,13 @@ struct r_anal_attr_t {
 	RAnalAttr *next;
 };
 
+/* Address index of the functions in anal->fcns. bounds holds the
+ * range spanned by the entrypoint, the size and the basic blocks of
+ * every function, so overlapping and non-contiguous functions are
+ * found by checking the candidates intersecting the address. */
 typedef struct r_anal_fcn_store_t {
-	SdbHash *h;
-	RList *l;
+	RIntervalTree bounds;
+	RIntervalTree entries;
 } RAnalFcnStore;
 
 /* Stores useful function metadata */
@@ -297,6 +298,9 @@ typedef struct r_anal_type_function_t {
 #endif
 	RAnalFcnMeta meta;
 	RRangeTiny bbr;
+	RAnalFcnStore *_store; // fcnstore indexing this function
+	RIntervalNode *_bnode;
+	RIntervalNode *_enode;
 } RAnalFunction;
 
 struct r_anal_type_t {
@@ -555,14 +559,18 @@ typedef struct r_anal_switch_obj_t {
 //struct r_anal_t*
 #define RANAL_BLOCK void*
 //struct r_anal_bb_t*
+struct r_anal_ref_t;
 typedef struct r_anal_callbacks_t {
 	int (*on_fcn_new) (RANAL, void *user, RAnalFunction *fcn);
 	int (*on_fcn_delete) (RANAL , void *user, RAnalFunction *fcn);
 	int (*on_fcn_rename) (RANAL, void *user, RAnalFunction *fcn, const char *oldname);
 	int (*on_fcn_bb_new) (RANAL, void *user, RAnalFunction *fcn, RANAL_BLOCK bb);
+	/* ref is NULL when the whole xrefs store is reset */
+	int (*on_xref) (RANAL, void *user, const struct r_anal_ref_t *ref, bool add);
 } RAnalCallbacks;
 
 #define R_ANAL_ESIL_GOTO_LIMIT 4096
+#define R_ANAL_ESIL_CODE_CACHE 4096
 
 typedef struct r_anal_options_t {
 	int cjmpref;
@@ -595,7 +603,7 @@ typedef struct r_anal_t {
 	void *user;
 	ut64 gp; // global pointer. used for mips. but can be used by other arches too in the future
 	RList *fcns;
-	RListRange *fcnstore;
+	RAnalFcnStore *fcnstore;
 	RList *refs;
 	RList *vartypes;
 	RReg *reg;
@@ -605,6 +613,7 @@ typedef struct r_anal_t {
 	int diff_ops;
 	double diff_thbb;
 	double diff_thfcn;
+	int diff_jobs;
 	RIOBind iob;
 	RFlagBind flb;
 	RBinBind binb; // Set only from core when an analysis plugin is called.
@@ -620,7 +629,10 @@ typedef struct r_anal_t {
 	struct r_anal_plugin_t *cur;
 	RAnalRange *limit;
 	RList *plugins;
-	Sdb *sdb_xrefs;
+	Sdb *sdb_xrefs; // only synced on save, see xrefs.c
+	RHashTable64 *dict_refs;  // from -> targets
+	RHashTable64 *dict_xrefs; // to -> sources
+	bool xrefs_dirty;
 	Sdb *sdb_types;
 	Sdb *sdb_meta; // TODO: Future r_meta api
 	Sdb *sdb_zigns;
@@ -1003,6 +1015,7 @@ typedef struct r_anal_esil_t {
 	ut8 lastsz;	//in bits //used for signature-flag
 	/* native ops and custom ops */
 	Sdb *ops;
+	RHashTable64 *code; // compiled expressions, see r_anal_esil_parse
 	Sdb *interrupts;
 	/* deep esil parsing fills this */
 	Sdb *stats;
@@ -1059,6 +1072,7 @@ typedef struct r_anal_plugin_t {
 	char *version;
 	int bits;
 	int esil; // can do esil or not
+	int reentrant; // op() can run from several threads at once
 	int fileformat_type;
 	int custom_fn_anal;
 	int (*init)(void *user);
@@ -1140,15 +1154,13 @@ int * (r_anal_compare) (RAnalFunction , RAnalFunction );
 /*----------------------------------------------------------------------------------------------*/
 
 #ifdef R_API
-/* --------- */ /* REFACTOR */ /* ---------- */
-R_API RListRange* r_listrange_new (void);
-R_API void r_listrange_free(RListRange *s);
-R_API void r_listrange_add(RListRange *s, RAnalFunction *f);
-R_API void r_listrange_del(RListRange *s, RAnalFunction *f);
-R_API void r_listrange_resize(RListRange *s, RAnalFunction *f, int newsize);
-R_API RAnalFunction *r_listrange_find_in_range(RListRange* s, ut64 addr);
-R_API RAnalFunction *r_listrange_find_root(RListRange* s, ut64 addr);
-/* --------- */ /* REFACTOR */ /* ---------- */
+/* fcnstore.c */
+R_API RAnalFcnStore *r_anal_fcnstore_new(void);
+R_API void r_anal_fcnstore_free(RAnalFcnStore *s);
+R_API bool r_anal_fcnstore_add(RAnalFcnStore *s, RAnalFunction *f);
+R_API void r_anal_fcnstore_del(RAnalFunction *f);
+R_API void r_anal_fcnstore_update(RAnalFunction *f);
+R_API void r_anal_fcnstore_reindex(RAnalFcnStore *s, RList *fcns);
 /* type.c */
 R_API int r_anal_type_get_size (RAnal *anal, const char *type);
 R_API RAnalType *r_anal_type_new(void);
@@ -1349,8 +1361,13 @@ R_API RList* r_anal_fcn_get_refs (RAnalFunction *anal);
 R_API RList* r_anal_fcn_get_xrefs (RAnalFunction *anal);
 R_API int r_anal_xrefs_from (RAnal *anal, RList *list, const char *kind, const RAnalRefType type, ut64 addr);
 R_API int r_anal_xrefs_set (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to);
+R_API int r_anal_xrefs_set_n(RAnal *anal, const RAnalRef *refs, int count);
+R_API RAnalRef *r_anal_xrefs_dump(RAnal *anal, int *count);
+R_API int r_anal_xrefs_restore(RAnal *anal, const RAnalRef *refs, int count);
 R_API int r_anal_xrefs_deln (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to);
 R_API bool r_anal_xrefs_save(RAnal *anal, const char *prjfile);
+R_API bool r_anal_xrefs_sync(RAnal *anal);
+R_API bool r_anal_xrefs_load(RAnal *anal);
 R_API RList* r_anal_fcn_get_vars (RAnalFunction *anal);
 R_API RList* r_anal_fcn_get_bbs (RAnalFunction *anal);
 R_API RList* r_anal_get_fcns (RAnal *anal);
@@ -64,6 +64,11 @@ R_LIB_VERSION_HEADER (r_bin);
 #define R_BIN_REQ_PACKAGE     0x1000000
 #define R_BIN_REQ_HEADER   0x2000000
 #define R_BIN_REQ_LISTPLUGINS   0x4000000
+#define R_BIN_REQ_LANG     0x8000000
+/* items r_bin_object_set_items leaves for the first access, lang is
+ * there because it is guessed from the symbols */
+#define R_BIN_REQ_LAZY (R_BIN_REQ_IMPORTS | R_BIN_REQ_SYMBOLS | R_BIN_REQ_RELOCS | \
+	R_BIN_REQ_STRINGS | R_BIN_REQ_CLASSES | R_BIN_REQ_SRCLINE | R_BIN_REQ_LANG)
 
 enum {
 	R_BIN_SYM_ENTRY,
@@ -189,6 +194,7 @@ typedef struct r_bin_object_t {
 	struct r_bin_plugin_t *plugin;
 	int referenced;
 	int lang;
+	ut64 loaded; // R_BIN_REQ_LAZY items already there
 	Sdb *kv;
 	void *bin_obj; // internal pointer used by formats
 } RBinObject;
@@ -229,6 +235,7 @@ typedef struct r_bin_t {
 	int minstrlen;
 	int maxstrlen;
 	ut64 maxstrbuf;
+	int strjobs; // threads scanning the strings of big sections
 	int rawstr;
 	Sdb *sdb;
 	RIDPool *file_ids;
@@ -582,6 +589,8 @@ R_API int r_bin_select_idx(RBin *bin, const char *name, int idx);
 R_API int r_bin_select_by_ids(RBin *bin, ut32 binfile_id, ut32 binobj_id );
 R_API int r_bin_object_delete (RBin *bin, ut32 binfile_id, ut32 binobj_id);
 R_API int r_bin_object_set_items(RBinFile *binfile, RBinObject *o);
+R_API void r_bin_object_load_items(RBinFile *binfile, RBinObject *o, ut64 items);
+R_API void r_bin_prefetch(RBin *bin, ut64 items);
 R_API int r_bin_use_arch(RBin *bin, const char *arch, int bits, const char *name);
 R_API RBinFile * r_bin_file_find_by_arch_bits(RBin *bin, const char *arch, int bits, const char *name);
 R_API RBinObject * r_bin_object_find_by_arch_bits (RBinFile *binfile, const char *arch, int bits, const char *name);
@@ -600,6 +609,8 @@ R_API RBinFile * r_bin_file_find_by_name (RBin * bin, const char * name);
 R_API RBinFile * r_bin_file_find_by_name_n (RBin * bin, const char * name, int idx);
 R_API int r_bin_file_set_cur_binfile (RBin * bin, RBinFile *bf);
 R_API RBinPlugin * r_bin_file_cur_plugin (RBinFile *binfile);
+R_API RBuffer *r_bin_file_buffer(RBinFile *bf, const ut8 *bytes, ut64 sz);
+R_API void r_bin_file_set_buf(RBinFile *bf, RBuffer *buf);
 R_API void r_bin_force_plugin (RBin *bin, const char *pname);
 R_API const char *r_bin_string_type (int type);
 
@@ -50,6 +50,7 @@ typedef struct r_bp_item_t {
 	int rwx;
 	int hw;
 	int trace;
+	bool traceonly; /* logs the hits in bp->tracelog without stopping */
 	int internal; /* used for internal purposes */
 	int enabled;
 	int hits;
@@ -78,7 +79,12 @@ typedef struct r_bp_t {
 	RList *bps; // list of breakpoints
 	RBreakpointItem **bps_idx;
 	int bps_idx_count;
+	RIntervalTree *tree; // bps by address range
 	st64 delta;
+	/* hits of the trace-only breakpoints */
+	ut64 *tracelog;
+	int tracelog_size;
+	int tracelog_count;
 } RBreakpoint;
 
 enum {
@@ -117,6 +123,8 @@ R_API int r_bp_list(RBreakpoint *bp, int rad);
 R_API int r_bp_get_bytes(RBreakpoint *bp, ut8 *buf, int len, int endian, int idx);
 R_API int r_bp_set_trace(RBreakpoint *bp, ut64 addr, int set);
 R_API int r_bp_set_trace_all(RBreakpoint *bp, int set);
+R_API int r_bp_set_traceonly(RBreakpoint *bp, ut64 addr, int set);
+R_API int r_bp_set_traceonly_all(RBreakpoint *bp, int set);
 R_API RBreakpointItem *r_bp_enable(RBreakpoint *bp, ut64 addr, int set);
 R_API int r_bp_enable_all(RBreakpoint *bp, int set);
 
@@ -138,6 +146,11 @@ R_API void r_bp_restore_one(RBreakpoint *bp, RBreakpointItem *b, bool set);
 R_API int r_bp_restore(RBreakpoint *bp, bool set);
 R_API bool r_bp_restore_except(RBreakpoint *bp, bool set, ut64 addr);
 
+/* tracelog */
+R_API bool r_bp_tracelog_init(RBreakpoint *bp, int size);
+R_API bool r_bp_tracelog_add(RBreakpoint *bp, ut64 addr);
+R_API void r_bp_tracelog_list(RBreakpoint *bp, int rad);
+
 /* traptrace */
 R_API void r_bp_traptrace_free(void *ptr);
 R_API void r_bp_traptrace_enable(RBreakpoint *bp, int enable);
@@ -43,8 +43,22 @@ typedef struct r_config_t {
 	PrintfCallback cb_printf;
 	RList *nodes;
 	SdbHash *ht;
+	ut32 gen; // bumped on every change, to cache what derives from it
+	ut32 keys; // renewed when a key is removed, invalidates the handles
 } RConfig;
 
+/* a key resolved once and then read or set without hashing its name,
+ * declared with R_CONFIG_HANDLE ("asm.bits") */
+typedef struct r_config_handle_t {
+	const char *name;
+	RConfigNode *node;
+	ut32 keys;
+	ut32 gen;
+	ut64 i_value;
+} RConfigHandle;
+
+#define R_CONFIG_HANDLE(x) { x, NULL, 0, 0, 0 }
+
 typedef struct r_config_hold_num_t {
 	char *key;
 	ut64 value;
@@ -90,6 +104,12 @@ R_API void r_config_node_free(void *n);
 R_API int r_config_toggle(RConfig *cfg, const char *name);
 R_API int r_config_readonly (RConfig *cfg, const char *key);
 
+R_API RConfigNode *r_config_handle_node(RConfig *cfg, RConfigHandle *h);
+R_API ut64 r_config_handle_get_i(RConfig *cfg, RConfigHandle *h);
+R_API const char *r_config_handle_get(RConfig *cfg, RConfigHandle *h);
+R_API bool r_config_handle_set(RConfig *cfg, RConfigHandle *h, const char *value);
+R_API bool r_config_handle_set_i(RConfig *cfg, RConfigHandle *h, ut64 i);
+
 /*----------------------------------------------------------------------------------------------*/
 R_API void r_config_set_sort_column (char *column);
 /*----------------------------------------------------------------------------------------------*/
@@ -203,18 +203,29 @@ typedef struct r_cons_canvas_t {
 typedef char *(*RConsEditorCallback)(void *core, const char *file, const char *str);
 typedef int (*RConsClickCallback)(void *core, int x, int y);
 
-typedef struct r_cons_t {
+typedef void (*RConsSink)(void *user, const char *buf, int len);
+
+/* what a command prints, each thread can have its own */
+typedef struct r_cons_context_t {
 	RConsGrep grep;
 	RStack *cons_stack;
-	RStack *break_stack;
 	char *buffer;
-	//int line;
 	int buffer_len;
 	int buffer_sz;
 	char *lastline;
+	int lines;
+	bool breaked; // stops what runs in this context, the main one uses RCons.breaked
+	RConsSink sink; // gets what r_cons_flush would write
+	void *sink_user;
+	int sink_chunk; // flush every time this many bytes are printed, 0 to wait
+	int sink_sent; // bytes of the buffer the sink already got
+} RConsContext;
+
+typedef struct r_cons_t {
+	RConsContext *context; // main thread output
+	RStack *break_stack;
 	int is_html;
 	int is_interactive;
-	int lines;
 	int rows;
 	int echo; // dump to stdout in realtime
 	int fps;
@@ -422,6 +433,12 @@ R_API void r_cons_canvas_fill(RConsCanvas *c, int x, int y, int w, int h, char c
 R_API RCons *r_cons_new (void);
 R_API RCons *r_cons_singleton (void);
 R_API RCons *r_cons_free (void);
+R_API RConsContext *r_cons_context_new(void);
+R_API void r_cons_context_free(RConsContext *ctx);
+R_API void r_cons_context_load(RConsContext *ctx);
+R_API RConsContext *r_cons_context(void);
+R_API bool r_cons_context_is_main(void);
+R_API void r_cons_context_break(RConsContext *ctx);
 R_API char *r_cons_lastline (int *size);
 
 typedef void (*RConsBreak)(void *);
@@ -98,6 +98,10 @@ typedef struct r_core_asmsteps_t {
 	int cols;
 } RCoreAsmsteps;
 
+/* changes since the project snapshot was saved, see snapshot.c */
+typedef struct r_core_prj_journal_t RCorePrjJournal;
+typedef struct r_core_task_sched_t RCoreTaskSched;
+
 typedef struct r_core_t {
 	RBin *bin;
 	RConfig *config;
@@ -166,6 +170,8 @@ typedef struct r_core_t {
 	bool fixedblock;
 	char *cmdfilter;
 	bool break_loop;
+	RCorePrjJournal *prj_journal;
+	RCoreTaskSched *task_sched;
 } RCore;
 
 R_API int r_core_bind(RCore *core, RCoreBind *bnd);
@@ -423,6 +429,10 @@ R_API int r_core_project_delete(RCore *core, const char *prjfile);
 R_API int r_core_project_list(RCore *core, int mode);
 R_API bool r_core_project_save_rdb(RCore *core, const char *file, int opts);
 R_API bool r_core_project_save(RCore *core, const char *file);
+R_API bool r_core_project_snapshot_save(RCore *core, const char *file);
+R_API bool r_core_project_snapshot_load(RCore *core, const char *file);
+R_API void r_core_project_snapshot_wait(RCore *core);
+R_API void r_core_project_snapshot_fini(RCore *core);
 R_API char *r_core_project_info(RCore *core, const char *file);
 R_API char *r_core_project_notes_file (RCore *core, const char *file);
 
@@ -474,6 +484,9 @@ R_API void fcn_callconv (RCore *core, RAnalFunction *fcn);
 #define R_CORE_PRJ_ANAL_MACROS	0x0200
 #define R_CORE_PRJ_ANAL_SEEK	0x0400
 #define R_CORE_PRJ_DBG_BREAK   0x0800
+#define R_CORE_PRJ_VMARKS	0x1000
+/* the parts r_core_project_snapshot_save covers */
+#define R_CORE_PRJ_SNAPSHOT	(R_CORE_PRJ_FLAGS | R_CORE_PRJ_IO_MAPS | R_CORE_PRJ_META | R_CORE_PRJ_XREFS | R_CORE_PRJ_FCNS | R_CORE_PRJ_ANAL_HINTS | R_CORE_PRJ_ANAL_TYPES)
 #define R_CORE_PRJ_ALL		0xFFFF
 
 typedef struct r_core_bin_filter_t {
@@ -571,15 +584,24 @@ R_API void r_core_syscmd_mkdir(const char *dir);
 R_API char *cmd_syscall_dostr(RCore *core, int num);
 /* tasks */
 
+/* gets the output as it is printed, from the thread running the task,
+ * and NULL once it ends */
 typedef void (*RCoreTaskCallback)(void *user, char *out);
 
 typedef struct r_core_task_t {
 	int id;
-	char state;
+	char state; // stopped, queued, running or done
 	void *user;
 	RCore *core;
 	RThreadMsg *msg;
 	RCoreTaskCallback cb;
+	bool readonly; // can run along other readonly tasks
+	RConsContext *cons; // where it prints, breaking it cancels the task
+	char *out; // printed so far
+	int outlen;
+	int outsize;
+	ut64 started;
+	ut64 ended;
 } RCoreTask;
 
 R_API RCoreTask *r_core_task_get (RCore *core, int id);
@@ -591,6 +613,11 @@ R_API RCoreTask *r_core_task_add (RCore *core, RCoreTask *task);
 R_API void r_core_task_add_bg (RCore *core, RCoreTask *task);
 R_API int r_core_task_del (RCore *core, int id);
 R_API void r_core_task_join (RCore *core, RCoreTask *task);
+R_API void r_core_task_free (RCoreTask *task);
+R_API void r_core_task_break (RCore *core, RCoreTask *task);
+R_API char *r_core_task_output (RCore *core, RCoreTask *task);
+R_API int r_core_task_cat (RCore *core, int id);
+R_API void r_core_task_fini (RCore *core);
 typedef void (*inRangeCb) (RCore *core, ut64 from, ut64 to, int vsize,
 			   bool asterisk, int count);
 R_API int r_core_search_value_in_range (RCore *core, ut64 from, ut64 to,
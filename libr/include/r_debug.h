@@ -105,6 +105,7 @@ typedef enum {
 	R_DEBUG_REASON_SWI,
 	R_DEBUG_REASON_INT,
 	R_DEBUG_REASON_FPU,
+	R_DEBUG_REASON_TRACELOG,
 } RDebugReasonType;
 
 
@@ -168,12 +169,54 @@ typedef struct r_debug_key {
 	int id;
 } RDebugKey;
 
+#define R_DEBUG_PAGE_SIZE 4096
+
+/* page of memory shared by all the sessions which saw it */
+typedef struct r_debug_page_t {
+	ut32 hash;
+	int refs;
+	struct r_debug_page_t *next; // same bucket of the store
+	ut8 data[R_DEBUG_PAGE_SIZE];
+} RDebugPage;
+
+typedef struct r_debug_page_ref_t {
+	ut64 addr;
+	RDebugPage *page;
+} RDebugPageRef;
+
+typedef struct r_debug_pagestore_t {
+	RDebugPage **buckets;
+	int nbuckets;
+	int count;
+	struct r_debug_session_t *synced; // memory matches it except in the soft-dirty pages
+	int pid; // process whose soft-dirty bits were cleared
+	bool softdirty; // the kernel tracks the written pages
+} RDebugPageStore;
+
 typedef struct r_debug_session_t {
 	RDebugKey key;
 	RListIter *reg[R_REG_TYPE_LAST];
-	RList *memlist; // <RDebugSnap*>
+	RDebugPageStore *store;
+	RDebugPageRef *pages; // sorted by address
+	int npages;
+	int fresh; // pages not seen by the previous sessions
 } RDebugSession;
 
+/* undo log of the last steps, see record.c */
+typedef struct r_debug_record_t {
+	struct r_debug_record_step_t **steps; // ring of the recorded steps
+	int size;
+	int head; // next slot
+	int count;
+	RAnalEsil *esil; // finds the memory written by a step
+	ut8 *regs[R_REG_TYPE_LAST]; // registers before the pending step
+	int regsize[R_REG_TYPE_LAST];
+	ut8 *buf; // changes of the pending step
+	int len;
+	int cap;
+	bool pending;
+} RDebugRecord;
+
 typedef struct r_debug_trace_t {
 	RList *traces;
 	int count;
@@ -252,6 +295,8 @@ typedef struct r_debug_t {
 	RList *maps_user; // <RDebugMap>
 	RList *snaps; // <RDebugSnap>
 	RList *sessions; // <RDebugSession>
+	RDebugPageStore *pagestore;
+	RDebugRecord *record; // set when dbg.record is
 	Sdb *sgnls;
 	RCoreBind corebind;
 	// internal use only
@@ -514,6 +559,24 @@ R_API RDebugSnap* r_debug_snap_get (RDebug *dbg, ut64 addr);
 R_API int r_debug_snap_set_idx (RDebug *dbg, int idx);
 R_API int r_debug_snap_set (RDebug *dbg, RDebugSnap *snap);
 
+/* record */
+R_API RDebugRecord *r_debug_record_new(int size);
+R_API void r_debug_record_free(RDebugRecord *r);
+R_API void r_debug_record_set(RDebug *dbg, int size);
+R_API void r_debug_record_reset(RDebug *dbg);
+R_API bool r_debug_record_begin(RDebug *dbg);
+R_API void r_debug_record_end(RDebug *dbg);
+R_API bool r_debug_record_undo(RDebug *dbg);
+R_API int r_debug_continue_back(RDebug *dbg);
+
+/* page store */
+R_API RDebugPageStore *r_debug_pagestore_new(void);
+R_API void r_debug_pagestore_free(RDebugPageStore *s);
+R_API RDebugPage *r_debug_pagestore_get(RDebugPageStore *s, const ut8 *data);
+R_API void r_debug_pagestore_unref(RDebugPageStore *s, RDebugPage *page);
+R_API bool r_debug_pagestore_capture(RDebug *dbg, RDebugSession *session, int perms);
+R_API bool r_debug_pagestore_restore(RDebug *dbg, RDebugSession *session);
+
 /* debug session */
 R_API void r_debug_session_free (void *p) ;
 R_API void r_debug_session_list (RDebug *dbg);
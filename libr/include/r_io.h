@@ -137,12 +137,15 @@ typedef struct r_io_t {
 	RIOUndo undo;
 	RList *plugins;
 	RList *sections;
+	RIntervalTree *sec_vtree; /* vaddr index of sections */
+	RIntervalTree *sec_ptree; /* paddr index of sections */
 	int next_section_id;
 	RIOSection *section; /* current section (cache) */
 	/* maps */
 	RList *maps; /*<RIOMap>*/
+	RIntervalTree *map_tree; /* address index of maps */
 	RList *files;
-	RList *cache;
+	RIntervalTree *cache; /* RIOCache pages by address */
 	RCache *buffer;
 	int buffer_enabled;
 	bool ff;
@@ -164,6 +167,13 @@ typedef struct r_io_t {
 	struct r_io_plugin_t *plugin_default;
 } RIO;
 
+/* one of the ranges read by r_io_read_vec */
+typedef struct r_io_vec_t {
+	ut64 addr;
+	ut8 *buf;
+	int len;
+} RIOVec;
+
 typedef struct r_io_plugin_t {
 //	void *plugin;
 	char *name;
@@ -181,6 +191,10 @@ typedef struct r_io_plugin_t {
 	RIODesc* (*open)(RIO *io, const char *, int rw, int mode);
 	RList* /*RIODesc* */ (*open_many)(RIO *io, const char *, int rw, int mode);
 	int (*read)(RIO *io, RIODesc *fd, ut8 *buf, int count);
+	/* optional, pointer to count bytes at io->off without copying them */
+	const ut8 *(*read_ptr)(RIO *io, RIODesc *fd, int count);
+	/* optional, reads count ranges of the debugged process at once */
+	int (*read_vec)(RIO *io, RIODesc *fd, RIOVec *vec, int count);
 	ut64 (*lseek)(RIO *io, RIODesc *fd, ut64 offset, int whence);
 	int (*write)(RIO *io, RIODesc *fd, const ut8 *buf, int count);
 	int (*close)(RIODesc *desc);
@@ -197,6 +211,7 @@ typedef RIO * (*RIOGetIO) (struct r_io_bind_t *iob);
 typedef int (*RIOSetFd)(RIO *io, int fd);
 typedef int (*RIOReadAt)(RIO *io, ut64 addr, ut8 *buf, int size);
 typedef int (*RIOWriteAt)(RIO *io, ut64 addr, const ut8 *buf, int size);
+typedef int (*RIOReadVec)(RIO *io, RIOVec *vec, int count);
 typedef ut64 (*RIOSize)(RIO *io);
 typedef ut64 (*RIOSeek)(RIO *io, ut64 offset, int whence);
 
@@ -223,6 +238,7 @@ typedef struct r_io_bind_t {
 	RIOSetFd set_fd; // XXX : this is conceptually broken with the new RIODesc foo
 	RIOReadAt read_at;
 	RIOWriteAt write_at;
+	RIOReadVec read_vec;
 	RIOSize size;
 	RIOSeek seek;
 	RIOSystem system;
@@ -242,13 +258,17 @@ typedef struct r_io_bind_t {
 	RIODescGetFD desc_get_by_fd;
 } RIOBind;
 
+#define R_IO_CACHE_PAGE 0x1000
+
+/* one page of the write cache, bits tells which bytes were written */
 typedef struct r_io_cache_t {
 	ut64 from;
-	ut64 to;
-	int size;
-	ut8 *data;
-	ut8 *odata;
-	int written;
+	int dirty;
+	ut8 bits[R_IO_CACHE_PAGE / 8]; /* bytes in the cache */
+	ut8 written[R_IO_CACHE_PAGE / 8]; /* bytes the file has as in data */
+	ut8 touched[R_IO_CACHE_PAGE / 8]; /* bytes the file no longer has as in odata */
+	ut8 data[R_IO_CACHE_PAGE];
+	ut8 odata[R_IO_CACHE_PAGE];
 } RIOCache;
 
 typedef struct r_io_range_t {
@@ -256,6 +276,16 @@ typedef struct r_io_range_t {
 	ut64 to;
 } RIORange;
 
+/* contiguous piece of a virtual range backed by a single section or map */
+typedef struct r_io_segment_t {
+	ut64 from;
+	ut64 to;
+	ut64 paddr; /* address to read from the fd */
+	int fd;
+	RIOSection *section;
+	RIOMap *map;
+} RIOSegment;
+
 // XXX: HACK this must be io->desc_new() maybe?
 #define RETURN_IO_DESC_NEW(fplugin,ffd,fname,fflags,mode,fdata) { \
 	if (!fname) return NULL; \
@@ -324,6 +354,9 @@ R_API int r_io_mread(RIO *io, int fd, ut64 maddr, ut8 *buf, int len);
 R_API int r_io_pread(RIO *io, ut64 paddr, ut8 *buf, int len);
 R_API int r_io_read(RIO *io, ut8 *buf, int len);
 R_API int r_io_read_at(RIO *io, ut64 addr, ut8 *buf, int len);
+R_API int r_io_read_at_ptr(RIO *io, ut64 addr, int len, const ut8 **ptr);
+R_API int r_io_read_vec(RIO *io, RIOVec *vec, int count);
+R_API int r_io_read_ptr(RIO *io, int len, const ut8 **ptr);
 R_API ut64 r_io_read_i(RIO *io, ut64 addr, int sz);
 R_API int r_io_write(RIO *io, const ut8 *buf, int len);
 R_API int r_io_write_at(RIO *io, ut64 addr, const ut8 *buf, int len);
@@ -343,6 +376,8 @@ R_API int r_io_shift(RIO *io, ut64 start, ut64 end, st64 move);
 R_API int r_io_create (RIO *io, const char *file, int mode, int type);
 R_API int r_io_bind(RIO *io, RIOBind *bnd);
 R_API void r_io_sort_maps (RIO *io);
+R_API RList *r_io_resolve_range(RIO *io, ut64 from, ut64 to);
+R_API ut64 r_io_next_backed(RIO *io, ut64 from, ut64 to);
 
 /* io/cache.c */
 R_API int r_io_cache_invalidate(RIO *io, ut64 from, ut64 to);
@@ -380,6 +415,8 @@ R_API int r_io_map_exists_for_offset (RIO *io, ut64 off);
 R_API int r_io_map_write_update(RIO *io, int fd, ut64 addr, ut64 len);
 R_API int r_io_map_truncate_update(RIO *io, int fd, ut64 sz);
 R_API int r_io_map_count (RIO *io);
+R_API bool r_io_map_set_range(RIO *io, RIOMap *map, ut64 from, ut64 to);
+R_API void r_io_map_reindex(RIO *io);
 R_API void r_io_map_list (RIO *io, int rad);
 
 /* io/section.c */
@@ -395,6 +432,7 @@ R_API RIOSection *r_io_section_pget(RIO *io, ut64 addr);
 R_API int r_io_section_set_archbits(RIO *io, ut64 addr, const char *arch, int bits);
 R_API const char *r_io_section_get_archbits(RIO* io, ut64 addr, int *bits);
 R_API void r_io_section_clear(RIO *io);
+R_API void r_io_section_fini(RIO *io);
 R_API int r_io_section_rm(RIO *io, int idx);
 R_API int r_io_section_rm_all (RIO *io, int fd);
 R_API void r_io_section_list(RIO *io, ut64 offset, int rad);
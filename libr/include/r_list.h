@@ -27,12 +27,6 @@ typedef struct r_list_t {
 	bool sorted;
 } RList;
 
-typedef struct r_list_range_t {
-	SdbHash *h;
-	RList *l;
-	//RListComparator c;
-} RListRange;
-
 typedef int (*RListComparator)(const void *a, const void *b);
 
 #define ROFList_Parent RList
@@ -50,6 +50,7 @@ typedef struct r_search_hit_t {
 } RSearchHit;
 
 typedef int (*RSearchUpdate)(void *s, ut64 from, const ut8 *buf, int len);
+typedef struct r_search_multi_t RSearchMulti;
 typedef int (*RSearchCallback)(RSearchKeyword *kw, void *user, ut64 where);
 
 typedef struct r_search_t {
@@ -70,6 +71,7 @@ typedef struct r_search_t {
 	int align;
 	RSearchUpdate update;
 	RList *kws; // TODO: Use r_search_kw_new ()
+	RSearchMulti *multi; // compiled kws, see multi.c
 	RIOBind iob;
 	char bckwrds;
 } RSearch;
@@ -116,6 +118,13 @@ R_API int r_search_strings_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_regexp_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_xrefs_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_hit_new(RSearch *s, RSearchKeyword *kw, ut64 addr);
+
+/* multi.c */
+R_API RSearchMulti *r_search_multi_new(RSearch *s);
+R_API void r_search_multi_free(RSearchMulti *m);
+R_API bool r_search_multi_usable(RSearch *s);
+R_API int r_search_multi_update(RSearch *s, ut64 from, const ut8 *buf, int len);
+
 R_API void r_search_set_distance(RSearch *s, int dist);
 R_API int r_search_strings(RSearch *s, ut32 min, ut32 max);
 R_API int r_search_set_string_limits(RSearch *s, ut32 min, ut32 max); // WTF dupped?
@@ -45,6 +45,15 @@ typedef struct r_sign_item_t {
 	RList *refs;
 } RSignItem;
 
+typedef struct r_sign_index_t {
+	RSignItem *items;
+	int count;
+	SdbHash *graph; // all the graph metrics set
+	RList *graph_any; // some of them set to -1
+	SdbHash *offset;
+	SdbHash *refs;
+} RSignIndex;
+
 typedef int (*RSignForeachCallback)(RSignItem *it, void *user);
 typedef int (*RSignSearchCallback)(RSignItem *it, RSearchKeyword *kw, ut64 addr, void *user);
 typedef int (*RSignGraphMatchCallback)(RSignItem *it, RAnalFunction *fcn, void *user);
@@ -77,6 +86,12 @@ R_API bool r_sign_match_graph(RAnal *a, RAnalFunction *fcn, int mincc, RSignGrap
 R_API bool r_sign_match_offset(RAnal *a, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user);
 R_API bool r_sign_match_refs(RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user);
 
+R_API RSignIndex *r_sign_index_new(RAnal *a);
+R_API void r_sign_index_free(RSignIndex *si);
+R_API bool r_sign_index_match_graph(RSignIndex *si, RAnalFunction *fcn, int mincc, RSignGraphMatchCallback cb, void *user);
+R_API bool r_sign_index_match_offset(RSignIndex *si, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user);
+R_API bool r_sign_index_match_refs(RSignIndex *si, RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user);
+
 R_API bool r_sign_load(RAnal *a, const char *file);
 R_API bool r_sign_save(RAnal *a, const char *file);
 
@@ -10,6 +10,7 @@
 #define HAVE_PTHREAD 0
 #define R_TH_TID HANDLE
 #define R_TH_LOCK_T PCRITICAL_SECTION
+#define R_TH_COND_T CONDITION_VARIABLE
 //HANDLE
 
 #elif HAVE_PTHREAD
@@ -17,12 +18,23 @@
 #include <pthread.h>
 #define R_TH_TID pthread_t
 #define R_TH_LOCK_T pthread_mutex_t
+#define R_TH_COND_T pthread_cond_t
 
 #else
 #error Threading library only supported for pthread and w32
 #endif
 
 #define R_TH_FUNCTION(x) int (*x)(struct r_th_t *)
+#define R_TH_ATEXIT_MAX 8
+
+typedef void (*RThreadAtExit)(void *user);
+
+/* one variable per thread */
+#if defined(_MSC_VER)
+#define R_TH_LOCAL __declspec(thread)
+#else
+#define R_TH_LOCAL __thread
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +45,10 @@ typedef struct r_th_lock_t {
 	R_TH_LOCK_T lock;
 } RThreadLock;
 
+typedef struct r_th_cond_t {
+	R_TH_COND_T cond;
+} RThreadCond;
+
 typedef struct r_th_t {
 	R_TH_TID tid;
 	RThreadLock *lock;
@@ -57,6 +73,7 @@ R_API int r_th_wait_async(RThread *th);
 R_API void r_th_break(RThread *th);
 R_API void *r_th_free(RThread *th);
 R_API int r_th_kill(RThread *th, int force);
+R_API bool r_th_atexit(RThreadAtExit fn, void *user);
 
 R_API RThreadLock *r_th_lock_new(void);
 R_API int r_th_lock_wait(RThreadLock *th);
@@ -65,6 +82,12 @@ R_API int r_th_lock_enter(RThreadLock *thl);
 R_API int r_th_lock_leave(RThreadLock *thl);
 R_API void *r_th_lock_free(RThreadLock *thl);
 
+R_API RThreadCond *r_th_cond_new(void);
+R_API void r_th_cond_signal(RThreadCond *cond);
+R_API void r_th_cond_signal_all(RThreadCond *cond);
+R_API void r_th_cond_wait(RThreadCond *cond, RThreadLock *thl);
+R_API void *r_th_cond_free(RThreadCond *cond);
+
 typedef struct r_thread_msg_t {
 	char *text;
 	char done;
@@ -75,6 +98,10 @@ typedef struct r_thread_msg_t {
 R_API RThreadMsg* r_th_msg_new (const char *cmd, void *cb);
 R_API void r_th_msg_free (RThreadMsg* msg);
 
+R_API RThreadPool *r_th_pool_new(int size, R_TH_FUNCTION(fun), void *user);
+R_API void r_th_pool_wait(RThreadPool *pool);
+R_API void r_th_pool_free(RThreadPool *pool);
+
 #endif
 
 #ifdef __cplusplus
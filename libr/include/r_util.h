@@ -41,6 +41,8 @@
 #include "r_util/r_strpool.h"
 #include "r_util/r_sys.h"
 #include "r_util/r_tree.h"
+#include "r_util/r_intervaltree.h"
+#include "r_util/r_hashtable.h"
 #include "r_util/r_uleb128.h"
 #include "r_util/r_utf8.h"
 #include "r_util/r_id_storage.h"
@@ -30,9 +30,11 @@ R_API RBuffer *r_buf_new(void);
 R_API RBuffer *r_buf_new_with_bytes(const ut8* bytes, ut64 len);
 R_API RBuffer *r_buf_new_with_pointers(const ut8 *bytes, ut64 len);
 R_API RBuffer *r_buf_new_with_buf(RBuffer *b);
+R_API RBuffer *r_buf_new_view(RBuffer *b);
 R_API RBuffer *r_buf_new_file(const char *file, bool newFile);
 R_API RBuffer *r_buf_new_slurp(const char *file);
 R_API RBuffer *r_buf_mmap(const char *file, int flags);
+R_API RBuffer *r_buf_mmap_cow(const char *file);
 R_API RBuffer *r_buf_new_sparse(void);
 R_API bool r_buf_dump (RBuffer *buf, const char *file);
 /* methods */
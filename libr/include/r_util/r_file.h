@@ -9,6 +9,7 @@ R_API char *r_file_root(const char *root, const char *path);
 R_API bool r_file_is_directory(const char *str);
 R_API bool r_file_is_regular(const char *str);
 R_API RMmap *r_file_mmap(const char *file, bool rw, ut64 base);
+R_API RMmap *r_file_mmap_cow(const char *file, ut64 base);
 R_API int r_file_mmap_read(const char *file, ut64 addr, ut8 *buf, int len);
 R_API int r_file_mmap_write(const char *file, ut64 addr, const ut8 *buf, int len);
 R_API void r_file_mmap_free(RMmap *m);
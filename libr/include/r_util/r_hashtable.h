@@ -0,0 +1,43 @@
+#ifndef R_HASHTABLE_H
+#define R_HASHTABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* hashtable.c */
+
+/* open addressing hashtable keyed by ut64, for the places where
+ * formatting addresses into sdb keys is the bottleneck */
+
+typedef void (*RHashTable64Free)(void *data);
+typedef bool (*RHashTable64ForeachCb)(void *user, ut64 key, void *data);
+
+typedef struct r_hashtable64_entry_t {
+	ut64 key;
+	void *data;
+} RHashTable64Entry;
+
+typedef struct r_hashtable64_t {
+	RHashTable64Entry *table;
+	ut8 *state;
+	ut32 size;    // number of slots, always a power of two
+	ut32 count;   // used slots
+	ut32 deleted; // tombstones
+	RHashTable64Free free;
+} RHashTable64;
+
+R_API RHashTable64 *r_hashtable64_new(RHashTable64Free free);
+R_API void r_hashtable64_free(RHashTable64 *ht);
+R_API void r_hashtable64_clear(RHashTable64 *ht);
+R_API void *r_hashtable64_lookup(RHashTable64 *ht, ut64 key);
+R_API bool r_hashtable64_insert(RHashTable64 *ht, ut64 key, void *data);
+R_API bool r_hashtable64_update(RHashTable64 *ht, ut64 key, void *data);
+R_API bool r_hashtable64_remove(RHashTable64 *ht, ut64 key);
+R_API void r_hashtable64_foreach(RHashTable64 *ht, RHashTable64ForeachCb cb, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //  R_HASHTABLE_H
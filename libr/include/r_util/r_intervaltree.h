@@ -0,0 +1,57 @@
+#ifndef R_INTERVALTREE_H
+#define R_INTERVALTREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* intervaltree.c */
+
+/* AVL tree of closed intervals [start, end] ordered by (start, seq).
+ * every node keeps the greatest end of its subtree so point and range
+ * queries only visit the branches that can intersect. seq is the
+ * insertion counter, it is kept across resizes and lets callers that
+ * care about "first added wins" semantics pick the lowest one. */
+
+typedef struct r_interval_node_t {
+	struct r_interval_node_t *link[2];
+	ut64 start;
+	ut64 end;
+	ut64 max_end;
+	ut64 seq;
+	int height;
+	void *data;
+} RIntervalNode;
+
+typedef void (*RIntervalNodeFree)(void *data);
+typedef bool (*RIntervalIterCb)(RIntervalNode *node, void *user);
+
+typedef struct r_interval_tree_t {
+	RIntervalNode *root;
+	RIntervalNodeFree free;
+	ut64 seq;
+	int count;
+} RIntervalTree;
+
+R_API RIntervalTree *r_interval_tree_new(RIntervalNodeFree free);
+R_API void r_interval_tree_free(RIntervalTree *t);
+R_API void r_interval_tree_init(RIntervalTree *t, RIntervalNodeFree free);
+R_API void r_interval_tree_fini(RIntervalTree *t);
+R_API RIntervalNode *r_interval_tree_insert(RIntervalTree *t, ut64 start, ut64 end, void *data);
+R_API bool r_interval_tree_delete(RIntervalTree *t, RIntervalNode *node, bool free_data);
+R_API bool r_interval_tree_resize(RIntervalTree *t, RIntervalNode *node, ut64 start, ut64 end);
+R_API RIntervalNode *r_interval_tree_node_at_data(RIntervalTree *t, ut64 start, void *data);
+R_API RIntervalNode *r_interval_tree_next(RIntervalTree *t, ut64 addr);
+R_API RIntervalNode *r_interval_tree_prev(RIntervalTree *t, ut64 addr);
+R_API bool r_interval_tree_all_in(RIntervalTree *t, ut64 addr, RIntervalIterCb cb, void *user);
+R_API bool r_interval_tree_all_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb cb, void *user);
+R_API bool r_interval_tree_foreach(RIntervalTree *t, RIntervalIterCb cb, void *user);
+R_API RIntervalNode *r_interval_tree_first_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb filter, void *user);
+R_API RIntervalNode *r_interval_tree_last_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb filter, void *user);
+R_API RList *r_interval_tree_list_intersect(RIntervalTree *t, ut64 start, ut64 end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //  R_INTERVALTREE_H
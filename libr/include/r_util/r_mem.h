@@ -4,7 +4,7 @@
 typedef struct r_mmap_t {
 	ut8 *buf;
 	ut64 base;
-	int len;
+	ut64 len;
 	int fd;
 	int rw;
 #if __WINDOWS__
@@ -1,20 +1,71 @@
-/* radare - LGPL - Copyright 2008-2015 - pancake */
+/* radare - LGPL - Copyright 2008-2017 - pancake */
 
-// TODO: implement a more inteligent way to store cached memory
 // TODO: define limit of max mem to cache
 
 #include "r_io.h"
 
-static void cache_item_free(RIOCache *cache) {
-	if (!cache)
-		return;
-	free (cache->data);
-	free (cache->odata);
-	free (cache);
+/* the write cache is a set of R_IO_CACHE_PAGE sized pages indexed by
+ * address, every written byte is flagged in the page bitmap so reads
+ * only patch what was really written and adjacent writes coalesce.
+ * Two more bitmaps follow what wc did to the file: written bytes are
+ * there as in data, touched ones differ from odata until invalidated */
+
+#define PAGE_MASK ((ut64)R_IO_CACHE_PAGE - 1)
+#define BIT_GET(b,i) ((b)[(i) >> 3] & (1 << ((i) & 7)))
+#define BIT_SET(b,i) ((b)[(i) >> 3] |= (1 << ((i) & 7)))
+#define BIT_UNSET(b,i) ((b)[(i) >> 3] &= ~(1 << ((i) & 7)))
+
+static RIOCache *cache_page(RIO *io, ut64 addr) {
+	ut64 from = addr & ~PAGE_MASK;
+	RIntervalNode *node = r_interval_tree_prev (io->cache, from);
+	return (node && node->start == from)? node->data: NULL;
+}
+
+static RIOCache *cache_page_new(RIO *io, ut64 from) {
+	RIOCache *c = R_NEW0 (RIOCache);
+	if (!c) {
+		return NULL;
+	}
+	c->from = from;
+	if (!r_interval_tree_insert (io->cache, from, from + PAGE_MASK, c)) {
+		free (c);
+		return NULL;
+	}
+	return c;
+}
+
+/* next run of cached bytes in the page starting at *i, up to end */
+static bool cache_page_run(RIOCache *c, int *i, int *len, int end) {
+	int j;
+	while (*i < end && !BIT_GET (c->bits, *i)) {
+		(*i)++;
+	}
+	if (*i >= end) {
+		return false;
+	}
+	for (j = *i; j < end && BIT_GET (c->bits, j); j++) {
+		;
+	}
+	*len = j - *i;
+	return true;
+}
+
+/* writes to the underlying io skipping the cache */
+static bool cache_write_raw(RIO *io, ut64 addr, const ut8 *buf, int len) {
+	int ret, ioc = io->cached;
+	io->cached = 2; // magic number to skip caching this write
+	(void)r_io_seek (io, addr, R_IO_SEEK_SET);
+	ret = r_io_write (io, buf, len);
+	io->cached = ioc;
+	return ret == len;
+}
+
+static ut64 cache_end(ut64 from, ut64 to) {
+	return (to > from)? to - 1: UT64_MAX;
 }
 
 R_API void r_io_cache_init(RIO *io) {
-	io->cache = r_list_newf ((RListFree)cache_item_free);
+	io->cache = r_interval_tree_new (free);
 	io->cached = false; // cache write ops
 	io->cached_read = false; // cached read ops
 }
@@ -25,102 +76,202 @@ R_API void r_io_cache_enable(RIO *io, int read, int write) {
 }
 
 R_API void r_io_cache_commit(RIO *io, ut64 from, ut64 to) {
+	RIntervalNode *node;
 	RListIter *iter;
 	RIOCache *c;
-	int ioc = io->cached;
-	io->cached = 2;
-	r_list_foreach (io->cache, iter, c) {
-		if (c->from >= from && c->to <= to) {
-			if (!r_io_write_at (io, c->from, c->data, c->size))
-				eprintf ("Error writing change at 0x%08"PFMT64x"\n", c->from);
-			else 
-				c->written = true;
-			break;
+	RList *pages;
+	ut64 end = cache_end (from, to);
+	int i, j, len, last;
+	if (from >= to) {
+		return;
+	}
+	pages = r_interval_tree_list_intersect (io->cache, from, end);
+	r_list_foreach (pages, iter, node) {
+		c = node->data;
+		// only the bytes of the page inside the range
+		i = (from > c->from)? from - c->from: 0;
+		last = (end < c->from + PAGE_MASK)? end - c->from + 1: R_IO_CACHE_PAGE;
+		for (; cache_page_run (c, &i, &len, last); i += len) {
+			if (!cache_write_raw (io, c->from + i, c->data + i, len)) {
+				eprintf ("Error writing change at 0x%08"PFMT64x"\n", c->from + i);
+				continue;
+			}
+			for (j = i; j < i + len; j++) {
+				BIT_SET (c->written, j);
+				BIT_SET (c->touched, j);
+			}
 		}
 	}
-	io->cached = ioc;
+	r_list_free (pages);
 }
 
 R_API void r_io_cache_reset(RIO *io, int set) {
 	io->cached = set;
-	r_list_purge (io->cache);
+	r_interval_tree_fini (io->cache);
 }
 
 R_API int r_io_cache_invalidate(RIO *io, ut64 from, ut64 to) {
+	RIntervalNode *node;
 	RListIter *iter;
 	RIOCache *c;
-	int done = false;
-
-	if (from<to) {
-		//r_list_foreach_safe (io->cache, iter, iter_tmp, c) {
-		r_list_foreach (io->cache, iter, c) {
-			if (c->from >= from && c->to <= to) {
-				int ioc = io->cached;
-				io->cached = 2; // magic number to skip caching this write
-				r_io_write_at (io, c->from, c->odata, c->size);
-				io->cached = ioc;
-				if (!c->written)
-					r_list_delete (io->cache, iter);
-				c->written = false;
-				done = true;
+	RList *pages;
+	ut64 a, end;
+	int i, done = false;
+
+	if (from >= to) {
+		return false;
+	}
+	end = cache_end (from, to);
+	pages = r_interval_tree_list_intersect (io->cache, from, end);
+	r_list_foreach (pages, iter, node) {
+		c = node->data;
+		for (a = R_MAX (from, c->from); a <= R_MIN (end, c->from + PAGE_MASK); a++) {
+			i = a - c->from;
+			if (!BIT_GET (c->bits, i)) {
+				continue;
+			}
+			if (BIT_GET (c->touched, i)) {
+				(void)cache_write_raw (io, a, c->odata + i, 1);
+			}
+			BIT_UNSET (c->bits, i);
+			BIT_UNSET (c->written, i);
+			BIT_UNSET (c->touched, i);
+			c->dirty--;
+			done = true;
+			if (a == UT64_MAX) {
 				break;
 			}
 		}
+		if (!c->dirty) {
+			r_interval_tree_delete (io->cache, node, true);
+		}
 	}
+	r_list_free (pages);
 	return done;
 }
 
+/* adjacent runs are merged across pages before being listed */
+typedef struct {
+	RIO *io;
+	int rad;
+	int idx;
+	ut64 addr;
+	int size;
+	int written;
+	ut8 *data;
+	ut8 *odata;
+	int capacity;
+} CacheList;
+
+static void cache_list_flush(CacheList *cl) {
+	RIO *io = cl->io;
+	int i;
+	if (!cl->size) {
+		return;
+	}
+	if (cl->rad == 1) {
+		io->cb_printf ("wx ");
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->data[i]);
+		}
+		io->cb_printf (" @ 0x%08"PFMT64x, cl->addr);
+		io->cb_printf (" # replaces: ");
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->odata[i]);
+		}
+		io->cb_printf ("\n");
+	} else if (cl->rad == 2) {
+		io->cb_printf ("%s{\"idx\":%d,\"addr\":%"PFMT64d",\"size\":%d,",
+			cl->idx? ",": "", cl->idx, cl->addr, cl->size);
+		io->cb_printf ("\"before\":\"");
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->odata[i]);
+		}
+		io->cb_printf ("\",\"after\":\"");
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->data[i]);
+		}
+		io->cb_printf ("\",\"written\":%s}", cl->written? "true": "false");
+	} else if (cl->rad == 0) {
+		io->cb_printf ("idx=%d addr=0x%08"PFMT64x" size=%d ", cl->idx, cl->addr, cl->size);
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->odata[i]);
+		}
+		io->cb_printf (" -> ");
+		for (i = 0; i < cl->size; i++) {
+			io->cb_printf ("%02x", cl->data[i]);
+		}
+		io->cb_printf (" %s\n", cl->written? "(written)": "(not written)");
+	}
+	cl->idx++;
+	cl->size = 0;
+}
+
+static bool cache_list_run(CacheList *cl, RIOCache *c, int i, int len) {
+	ut64 addr = c->from + i;
+	int written = !!BIT_GET (c->written, i);
+	if (cl->size && (cl->addr + cl->size != addr || cl->written != written)) {
+		cache_list_flush (cl);
+	}
+	if (cl->size + len > cl->capacity) {
+		int capacity = (cl->size + len) * 2;
+		ut8 *data = realloc (cl->data, capacity);
+		ut8 *odata = data? realloc (cl->odata, capacity): NULL;
+		if (data) {
+			cl->data = data;
+		}
+		if (!odata) {
+			return false;
+		}
+		cl->odata = odata;
+		cl->capacity = capacity;
+	}
+	if (!cl->size) {
+		cl->addr = addr;
+		cl->written = written;
+	}
+	memcpy (cl->data + cl->size, c->data + i, len);
+	memcpy (cl->odata + cl->size, c->odata + i, len);
+	cl->size += len;
+	return true;
+}
+
+static bool cache_list_cb(RIntervalNode *node, void *user) {
+	RIOCache *c = node->data;
+	int i, j, len;
+	for (i = 0; cache_page_run (c, &i, &len, R_IO_CACHE_PAGE); i += len) {
+		// split the run where the written state changes
+		for (j = 1; j < len && !BIT_GET (c->written, i + j) == !BIT_GET (c->written, i); j++) {
+			;
+		}
+		len = j;
+		if (!cache_list_run (user, c, i, len)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 R_API int r_io_cache_list(RIO *io, int rad) {
-	int i, j = 0;
-	RListIter *iter;
-	RIOCache *c;
+	CacheList cl = { io, rad };
 	if (rad == 2) {
 		io->cb_printf ("[");
 	}
-	r_list_foreach (io->cache, iter, c) {
-		if (rad == 1) {
-			io->cb_printf ("wx ");
-			for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", (ut8)(c->data[i] & 0xff));
-			}
-			io->cb_printf (" @ 0x%08"PFMT64x, c->from);
-			io->cb_printf (" # replaces: ");
-		  	for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", (ut8)(c->odata[i] & 0xff));
-			}
-			io->cb_printf ("\n");
-		} else if (rad == 2) {
-			io->cb_printf ("{\"idx\":%"PFMT64d",\"addr\":%"PFMT64d",\"size\":%d,", j, c->from, c->size);
-			io->cb_printf ("\"before\":\"");
-		  	for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", c->odata[i]);
-			}
-			io->cb_printf ("\",\"after\":\"");
-		  	for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", c->data[i]);
-			}
-			io->cb_printf ("\",\"written\":%s}%s", c->written? "true": "false",iter->n? ",": "");
-		} else if (rad == 0) {
-			io->cb_printf ("idx=%d addr=0x%08"PFMT64x" size=%d ", j, c->from, c->size);
-			for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", c->odata[i]);
-			}
-			io->cb_printf (" -> ");
-			for (i = 0; i < c->size; i++) {
-				io->cb_printf ("%02x", c->data[i]);
-			}
-			io->cb_printf (" %s\n", c->written? "(written)": "(not written)");
-		}
-		j++;
-	}
-	if (rad == 2)
+	r_interval_tree_foreach (io->cache, cache_list_cb, &cl);
+	cache_list_flush (&cl);
+	if (rad == 2) {
 		io->cb_printf ("]");
+	}
+	free (cl.data);
+	free (cl.odata);
 	return false;
 }
 
 R_API int r_io_cache_write(RIO *io, ut64 addr, const ut8 *buf, int len) {
-//	int i;
-	RIOCache *ch;
+	ut8 tmp[R_IO_CACHE_PAGE];
+	int i, l, off, fresh, done = 0;
+	RIOCache *c;
+	ut64 at;
 	if (io->cached == 2) {
 		/* do not allow to use the cache write in debugger mode */
 		/* this is a hack to solve issues */
@@ -129,65 +280,87 @@ R_API int r_io_cache_write(RIO *io, ut64 addr, const ut8 *buf, int len) {
 	if (len < 0) {
 		return 0;
 	}
-#if 0
-	for (i = 0; i<len; i++) {
-		if (buf[i] != 0xff)
+	while (done < len) {
+		at = addr + done;
+		off = at & PAGE_MASK;
+		l = R_MIN (len - done, R_IO_CACHE_PAGE - off);
+		c = cache_page (io, at);
+		if (!c && !(c = cache_page_new (io, at - off))) {
 			break;
+		}
+		for (i = fresh = 0; i < l; i++) {
+			if (!BIT_GET (c->bits, off + i)) {
+				fresh++;
+			}
+		}
+		// keep the bytes being replaced, only the first write to
+		// each byte needs them so rewrites do not hit the backend.
+		// we must use raw io here to avoid calling to cacheread and get wrong reads
+		if (fresh) {
+			if (r_io_seek (io, at, R_IO_SEEK_SET) == UT64_MAX) {
+				memset (tmp, 0xff, l);
+			}
+			r_io_read_internal (io, tmp, l);
+			for (i = 0; i < l; i++) {
+				if (!BIT_GET (c->bits, off + i)) {
+					c->odata[off + i] = tmp[i];
+					BIT_SET (c->bits, off + i);
+				}
+			}
+			c->dirty += fresh;
+		}
+		memcpy (c->data + off, buf + done, l);
+		// the file keeps what a previous commit put there
+		for (i = 0; i < l; i++) {
+			if (io->cached) {
+				BIT_UNSET (c->written, off + i);
+			} else {
+				BIT_SET (c->written, off + i);
+			}
+		}
+		done += l;
+	}
+	return done;
+}
+
+typedef struct {
+	ut64 addr;
+	ut64 end;
+	ut8 *buf;
+	int covered;
+} CacheRead;
+
+static bool cache_read_cb(RIntervalNode *node, void *user) {
+	CacheRead *cr = user;
+	RIOCache *c = node->data;
+	ut64 from = R_MAX (cr->addr, c->from);
+	ut64 to = R_MIN (cr->end, c->from + PAGE_MASK);
+	int i, n = to - from + 1;
+	int off = from - c->from;
+	ut8 *dst = cr->buf + (from - cr->addr);
+	if (c->dirty == R_IO_CACHE_PAGE) {
+		memcpy (dst, c->data + off, n);
+		cr->covered += n;
+		return true;
+	}
+	for (i = 0; i < n; i++) {
+		if (BIT_GET (c->bits, off + i)) {
+			dst[i] = c->data[off + i];
+			cr->covered++;
+		}
 	}
-	if (i == len) {
-		return -1;
-	}
-#endif
-	ch = R_NEW0 (RIOCache);
-	if (!ch) return 0;
-	ch->from = addr;
-	ch->to = addr + len;
-	ch->size = len;
-	ch->odata = (ut8*)malloc (len);
-	ch->data = (ut8*)malloc (len);
-	ch->written = io->cached? 0: 1;
-#if 1
-	// we must use raw io here to avoid calling to cacheread and get wrong reads
-	if (r_io_seek (io, addr, R_IO_SEEK_SET)==UT64_MAX)
-		memset (ch->odata, 0xff, len);
-	r_io_read_internal (io, ch->odata, len);
-#else
-	r_io_read_at (io, addr, ch->odata, len);
-#endif
-	memcpy (ch->data, buf, len);
-	r_list_append (io->cache, ch);
-	return len;
+	return true;
 }
 
 R_API int r_io_cache_read(RIO *io, ut64 addr, ut8 *buf, int len) {
-	int l, ret, da, db;
-	int covered = 0;
-	RListIter *iter;
-	RIOCache *c;
-	if (len < 0) {
+	CacheRead cr = { addr, 0, buf, 0 };
+	if (len < 1) {
 		return 0;
 	}
-
-	r_list_foreach (io->cache, iter, c) {
-		if (r_range_overlap (addr, addr+len-1, c->from, c->to, &ret)) {
-			if (ret>0) {
-				da = ret;
-				db = 0;
-				l = c->size;
-			} else if (ret<0) {
-				da = 0;
-				db = -ret;
-				l = c->size - db;
-			} else {
-				da = 0;
-				db = 0;
-				l = c->size;
-			}
-			if ((l+da)>len) l = len-da;					//say hello to integer overflow, but this won't happen in realistic scenarios because malloc will fail befor
-			if (l<1) l = 1; // XXX: fail
-			else memcpy (buf+da, c->data+db, l);
-			covered += l;
-		}
+	cr.end = addr + len - 1;
+	if (cr.end < addr) {
+		cr.end = UT64_MAX;
 	}
-	return covered;
+	r_interval_tree_all_intersect (io->cache, addr, cr.end, cache_read_cb, &cr);
+	return cr.covered;
 }
@@ -84,11 +84,12 @@ R_API RIO *r_io_free(RIO *io) {
 	}
 	R_FREE (io->plugin_default);
 	r_list_free (io->plugins);
-	r_list_free (io->sections);
+	r_io_section_fini (io);
 	r_list_free (io->maps);
+	r_interval_tree_free (io->map_tree);
 	r_list_free (io->undo.w_list);
 	r_cache_free (io->buffer);
-	r_list_free (io->cache);
+	r_interval_tree_free (io->cache);
 	r_io_desc_fini (io);
 	free (io);
 	return NULL;
@@ -351,6 +352,25 @@ R_API int r_io_read(RIO *io, ut8 *buf, int len) {
 	return ret;
 }
 
+/* r_io_read counterpart of r_io_read_at_ptr */
+R_API int r_io_read_ptr(RIO *io, int len, const ut8 **ptr) {
+	ut64 vaddr;
+	int ret;
+	if (!io || !io->desc || !ptr || io->off == UT64_MAX) {
+		return 0;
+	}
+	if (io->enforce_rwx & R_IO_READ) {
+		return 0;
+	}
+	vaddr = r_io_section_maddr_to_vaddr (io, io->off);
+	vaddr = (vaddr == UT64_MAX) ? io->off : vaddr;
+	ret = r_io_read_at_ptr (io, vaddr, len, ptr);
+	if (ret > 0) {
+		io->off += ret;
+	}
+	return ret;
+}
+
 int r_io_read_cr (RIO *io, ut64 addr, ut8 *buf, int len) {
 	RList *maps;
 	RListIter *iter;
@@ -428,39 +448,13 @@ R_API int r_io_read_at(RIO *io, ut64 addr, ut8 *buf, int len) {
 			// an IO Map (yet.), so the "checking existence of" only works if r_core_file
 			// APIs are used to load files.
 			if (!exists && r_io_map_count (io) > 0) {
-				// XXX this will break if there is actually data at this location
-				// or within UT64_MAX - len
-				ut64 next_map_addr = UT64_MAX;
-				ut64 next_sec_addr = UT64_MAX;
-
-				RIOMap *next_map = NULL;
-				RIOSection *next_sec = NULL;
-				// is there a map somewhere within the next range for
-				// us to read from
-				next_sec = r_io_section_get_first_in_vaddr_range (io, addr + w, addr + len + w);
-				next_sec_addr = next_sec? next_sec->paddr: UT64_MAX;
-
-				if (!next_sec) {
-					next_map = r_io_map_get_first_map_in_range (io, addr + w, addr + len + w);
-					next_map_addr = next_map? next_map->from: UT64_MAX;
-					if (len <= next_map_addr - addr)
-						next_map_addr = UT64_MAX;
-					else l = next_map_addr - addr;
-
-				} else if (len <= next_map_addr - addr) {
-					next_sec_addr = UT64_MAX;
-				} else {
-					if (addr > next_sec_addr) {
-						/* avoid negative deltas */
-						return olen;
-					}
-					l = next_sec_addr - addr;
-				}
-
-				if (!next_sec && !next_map) {
+				// jump to the first address backing the rest of the read
+				ut64 next = r_io_next_backed (io, addr + w, addr + w + len);
+				if (next == UT64_MAX) {
 					// done
 					return olen;
 				}
+				l = next - (addr + w);
 				// want to capture monotonicity even when maps are 0 in length
 				if (l == 0) l++;
 				w += l;
@@ -558,6 +552,97 @@ bear in mind that we need to fix that loop and honor lseek sections and sio maps
 	return olen;
 }
 
+/* borrows a pointer to the len bytes at addr from the plugin of the file
+ * mapped there instead of copying them. Returns len, or 0 when they can't
+ * be served that way (caches, several chunks, not mmaped...) and the
+ * caller must fall back to r_io_read_at. The bytes are only valid until
+ * the next write or close of the file. */
+R_API int r_io_read_at_ptr(RIO *io, ut64 addr, int len, const ut8 **ptr) {
+	ut64 last, last2;
+	int exists, ms, l;
+	if (!io || !ptr || len < 1) {
+		return 0;
+	}
+	*ptr = NULL;
+	if (io->vio || io->buffer_enabled || io->cached || io->debug || readcache) {
+		return 0;
+	}
+	if ((io->sectonly && !r_list_empty (io->sections)) || addr + len < addr) {
+		return 0;
+	}
+	/* same single chunk path r_io_read_at takes */
+	exists = r_io_section_exists_for_paddr (io, addr, 0) ||
+		r_io_section_exists_for_vaddr (io, addr, 0) ||
+		r_io_map_exists_for_offset (io, addr);
+	if (!exists && r_io_map_count (io) > 0) {
+		return 0;
+	}
+	last = r_io_section_next (io, addr);
+	last2 = r_io_map_next (io, addr);
+	if (last == addr) {
+		last = last2;
+	}
+	l = (len > (last - addr))? (last - addr): len;
+	if (l > 0 && l < len) {
+		return 0;
+	}
+	io->off = addr;
+	r_io_map_select (io, addr);
+	if (r_io_seek (io, addr, R_IO_SEEK_SET) == UT64_MAX) {
+		return 0;
+	}
+	ms = r_io_map_select (io, addr);
+	if (r_list_length (io->maps) > 1 && ms > 0) {
+		if (r_io_section_maddr_to_vaddr (io, addr) == UT64_MAX &&
+				r_io_section_vaddr_to_maddr_try (io, addr) == UT64_MAX) {
+			return 0;
+		}
+	}
+	if (!io->desc || !io->desc->plugin || !io->desc->plugin->read_ptr) {
+		return 0;
+	}
+	*ptr = io->desc->plugin->read_ptr (io, io->desc, len);
+	return *ptr? len: 0;
+}
+
+/* the debugger reads the range straight from the process memory */
+static bool io_vec_raw(RIO *io, RIOVec *v) {
+	ut64 end = v->addr + v->len;
+	return !r_io_section_get_first_in_vaddr_range (io, v->addr, end) &&
+		!r_io_section_get_first_in_paddr_range (io, v->addr, end);
+}
+
+/* reads count ranges, in one go when the debugger plugin can. Like
+ * r_io_read_at, the bytes which can't be read are set to io->Oxff and
+ * the ranges with sections mapped on them are read through these */
+R_API int r_io_read_vec(RIO *io, RIOVec *vec, int count) {
+	RIOPlugin *plugin;
+	RIOVec *raw = NULL;
+	int i, n = 0;
+	if (!io || !vec || count < 1) {
+		return 0;
+	}
+	plugin = io->desc? io->desc->plugin: NULL;
+	if (io->debug && plugin && plugin->read_vec && io->Oxff == 0xff &&
+	    !io->vio && !io->buffer_enabled && !io->cached && !readcache) {
+		raw = calloc (count, sizeof (RIOVec));
+	}
+	for (i = 0; i < count; i++) {
+		if (raw && vec[i].len > 0 && io_vec_raw (io, &vec[i])) {
+			raw[n++] = vec[i];
+		} else {
+			r_io_read_at (io, vec[i].addr, vec[i].buf, vec[i].len);
+		}
+	}
+	if (n > 0 && plugin->read_vec (io, io->desc, raw, n) != n) {
+		for (i = 0; i < n; i++) {
+			r_io_read_at (io, raw[i].addr, raw[i].buf, raw[i].len);
+		}
+	}
+	free (raw);
+	return count;
+}
+
 R_API ut64 r_io_read_i(RIO *io, ut64 addr, int sz) {
 	ut64 ret = 0LL;
 	ut8 buf[8];
@@ -971,6 +1056,7 @@ R_API int r_io_bind(RIO *io, RIOBind *bnd) {
 	bnd->get_io = r_io_bind_get_io;
 	bnd->read_at = r_io_read_at;
 	bnd->write_at = r_io_write_at;
+	bnd->read_vec = r_io_read_vec;
 	bnd->size = r_io_size;
 	bnd->seek = r_io_seek;
 	bnd->system = r_io_system;
@@ -1046,6 +1132,7 @@ R_API int r_io_create(RIO *io, const char *file, int mode, int type) {
 
 R_API void r_io_sort_maps(RIO *io) {
 	r_list_sort (io->maps, (RListComparator)r_io_map_sort);
+	r_io_map_reindex (io);
 }
 
 // THIS IS pread.. a weird one
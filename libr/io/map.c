@@ -7,6 +7,74 @@
 #include <r_util.h>
 #include <r_list.h>
 
+/* interval of a map in io->map_tree. empty maps behave as if they
+ * extended up to the end of the address space (see r_io_map_get) */
+static void map_itv(RIOMap *map, ut64 *start, ut64 *end) {
+	*start = map->from;
+	if (map->to > map->from) {
+		*end = map->to - 1;
+	} else if (map->to == map->from) {
+		*end = UT64_MAX;
+	} else {
+		*end = map->from;
+	}
+}
+
+static void map_index(RIO *io, RIOMap *map) {
+	ut64 start, end;
+	map_itv (map, &start, &end);
+	r_interval_tree_insert (io->map_tree, start, end, map);
+}
+
+static void map_unindex(RIO *io, RIOMap *map) {
+	RIntervalNode *node = r_interval_tree_node_at_data (io->map_tree, map->from, map);
+	r_interval_tree_delete (io->map_tree, node, false);
+}
+
+static bool map_in(RIOMap *map, ut64 addr) {
+	return map->from <= addr && addr < map->to;
+}
+
+/* same overlap test used by all the range based lookups */
+static bool map_in_range(RIOMap *map, ut64 addr, ut64 endaddr) {
+	return (map->from <= addr && addr < map->to) ||
+		(map->from < endaddr && endaddr < map->to) ||
+		(addr <= map->from && map->to <= endaddr);
+}
+
+typedef struct {
+	ut64 addr;
+	ut64 endaddr;
+	int fd;
+	RIOMap *skip;
+} MapQuery;
+
+static bool filter_in(RIntervalNode *node, void *user) {
+	MapQuery *q = user;
+	return map_in ((RIOMap *)node->data, q->addr);
+}
+
+static bool filter_in_fd(RIntervalNode *node, void *user) {
+	MapQuery *q = user;
+	RIOMap *map = node->data;
+	return map->fd == q->fd && map_in (map, q->addr);
+}
+
+static bool filter_in_skip(RIntervalNode *node, void *user) {
+	MapQuery *q = user;
+	return node->data != q->skip && map_in ((RIOMap *)node->data, q->addr);
+}
+
+static bool filter_in_range(RIntervalNode *node, void *user) {
+	MapQuery *q = user;
+	return map_in_range ((RIOMap *)node->data, q->addr, q->endaddr);
+}
+
+static RIntervalNode *map_first_in(RIO *io, ut64 addr, RIntervalIterCb filter, MapQuery *q) {
+	q->addr = addr;
+	return r_interval_tree_first_intersect (io->map_tree, addr, addr, filter, q);
+}
+
 R_API int r_io_map_count (RIO *io) {
 	return r_list_length (io->maps);
 }
@@ -23,11 +91,41 @@ R_API RIOMap * r_io_map_new(RIO *io, int fd, int flags, ut64 delta, ut64 addr, u
 	map->from = addr;
 	map->to = addr + size;
 	r_list_append (io->maps, map);
+	map_index (io, map);
 	return map;
 }
 
 R_API void r_io_map_init(RIO *io) {
 	io->maps = r_list_new ();
+	io->map_tree = r_interval_tree_new (NULL);
+}
+
+/* the only safe way to move or resize a map already added to io */
+R_API bool r_io_map_set_range(RIO *io, RIOMap *map, ut64 from, ut64 to) {
+	RIntervalNode *node;
+	ut64 start, end;
+	if (!io || !map) {
+		return false;
+	}
+	node = r_interval_tree_node_at_data (io->map_tree, map->from, map);
+	map->from = from;
+	map->to = to;
+	map_itv (map, &start, &end);
+	if (!node) {
+		return r_interval_tree_insert (io->map_tree, start, end, map) != NULL;
+	}
+	return r_interval_tree_resize (io->map_tree, node, start, end);
+}
+
+/* rebuild the index following the current order of io->maps */
+R_API void r_io_map_reindex(RIO *io) {
+	RListIter *iter;
+	RIOMap *map;
+	r_interval_tree_fini (io->map_tree);
+	r_interval_tree_init (io->map_tree, NULL);
+	r_list_foreach (io->maps, iter, map) {
+		map_index (io, map);
+	}
 }
 
 R_API int r_io_map_sort(void *_a, void *_b) {
@@ -50,7 +148,7 @@ R_API int r_io_map_write_update(RIO *io, int fd, ut64 addr, ut64 len) {
 	}
 	if (map && map->to < addr+len) {
 		res = true;
-		map->to = addr+len;
+		r_io_map_set_range (io, map, map->from, addr + len);
 	}
 	return res;
 }
@@ -65,23 +163,21 @@ R_API int r_io_map_truncate_update(RIO *io, int fd, ut64 sz) {
 	}
 	if (map) {
 		res = true;
-		map->to = map->from + sz;
+		r_io_map_set_range (io, map, map->from, map->from + sz);
 	}
 	return res;
 }
 
+static bool filter_get(RIntervalNode *node, void *user) {
+	RIOMap *map = node->data;
+	ut64 addr = *(ut64 *)user;
+	return (map->from == map->to && addr >= map->from) || map_in (map, addr);
+}
+
 R_API RIOMap *r_io_map_get(RIO *io, ut64 addr) {
-	RIOMap *map;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from == map->to && addr >= map->from) {
-			return map;
-		}
-		if (addr >= map->from && addr < map->to) {
-			return map;
-		}
-	}
-	return NULL;
+	RIntervalNode *node = r_interval_tree_first_intersect (io->map_tree,
+		addr, addr, filter_get, &addr);
+	return node? node->data: NULL;
 }
 
 R_API RIOMap *r_io_map_resolve(RIO *io, int fd) {
@@ -110,59 +206,62 @@ R_API RIOMap *r_io_map_resolve_from_list (RList *maps, int fd) {
 	return NULL;
 }
 
-static RList *r_io_map_get_maps_in_range_prepend(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOMap *map;
-	RListIter *iter;
-	RList *maps = r_list_new ();
-	if (!maps) return NULL;
-	maps->free = NULL;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from <= addr && addr < map->to) r_list_append(maps, map);
-		//if (map->from == addr && endaddr == map->to) r_list_prepend(maps, map);
-		if (map->from < endaddr && endaddr < map->to) r_list_prepend(maps, map);
-		if (addr <= map->from && map->to <= endaddr) r_list_prepend(maps, map);
-	}
-	return maps;
+/* candidates overlapping the [addr, endaddr] window in io->maps order */
+static RList *maps_in_range(RIO *io, ut64 addr, ut64 endaddr) {
+	return r_interval_tree_list_intersect (io->map_tree,
+		R_MIN (addr, endaddr), R_MAX (addr, endaddr));
 }
 
 R_API RIOMap *r_io_map_resolve_in_range (RIO *io, ut64 addr, ut64 endaddr, int fd) {
-	RList *maps;
-	RIOMap *map;
+	RIntervalNode *node;
+	RIOMap *map, *in = NULL, *over = NULL;
+	RListIter *iter;
+	RList *nodes;
 	if (!io || !io->maps) {
 		return NULL;
 	}
-	maps = r_io_map_get_maps_in_range_prepend (io, addr, endaddr);
-	map = r_io_map_resolve_from_list (maps, fd);
-	r_list_free (maps);
-	return map;
+	nodes = maps_in_range (io, addr, endaddr);
+	// maps overlapping the end or contained in the range take precedence
+	// over the ones containing addr, and among those the last one wins
+	r_list_foreach (nodes, iter, node) {
+		map = node->data;
+		if (map->fd != fd) {
+			continue;
+		}
+		if ((map->from < endaddr && endaddr < map->to) ||
+		    (addr <= map->from && map->to <= endaddr)) {
+			over = map;
+		} else if (!in && map_in (map, addr)) {
+			in = map;
+		}
+	}
+	r_list_free (nodes);
+	return over? over: in;
 }
 
 R_API RList *r_io_map_get_maps_in_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOMap *map;
+	RIntervalNode *node;
 	RListIter *iter;
-	RList *maps = r_list_new ();
-	if (!maps) return NULL;
+	RList *nodes, *maps = r_list_new ();
+	if (!maps) {
+		return NULL;
+	}
 	maps->free = NULL;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from <= addr && addr < map->to) r_list_append(maps, map);
-		//if (map->from == addr && endaddr == map->to) r_list_append(maps, map);
-		if (map->from < endaddr && endaddr < map->to) r_list_append(maps, map);
-		if (addr <= map->from && map->to <= endaddr) r_list_append(maps, map);
+	nodes = maps_in_range (io, addr, endaddr);
+	r_list_foreach (nodes, iter, node) {
+		if (map_in_range (node->data, addr, endaddr)) {
+			r_list_append (maps, node->data);
+		}
 	}
+	r_list_free (nodes);
 	return maps;
 }
 
 R_API RIOMap * r_io_map_get_first_map_in_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOMap *map = NULL;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from <= addr && addr < map->to) break;
-		//if (map->from == addr && endaddr == map->to) r_list_append(maps, map);
-		if (map->from < endaddr && endaddr < map->to) break;
-		if (addr <= map->from && map->to <= endaddr) break;
-		map = NULL;
-	}
-	return map;
+	MapQuery q = { addr, endaddr };
+	RIntervalNode *node = r_interval_tree_first_intersect (io->map_tree,
+		R_MIN (addr, endaddr), R_MAX (addr, endaddr), filter_in_range, &q);
+	return node? node->data: NULL;
 }
 
 R_API int r_io_map_del(RIO *io, int fd) {
@@ -172,6 +271,7 @@ R_API int r_io_map_del(RIO *io, int fd) {
 	if (io && io->maps) {
 		r_list_foreach_safe (io->maps, iter, tmp, map) {
 			if (fd==-1 || map->fd==fd) {
+				map_unindex (io, map);
 				r_list_delete (io->maps, iter);
 				deleted = true;
 			}
@@ -181,25 +281,18 @@ R_API int r_io_map_del(RIO *io, int fd) {
 }
 
 R_API ut64 r_io_map_next(RIO *io, ut64 addr) {
-	ut64 next = UT64_MAX;
-	RIOMap *map;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from > addr)
-			if (!next || map->from < next)
-				next = map->from;
-	}
-	return next;
+	RIntervalNode *node = r_interval_tree_next (io->map_tree, addr);
+	return node? node->start: UT64_MAX;
 }
 
 R_API int r_io_map_del_at(RIO *io, ut64 addr) {
-	RIOMap *map;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from <= addr && addr < map->to) {
-			r_list_delete (io->maps, iter);
-			return true;
-		}
+	MapQuery q = {0};
+	RIntervalNode *node = map_first_in (io, addr, filter_in, &q);
+	if (node) {
+		RIOMap *map = node->data;
+		r_interval_tree_delete (io->map_tree, node, false);
+		r_list_delete_data (io->maps, map);
+		return true;
 	}
 	return false;
 }
@@ -226,31 +319,20 @@ R_API RIOMap *r_io_map_add_next_available(RIO *io, int fd, int flags, ut64 delta
 }
 
 R_API RIOMap *r_io_map_add(RIO *io, int fd, int flags, ut64 delta, ut64 addr, ut64 size) {
-	RIOMap *map;
-	RListIter *iter;
 	ut64 end_addr = addr + size;
-	r_list_foreach (io->maps, iter, map) {
-		// XXX - This does not handle when file overflow 0xFFFFFFFF000 -> 0x00000000
-		// keeping (fd, to, from) tuples as separate maps
-		if ( map->fd == fd && ((map->from <= addr && addr < map->to) ||
-			(map->from <= end_addr  && end_addr < map->to)) )
-			//return r_io_map_add(io, fd, flags, delta, map->to, size);
-			return NULL;
+	MapQuery q = { 0, 0, fd };
+	// XXX - This does not handle when file overflow 0xFFFFFFFF000 -> 0x00000000
+	// keeping (fd, to, from) tuples as separate maps
+	if (map_first_in (io, addr, filter_in_fd, &q) ||
+	    map_first_in (io, end_addr, filter_in_fd, &q)) {
+		return NULL;
 	}
 	return r_io_map_new (io, fd, flags, delta, addr, size);
 }
 
 R_API int r_io_map_exists_for_offset (RIO *io, ut64 off) {
-	int res = false;
-	RIOMap *im = NULL;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, im) {
-		if (im->from <= off && off < im->to) {
-			res = true;
-			break;
-		}
-	}
-	return res;
+	MapQuery q = {0};
+	return map_first_in (io, off, filter_in, &q) != NULL;
 }
 
 R_API ut64 r_io_map_select(RIO *io, ut64 off) {
@@ -260,23 +342,39 @@ R_API ut64 r_io_map_select(RIO *io, ut64 off) {
 	RIOMap *im = NULL;
 	RListIter *iter;
 	ut64 prevfrom = 0LL;
-	r_list_foreach (io->maps, iter, im) {
-		if (off >= im->from) {
-			if (prevfrom) {
-				if (im->from < prevfrom) {
+	RIntervalNode *node;
+	MapQuery q = { 0, 0, io->raised };
+	// the raised fd wins, otherwise the last map containing off does
+	node = map_first_in (io, off, filter_in_fd, &q);
+	if (!node) {
+		q.addr = off;
+		node = r_interval_tree_last_intersect (io->map_tree, off, off, filter_in, &q);
+	}
+	im = node? node->data: NULL;
+	if (im && r_io_desc_get (io, im->fd)) {
+		// no need to switch descs here, the final use_fd picks it
+		paddr = off - im->from + im->delta;
+		fd = im->fd;
+		done = 1;
+	} else {
+		r_list_foreach (io->maps, iter, im) {
+			if (off >= im->from) {
+				if (prevfrom) {
+					if (im->from < prevfrom) {
+						r_io_use_fd (io, im->fd);
+					}
+				} else {
 					r_io_use_fd (io, im->fd);
 				}
-			} else {
-				r_io_use_fd (io, im->fd);
+				prevfrom = im->from;
 			}
-			prevfrom = im->from;
-		}
-		if (off >= im->from && off < im->to) {
-			paddr = off - im->from + im->delta; //-im->from;
-			fd = im->fd;
-			done = 1;
-			if (fd == io->raised) {
-				break;
+			if (off >= im->from && off < im->to) {
+				paddr = off - im->from + im->delta; //-im->from;
+				fd = im->fd;
+				done = 1;
+				if (fd == io->raised) {
+					break;
+				}
 			}
 		}
 	}
@@ -303,15 +401,13 @@ R_API ut64 r_io_map_select_current_fd(RIO *io, ut64 off, int fd) {
 	int done = 0;
 	ut64 paddr = off;
 	RIOMap *im = NULL;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, im) {
-		if (im->fd != fd) {
-			continue;
-		}
-		if (off >= im->from && off < im->to) {
-			paddr = off - im->from + im->delta; //-im->from;
-			done = 1;
-		}
+	MapQuery q = { off, 0, fd };
+	RIntervalNode *node = r_interval_tree_last_intersect (io->map_tree,
+		off, off, filter_in_fd, &q);
+	if (node) {
+		im = node->data;
+		paddr = off - im->from + im->delta; //-im->from;
+		done = 1;
 	}
 	if (done == 0) {
 		(void) r_io_seek (io, -1, R_IO_SEEK_SET);
@@ -330,21 +426,11 @@ R_API ut64 r_io_map_select_current_fd(RIO *io, ut64 off, int fd) {
 }
 
 R_API bool r_io_map_overlaps (RIO *io, RIODesc *fd, RIOMap *map) {
-	RListIter *iter;
-	RIOMap *im = NULL;
-	ut64 off = map->from;
+	MapQuery q = { 0, 0, 0, map };
 	if (!fd) {
 		return false;
 	}
-	r_list_foreach (io->maps, iter, im) {
-		if (im == map) {
-			continue;
-		}
-		if (off >= im->from && off < im->to) {
-			return true;
-		}
-	}
-	return false;
+	return map_first_in (io, map->from, filter_in_skip, &q) != NULL;
 }
 
 R_API void r_io_map_list(RIO *io, int mode) {
@@ -103,6 +103,21 @@ static int r_io_mmap_read(RIO *io, RIODesc *fd, ut8 *buf, int count) {
 	return r_buf_read_at (mmo->buf, io->off, buf, count);
 }
 
+static const ut8 *r_io_mmap_read_ptr(RIO *io, RIODesc *fd, int count) {
+	RIOMMapFileObj *mmo;
+	if (!fd || !fd->data || count < 1) {
+		return NULL;
+	}
+	mmo = fd->data;
+	if (!mmo->buf || !mmo->buf->buf || mmo->buf->base) {
+		return NULL;
+	}
+	if (io->off > mmo->buf->length || count > mmo->buf->length - io->off) {
+		return NULL;
+	}
+	return mmo->buf->buf + io->off;
+}
+
 static int r_io_mmap_write(RIO *io, RIODesc *fd, const ut8 *buf, int count) {
 	RIOMMapFileObj *mmo;
 	int len = count;
@@ -171,6 +186,10 @@ static int __read(RIO *io, RIODesc *fd, ut8 *buf, int len) {
 	return r_io_mmap_read (io, fd, buf, len);
 }
 
+static const ut8 *__read_ptr(RIO *io, RIODesc *fd, int len) {
+	return r_io_mmap_read_ptr (io, fd, len);
+}
+
 static int __write(RIO *io, RIODesc *fd, const ut8 *buf, int len) {
 	return r_io_mmap_write(io, fd, buf, len);
 }
@@ -197,6 +216,7 @@ struct r_io_plugin_t r_io_plugin_mmap = {
 	.open = __open,
 	.close = __close,
 	.read = __read,
+	.read_ptr = __read_ptr,
 	.check = __plugin_open,
 	.lseek = __lseek,
 	.write = __write,
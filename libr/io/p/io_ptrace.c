@@ -1,5 +1,8 @@
 /* radare - LGPL - Copyright 2008-2016 - pancake */
 
+#if __linux__
+#define _GNU_SOURCE // process_vm_readv
+#endif
 #include <r_userconf.h>
 #include <r_io.h>
 #include <r_lib.h>
@@ -13,6 +16,17 @@
 #include <sys/wait.h>
 #include <errno.h>
 
+/* process_vm_readv/writev move whole ranges in one syscall, ptrace
+ * is still used for the pages they can not access */
+#if __linux__ && !__ANDROID__
+#define USE_VM_RW 1
+#include <sys/uio.h>
+#else
+#define USE_VM_RW 0
+#endif
+#define VM_PAGE 4096
+#define VM_IOV_MAX 1024
+
 typedef struct {
 	int pid;
 	int tid;
@@ -69,6 +83,44 @@ static int debug_os_read_at(int pid, ut32 *buf, int sz, ut64 addr) {
 	return sz;
 }
 
+#if USE_VM_RW
+/* reads what process_vm_readv can, page by page after a failure. The
+ * pages it can not read go through ptrace, which sets the unmapped
+ * ones to 0xff */
+static int vm_read_at(int pid, ut8 *buf, int len, ut64 addr) {
+	struct iovec local, remote;
+	ssize_t n;
+	int done = 0;
+	local.iov_base = buf;
+	local.iov_len = len;
+	remote.iov_base = (void *)(size_t)addr;
+	remote.iov_len = len;
+	n = process_vm_readv (pid, &local, 1, &remote, 1, 0);
+	if (n == len) {
+		return len;
+	}
+	if (n < 0 && errno != EFAULT) {
+		return -1;
+	}
+	if (n > 0) {
+		done = n;
+	}
+	while (done < len) {
+		ut64 at = addr + done;
+		int chunk = R_MIN (len - done, VM_PAGE - (at % VM_PAGE));
+		local.iov_base = buf + done;
+		local.iov_len = chunk;
+		remote.iov_base = (void *)(size_t)at;
+		remote.iov_len = chunk;
+		if (process_vm_readv (pid, &local, 1, &remote, 1, 0) != chunk) {
+			debug_os_read_at (pid, (ut32*)(buf + done), chunk, at);
+		}
+		done += chunk;
+	}
+	return len;
+}
+#endif
+
 static int __read(RIO *io, RIODesc *desc, ut8 *buf, int len) {
 #if USE_PROC_PID_MEM
 	int ret, fd;
@@ -77,6 +129,11 @@ static int __read(RIO *io, RIODesc *desc, ut8 *buf, int len) {
 	if (!desc || !desc->data)
 		return -1;
 	memset (buf, '\xff', len); // TODO: only memset the non-readed bytes
+#if USE_VM_RW
+	if (len > 0 && addr != UT64_MAX && vm_read_at (RIOPTRACE_PID (desc), buf, len, addr) == len) {
+		return len;
+	}
+#endif
 	/* reopen procpidmem if necessary */
 #if USE_PROC_PID_MEM
 	fd = RIOPTRACE_FD (desc);
@@ -125,10 +182,81 @@ static int ptrace_write_at(int pid, const ut8 *pbuf, int sz, ut64 addr) {
 	return sz;
 }
 
+#if USE_VM_RW
+/* process_vm_writev can not write the read-only pages (code), what it
+ * could not write goes through ptrace */
+static int vm_write_at(int pid, const ut8 *buf, int len, ut64 addr) {
+	struct iovec local, remote;
+	ssize_t n;
+	local.iov_base = (void *)buf;
+	local.iov_len = len;
+	remote.iov_base = (void *)(size_t)addr;
+	remote.iov_len = len;
+	n = process_vm_writev (pid, &local, 1, &remote, 1, 0);
+	if (n == len) {
+		return len;
+	}
+	if (n < 0 && errno != EFAULT) {
+		return ptrace_write_at (pid, buf, len, addr);
+	}
+	n = R_MAX (n, 0);
+	if (ptrace_write_at (pid, buf + n, len - n, addr + n) != len - n) {
+		return n;
+	}
+	return len;
+}
+
+/* all the ranges with one process_vm_readv per VM_IOV_MAX of them */
+static int __read_vec(RIO *io, RIODesc *desc, RIOVec *vec, int count) {
+	struct iovec local[VM_IOV_MAX], remote[VM_IOV_MAX];
+	int pid, i, j, n;
+	ssize_t total, ret;
+	if (!desc || !desc->data) {
+		return -1;
+	}
+	pid = RIOPTRACE_PID (desc);
+	for (i = 0; i < count; i += n) {
+		n = R_MIN (count - i, VM_IOV_MAX);
+		total = 0;
+		for (j = 0; j < n; j++) {
+			local[j].iov_base = vec[i + j].buf;
+			local[j].iov_len = vec[i + j].len;
+			remote[j].iov_base = (void *)(size_t)vec[i + j].addr;
+			remote[j].iov_len = vec[i + j].len;
+			total += vec[i + j].len;
+		}
+		ret = process_vm_readv (pid, local, n, remote, n, 0);
+		if (ret == total) {
+			continue;
+		}
+		if (ret < 0 && errno != EFAULT) {
+			return -1;
+		}
+		/* the ranges after the fault */
+		for (j = 0, ret = R_MAX (ret, 0); j < n; j++) {
+			RIOVec *v = &vec[i + j];
+			if (ret >= v->len) {
+				ret -= v->len;
+				continue;
+			}
+			memset (v->buf + ret, 0xff, v->len - ret);
+			vm_read_at (pid, v->buf + ret, v->len - ret, v->addr + ret);
+			ret = 0;
+		}
+	}
+	return count;
+}
+#endif
+
 static int __write(RIO *io, RIODesc *fd, const ut8 *buf, int len) {
 	if (!fd || !fd->data) {
 		return -1;
 	}
+#if USE_VM_RW
+	if (len > 0 && io->off != UT64_MAX) {
+		return vm_write_at (RIOPTRACE_PID (fd), buf, len, io->off);
+	}
+#endif
 	return ptrace_write_at (RIOPTRACE_PID (fd), buf, len, io->off);
 }
 
@@ -316,6 +444,9 @@ RIOPlugin r_io_plugin_ptrace = {
 	.lseek = __lseek,
 	.system = __system,
 	.write = __write,
+#if USE_VM_RW
+	.read_vec = __read_vec,
+#endif
 	.isdbg = true
 };
 #else
@@ -4,16 +4,142 @@
 // no link
 #include "r_cons.h"
 
+/* sections are indexed by vaddr and paddr in two interval trees that
+ * follow the order of io->sections, lookups keep returning the first
+ * (or last) matching section of the list like the linear walks did */
+
+static void itv_of(ut64 from, ut64 size, ut64 *start, ut64 *end) {
+	*start = from;
+	if (!size) {
+		*end = from;
+	} else if (from + size > from) {
+		*end = from + size - 1;
+	} else {
+		*end = UT64_MAX;
+	}
+}
+
+static void section_vitv(RIOSection *s, ut64 *start, ut64 *end) {
+	itv_of (s->vaddr, s->vsize, start, end);
+}
+
+static void section_pitv(RIOSection *s, ut64 *start, ut64 *end) {
+	itv_of (s->paddr, s->size, start, end);
+}
+
+static void section_index(RIO *io, RIOSection *s) {
+	ut64 start, end;
+	section_vitv (s, &start, &end);
+	r_interval_tree_insert (io->sec_vtree, start, end, s);
+	section_pitv (s, &start, &end);
+	r_interval_tree_insert (io->sec_ptree, start, end, s);
+}
+
+static void section_unindex(RIO *io, RIOSection *s) {
+	RIntervalNode *node;
+	node = r_interval_tree_node_at_data (io->sec_vtree, s->vaddr, s);
+	r_interval_tree_delete (io->sec_vtree, node, false);
+	node = r_interval_tree_node_at_data (io->sec_ptree, s->paddr, s);
+	r_interval_tree_delete (io->sec_ptree, node, false);
+}
+
+/* must be called before changing the addresses of an indexed section */
+static void section_reindex(RIO *io, RIOSection *s, ut64 paddr, ut64 vaddr, ut64 size, ut64 vsize) {
+	RIntervalNode *vnode = r_interval_tree_node_at_data (io->sec_vtree, s->vaddr, s);
+	RIntervalNode *pnode = r_interval_tree_node_at_data (io->sec_ptree, s->paddr, s);
+	ut64 start, end;
+	s->paddr = paddr;
+	s->vaddr = vaddr;
+	s->size = size;
+	s->vsize = vsize;
+	section_vitv (s, &start, &end);
+	r_interval_tree_resize (io->sec_vtree, vnode, start, end);
+	section_pitv (s, &start, &end);
+	r_interval_tree_resize (io->sec_ptree, pnode, start, end);
+}
+
+static bool section_vin(RIOSection *s, ut64 vaddr) {
+	return vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize;
+}
+
+static bool section_pin(RIOSection *s, ut64 paddr) {
+	return paddr >= s->paddr && paddr < s->paddr + s->size;
+}
+
+static bool section_in_range(ut64 sec_from, ut64 sec_to, ut64 addr, ut64 endaddr) {
+	return (sec_from <= addr && addr < sec_to) ||
+		(sec_from < endaddr && endaddr < sec_to) ||
+		(addr <= sec_from && sec_to <= endaddr);
+}
+
+typedef struct {
+	ut64 addr;
+	ut64 endaddr;
+	int mapped;
+	bool use_bin_id;
+	ut32 bin_id;
+} SectionQuery;
+
+static bool filter_vin(RIntervalNode *node, void *user) {
+	SectionQuery *q = user;
+	RIOSection *s = node->data;
+	if (q->mapped && !(s->flags & R_IO_MAP)) {
+		return false;
+	}
+	if (q->use_bin_id && s->bin_id != q->bin_id) {
+		return false;
+	}
+	return section_vin (s, q->addr);
+}
+
+static bool filter_pin(RIntervalNode *node, void *user) {
+	SectionQuery *q = user;
+	return section_pin ((RIOSection *)node->data, q->addr);
+}
+
+static bool filter_vrange(RIntervalNode *node, void *user) {
+	SectionQuery *q = user;
+	RIOSection *s = node->data;
+	return (s->flags & R_IO_MAP) && section_in_range (s->vaddr,
+		s->vaddr + s->vsize, q->addr, q->endaddr);
+}
+
+static bool filter_prange(RIntervalNode *node, void *user) {
+	SectionQuery *q = user;
+	RIOSection *s = node->data;
+	return (s->flags & R_IO_MAP) && section_in_range (s->paddr,
+		s->paddr + s->size, q->addr, q->endaddr);
+}
+
+static RIOSection *section_first(RIntervalTree *t, ut64 addr, ut64 endaddr, RIntervalIterCb filter, SectionQuery *q) {
+	RIntervalNode *node;
+	q->addr = addr;
+	q->endaddr = endaddr;
+	node = r_interval_tree_first_intersect (t, R_MIN (addr, endaddr),
+		R_MAX (addr, endaddr), filter, q);
+	return node? node->data: NULL;
+}
+
 R_API void r_io_section_init(RIO *io) {
 	io->next_section_id = 0;
 	io->enforce_rwx = 0; // do not enforce RWX section permissions by default
 	io->enforce_seek = 0; // do not limit seeks out of the file by default
+	io->sec_vtree = r_interval_tree_new (NULL);
+	io->sec_ptree = r_interval_tree_new (NULL);
 	io->sections = r_list_newf (r_io_section_free);
 	if (!io->sections) {
 		return;
 	}
 }
 
+R_API void r_io_section_fini(RIO *io) {
+	r_list_free (io->sections);
+	io->sections = NULL;
+	r_interval_tree_free (io->sec_vtree);
+	r_interval_tree_free (io->sec_ptree);
+	io->sec_vtree = io->sec_ptree = NULL;
+}
+
 R_API RIOSection *r_io_section_get_name(RIO *io, const char *name) {
 	RListIter *iter;
 	RIOSection *s;
@@ -29,9 +155,12 @@ R_API RIOSection *r_io_section_get_name(RIO *io, const char *name) {
 
 // update name and rwx, size is experimental
 static RIOSection *findMatching (RIO *io, ut64 paddr, ut64 vaddr, ut64 size, ut64 vsize, int rwx, const char *name) {
+	RIntervalNode *node;
 	RListIter *iter;
 	RIOSection *s;
-	r_list_foreach (io->sections, iter, s) {
+	RList *nodes = r_interval_tree_list_intersect (io->sec_ptree, paddr, paddr);
+	r_list_foreach (nodes, iter, node) {
+		s = node->data;
 		if (s->paddr != paddr) continue;
 		if (s->vaddr != vaddr) continue;
 #if 1
@@ -45,8 +174,10 @@ static RIOSection *findMatching (RIO *io, ut64 paddr, ut64 vaddr, ut64 size, ut6
 		if (name && strcmp (name, s->name)) {
 			s->name = strdup (name);
 		}
+		r_list_free (nodes);
 		return s;
 	}
+	r_list_free (nodes);
 	return NULL;
 }
 
@@ -74,14 +205,18 @@ R_API RIOSection *r_io_section_add (RIO *io, ut64 offset, ut64 vaddr, ut64 size,
 	s = r_io_section_get_name (io, name);
 	if (!s) {
 		s = R_NEW0 (RIOSection);
+		if (!s) {
+			return NULL;
+		}
 		s->id = io->next_section_id++;
+		s->paddr = offset;
+		s->vaddr = vaddr;
+		s->size = size;
+		s->vsize = vsize;
 	} else {
 		update = 1;
+		section_reindex (io, s, offset, vaddr, size, vsize);
 	}
-	s->paddr = offset;
-	s->vaddr = vaddr;
-	s->size = size;
-	s->vsize = vsize;
 	s->flags = rwx;
 	s->arch = s->bits = 0;
 	s->bin_id = bin_id;
@@ -90,6 +225,7 @@ R_API RIOSection *r_io_section_add (RIO *io, ut64 offset, ut64 vaddr, ut64 size,
 		if (name) s->name = strdup (name);
 		else s->name = strdup ("");
 		r_list_append (io->sections, s);
+		section_index (io, s);
 	}
 	return s;
 }
@@ -115,6 +251,7 @@ R_API int r_io_section_rm(RIO *io, int idx) {
 	}
 	r_list_foreach (io->sections, iter, s) {
 		if (s->id == idx) {
+			section_unindex (io, s);
 			r_list_delete (io->sections, iter);
 			return true;
 		}
@@ -129,8 +266,10 @@ R_API int r_io_section_rm_all (RIO *io, int fd) {
 		return false;
 	}
 	r_list_foreach_safe (io->sections, iter, ator, section) {
-		if (section->fd == fd || fd == -1)
+		if (section->fd == fd || fd == -1) {
+			section_unindex (io, section);
 			r_list_delete (io->sections, iter);
+		}
 	}
 	return true;
 }
@@ -145,6 +284,8 @@ R_API void r_io_section_free(void *ptr) {
 
 R_API void r_io_section_clear(RIO *io) {
 	r_list_free (io->sections);
+	r_interval_tree_fini (io->sec_vtree);
+	r_interval_tree_fini (io->sec_ptree);
 	io->sections = r_list_newf (r_io_section_free);
 	if (!io->sections) {
 		return;
@@ -335,37 +476,21 @@ R_API void r_io_section_list_visual(RIO *io, ut64 seek, ut64 len, int use_color,
 }
 
 R_API RIOSection *r_io_section_vget(RIO *io, ut64 vaddr) {
-	RListIter *iter;
-	RIOSection *s;
-	r_list_foreach (io->sections, iter, s) {
-		if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize) {
-			return s;
-		}
-	}
-	return NULL;
+	SectionQuery q = {0};
+	return section_first (io->sec_vtree, vaddr, vaddr, filter_vin, &q);
 }
 
 // maddr == section->paddr
 R_API RIOSection *r_io_section_mget_in(RIO *io, ut64 maddr) {
-	RIOSection *s;
-	RListIter *iter;
-	r_list_foreach (io->sections, iter, s) {
-		if ((maddr >= s->paddr && maddr < (s->paddr + s->size))) {
-			return s;
-		}
-	}
-	return NULL;
+	SectionQuery q = {0};
+	return section_first (io->sec_ptree, maddr, maddr, filter_pin, &q);
 }
 
 R_API RIOSection *r_io_section_mget_prev(RIO *io, ut64 maddr) {
-	RIOSection *s;
-	RListIter *iter;
-	r_list_foreach_prev (io->sections, iter, s) {
-		if ((maddr >= s->paddr && maddr < (s->paddr + s->size))) {
-			return s;
-		}
-	}
-	return NULL;
+	SectionQuery q = { maddr };
+	RIntervalNode *node = r_interval_tree_last_intersect (io->sec_ptree,
+		maddr, maddr, filter_pin, &q);
+	return node? node->data: NULL;
 }
 
 // XXX: rename this
@@ -419,17 +544,9 @@ R_API ut64 r_io_section_vaddr_to_maddr_try(RIO *io, ut64 vaddr) {
 /* returns the conversion from vaddr to maddr if the given vaddr is in a mapped
  * region, UT64_MAX otherwise */
 R_API ut64 r_io_section_vaddr_to_maddr(RIO *io, ut64 vaddr) {
-	RListIter *iter;
-	RIOSection *s;
-
-	r_list_foreach (io->sections, iter, s) {
-		if (s->flags & R_IO_MAP) {
-			if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize) {
-				return (vaddr - s->vaddr + s->paddr);
-			}
-		}
-	}
-	return UT64_MAX;
+	SectionQuery q = { 0, 0, R_IO_MAP };
+	RIOSection *s = section_first (io->sec_vtree, vaddr, vaddr, filter_vin, &q);
+	return s? (vaddr - s->vaddr + s->paddr): UT64_MAX;
 }
 
 /* returns the conversion from file offset to vaddr if the given offset is
@@ -469,100 +586,57 @@ R_API int r_io_section_exists_for_vaddr (RIO *io, ut64 vaddr, int hasperm) {
 	return false;
 }
 
+/* returns the vaddr of the first section containing o, or the closest
+ * section start after it. UT64_MAX if there's nothing else mapped */
 // dupped in vio.c
 R_API ut64 r_io_section_next(RIO *io, ut64 o) {
-	RListIter *iter;
-	RIOSection *s;
-	ut64 addr, newsec = UT64_MAX;
-
-	r_list_foreach (io->sections, iter, s) {
-		addr = s->vaddr;
-		if (s->vaddr > o && s->vaddr < newsec) {
-			newsec = s->vaddr;
-		}
-		addr = s->vaddr + s->vsize;
-		if (addr > o && addr < newsec) {
-			newsec = s->vaddr;
-		}
+	SectionQuery q = {0};
+	RIntervalNode *node;
+	RIOSection *s = section_first (io->sec_vtree, o, o, filter_vin, &q);
+	if (s) {
+		return s->vaddr;
 	}
-
-	return newsec;
+	node = r_interval_tree_next (io->sec_vtree, o);
+	return node? node->start: UT64_MAX;
 }
 
-R_API RList *r_io_section_get_in_paddr_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOSection *s;
+static RList *sections_in_range(RIntervalTree *t, ut64 addr, ut64 endaddr, RIntervalIterCb filter) {
+	SectionQuery q = { addr, endaddr };
+	RIntervalNode *node;
 	RListIter *iter;
-	RList *sections = r_list_new ();
-	if (!sections) return NULL;
-	sections->free = r_io_section_free;
-	ut64 sec_from, sec_to;
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->flags & R_IO_MAP)) continue;
-		sec_from = s->paddr;
-		sec_to = sec_from + s->size;
-		if (sec_from <= addr && addr < sec_to) r_list_append (sections, s);
-		if (sec_from < endaddr && endaddr < sec_to) r_list_append (sections, s);
-		if (addr <= sec_from && sec_to <= endaddr) r_list_append (sections, s);
+	RList *nodes, *sections = r_list_new ();
+	if (!sections) {
+		return NULL;
 	}
-	return sections;
-}
-
-R_API RList *r_io_section_get_in_vaddr_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOSection *s;
-	RListIter *iter;
-	RList *sections = r_list_new ();
-	if (!sections) return NULL;
 	//Here section->free is not needed and wrong since we are appending into
 	//the list sections from io->sections that are widely used so just free the
 	//list but not the elements to avoid UAF. r_io_free will free sections for us
-	ut64 sec_from, sec_to;
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->flags & R_IO_MAP)) {
-			continue;
+	nodes = r_interval_tree_list_intersect (t, R_MIN (addr, endaddr), R_MAX (addr, endaddr));
+	r_list_foreach (nodes, iter, node) {
+		if (filter (node, &q)) {
+			r_list_append (sections, node->data);
 		}
-		sec_from = s->vaddr;
-		sec_to = sec_from + s->vsize;
-		if (sec_from <= addr && addr < sec_to) r_list_append (sections, s);
-		if (sec_from < endaddr && endaddr < sec_to) r_list_append (sections, s);
-		if (addr <= sec_from && sec_to <= endaddr) r_list_append (sections, s);
 	}
+	r_list_free (nodes);
 	return sections;
 }
 
+R_API RList *r_io_section_get_in_paddr_range(RIO *io, ut64 addr, ut64 endaddr) {
+	return sections_in_range (io->sec_ptree, addr, endaddr, filter_prange);
+}
+
+R_API RList *r_io_section_get_in_vaddr_range(RIO *io, ut64 addr, ut64 endaddr) {
+	return sections_in_range (io->sec_vtree, addr, endaddr, filter_vrange);
+}
+
 R_API RIOSection * r_io_section_get_first_in_paddr_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOSection *s= NULL;
-	RListIter *iter;
-	ut64 sec_from, sec_to;
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->flags & R_IO_MAP)) {
-			continue;
-		}
-		sec_to = s->paddr + s->size;
-		sec_from = s->paddr;
-		if (sec_from <= addr && addr < sec_to) break;
-		//if (map->from == addr && endaddr == sec_to) r_list_append(maps, map);
-		if (sec_from < endaddr && endaddr < sec_to) break;
-		if (addr <= sec_from && sec_to <= endaddr) break;
-		s = NULL;
-	}
-	return s;
+	SectionQuery q = {0};
+	return section_first (io->sec_ptree, addr, endaddr, filter_prange, &q);
 }
 
 R_API RIOSection * r_io_section_get_first_in_vaddr_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOSection *s= NULL;
-	RListIter *iter;
-	ut64 sec_from, sec_to;
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->flags & R_IO_MAP)) continue;
-		sec_to = s->vaddr + s->vsize;
-		sec_from = s->vaddr;
-		if (sec_from <= addr && addr < sec_to) break;
-		//if (map->from == addr && endaddr == sec_to) r_list_append(maps, map);
-		if (sec_from < endaddr && endaddr < sec_to) break;
-		if (addr <= sec_from && sec_to <= endaddr) break;
-		s = NULL;
-	}
-	return s;
+	SectionQuery q = {0};
+	return section_first (io->sec_vtree, addr, endaddr, filter_vrange, &q);
 }
 
 R_API int r_io_section_set_archbits(RIO *io, ut64 addr, const char *arch, int bits) {
@@ -590,17 +664,8 @@ R_API const char *r_io_section_get_archbits(RIO* io, ut64 addr, int *bits) {
 }
 
 R_API RIOSection *r_io_section_getv_bin_id(RIO *io, ut64 vaddr, ut32 bin_id) {
-	RListIter *iter;
-	RIOSection *s;
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->flags & R_IO_MAP) || s->bin_id != bin_id) {
-			continue;
-		}
-		if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize) {
-			return s;
-		}
-	}
-	return NULL;
+	SectionQuery q = { 0, 0, R_IO_MAP, true, bin_id };
+	return section_first (io->sec_vtree, vaddr, vaddr, filter_vin, &q);
 }
 
 R_API int r_io_section_set_archbits_bin_id(RIO *io, ut64 addr, const char *arch, int bits, ut32 bin_id) {
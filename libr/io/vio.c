@@ -125,6 +125,132 @@ R_API int r_io_vread (RIO *io, ut64 vaddr, ut8 *buf, int len) {
 	return true;
 }
 
+static bool filter_map_in(RIntervalNode *node, void *user) {
+	RIOMap *map = node->data;
+	ut64 addr = *(ut64 *)user;
+	return map->from <= addr && addr < map->to;
+}
+
+static bool filter_section_in(RIntervalNode *node, void *user) {
+	RIOSection *s = node->data;
+	ut64 addr = *(ut64 *)user;
+	return (s->flags & R_IO_MAP) && addr >= s->vaddr && addr < s->vaddr + s->vsize;
+}
+
+typedef struct {
+	int fd;
+	ut64 maddr;
+} FdQuery;
+
+static bool filter_map_fd(RIntervalNode *node, void *user) {
+	RIOMap *map = node->data;
+	FdQuery *q = user;
+	return map->fd == q->fd && map->from <= q->maddr && q->maddr < map->to;
+}
+
+static ut64 next_start(RIntervalTree *t, ut64 addr) {
+	RIntervalNode *node = r_interval_tree_next (t, addr);
+	return node? node->start: UT64_MAX;
+}
+
+/* resolves the segment starting at addr into seg, returning false for
+ * an unbacked hole. either way *end is where the next one starts */
+static bool resolve_at(RIO *io, ut64 addr, ut64 to, RIOSegment *seg, ut64 *end) {
+	RIntervalNode *node;
+	RIOSection *s = NULL;
+	RIOMap *map = NULL;
+	ut64 next = io->va? next_start (io->sec_vtree, addr): UT64_MAX;
+	if (io->va) {
+		node = r_interval_tree_first_intersect (io->sec_vtree,
+			addr, addr, filter_section_in, &addr);
+		s = node? node->data: NULL;
+	}
+	if (!s) {
+		node = r_interval_tree_first_intersect (io->map_tree,
+			addr, addr, filter_map_in, &addr);
+		map = node? node->data: NULL;
+	}
+	if (!s && !map) {
+		// jump to the next mapped thing
+		*end = R_MIN (next, next_start (io->map_tree, addr));
+		return false;
+	}
+	*end = R_MIN (to, next);
+	memset (seg, 0, sizeof (RIOSegment));
+	seg->from = addr;
+	if (s) {
+		FdQuery q = { s->fd, s->paddr + (addr - s->vaddr) };
+		*end = R_MIN (*end, s->vaddr + s->vsize);
+		// only the first size bytes of the section live in the file
+		if (addr - s->vaddr >= s->size) {
+			return false;
+		}
+		*end = R_MIN (*end, s->vaddr + s->size);
+		node = r_interval_tree_first_intersect (io->map_tree,
+			q.maddr, q.maddr, filter_map_fd, &q);
+		seg->section = s;
+		seg->fd = s->fd;
+		seg->paddr = q.maddr;
+		if (node) {
+			map = node->data;
+			*end = R_MIN (*end, addr + (map->to - q.maddr));
+			seg->paddr = q.maddr - map->from + map->delta;
+			seg->map = map;
+		}
+	} else {
+		*end = R_MIN (*end, map->to);
+		*end = R_MIN (*end, next_start (io->map_tree, addr));
+		seg->fd = map->fd;
+		seg->paddr = addr - map->from + map->delta;
+		seg->map = map;
+	}
+	seg->to = *end;
+	return true;
+}
+
+/* splits the virtual range [from, to) into segments backed by a single
+ * section (when io.va is set) or map, walking the indexes once instead
+ * of resolving every chunk. unbacked holes are not part of the result */
+R_API RList *r_io_resolve_range(RIO *io, ut64 from, ut64 to) {
+	RIOSegment seg, *dup;
+	RList *segs;
+	ut64 addr, end;
+	if (!io || from >= to) {
+		return NULL;
+	}
+	segs = r_list_newf (free);
+	if (!segs) {
+		return NULL;
+	}
+	for (addr = from; addr < to && addr != UT64_MAX; addr = end) {
+		if (!resolve_at (io, addr, to, &seg, &end)) {
+			continue;
+		}
+		if (!(dup = R_NEW (RIOSegment))) {
+			break;
+		}
+		*dup = seg;
+		r_list_append (segs, dup);
+	}
+	return segs;
+}
+
+/* the first address of [from, to) that r_io_resolve_range would return
+ * a segment for, or UT64_MAX */
+R_API ut64 r_io_next_backed(RIO *io, ut64 from, ut64 to) {
+	RIOSegment seg;
+	ut64 addr, end;
+	if (!io) {
+		return UT64_MAX;
+	}
+	for (addr = from; addr < to && addr != UT64_MAX; addr = end) {
+		if (resolve_at (io, addr, to, &seg, &end)) {
+			return addr;
+		}
+	}
+	return UT64_MAX;
+}
+
 /*you can throw any fd on this beast, it's important that len is equal or smaller than the size of buf*/
 R_API int r_io_mread (RIO *io, int fd, ut64 maddr, ut8 *buf, int len) {
 	int read_bytes = len;
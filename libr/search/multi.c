@@ -0,0 +1,465 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_search.h>
+#include <ctype.h>
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __GNUC__ && (__x86_64__ || __i386__)
+/* built for the baseline, the wider scans are picked at runtime */
+#define MULTI_SHUFTI 1
+#include <immintrin.h>
+#endif
+
+/* multi keyword engine, r_search_update uses it instead of walking
+ * every keyword for every byte when more than one is loaded. Each
+ * keyword is anchored on its longest run of unmasked bytes and an
+ * Aho-Corasick automaton over the anchors finds all the candidates in
+ * one pass, which are then checked against the keyword and its mask.
+ * The last bytes of each block are kept, so hits crossing two blocks
+ * are still found.
+ *
+ * Between candidates the bytes that can start an anchor are looked for
+ * 16 or 32 at a time (SSSE3 or AVX2, whichever the cpu has) by a nibble
+ * class test: each start byte puts the bit of its high nibble (mod 8)
+ * in the entries of the two nibble tables, so a byte may start an
+ * anchor only if both lookups share a bit. That holds for any number
+ * of start bytes, the few false positives are dropped by first[]. */
+
+#define MULTI_FIRST_SIMD 4
+
+typedef struct {
+	RSearchKeyword *kw;
+	int aoff; // anchor offset and length in the keyword
+	int alen;
+	ut64 next; // without search.overlap the next hit starts here
+} MultiKw;
+
+typedef struct {
+	ut64 addr;
+	ut64 end;
+	int kw;
+} MultiHit;
+
+struct r_search_multi_t {
+	bool usable;
+	MultiKw *kws;
+	int nkws;
+	int maxlen;
+	int *delta; // 256 transitions per state
+	int *out; // first keyword whose anchor ends at each state
+	int *outnext; // next keyword ending at the same state
+	int nstates;
+	ut8 fold[256];
+	ut8 first[256]; // bytes an anchor can start with
+	ut8 firstset[MULTI_FIRST_SIMD];
+	int nfirst;
+	ut8 lonib[16]; // nibble classes of the bytes in first[]
+	ut8 hinib[16];
+	int (*skip)(struct r_search_multi_t *m, const ut8 *buf, int p, int len);
+	ut8 *tail; // last maxlen - 1 bytes seen
+	int taillen;
+	ut64 tailend;
+	MultiHit *hits;
+	int nhits;
+	int hitsize;
+};
+
+static bool is_exact(RSearchKeyword *kw, int i) {
+	return !kw->binmask_length || kw->bin_binmask[i % kw->binmask_length] == 0xff;
+}
+
+/* the longest run of unmasked bytes */
+static bool multi_anchor(MultiKw *k) {
+	RSearchKeyword *kw = k->kw;
+	int i, run = 0;
+	k->alen = 0;
+	for (i = 0; i < kw->keyword_length; i++) {
+		run = is_exact (kw, i)? run + 1: 0;
+		if (run > k->alen) {
+			k->alen = run;
+			k->aoff = i - run + 1;
+		}
+	}
+	return k->alen > 0;
+}
+
+static bool multi_build(RSearchMulti *m) {
+	int i, c, st, size = 1, head = 0, qlen = 0;
+	int *fail = NULL, *queue = NULL;
+	for (i = 0; i < m->nkws; i++) {
+		size += m->kws[i].alen;
+	}
+	m->delta = malloc (size * 256 * sizeof (int));
+	m->out = malloc (size * sizeof (int));
+	m->outnext = malloc (m->nkws * sizeof (int));
+	fail = calloc (size, sizeof (int));
+	queue = malloc (size * sizeof (int));
+	if (!m->delta || !m->out || !m->outnext || !fail || !queue) {
+		free (fail);
+		free (queue);
+		return false;
+	}
+	memset (m->delta, 0xff, 256 * sizeof (int));
+	m->out[0] = -1;
+	m->nstates = 1;
+	/* trie of the folded anchors */
+	for (i = 0; i < m->nkws; i++) {
+		MultiKw *k = &m->kws[i];
+		const ut8 *a = k->kw->bin_keyword + k->aoff;
+		int j;
+		for (st = 0, j = 0; j < k->alen; j++) {
+			int *t = &m->delta[st * 256 + m->fold[a[j]]];
+			if (*t < 0) {
+				*t = m->nstates++;
+				memset (m->delta + *t * 256, 0xff, 256 * sizeof (int));
+				m->out[*t] = -1;
+			}
+			st = *t;
+		}
+		m->outnext[i] = m->out[st];
+		m->out[st] = i;
+		for (c = 0; c < 256; c++) {
+			if (m->fold[c] == m->fold[a[0]]) {
+				m->first[c] = 1;
+			}
+		}
+	}
+	/* turn it into a dfa, the outputs of the suffixes are appended */
+	for (c = 0; c < 256; c++) {
+		int t = m->delta[c];
+		if (t < 0) {
+			m->delta[c] = 0;
+		} else {
+			queue[qlen++] = t;
+		}
+	}
+	while (head < qlen) {
+		int s = queue[head++];
+		int f = fail[s];
+		if (m->out[s] < 0) {
+			m->out[s] = m->out[f];
+		} else {
+			for (i = m->out[s]; m->outnext[i] >= 0; i = m->outnext[i]) {
+				;
+			}
+			m->outnext[i] = m->out[f];
+		}
+		for (c = 0; c < 256; c++) {
+			int t = m->delta[s * 256 + c];
+			if (t < 0) {
+				m->delta[s * 256 + c] = m->delta[f * 256 + c];
+			} else {
+				fail[t] = m->delta[f * 256 + c];
+				queue[qlen++] = t;
+			}
+		}
+	}
+	/* the raw bytes go where their folded ones do */
+	for (st = 0; st < m->nstates; st++) {
+		int *d = m->delta + st * 256;
+		for (c = 0; c < 256; c++) {
+			d[c] = d[m->fold[c]];
+		}
+	}
+	for (c = 0; c < 256; c++) {
+		if (m->first[c]) {
+			if (m->nfirst < MULTI_FIRST_SIMD) {
+				m->firstset[m->nfirst] = c;
+			}
+			m->nfirst++;
+			m->lonib[c & 15] |= 1 << ((c >> 4) & 7);
+			m->hinib[c >> 4] = 1 << ((c >> 4) & 7);
+		}
+	}
+	free (fail);
+	free (queue);
+	return true;
+}
+
+#if MULTI_SHUFTI
+/* the first byte of the 16 or 32 at p passing the nibble test which
+ * is really in first[], or -1 */
+static inline int shufti_hit(RSearchMulti *m, const ut8 *buf, int p, ut32 bits) {
+	while (bits) {
+		int i = p + __builtin_ctz (bits);
+		if (m->first[buf[i]]) {
+			return i;
+		}
+		bits &= bits - 1;
+	}
+	return -1;
+}
+
+__attribute__((target("avx2")))
+static int multi_skip_avx2(RSearchMulti *m, const ut8 *buf, int p, int len) {
+	const __m256i lo = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *)m->lonib));
+	const __m256i hi = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *)m->hinib));
+	const __m256i nib = _mm256_set1_epi8 (0x0f);
+	const __m256i zero = _mm256_setzero_si256 ();
+	for (; p + 32 <= len; p += 32) {
+		__m256i v = _mm256_loadu_si256 ((const __m256i *)(buf + p));
+		__m256i l = _mm256_shuffle_epi8 (lo, _mm256_and_si256 (v, nib));
+		__m256i h = _mm256_shuffle_epi8 (hi, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), nib));
+		ut32 bits = ~(ut32)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_and_si256 (l, h), zero));
+		int at = shufti_hit (m, buf, p, bits);
+		if (at >= 0) {
+			return at;
+		}
+	}
+	while (p < len && !m->first[buf[p]]) {
+		p++;
+	}
+	return p;
+}
+
+__attribute__((target("ssse3")))
+static int multi_skip_ssse3(RSearchMulti *m, const ut8 *buf, int p, int len) {
+	const __m128i lo = _mm_loadu_si128 ((const __m128i *)m->lonib);
+	const __m128i hi = _mm_loadu_si128 ((const __m128i *)m->hinib);
+	const __m128i nib = _mm_set1_epi8 (0x0f);
+	const __m128i zero = _mm_setzero_si128 ();
+	for (; p + 16 <= len; p += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(buf + p));
+		__m128i l = _mm_shuffle_epi8 (lo, _mm_and_si128 (v, nib));
+		__m128i h = _mm_shuffle_epi8 (hi, _mm_and_si128 (_mm_srli_epi16 (v, 4), nib));
+		ut32 bits = ~_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_and_si128 (l, h), zero)) & 0xffff;
+		int at = shufti_hit (m, buf, p, bits);
+		if (at >= 0) {
+			return at;
+		}
+	}
+	while (p < len && !m->first[buf[p]]) {
+		p++;
+	}
+	return p;
+}
+#endif
+
+/* next position from p with a byte starting an anchor */
+static int multi_skip(RSearchMulti *m, const ut8 *buf, int p, int len) {
+#if __SSE2__
+	if (m->nfirst <= MULTI_FIRST_SIMD) {
+		__m128i set[MULTI_FIRST_SIMD];
+		int i;
+		for (i = 0; i < m->nfirst; i++) {
+			set[i] = _mm_set1_epi8 ((char)m->firstset[i]);
+		}
+		for (; p + 16 <= len; p += 16) {
+			__m128i v = _mm_loadu_si128 ((const __m128i *)(buf + p));
+			__m128i eq = _mm_cmpeq_epi8 (v, set[0]);
+			int bits;
+			for (i = 1; i < m->nfirst; i++) {
+				eq = _mm_or_si128 (eq, _mm_cmpeq_epi8 (v, set[i]));
+			}
+			bits = _mm_movemask_epi8 (eq);
+			if (bits) {
+				return p + __builtin_ctz (bits);
+			}
+		}
+	}
+#endif
+	while (p < len && !m->first[buf[p]]) {
+		p++;
+	}
+	return p;
+}
+
+R_API void r_search_multi_free(RSearchMulti *m) {
+	if (m) {
+		free (m->kws);
+		free (m->delta);
+		free (m->out);
+		free (m->outnext);
+		free (m->tail);
+		free (m->hits);
+		free (m);
+	}
+}
+
+/* compiles the keywords of s, the result is not usable if one of them
+ * has no unmasked bytes to anchor on */
+R_API RSearchMulti *r_search_multi_new(RSearch *s) {
+	RSearchMulti *m = R_NEW0 (RSearchMulti);
+	RSearchKeyword *kw;
+	RListIter *iter;
+	int i;
+	if (!m) {
+		return NULL;
+	}
+	m->tailend = UT64_MAX;
+	for (i = 0; i < 256; i++) {
+		m->fold[i] = tolower (i);
+	}
+	m->kws = calloc (r_list_length (s->kws), sizeof (MultiKw));
+	if (!m->kws) {
+		r_search_multi_free (m);
+		return NULL;
+	}
+	r_list_foreach (s->kws, iter, kw) {
+		MultiKw *k = &m->kws[m->nkws++];
+		k->kw = kw;
+		if (!multi_anchor (k)) {
+			return m;
+		}
+		m->maxlen = R_MAX (m->maxlen, kw->keyword_length);
+	}
+	if (m->maxlen > 1) {
+		m->tail = malloc (m->maxlen - 1);
+		if (!m->tail) {
+			return m;
+		}
+	}
+	m->usable = multi_build (m);
+	m->skip = multi_skip;
+#if MULTI_SHUFTI
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		m->skip = multi_skip_avx2;
+	} else if (__builtin_cpu_supports ("ssse3")) {
+		m->skip = multi_skip_ssse3;
+	}
+#endif
+	return m;
+}
+
+/* whether r_search_update can use the engine, it is compiled on the
+ * first call after the keywords or the search state change */
+R_API bool r_search_multi_usable(RSearch *s) {
+	if (s->inverse || s->distance || s->bckwrds || r_list_length (s->kws) < 2) {
+		return false;
+	}
+	if (!s->multi) {
+		s->multi = r_search_multi_new (s);
+	}
+	return s->multi && s->multi->usable;
+}
+
+static bool multi_verify(RSearchKeyword *kw, const ut8 *buf) {
+	int i;
+	for (i = 0; i < kw->keyword_length; i++) {
+		ut8 a = buf[i];
+		ut8 b = kw->bin_keyword[i];
+		if (kw->icase) {
+			a = tolower (a);
+			b = tolower (b);
+		}
+		if (kw->binmask_length) {
+			ut8 mask = kw->bin_binmask[i % kw->binmask_length];
+			a &= mask;
+			b &= mask;
+		}
+		if (a != b) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* queues the hits found in buf which start at or after base and before
+ * smax, and end after emin */
+static bool multi_scan(RSearchMulti *m, const ut8 *buf, int len, ut64 base, ut64 smax, ut64 emin) {
+	int p, st = 0;
+	for (p = 0; p < len; p++) {
+		int i;
+		if (!st) {
+			p = m->skip (m, buf, p, len);
+			if (p == len) {
+				break;
+			}
+		}
+		st = m->delta[st * 256 + buf[p]];
+		for (i = m->out[st]; i >= 0; i = m->outnext[i]) {
+			MultiKw *k = &m->kws[i];
+			int at = p - (k->aoff + k->alen - 1);
+			ut64 addr = base + at;
+			ut64 end = addr + k->kw->keyword_length;
+			if (at < 0 || at + k->kw->keyword_length > len) {
+				continue;
+			}
+			if (addr >= smax || end <= emin || !multi_verify (k->kw, buf + at)) {
+				continue;
+			}
+			if (m->nhits == m->hitsize) {
+				int size = m->hitsize? m->hitsize * 2: 64;
+				MultiHit *hits = realloc (m->hits, size * sizeof (MultiHit));
+				if (!hits) {
+					return false;
+				}
+				m->hits = hits;
+				m->hitsize = size;
+			}
+			m->hits[m->nhits].addr = addr;
+			m->hits[m->nhits].end = end;
+			m->hits[m->nhits].kw = i;
+			m->nhits++;
+		}
+	}
+	return true;
+}
+
+/* same order the byte by byte search reports them */
+static int hit_cmp(const void *a, const void *b) {
+	const MultiHit *x = a, *y = b;
+	if (x->end != y->end) {
+		return (x->end < y->end)? -1: 1;
+	}
+	return x->kw - y->kw;
+}
+
+static void multi_keep_tail(RSearchMulti *m, ut64 from, const ut8 *buf, int len) {
+	int keep = m->maxlen - 1;
+	if (keep < 1) {
+		return;
+	}
+	if (len >= keep) {
+		memcpy (m->tail, buf + len - keep, keep);
+		m->taillen = keep;
+	} else {
+		int old = R_MIN (m->taillen, keep - len);
+		memmove (m->tail, m->tail + m->taillen - old, old);
+		memcpy (m->tail + old, buf, len);
+		m->taillen = old + len;
+	}
+	m->tailend = from + len;
+}
+
+R_API int r_search_multi_update(RSearch *s, ut64 from, const ut8 *buf, int len) {
+	RSearchMulti *m = s->multi;
+	int i, count = 0;
+	m->nhits = 0;
+	if (m->tailend != from) {
+		m->taillen = 0;
+	}
+	if (m->taillen > 0 && len > 0) {
+		/* hits starting in the previous block */
+		int head = R_MIN (len, m->maxlen - 1);
+		ut8 *join = malloc (m->taillen + head);
+		if (!join) {
+			return -1;
+		}
+		memcpy (join, m->tail, m->taillen);
+		memcpy (join + m->taillen, buf, head);
+		multi_scan (m, join, m->taillen + head, from - m->taillen, from, from);
+		free (join);
+	}
+	if (!multi_scan (m, buf, len, from, UT64_MAX, from)) {
+		return -1;
+	}
+	multi_keep_tail (m, from, buf, len);
+	qsort (m->hits, m->nhits, sizeof (MultiHit), hit_cmp);
+	for (i = 0; i < m->nhits; i++) {
+		MultiHit *h = &m->hits[i];
+		MultiKw *k = &m->kws[h->kw];
+		if (!s->overlap && h->addr < k->next) {
+			continue;
+		}
+		k->next = h->end;
+		if (!r_search_hit_new (s, k->kw, h->addr)) {
+			return -1;
+		}
+		k->kw->count++;
+		count++;
+	}
+	return count;
+}
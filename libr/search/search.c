@@ -45,6 +45,7 @@ R_API RSearch *r_search_free(RSearch *s) {
 	r_mem_pool_free (s->pool);
 	r_list_free (s->hits);
 	r_list_free (s->kws);
+	r_search_multi_free (s->multi);
 	//r_io_free(s->iob.io); this is suposed to be a weak reference
 	free (s);
 	return NULL;
@@ -90,6 +91,8 @@ R_API int r_search_begin(RSearch *s) {
 		kw->distance = 0; //s->distance;
 		kw->last = 0;
 	}
+	r_search_multi_free (s->multi);
+	s->multi = NULL;
 #if 0
 	/* TODO: compile regexpes */
 	switch(s->mode) {
@@ -393,7 +396,11 @@ R_API void r_search_set_callback(RSearch *s, RSearchCallback(callback), void *us
 R_API int r_search_update(RSearch *s, ut64 *from, const ut8 *buf, long len) {
 	int ret = -1;
 	if (s->update) {
-		ret = s->update (s, *from, buf, len);
+		if (s->update == r_search_mybinparse_update && r_search_multi_usable (s)) {
+			ret = r_search_multi_update (s, *from, buf, len);
+		} else {
+			ret = s->update (s, *from, buf, len);
+		}
 		if (s->mode == R_SEARCH_AES) {
 			ret = R_MIN (R_SEARCH_AES_BOX_SIZE, len);
 		}
@@ -430,12 +437,16 @@ R_API int r_search_kw_add(RSearch *s, RSearchKeyword *kw) {
 	if (!kw) return false;
 	kw->kwidx = s->n_kws++;
 	r_list_append (s->kws, kw);
+	r_search_multi_free (s->multi);
+	s->multi = NULL;
 	return true;
 }
 
 R_API void r_search_kw_reset(RSearch *s) {
 	r_list_free (s->kws);
 	s->kws = r_list_new ();
+	r_search_multi_free (s->multi);
+	s->multi = NULL;
 }
 
 R_API void r_search_reset(RSearch *s, int mode) {
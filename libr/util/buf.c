@@ -143,6 +143,15 @@ R_API RBuffer *r_buf_new_with_buf(RBuffer *b) {
 	return r_buf_new_with_bytes (b->buf, b->length);
 }
 
+/* another view of the bytes of b if it does not own them, a copy
+ * otherwise. a view must not outlive the owner of the bytes */
+R_API RBuffer *r_buf_new_view(RBuffer *b) {
+	if (b->ro) {
+		return r_buf_new_with_pointers (b->buf, b->length);
+	}
+	return r_buf_new_with_buf (b);
+}
+
 R_API RBuffer *r_buf_new_sparse() {
 	RBuffer *b = r_buf_new ();
 	if (!b) {
@@ -197,6 +206,24 @@ R_API RBuffer *r_buf_mmap (const char *file, int flags) {
 	return NULL; /* we just freed b, don't return it */
 }
 
+/* read only file mapping that can still be patched in memory, only the
+ * pages which are touched become resident */
+R_API RBuffer *r_buf_mmap_cow(const char *file) {
+	RBuffer *b = r_buf_new ();
+	if (!b) {
+		return NULL;
+	}
+	b->mmap = r_file_mmap_cow (file, 0);
+	if (!b->mmap) {
+		r_buf_free (b);
+		return NULL;
+	}
+	b->buf = b->mmap->buf;
+	b->length = b->mmap->len;
+	b->empty = !b->length;
+	return b;
+}
+
 R_API RBuffer *r_buf_new_file(const char *file, bool newFile) {
 	const int mode = 0644;
 	int flags = O_RDWR;
@@ -281,16 +308,31 @@ R_API int r_buf_set_bits(RBuffer *b, int bitoff, int bitsize, ut64 value) {
 	return false;
 }
 
+/* drops the bytes of b, which may be mapped or borrowed */
+static void buf_release(RBuffer *b) {
+	if (b->mmap) {
+		r_file_mmap_free (b->mmap);
+		b->mmap = NULL;
+	} else if (!b->ro) {
+		free (b->buf);
+	}
+	b->buf = NULL;
+	b->ro = false;
+}
+
 R_API int r_buf_set_bytes(RBuffer *b, const ut8 *buf, ut64 length) {
+	ut8 *bytes;
 	if (length <= 0 || !buf) {
 		return false;
 	}
-	free (b->buf);
-	if (!(b->buf = malloc (length + 1))) {
+	// buf may point into the bytes released here
+	if (!(bytes = malloc (length + 1))) {
 		return false;
 	}
-	memmove (b->buf, buf, length);
-	b->buf[length] = '\0';
+	memmove (bytes, buf, length);
+	bytes[length] = '\0';
+	buf_release (b);
+	b->buf = bytes;
 	b->length = length;
 	b->empty = 0;
 	return true;
@@ -300,7 +342,7 @@ R_API int r_buf_set_bytes_steal(RBuffer *b, const ut8 *buf, ut64 length) {
 	if (length <= 0 || !buf) {
 		return false;
 	}
-	free (b->buf);
+	buf_release (b);
 	b->buf = (ut8*)buf;
 	b->length = length;
 	b->empty = 0;
@@ -683,11 +683,11 @@ R_API int r_file_mmap_read (const char *file, ut64 addr, ut8 *buf, int len) {
 }
 
 #if __UNIX__
-static RMmap *r_file_mmap_unix (RMmap *m, int fd) {
+static RMmap *r_file_mmap_unix (RMmap *m, int fd, bool cow) {
 	ut8 empty = m->len == 0;
 	m->buf = mmap (NULL, (empty?1024:m->len) ,
-		m->rw?PROT_READ|PROT_WRITE:PROT_READ,
-		MAP_SHARED, fd, (off_t)m->base);
+		(m->rw || cow)?PROT_READ|PROT_WRITE:PROT_READ,
+		cow? MAP_PRIVATE: MAP_SHARED, fd, (off_t)m->base);
 	if (m->buf == MAP_FAILED) {
 		free (m);
 		m = NULL;
@@ -734,8 +734,7 @@ static RMmap *r_file_mmap_other (RMmap *m) {
 }
 #endif
 
-// TODO: add rwx support?
-R_API RMmap *r_file_mmap (const char *file, bool rw, ut64 base) {
+static RMmap *file_mmap (const char *file, bool rw, bool cow, ut64 base) {
 	RMmap *m = NULL;
 	int fd = -1;
 	if (!rw && !r_file_exists (file)) return m;
@@ -767,7 +766,7 @@ R_API RMmap *r_file_mmap (const char *file, bool rw, ut64 base) {
 		return NULL;
 	}
 #if __UNIX__
-	return r_file_mmap_unix (m, fd);
+	return r_file_mmap_unix (m, fd, cow);
 #elif __WINDOWS__
 	close (fd);
 	m->fd = -1;
@@ -777,6 +776,17 @@ R_API RMmap *r_file_mmap (const char *file, bool rw, ut64 base) {
 #endif
 }
 
+// TODO: add rwx support?
+R_API RMmap *r_file_mmap (const char *file, bool rw, ut64 base) {
+	return file_mmap (file, rw, false, base);
+}
+
+/* private mapping, the pages are the ones in the page cache until they
+ * are written, and the writes never reach the file */
+R_API RMmap *r_file_mmap_cow (const char *file, ut64 base) {
+	return file_mmap (file, false, true, base);
+}
+
 R_API void r_file_mmap_free (RMmap *m) {
 	if (!m) {
 		return;
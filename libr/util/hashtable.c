@@ -0,0 +1,198 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_util.h>
+
+#define SLOT_EMPTY 0
+#define SLOT_USED 1
+#define SLOT_DELETED 2
+#define MIN_SIZE 16
+
+static inline ut32 hash64(ut64 key, ut32 size) {
+	key *= 0x9e3779b97f4a7c15ULL;
+	return (ut32)(key >> 32) & (size - 1);
+}
+
+/* slot holding key, or the first free one where it should go */
+static ut32 find_slot(RHashTable64 *ht, ut64 key, bool *found) {
+	ut32 i = hash64 (key, ht->size);
+	ut32 tomb = UT32_MAX;
+	for (;;) {
+		switch (ht->state[i]) {
+		case SLOT_EMPTY:
+			*found = false;
+			return (tomb != UT32_MAX)? tomb: i;
+		case SLOT_DELETED:
+			if (tomb == UT32_MAX) {
+				tomb = i;
+			}
+			break;
+		default:
+			if (ht->table[i].key == key) {
+				*found = true;
+				return i;
+			}
+			break;
+		}
+		i = (i + 1) & (ht->size - 1);
+	}
+}
+
+static bool rehash(RHashTable64 *ht, ut32 size) {
+	RHashTable64Entry *otable = ht->table;
+	ut8 *ostate = ht->state;
+	ut32 i, osize = ht->size;
+	bool found;
+	ht->table = calloc (size, sizeof (RHashTable64Entry));
+	ht->state = calloc (size, 1);
+	if (!ht->table || !ht->state) {
+		free (ht->table);
+		free (ht->state);
+		ht->table = otable;
+		ht->state = ostate;
+		return false;
+	}
+	ht->size = size;
+	ht->deleted = 0;
+	for (i = 0; i < osize; i++) {
+		if (ostate[i] == SLOT_USED) {
+			ut32 j = find_slot (ht, otable[i].key, &found);
+			ht->table[j] = otable[i];
+			ht->state[j] = SLOT_USED;
+		}
+	}
+	free (otable);
+	free (ostate);
+	return true;
+}
+
+R_API RHashTable64 *r_hashtable64_new(RHashTable64Free free) {
+	RHashTable64 *ht = R_NEW0 (RHashTable64);
+	if (!ht) {
+		return NULL;
+	}
+	ht->table = calloc (MIN_SIZE, sizeof (RHashTable64Entry));
+	ht->state = calloc (MIN_SIZE, 1);
+	if (!ht->table || !ht->state) {
+		r_hashtable64_free (ht);
+		return NULL;
+	}
+	ht->size = MIN_SIZE;
+	ht->free = free;
+	return ht;
+}
+
+R_API void r_hashtable64_clear(RHashTable64 *ht) {
+	ut32 i;
+	if (!ht) {
+		return;
+	}
+	if (ht->free) {
+		for (i = 0; i < ht->size; i++) {
+			if (ht->state[i] == SLOT_USED) {
+				ht->free (ht->table[i].data);
+			}
+		}
+	}
+	memset (ht->state, SLOT_EMPTY, ht->size);
+	ht->count = 0;
+	ht->deleted = 0;
+}
+
+R_API void r_hashtable64_free(RHashTable64 *ht) {
+	if (ht) {
+		if (ht->state) {
+			r_hashtable64_clear (ht);
+		}
+		free (ht->table);
+		free (ht->state);
+		free (ht);
+	}
+}
+
+R_API void *r_hashtable64_lookup(RHashTable64 *ht, ut64 key) {
+	bool found;
+	ut32 i;
+	if (!ht) {
+		return NULL;
+	}
+	i = find_slot (ht, key, &found);
+	return found? ht->table[i].data: NULL;
+}
+
+static bool ht_put(RHashTable64 *ht, ut64 key, void *data, bool update) {
+	bool found;
+	ut32 i;
+	if (!ht) {
+		return false;
+	}
+	// keep the load factor (tombstones included) under 3/4
+	if ((ht->count + ht->deleted + 1) * 4 > ht->size * 3) {
+		ut32 size = (ht->count + 1) * 2 > ht->size? ht->size * 2: ht->size;
+		if (!rehash (ht, size)) {
+			return false;
+		}
+	}
+	i = find_slot (ht, key, &found);
+	if (found) {
+		if (!update) {
+			return false;
+		}
+		if (ht->free && ht->table[i].data != data) {
+			ht->free (ht->table[i].data);
+		}
+		ht->table[i].data = data;
+		return true;
+	}
+	if (ht->state[i] == SLOT_DELETED) {
+		ht->deleted--;
+	}
+	ht->table[i].key = key;
+	ht->table[i].data = data;
+	ht->state[i] = SLOT_USED;
+	ht->count++;
+	return true;
+}
+
+/* fails if the key is already there */
+R_API bool r_hashtable64_insert(RHashTable64 *ht, ut64 key, void *data) {
+	return ht_put (ht, key, data, false);
+}
+
+/* inserts or replaces the data of key */
+R_API bool r_hashtable64_update(RHashTable64 *ht, ut64 key, void *data) {
+	return ht_put (ht, key, data, true);
+}
+
+R_API bool r_hashtable64_remove(RHashTable64 *ht, ut64 key) {
+	bool found;
+	ut32 i;
+	if (!ht) {
+		return false;
+	}
+	i = find_slot (ht, key, &found);
+	if (!found) {
+		return false;
+	}
+	if (ht->free) {
+		ht->free (ht->table[i].data);
+	}
+	ht->state[i] = SLOT_DELETED;
+	ht->count--;
+	ht->deleted++;
+	return true;
+}
+
+/* the table must not be modified from the callback */
+R_API void r_hashtable64_foreach(RHashTable64 *ht, RHashTable64ForeachCb cb, void *user) {
+	ut32 i;
+	if (!ht) {
+		return;
+	}
+	for (i = 0; i < ht->size; i++) {
+		if (ht->state[i] == SLOT_USED) {
+			if (!cb (user, ht->table[i].key, ht->table[i].data)) {
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,327 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_util.h>
+
+#define H(n) ((n)? (n)->height: 0)
+
+static void node_update(RIntervalNode *n) {
+	int i, hl = H (n->link[0]), hr = H (n->link[1]);
+	n->height = 1 + R_MAX (hl, hr);
+	n->max_end = n->end;
+	for (i = 0; i < 2; i++) {
+		if (n->link[i] && n->link[i]->max_end > n->max_end) {
+			n->max_end = n->link[i]->max_end;
+		}
+	}
+}
+
+/* dir = 0 rotates left, dir = 1 rotates right */
+static RIntervalNode *node_rotate(RIntervalNode *n, int dir) {
+	RIntervalNode *c = n->link[!dir];
+	n->link[!dir] = c->link[dir];
+	c->link[dir] = n;
+	node_update (n);
+	node_update (c);
+	return c;
+}
+
+static RIntervalNode *node_balance(RIntervalNode *n) {
+	int bal;
+	node_update (n);
+	bal = H (n->link[0]) - H (n->link[1]);
+	if (bal > 1) {
+		if (H (n->link[0]->link[0]) < H (n->link[0]->link[1])) {
+			n->link[0] = node_rotate (n->link[0], 0);
+		}
+		return node_rotate (n, 1);
+	}
+	if (bal < -1) {
+		if (H (n->link[1]->link[1]) < H (n->link[1]->link[0])) {
+			n->link[1] = node_rotate (n->link[1], 1);
+		}
+		return node_rotate (n, 0);
+	}
+	return n;
+}
+
+static int node_cmp(ut64 start, ut64 seq, RIntervalNode *n) {
+	if (start != n->start) {
+		return start < n->start? -1: 1;
+	}
+	if (seq != n->seq) {
+		return seq < n->seq? -1: 1;
+	}
+	return 0;
+}
+
+static RIntervalNode *node_insert(RIntervalNode *root, RIntervalNode *n) {
+	if (!root) {
+		return n;
+	}
+	if (node_cmp (n->start, n->seq, root) < 0) {
+		root->link[0] = node_insert (root->link[0], n);
+	} else {
+		root->link[1] = node_insert (root->link[1], n);
+	}
+	return node_balance (root);
+}
+
+static RIntervalNode *node_unlink_min(RIntervalNode *n, RIntervalNode **min) {
+	if (!n->link[0]) {
+		*min = n;
+		return n->link[1];
+	}
+	n->link[0] = node_unlink_min (n->link[0], min);
+	return node_balance (n);
+}
+
+static RIntervalNode *node_unlink(RIntervalNode *root, RIntervalNode *n, bool *found) {
+	RIntervalNode *min = NULL;
+	int c;
+	if (!root) {
+		return NULL;
+	}
+	c = node_cmp (n->start, n->seq, root);
+	if (c) {
+		root->link[c > 0] = node_unlink (root->link[c > 0], n, found);
+		return node_balance (root);
+	}
+	*found = true;
+	if (!root->link[0] || !root->link[1]) {
+		return root->link[0]? root->link[0]: root->link[1];
+	}
+	root->link[1] = node_unlink_min (root->link[1], &min);
+	min->link[0] = root->link[0];
+	min->link[1] = root->link[1];
+	return node_balance (min);
+}
+
+static void node_free(RIntervalNode *n, RIntervalNodeFree free_data) {
+	if (n) {
+		node_free (n->link[0], free_data);
+		node_free (n->link[1], free_data);
+		if (free_data) {
+			free_data (n->data);
+		}
+		free (n);
+	}
+}
+
+R_API void r_interval_tree_init(RIntervalTree *t, RIntervalNodeFree free) {
+	t->root = NULL;
+	t->free = free;
+	t->seq = 0;
+	t->count = 0;
+}
+
+R_API void r_interval_tree_fini(RIntervalTree *t) {
+	if (t) {
+		node_free (t->root, t->free);
+		t->root = NULL;
+		t->count = 0;
+	}
+}
+
+R_API RIntervalTree *r_interval_tree_new(RIntervalNodeFree free) {
+	RIntervalTree *t = R_NEW0 (RIntervalTree);
+	if (t) {
+		r_interval_tree_init (t, free);
+	}
+	return t;
+}
+
+R_API void r_interval_tree_free(RIntervalTree *t) {
+	r_interval_tree_fini (t);
+	free (t);
+}
+
+R_API RIntervalNode *r_interval_tree_insert(RIntervalTree *t, ut64 start, ut64 end, void *data) {
+	RIntervalNode *n;
+	if (!t || start > end) {
+		return NULL;
+	}
+	n = R_NEW0 (RIntervalNode);
+	if (!n) {
+		return NULL;
+	}
+	n->start = start;
+	n->end = end;
+	n->seq = t->seq++;
+	n->data = data;
+	node_update (n);
+	t->root = node_insert (t->root, n);
+	t->count++;
+	return n;
+}
+
+R_API bool r_interval_tree_delete(RIntervalTree *t, RIntervalNode *node, bool free_data) {
+	bool found = false;
+	if (!t || !node) {
+		return false;
+	}
+	t->root = node_unlink (t->root, node, &found);
+	if (!found) {
+		return false;
+	}
+	if (free_data && t->free) {
+		t->free (node->data);
+	}
+	free (node);
+	t->count--;
+	return true;
+}
+
+/* moves the node keeping its insertion order */
+R_API bool r_interval_tree_resize(RIntervalTree *t, RIntervalNode *node, ut64 start, ut64 end) {
+	bool found = false;
+	if (!t || !node || start > end) {
+		return false;
+	}
+	if (node->start == start && node->end == end) {
+		return true;
+	}
+	t->root = node_unlink (t->root, node, &found);
+	if (!found) {
+		return false;
+	}
+	node->start = start;
+	node->end = end;
+	node->link[0] = node->link[1] = NULL;
+	node_update (node);
+	t->root = node_insert (t->root, node);
+	return true;
+}
+
+static RIntervalNode *node_at_data(RIntervalNode *n, ut64 start, void *data) {
+	RIntervalNode *r;
+	while (n) {
+		if (start < n->start) {
+			n = n->link[0];
+		} else if (start > n->start) {
+			n = n->link[1];
+		} else {
+			if (n->data == data) {
+				return n;
+			}
+			r = node_at_data (n->link[0], start, data);
+			return r? r: node_at_data (n->link[1], start, data);
+		}
+	}
+	return NULL;
+}
+
+R_API RIntervalNode *r_interval_tree_node_at_data(RIntervalTree *t, ut64 start, void *data) {
+	return t? node_at_data (t->root, start, data): NULL;
+}
+
+/* first node (lowest start, then lowest seq) starting after addr */
+R_API RIntervalNode *r_interval_tree_next(RIntervalTree *t, ut64 addr) {
+	RIntervalNode *n, *best = NULL;
+	for (n = t? t->root: NULL; n; ) {
+		if (n->start > addr) {
+			best = n;
+			n = n->link[0];
+		} else {
+			n = n->link[1];
+		}
+	}
+	return best;
+}
+
+/* last node (highest start, then highest seq) starting at or before addr */
+R_API RIntervalNode *r_interval_tree_prev(RIntervalTree *t, ut64 addr) {
+	RIntervalNode *n, *best = NULL;
+	for (n = t? t->root: NULL; n; ) {
+		if (n->start <= addr) {
+			best = n;
+			n = n->link[1];
+		} else {
+			n = n->link[0];
+		}
+	}
+	return best;
+}
+
+static bool node_intersect(RIntervalNode *n, ut64 start, ut64 end, RIntervalIterCb cb, void *user) {
+	while (n && n->max_end >= start) {
+		if (!node_intersect (n->link[0], start, end, cb, user)) {
+			return false;
+		}
+		if (n->start > end) {
+			return true;
+		}
+		if (n->end >= start && !cb (n, user)) {
+			return false;
+		}
+		n = n->link[1];
+	}
+	return true;
+}
+
+/* calls cb for every interval containing addr, sorted by start */
+R_API bool r_interval_tree_all_in(RIntervalTree *t, ut64 addr, RIntervalIterCb cb, void *user) {
+	return t? node_intersect (t->root, addr, addr, cb, user): true;
+}
+
+/* calls cb for every interval intersecting [start, end], sorted by start */
+R_API bool r_interval_tree_all_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb cb, void *user) {
+	if (!t || start > end) {
+		return true;
+	}
+	return node_intersect (t->root, start, end, cb, user);
+}
+
+R_API bool r_interval_tree_foreach(RIntervalTree *t, RIntervalIterCb cb, void *user) {
+	return t? node_intersect (t->root, 0, UT64_MAX, cb, user): true;
+}
+
+typedef struct {
+	RIntervalNode *best;
+	RIntervalIterCb filter;
+	void *user;
+	bool last;
+} PickCtx;
+
+static bool pick_cb(RIntervalNode *n, void *user) {
+	PickCtx *ctx = user;
+	if (ctx->best && (ctx->last? n->seq < ctx->best->seq: n->seq > ctx->best->seq)) {
+		return true;
+	}
+	if (!ctx->filter || ctx->filter (n, ctx->user)) {
+		ctx->best = n;
+	}
+	return true;
+}
+
+/* lowest seq node intersecting [start, end] accepted by filter (if any) */
+R_API RIntervalNode *r_interval_tree_first_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb filter, void *user) {
+	PickCtx ctx = { NULL, filter, user, false };
+	r_interval_tree_all_intersect (t, start, end, pick_cb, &ctx);
+	return ctx.best;
+}
+
+/* highest seq node intersecting [start, end] accepted by filter (if any) */
+R_API RIntervalNode *r_interval_tree_last_intersect(RIntervalTree *t, ut64 start, ut64 end, RIntervalIterCb filter, void *user) {
+	PickCtx ctx = { NULL, filter, user, true };
+	r_interval_tree_all_intersect (t, start, end, pick_cb, &ctx);
+	return ctx.best;
+}
+
+static bool list_cb(RIntervalNode *n, void *user) {
+	return r_list_append ((RList *)user, n) != NULL;
+}
+
+static int seq_cmp(const void *a, const void *b) {
+	const RIntervalNode *na = a, *nb = b;
+	return (na->seq > nb->seq) - (na->seq < nb->seq);
+}
+
+/* nodes intersecting [start, end] in insertion order */
+R_API RList *r_interval_tree_list_intersect(RIntervalTree *t, ut64 start, ut64 end) {
+	RList *list = r_list_new ();
+	if (list) {
+		r_interval_tree_all_intersect (t, start, end, list_cb, list);
+		r_list_sort (list, (RListComparator)seq_cmp);
+	}
+	return list;
+}
@@ -2,6 +2,33 @@
 
 #include <r_th.h>
 
+/* what r_th_atexit registered in this thread */
+static R_TH_LOCAL struct {
+	RThreadAtExit fn;
+	void *user;
+} th_atexit[R_TH_ATEXIT_MAX];
+static R_TH_LOCAL int th_atexit_n = 0;
+
+/* fn (user) is called when the calling thread, started by r_th_new, ends,
+ * the last registered first. It is for what the thread keeps in its own
+ * R_TH_LOCAL variables */
+R_API bool r_th_atexit(RThreadAtExit fn, void *user) {
+	if (!fn || th_atexit_n >= R_TH_ATEXIT_MAX) {
+		return false;
+	}
+	th_atexit[th_atexit_n].fn = fn;
+	th_atexit[th_atexit_n].user = user;
+	th_atexit_n++;
+	return true;
+}
+
+static void th_run_atexit() {
+	while (th_atexit_n > 0) {
+		th_atexit_n--;
+		th_atexit[th_atexit_n].fn (th_atexit[th_atexit_n].user);
+	}
+}
+
 static void *_r_th_launcher(void *_th) {
 	int ret;
 	RThread *th = _th;
@@ -24,6 +51,7 @@ static void *_r_th_launcher(void *_th) {
 		th->running = false;
 		r_th_lock_enter (th->lock);
 	} while (ret);
+	th_run_atexit ();
 #if HAVE_PTHREAD
 	pthread_exit (&ret);
 #endif
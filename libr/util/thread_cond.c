@@ -0,0 +1,56 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_th.h>
+
+/* condition variables, to sleep on a lock until another thread signals */
+
+R_API RThreadCond *r_th_cond_new() {
+	RThreadCond *cond = R_NEW0 (RThreadCond);
+	if (!cond) {
+		return NULL;
+	}
+#if HAVE_PTHREAD
+	if (pthread_cond_init (&cond->cond, NULL)) {
+		free (cond);
+		return NULL;
+	}
+#elif __WINDOWS__ && !defined(__CYGWIN__)
+	InitializeConditionVariable (&cond->cond);
+#endif
+	return cond;
+}
+
+R_API void r_th_cond_signal(RThreadCond *cond) {
+#if HAVE_PTHREAD
+	pthread_cond_signal (&cond->cond);
+#elif __WINDOWS__ && !defined(__CYGWIN__)
+	WakeConditionVariable (&cond->cond);
+#endif
+}
+
+R_API void r_th_cond_signal_all(RThreadCond *cond) {
+#if HAVE_PTHREAD
+	pthread_cond_broadcast (&cond->cond);
+#elif __WINDOWS__ && !defined(__CYGWIN__)
+	WakeAllConditionVariable (&cond->cond);
+#endif
+}
+
+/* releases thl while sleeping, the caller must hold it */
+R_API void r_th_cond_wait(RThreadCond *cond, RThreadLock *thl) {
+#if HAVE_PTHREAD
+	pthread_cond_wait (&cond->cond, &thl->lock);
+#elif __WINDOWS__ && !defined(__CYGWIN__)
+	SleepConditionVariableCS (&cond->cond, &thl->lock, INFINITE);
+#endif
+}
+
+R_API void *r_th_cond_free(RThreadCond *cond) {
+	if (cond) {
+#if HAVE_PTHREAD
+		pthread_cond_destroy (&cond->cond);
+#endif
+		free (cond);
+	}
+	return NULL;
+}
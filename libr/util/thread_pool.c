@@ -0,0 +1,65 @@
+/* radare - LGPL - Copyright 2017 - pancake */
+
+#include <r_th.h>
+
+/* a set of threads running the same function on a shared user pointer,
+ * the function is expected to pull its work from there and return 0
+ * when there is nothing left to do */
+
+R_API RThreadPool *r_th_pool_new(int size, R_TH_FUNCTION(fun), void *user) {
+	RThreadPool *pool;
+	int i;
+	if (size < 1 || !fun) {
+		return NULL;
+	}
+	pool = R_NEW0 (RThreadPool);
+	if (!pool) {
+		return NULL;
+	}
+	pool->threads = calloc (size, sizeof (RThread *));
+	if (!pool->threads) {
+		free (pool);
+		return NULL;
+	}
+	for (i = 0; i < size; i++) {
+		if (!(pool->threads[i] = r_th_new (fun, user, 0))) {
+			break;
+		}
+		pool->size++;
+	}
+	if (!pool->size) {
+		// let the caller fall back to doing the work itself
+		free (pool->threads);
+		free (pool);
+		return NULL;
+	}
+	return pool;
+}
+
+/* waits until all the threads are done */
+R_API void r_th_pool_wait(RThreadPool *pool) {
+	int i;
+	if (!pool) {
+		return;
+	}
+	for (i = 0; i < pool->size; i++) {
+		if (pool->threads[i]) {
+			r_th_wait (pool->threads[i]);
+		}
+	}
+}
+
+R_API void r_th_pool_free(RThreadPool *pool) {
+	int i;
+	if (!pool) {
+		return;
+	}
+	r_th_pool_wait (pool);
+	for (i = 0; i < pool->size; i++) {
+		// already joined, r_th_free () would try to cancel it
+		r_th_lock_free (pool->threads[i]->lock);
+		free (pool->threads[i]);
+	}
+	free (pool->threads);
+	free (pool);
+}